@@ -17,20 +17,19 @@
 #define LED_PORT        7
 #define RED_LED_PIN     6
 #define GREEN_LED_PIN   7
+#define LED_MASK        (OCRE_GPIO_PIN_MASK(RED_LED_PIN) | OCRE_GPIO_PIN_MASK(GREEN_LED_PIN))
 
 // Manages the LED state, and called by the timer callback function
 void toggle_leds(void) {
     static bool red_active = true;
     
     if (red_active) {
-        // Turn on red LED (active low), turn off green LED
-        ocre_gpio_pin_set(LED_PORT, RED_LED_PIN, OCRE_GPIO_PIN_RESET);
-        ocre_gpio_pin_set(LED_PORT, GREEN_LED_PIN, OCRE_GPIO_PIN_SET);
+        // Turn on red LED (active low), turn off green LED, both in one port write
+        ocre_gpio_port_set_masked(LED_PORT, LED_MASK, OCRE_GPIO_PIN_MASK(GREEN_LED_PIN));
         printf("LED is: RED");  // No newline character
     } else {
-        // Turn on green LED (active low), turn off red LED
-        ocre_gpio_pin_set(LED_PORT, RED_LED_PIN, OCRE_GPIO_PIN_SET);
-        ocre_gpio_pin_set(LED_PORT, GREEN_LED_PIN, OCRE_GPIO_PIN_RESET);
+        // Turn on green LED (active low), turn off red LED, both in one port write
+        ocre_gpio_port_set_masked(LED_PORT, LED_MASK, OCRE_GPIO_PIN_MASK(RED_LED_PIN));
         printf("LED is: GREEN");  // No newline character
     }
     
@@ -1,5 +1,6 @@
 #include "mongoose.h"
 #include "ocre_api.h"
+#include "ocre_modbus.h"
 
 //=========================================================================
 // Modbus server and register definitions
@@ -8,16 +9,22 @@
 #define MODBUS_TCP_PORT         "1502"
 #define MODBUS_TCP_ADDRESS      "tcp://0.0.0.0:" MODBUS_TCP_PORT
 
-#define MODBUS_HEADER_SIZE      7
 #define MODBUS_MAX_REGISTERS    64
+#define MODBUS_BATCH_SIZE       (4 * OCRE_MODBUS_MAX_ADU_SIZE)
 
-#define SENSOR_SCAN_INTERVAL_MS 500
+// Sensors are sampled quickly while a master polls them and slowly when nobody does
+#define SENSOR_SCAN_ACTIVE_MS   100
+#define SENSOR_SCAN_IDLE_MS     5000
+#define SENSOR_POLL_TIMEOUT_MS  3000   // Without sensor reads for this long, go idle
 #define SENSOR_SCAN_TIMER_ID    1
 
-// LED control
+#define EVENT_BUDGET_US         2000
+
+// LED control, also writable as coil 0 (red) and coil 1 (green)
 #define REGISTER_LED            0x00
 #define REGISTER_LED_MASK_RED   0x01
 #define REGISTER_LED_MASK_GREEN 0x02
+#define COIL_COUNT              2
 
 // Button press count
 #define REGISTER_BUTTON         0x01
@@ -60,8 +67,16 @@
 #define REGISTER_LIGHT_L        0x20
 #define REGISTER_LIGHT_H        0x21
 
+// First sensor register, the ones below are live control registers
+#define REGISTER_SENSOR_FIRST   REGISTER_ACCEL_X_L
+
 static uint16_t holding_registers[MODBUS_MAX_REGISTERS] = {0};
 
+// Sensor registers are double buffered. A sampling pass fills the back snapshot and
+// publishes it whole, so a read never mixes words from two passes.
+static uint16_t sensor_snapshots[2][MODBUS_MAX_REGISTERS] = {0};
+static int sensor_front = 0;
+
 // Copied from Zephyr
 enum sensor_channel {
 	/** Acceleration on the X axis, in m/s^2. */
@@ -239,6 +254,7 @@ typedef struct {
     bool active;
     int num_channels;
     channel_map_t map[MAX_CHANNELS_PER_SENSOR];
+    int id;         // Resolved by sensor_init()
 } sensor_map_t;
 
 sensor_map_t sensors[] = {
@@ -295,29 +311,6 @@ sensor_map_t sensors[] = {
 // for convenience
 int sensor_map_len = sizeof(sensors) / sizeof(sensor_map_t);
 
-// Utility to split float into two 16-bit words (assuming IEEE 754 and little endian)
-void float_to_registers(float value, uint16_t *reg_out) {
-    union {
-        float f;
-        uint16_t u16[2];
-    } u;
-    u.f = value;
-
-    // Store low word first (Modbus register 0 = lower 16 bits)
-    reg_out[0] = u.u16[0];
-    reg_out[1] = u.u16[1];
-}
-
-float register_to_float(uint16_t *reg_in) {
-    union {
-        float f;
-        uint16_t u16[2];
-    } u;
-    u.u16[0] = reg_in[0]; // Low word
-    u.u16[1] = reg_in[1]; // High word
-    return u.f;
-}
-
 //=======================================================================
 // Button configuration and callback
 //=======================================================================
@@ -326,18 +319,12 @@ float register_to_float(uint16_t *reg_in) {
 #define BUTTON_PORT 2
 #define BUTTON_PIN 13
 
-// GPIO callback function for button press
-static void button_cb(void)
+// GPIO callback function for button press, only called on the rising edge
+static void button_cb(int port, int pin, ocre_gpio_pin_state_t state, void *user_data)
 {
-    // For the moment, GPIO callbacks do not support passing the button state and
-    // trigger on both edges. Thus, we increment the button press count every other call.
-    // Good enough for this demo.
-    static bool press_state = 0;
-    if (!press_state) {
-        holding_registers[REGISTER_BUTTON]++; // Increment button press count
-        printf("Press count=%d\n", holding_registers[REGISTER_BUTTON]);
-    }
-    press_state = !press_state; 
+    uint16_t *press_count = user_data;
+    (*press_count)++; // Increment button press count
+    printf("Press count=%d\n", *press_count);
 }
 
 int button_init() {
@@ -348,14 +335,9 @@ int button_init() {
         return -1;
     }
 
-    // Register callbacks
-    if (ocre_gpio_register_callback(BUTTON_PORT, BUTTON_PIN) != 0)
-    {
-        printf("Failed to register button callback\n");
-        return -1;
-    }
-
-    if (ocre_register_gpio_callback(BUTTON_PIN, BUTTON_PORT, button_cb) != 0)
+    // Register callback, releases are filtered out in the host
+    if (ocre_register_gpio_callback_ex(BUTTON_PORT, BUTTON_PIN, OCRE_GPIO_EDGE_RISING, button_cb,
+                                       &holding_registers[REGISTER_BUTTON]) != 0)
     {
         printf("Failed to register GPIO callback function\n");
         return -1;
@@ -368,27 +350,41 @@ int button_init() {
 // LED control
 //=======================================================================
 
+// Resolved once in led_init() so register writes do not look names up again
+static ocre_gpio_pin_t led0;
+static ocre_gpio_pin_t led1;
+
 static void update_leds() {
     printf("Updating LEDs\n");
     // Active high in the registers, active low in the GPIO
     bool led0_state = holding_registers[REGISTER_LED] & REGISTER_LED_MASK_RED;
     bool led1_state = holding_registers[REGISTER_LED] & REGISTER_LED_MASK_GREEN;
-    ocre_gpio_set_by_name("led0", led0_state ? OCRE_GPIO_PIN_RESET : OCRE_GPIO_PIN_SET);
-    ocre_gpio_set_by_name("led1", led1_state ? OCRE_GPIO_PIN_RESET : OCRE_GPIO_PIN_SET);
+    if (led0.port == led1.port) {
+        // One port write, so both LEDs change at the same instant
+        uint32_t mask = OCRE_GPIO_PIN_MASK(led0.pin) | OCRE_GPIO_PIN_MASK(led1.pin);
+        uint32_t value = (led0_state ? 0 : OCRE_GPIO_PIN_MASK(led0.pin)) | (led1_state ? 0 : OCRE_GPIO_PIN_MASK(led1.pin));
+        ocre_gpio_port_set_masked(led0.port, mask, value);
+    }
+    else {
+        ocre_gpio_pin_set(led0.port, led0.pin, led0_state ? OCRE_GPIO_PIN_RESET : OCRE_GPIO_PIN_SET);
+        ocre_gpio_pin_set(led1.port, led1.pin, led1_state ? OCRE_GPIO_PIN_RESET : OCRE_GPIO_PIN_SET);
+    }
 }
 
 int led_init() {
     // Configure LEDs as outputs
-    if (ocre_gpio_configure_by_name("led0", OCRE_GPIO_DIR_OUTPUT) != 0 ||
-        ocre_gpio_configure_by_name("led1", OCRE_GPIO_DIR_OUTPUT) != 0)
+    if (ocre_gpio_resolve("led0", &led0) != 0 ||
+        ocre_gpio_resolve("led1", &led1) != 0 ||
+        ocre_gpio_configure(led0.port, led0.pin, OCRE_GPIO_DIR_OUTPUT) != 0 ||
+        ocre_gpio_configure(led1.port, led1.pin, OCRE_GPIO_DIR_OUTPUT) != 0)
     {
         printf("LED config failed\n");
         return -1;
     }
 
     // Initialize LEDs to OFF
-    ocre_gpio_set_by_name("led0", OCRE_GPIO_PIN_SET);
-    ocre_gpio_set_by_name("led1", OCRE_GPIO_PIN_SET);
+    ocre_gpio_pin_set(led0.port, led0.pin, OCRE_GPIO_PIN_SET);
+    ocre_gpio_pin_set(led1.port, led1.pin, OCRE_GPIO_PIN_SET);
     
     return 0;
 }
@@ -397,22 +393,74 @@ int led_init() {
 // Sensor configuration
 //=======================================================================
 
-void read_sensor(sensor_map_t sensor) {
-    for (int ch_idx = 0; ch_idx < sensor.num_channels; ch_idx++) {
-        channel_map_t channel = sensor.map[ch_idx];
-        // printf("Reading '%s' channel id=%d reg=0x%02X\n", sensor.name, channel.id, channel.reg);
-        float val = ocre_sensors_read_by_name(sensor.name, channel.id);
-        // printf("%s returned value %0.6f for channel %d\n", sensor.name, val, channel.id);
-        float_to_registers(val, &holding_registers[channel.reg]);
+static uint64_t last_poll_us = 0;
+static int scan_interval_ms = 0;
+
+void read_sensor(const sensor_map_t *sensor, uint16_t *registers) {
+    int channels[MAX_CHANNELS_PER_SENSOR];
+    ocre_sensor_sample_t samples[MAX_CHANNELS_PER_SENSOR];
+    for (int ch_idx = 0; ch_idx < sensor->num_channels; ch_idx++) {
+        channels[ch_idx] = sensor->map[ch_idx].id;
+    }
+    // One host call and one driver fetch, so all axes come from the same sample.
+    // Native values go straight to float, without a round trip through double.
+    int count = ocre_sensors_read_samples(sensor->id, channels, samples, sensor->num_channels);
+    if (count < 0) {
+        // printf("Reading '%s' failed (%d)\n", sensor->name, count);
+        return;
+    }
+    for (int ch_idx = 0; ch_idx < count; ch_idx++) {
+        float value = ocre_sensor_sample_to_float(&samples[ch_idx]);
+        // printf("%s returned value %0.6f for channel %d\n", sensor->name, value, channels[ch_idx]);
+        ocre_modbus_float_to_registers(value, &registers[sensor->map[ch_idx].reg]);
     }
 }
 
-static void read_sensors() {
+// One complete sampling pass, then swap it in
+static void sample_sensors() {
+    int front = __atomic_load_n(&sensor_front, __ATOMIC_RELAXED);
+    uint16_t *back = sensor_snapshots[front ^ 1];
+
+    // Sensors that fail to read keep their previous values
+    memcpy(back, sensor_snapshots[front], sizeof(sensor_snapshots[0]));
     for (int i = 0; i < sensor_map_len; i++) {
         if (sensors[i].active) {
-            read_sensor(sensors[i]);
+            read_sensor(&sensors[i], back);
         }
     }
+    __atomic_store_n(&sensor_front, front ^ 1, __ATOMIC_RELEASE);
+}
+
+static void set_scan_interval(int interval_ms) {
+    if (interval_ms == scan_interval_ms) {
+        return;
+    }
+    ocre_timer_stop(SENSOR_SCAN_TIMER_ID);
+    if (ocre_timer_start(SENSOR_SCAN_TIMER_ID, interval_ms, true) != 0) {
+        printf("Timer start failed\n");
+        return;
+    }
+    scan_interval_ms = interval_ms;
+    printf("Sensor scan interval %dms\n", interval_ms);
+}
+
+// Timer callback
+static void read_sensors() {
+    sample_sensors();
+    if (scan_interval_ms == SENSOR_SCAN_ACTIVE_MS &&
+        ocre_time_us() - last_poll_us > SENSOR_POLL_TIMEOUT_MS * 1000ULL) {
+        set_scan_interval(SENSOR_SCAN_IDLE_MS);
+    }
+}
+
+// Called when a master reads sensor registers
+static void sensor_polled() {
+    last_poll_us = ocre_time_us();
+    if (scan_interval_ms != SENSOR_SCAN_ACTIVE_MS) {
+        // The idle snapshot may be seconds old, so answer the first read with fresh data
+        sample_sensors();
+        set_scan_interval(SENSOR_SCAN_ACTIVE_MS);
+    }
 }
 
 int sensor_init() {
@@ -433,6 +481,11 @@ int sensor_init() {
             sensors[i].active = false;
             continue;
         }
+        sensors[i].id = ocre_sensors_resolve(sensors[i].name);
+        if (sensors[i].id < 0) {
+            printf("sensor_init: could not resolve sensor '%s'\n", sensors[i].name);
+            sensors[i].active = false;
+        }
         else {
             printf("sensor_init: open sensor '%s' OK\n", sensors[i].name);
             sensors[i].active = true;
@@ -448,87 +501,93 @@ int sensor_init() {
 // Modbus functions
 //=======================================================================
 
-static void send_exception(struct mg_connection *c, uint8_t unit_id,
-                           uint16_t transaction_id, uint8_t function_code, uint8_t exception_code) {
-    uint8_t response[9] = {
-        (transaction_id >> 8), (transaction_id & 0xFF),
-        0x00, 0x00, // Protocol ID
-        0x00, 0x03, // Length
-        unit_id,
-        (function_code | 0x80),
-        exception_code
-    };
-    mg_send(c, response, sizeof(response));
+static ocre_modbus_server_t modbus_server;
+
+static void set_led_register(uint16_t value) {
+    if (holding_registers[REGISTER_LED] != value) {
+        holding_registers[REGISTER_LED] = value;
+        update_leds(); // Update LEDs based on holding registers
+        printf("Register %d updated to %d\n", REGISTER_LED, value);
+    }
 }
 
-static void handle_modbus(struct mg_connection *c, const uint8_t *buf, size_t len) {
-    if (len < MODBUS_HEADER_SIZE + 1) return;
+// Holding and input registers read the same table
+static uint8_t read_registers(void *user_data, ocre_modbus_table_t table,
+                              uint16_t start, uint16_t count, uint16_t *values) {
+    if (start + count > MODBUS_MAX_REGISTERS) {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_ADDRESS;
+    }
+    if (start + count > REGISTER_SENSOR_FIRST) {
+        sensor_polled();
+    }
 
-    uint16_t transaction_id = (buf[0] << 8) | buf[1];
-    uint8_t unit_id = buf[6];
-    uint8_t function_code = buf[7];
+    // Sensor values come from the published snapshot, control registers are live
+    const uint16_t *snapshot = sensor_snapshots[__atomic_load_n(&sensor_front, __ATOMIC_ACQUIRE)];
+    memcpy(values, &snapshot[start], count * sizeof(uint16_t));
+    for (uint16_t reg = start; reg < REGISTER_SENSOR_FIRST && reg < start + count; reg++) {
+        values[reg - start] = holding_registers[reg];
+    }
+    return OCRE_MODBUS_EX_NONE;
+}
 
-    switch (function_code) {
-        case 0x03: { // Read Holding Registers
-            if (len < MODBUS_HEADER_SIZE + 5) break;
-            uint16_t start = (buf[8] << 8) | buf[9];
-            uint16_t count = (buf[10] << 8) | buf[11];
+static uint8_t write_registers(void *user_data, uint16_t start, uint16_t count, const uint16_t *values) {
+    if (start != REGISTER_LED || count != 1) {
+        // LED register is the only writable register
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_ADDRESS;
+    }
+    set_led_register(values[0]);
+    return OCRE_MODBUS_EX_NONE;
+}
 
-            if (start + count > MODBUS_MAX_REGISTERS || count > 125) {
-                send_exception(c, unit_id, transaction_id, function_code, 0x02); // Illegal data address
-                return;
-            }
+static uint8_t read_bits(void *user_data, ocre_modbus_table_t table,
+                         uint16_t start, uint16_t count, uint8_t *bits) {
+    if (table != OCRE_MODBUS_COILS || start + count > COIL_COUNT) {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_ADDRESS;
+    }
+    bits[0] = (holding_registers[REGISTER_LED] >> start) & ((1 << count) - 1);
+    return OCRE_MODBUS_EX_NONE;
+}
 
-            uint8_t response[260];
-            size_t res_len = 0;
-            response[res_len++] = buf[0]; response[res_len++] = buf[1]; // Transaction ID
-            response[res_len++] = 0x00; response[res_len++] = 0x00;     // Protocol ID
-            response[res_len++] = 0x00;
-            response[res_len++] = 3 + count * 2;                        // Length
-            response[res_len++] = unit_id;
-            response[res_len++] = function_code;
-            response[res_len++] = count * 2;
-
-            for (uint16_t i = 0; i < count; i++) {
-                response[res_len++] = holding_registers[start + i] >> 8;
-                response[res_len++] = holding_registers[start + i] & 0xFF;
-            }
+static uint8_t write_bits(void *user_data, uint16_t start, uint16_t count, const uint8_t *bits) {
+    if (start + count > COIL_COUNT) {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_ADDRESS;
+    }
+    uint16_t mask = ((1 << count) - 1) << start;
+    set_led_register((holding_registers[REGISTER_LED] & ~mask) | ((bits[0] << start) & mask));
+    return OCRE_MODBUS_EX_NONE;
+}
 
-            mg_send(c, response, res_len);
-            break;
-        }
+static const ocre_modbus_map_t modbus_map = {
+    .read_registers = read_registers,
+    .write_registers = write_registers,
+    .read_bits = read_bits,
+    .write_bits = write_bits,
+};
 
-        case 0x06: { // Write Single Register
-            if (len < MODBUS_HEADER_SIZE + 5) break;
-            uint16_t reg = (buf[8] << 8) | buf[9];
-            uint16_t value = (buf[10] << 8) | buf[11];
+static void modbus_slave_handler(struct mg_connection *c, int ev, void *ev_data) {
+    if (ev == MG_EV_READ) {
+        static uint8_t responses[MODBUS_BATCH_SIZE];
+        size_t offset = 0;
+        int used;
 
-            if (reg != 0x0) {
-                // LED register is the only writable register
-                send_exception(c, unit_id, transaction_id, function_code, 0x02);
-                return;
+        // Answer every complete ADU in the buffer, one send per batch of responses
+        do {
+            size_t res_len = 0;
+            used = ocre_modbus_server_process(&modbus_server, (const uint8_t *)c->recv.buf + offset,
+                                              c->recv.len - offset, responses, sizeof(responses), &res_len);
+            if (res_len > 0) {
+                mg_send(c, responses, res_len);
             }
-
-            if (holding_registers[reg] != value) {
-                holding_registers[reg] = value;
-                update_leds(); // Update LEDs based on holding registers
-                printf("Register %d updated to %d\n", reg, value);
+            if (used < 0) {
+                // Framing is lost, nothing after this can be trusted
+                c->is_closing = 1;
+                offset = c->recv.len;
+                break;
             }
-            
-            mg_send(c, buf, len); // Echo original request
-            break;
-        }
-
-        default:
-            send_exception(c, unit_id, transaction_id, function_code, 0x01); // Illegal function
-            break;
-    }
-}
+            offset += used;
+        } while (used > 0);
 
-static void modbus_slave_handler(struct mg_connection *c, int ev, void *ev_data) {
-    if (ev == MG_EV_READ) {
-        handle_modbus(c, (const uint8_t *)c->recv.buf, c->recv.len);
-        mg_iobuf_del(&c->recv, 0, c->recv.len);  // Clear recv buffer
+        mg_iobuf_del(&c->recv, 0, offset);
     }
 }
 
@@ -561,24 +620,32 @@ int main(void) {
         printf("Timer creation failed\n");
         return -1;
     }
-    if (ocre_timer_start(SENSOR_SCAN_TIMER_ID, SENSOR_SCAN_INTERVAL_MS, true) != 0)
+    // Start idle, the first sensor read switches to the active rate
+    sample_sensors();
+    set_scan_interval(SENSOR_SCAN_IDLE_MS);
+    if (scan_interval_ms != SENSOR_SCAN_IDLE_MS)
     {
-        printf("Timer start failed\n");
         return -1;
     }
-    printf("Sensor read timer started (ID: %d, Interval: %dms)\n", 0, SENSOR_SCAN_INTERVAL_MS);
+    printf("Sensor read timer started (ID: %d)\n", SENSOR_SCAN_TIMER_ID);
 
     // Start Modbus server
     struct mg_mgr mgr;
     mg_mgr_init(&mgr);
+    ocre_modbus_server_init(&modbus_server, &modbus_map, NULL);
     mg_listen(&mgr, MODBUS_TCP_ADDRESS, modbus_slave_handler, NULL);
 
     printf("Modbus Listening on %s\n", MODBUS_TCP_ADDRESS);
-    
+
+    // Drain Ocre events within a strict time slice so sockets are not held up
+    ocre_event_policy_t policy = { .max_events = OCRE_EVENT_DRAIN, .max_time_us = EVENT_BUDGET_US };
+    ocre_set_event_policy(&policy);
+
+    // mg_mgr_poll() waits in ocre_poll() (see mongoose_config.h), so it returns as soon as
+    // a socket is ready or an Ocre event is queued, and the events are handled right after
     for (;;) {
-        mg_mgr_poll(&mgr, 100);
-        // read_sensors();
-        ocre_process_events();
+        mg_mgr_poll(&mgr, 1000);
+        ocre_process_events_ex(OCRE_EVENT_FLAG_NONE, 0);
     }
 
     mg_mgr_free(&mgr);
@@ -0,0 +1,72 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ * Pulse Counter Example
+ *
+ * Counts rising edges on an input pin and reports their frequency from host timestamps.
+ * The user button is used here; wire a signal generator or tachometer to the same pin
+ * to measure kilohertz inputs.
+ */
+#include <stdio.h>
+#include <ocre_api.h>
+
+#define PULSE_PORT 2
+#define PULSE_PIN 13
+#define PULSE_BATCH 64       // Edges per event
+#define PULSE_LATENCY_MS 250 // Deliver slow signals at least this often
+#define PULSE_RECORDS 256
+
+static ocre_gpio_edge_record_t pulse_records[PULSE_RECORDS];
+static ocre_gpio_capture_t pulse_capture;
+
+static void pulse_callback(ocre_gpio_capture_t *capture, const ocre_gpio_edge_record_t *edges, uint32_t count,
+                           void *user_data)
+{
+    uint64_t interval_ns = ocre_gpio_capture_interval_ns(capture);
+    printf("%u edges, last at %llu ns, total %u, dropped %u", count,
+           (unsigned long long)edges[count - 1].timestamp_ns, ocre_gpio_capture_edges(capture),
+           ocre_gpio_capture_dropped(capture));
+    if (interval_ns)
+    {
+        printf(", %.1f Hz", 1e9 / (double)interval_ns);
+    }
+    printf("\n");
+}
+
+int main(void)
+{
+    printf("=== Pulse Counter Example ===\n");
+
+    if (ocre_gpio_init() != 0)
+    {
+        printf("GPIO init failed\n");
+        return -1;
+    }
+
+    if (ocre_gpio_configure(PULSE_PORT, PULSE_PIN, OCRE_GPIO_DIR_INPUT) != 0)
+    {
+        printf("Pulse input config failed\n");
+        return -1;
+    }
+
+    int ret = ocre_gpio_capture_start(&pulse_capture, PULSE_PORT, PULSE_PIN, OCRE_GPIO_EDGE_RISING, pulse_records,
+                                      PULSE_RECORDS, PULSE_BATCH, PULSE_LATENCY_MS, pulse_callback, NULL);
+    if (ret != 0)
+    {
+        printf("Edge capture failed to start (code: %d)\n", ret);
+        return -1;
+    }
+    printf("Counting rising edges on port %d pin %d\n", PULSE_PORT, PULSE_PIN);
+
+    while (1)
+    {
+        ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, 1000);
+    }
+
+    ocre_gpio_capture_stop(&pulse_capture);
+    printf("Pulse Counter exiting.\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ * IMU Sensor Streaming Example
+ */
+#include <stdio.h>
+#include <ocre_api.h>
+
+#define MAX_IMU_CHANNELS 16
+#define IMU_RATE_HZ 200
+#define IMU_BATCH 20 // Samples per wake-up, 10 per second at 200 Hz
+#define IMU_BLOCKS 4
+
+// Host-written sample blocks, uint64_t keeps them 8-byte aligned
+static uint64_t imu_buffer[(IMU_BLOCKS * OCRE_SENSOR_BLOCK_SIZE(MAX_IMU_CHANNELS, IMU_BATCH) + 7) / 8];
+static ocre_sensor_stream_t imu_stream;
+
+static void imu_block_callback(ocre_sensor_stream_t *stream, const ocre_sensor_block_t *block, void *user_data)
+{
+    int channel_count = *(const int *)user_data;
+    static uint32_t block_count = 0;
+
+    if (block->dropped)
+    {
+        printf("Warning: %u samples dropped\n", block->dropped);
+    }
+
+    // Print the mean of each channel over the block
+    printf("Block #%u at %llu us, %u samples every %u us:\n", ++block_count,
+           (unsigned long long)block->timestamp_us, block->sample_count, block->period_us);
+    for (int c = 0; c < channel_count; c++)
+    {
+        double sum = 0.0;
+        for (uint32_t s = 0; s < block->sample_count; s++)
+        {
+            sum += block->values[s * channel_count + c];
+        }
+        printf("  Channel %d: mean %f\n", c, sum / block->sample_count);
+    }
+}
+
+int main(void)
+{
+    printf("=== IMU Sensor Streaming Example ===\n");
+
+    // Initialize the sensor API
+    int ret = ocre_sensors_init();
+    if (ret != 0)
+    {
+        printf("Error: Sensors not initialized (code: %d)\n", ret);
+        return -1;
+    }
+
+    if (ocre_sensors_discover() <= 0)
+    {
+        printf("Error: No sensors discovered\n");
+        return -1;
+    }
+
+    if (ocre_sensors_open_by_name("imu") != 0)
+    {
+        printf("Could not open IMU sensor by name 'imu'\n");
+        return -1;
+    }
+    int imu_sensor_id = ocre_sensors_resolve("imu");
+    if (imu_sensor_id < 0)
+    {
+        printf("Could not resolve IMU sensor 'imu'\n");
+        return -1;
+    }
+
+    // Stream every channel the IMU reports
+    static int imu_channels[MAX_IMU_CHANNELS];
+    static int imu_channel_count = 0;
+    int channel_count = ocre_sensors_get_channel_count(imu_sensor_id);
+    for (int j = 0; j < channel_count && imu_channel_count < MAX_IMU_CHANNELS; j++)
+    {
+        int channel_type = ocre_sensors_get_channel_type(imu_sensor_id, j);
+        if (channel_type >= 0)
+        {
+            imu_channels[imu_channel_count++] = channel_type;
+        }
+    }
+
+    ret = ocre_sensors_stream_start(&imu_stream, imu_sensor_id, imu_channels, imu_channel_count, IMU_RATE_HZ,
+                                    IMU_BATCH, imu_buffer, sizeof(imu_buffer), imu_block_callback,
+                                    &imu_channel_count);
+    if (ret != 0)
+    {
+        printf("Error: Could not start IMU stream (code: %d)\n", ret);
+        return -1;
+    }
+    printf("Streaming %d IMU channels at %d Hz\n", imu_channel_count, IMU_RATE_HZ);
+
+    // The host samples in the background; sleep in the host until a block is ready
+    while (1)
+    {
+        ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, 1000);
+    }
+
+    ocre_sensors_stream_stop(&imu_stream);
+    printf("IMU Sensor Streaming exiting.\n");
+    return 0;
+}
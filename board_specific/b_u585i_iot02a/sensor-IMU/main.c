@@ -8,6 +8,71 @@
  */
 #include <stdio.h>
 #include <ocre_api.h>
+#include <ocre_task.h>
+
+#define MAX_IMU_CHANNELS 16
+
+// Channel types for the bulk read, looked up once
+static int imu_channels[MAX_IMU_CHANNELS];
+static double imu_values[MAX_IMU_CHANNELS];
+static int imu_channel_count = 0;
+static int imu_sensor_id = -1;
+static int imu_resolved_id = -1;
+static int reading_count = 0;
+static ocre_task_t imu_task;
+
+static void read_imu(void)
+{
+    reading_count++;
+    printf("\n--- IMU Reading #%d ---\n", reading_count);
+
+    // Read using the ID resolved from the name
+    printf("Reading by name:\n");
+    int channel_count_by_name = imu_resolved_id >= 0 ? ocre_sensors_get_channel_count(imu_resolved_id) : 0;
+    for (int j = 0; j < channel_count_by_name; j++)
+    {
+        int channel_type = ocre_sensors_get_channel_type(imu_resolved_id, j);
+        if (channel_type >= 0)
+        {
+            double value = ocre_sensors_read(imu_resolved_id, channel_type);
+            printf("  Channel %d (type %d): %f\n", j, channel_type, value);
+        }
+    }
+
+    // Read using handle-based API
+    printf("Reading by handle:\n");
+    int channel_count_by_id = ocre_sensors_get_channel_count(imu_sensor_id);
+    for (int j = 0; j < channel_count_by_id; j++)
+    {
+        int channel_type = ocre_sensors_get_channel_type(imu_sensor_id, j);
+        if (channel_type >= 0)
+        {
+            double value = ocre_sensors_read(imu_sensor_id, channel_type);
+            printf("  Channel %d (type %d): %f\n", j, channel_type, value);
+        }
+    }
+
+    // Read all channels from one sample in a single call
+    printf("Reading all channels at once:\n");
+    int read_count = ocre_sensors_read_channels(imu_sensor_id, imu_channels, imu_values, imu_channel_count);
+    for (int j = 0; j < read_count; j++)
+    {
+        printf("  Channel %d (type %d): %f\n", j, imu_channels[j], imu_values[j]);
+    }
+}
+
+// The reading loop runs as a cooperative task, so events are still dispatched while it waits
+static int imu_task_func(ocre_task_t *task, void *user_data)
+{
+    OCRE_TASK_BEGIN(task);
+    while (1)
+    {
+        read_imu();
+        printf("Waiting 4 seconds before next reading...\n");
+        ocre_task_sleep(task, 4000); // Wait 4 seconds
+    }
+    OCRE_TASK_END(task);
+}
 
 int main(void)
 {
@@ -51,7 +116,6 @@ int main(void)
     printf("\n=== Finding IMU Sensor by Handle ===\n");
 
     // Search for IMU sensor by iterating through all sensors
-    int imu_sensor_id = -1;
     ocre_sensor_handle_t imu_handle_by_id = -1;
 
     for (int sensor_id = 0; sensor_id < nr_of_sensors; sensor_id++)
@@ -89,44 +153,26 @@ int main(void)
     printf("Successfully found IMU sensor by handle - ID: %d, Handle: %d\n",
            imu_sensor_id, imu_handle_by_id);
 
-    printf("\n=== Starting Continuous IMU Reading ===\n");
-    printf("Reading IMU sensor every 4 seconds...\n");
-
-    int reading_count = 0;
-
-    while (1)
+    int channel_count = ocre_sensors_get_channel_count(imu_sensor_id);
+    for (int j = 0; j < channel_count && imu_channel_count < MAX_IMU_CHANNELS; j++)
     {
-        reading_count++;
-        printf("\n--- IMU Reading #%d ---\n", reading_count);
-
-        // Read using name-based API
-        printf("Reading by name:\n");
-        int channel_count_by_name = ocre_sensors_get_channel_count_by_name("imu");
-        for (int j = 0; j < channel_count_by_name; j++)
+        int channel_type = ocre_sensors_get_channel_type(imu_sensor_id, j);
+        if (channel_type >= 0)
         {
-            int channel_type = ocre_sensors_get_channel_type_by_name("imu", j);
-            if (channel_type >= 0)
-            {
-                double value = ocre_sensors_read_by_name("imu", channel_type);
-                printf("  Channel %d (type %d): %f\n", j, channel_type, value);
-            }
+            imu_channels[imu_channel_count++] = channel_type;
         }
+    }
 
-        // Read using handle-based API
-        printf("Reading by handle:\n");
-        int channel_count_by_id = ocre_sensors_get_channel_count(imu_sensor_id);
-        for (int j = 0; j < channel_count_by_id; j++)
-        {
-            int channel_type = ocre_sensors_get_channel_type(imu_sensor_id, j);
-            if (channel_type >= 0)
-            {
-                double value = ocre_sensors_read(imu_sensor_id, channel_type);
-                printf("  Channel %d (type %d): %f\n", j, channel_type, value);
-            }
-        }
+    printf("\n=== Starting Continuous IMU Reading ===\n");
+    printf("Reading IMU sensor every 4 seconds...\n");
 
-        printf("Waiting 4 seconds before next reading...\n");
-        ocre_sleep(4000); // Wait 4 seconds
+    // Resolve the name once so the readings do not pass strings to the host
+    imu_resolved_id = ocre_sensors_resolve("imu");
+
+    ocre_task_start(&imu_task, imu_task_func, NULL);
+    while (ocre_task_is_running(&imu_task))
+    {
+        ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, OCRE_WAIT_FOREVER);
     }
 
     printf("IMU Sensor Reader exiting.\n");
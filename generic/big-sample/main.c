@@ -10,11 +10,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <ocre_alloc.h>
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
 
 #define DATA_SIZE 1000000  // 1MB of data
 #define CHUNK_SIZE 1024    // Process in 1KB chunks
 #define ITERATIONS 100     // Number of processing iterations
 
+// Working memory is reserved up front instead of coming from the heap
+static char work_storage[DATA_SIZE + OCRE_ALLOC_ALIGN];
+static ocre_arena_t work_arena;
+
 // Large static data arrays to increase binary size
 static const char large_data_array1[200000] = {
     // Initialize with pattern data to prevent optimization
@@ -65,6 +73,104 @@ static const int lookup_table[50000] = {
     [40000] = 1400, [45000] = 1450, [49999] = 1499
 };
 
+// Statistics of a range of bytes, computed by the kernels compared below
+typedef struct {
+    uint32_t sum;
+    uint32_t zeros;
+    unsigned char min;
+    unsigned char max;
+} byte_stats_t;
+
+typedef void (*stats_kernel_t)(const unsigned char *data, int len, byte_stats_t *stats);
+
+// One byte at a time, kept scalar even in SIMD builds as the baseline
+static void byte_stats_scalar(const unsigned char *data, int len, byte_stats_t *stats)
+{
+    uint32_t sum = 0;
+    uint32_t zeros = 0;
+    unsigned char min = 255;
+    unsigned char max = 0;
+#pragma clang loop vectorize(disable) interleave(disable)
+    for (int i = 0; i < len; i++) {
+        unsigned char byte_val = data[i];
+        sum += byte_val;
+        zeros += byte_val == 0;
+        if (byte_val < min) min = byte_val;
+        if (byte_val > max) max = byte_val;
+    }
+    stats->sum = sum;
+    stats->zeros = zeros;
+    stats->min = min;
+    stats->max = max;
+}
+
+#ifdef __wasm_simd128__
+// 16 bytes at a time with SIMD128, built with -DOCRE_SIMD=ON
+static void byte_stats_simd(const unsigned char *data, int len, byte_stats_t *stats)
+{
+    const v128_t zero = wasm_i8x16_splat(0);
+    v128_t sum32 = zero;
+    v128_t zeros32 = zero;
+    v128_t min = wasm_u8x16_splat(255);
+    v128_t max = zero;
+    int i = 0;
+    while (i + 16 <= len) {
+        // Byte-pair sums fit 16-bit lanes for 128 vectors, zero counts 8-bit lanes for 255
+        int block_end = i + 128 * 16 < len ? i + 128 * 16 : len;
+        v128_t sum16 = zero;
+        v128_t zeros8 = zero;
+        for (; i + 16 <= block_end; i += 16) {
+            v128_t v = wasm_v128_load(data + i);
+            sum16 = wasm_i16x8_add(sum16, wasm_u16x8_extadd_pairwise_u8x16(v));
+            zeros8 = wasm_i8x16_sub(zeros8, wasm_i8x16_eq(v, zero)); // eq lanes are -1
+            min = wasm_u8x16_min(min, v);
+            max = wasm_u8x16_max(max, v);
+        }
+        sum32 = wasm_i32x4_add(sum32, wasm_u32x4_extadd_pairwise_u16x8(sum16));
+        zeros32 = wasm_i32x4_add(zeros32,
+                                 wasm_u32x4_extadd_pairwise_u16x8(wasm_u16x8_extadd_pairwise_u8x16(zeros8)));
+    }
+
+    unsigned char min_lanes[16];
+    unsigned char max_lanes[16];
+    wasm_v128_store(min_lanes, min);
+    wasm_v128_store(max_lanes, max);
+    byte_stats_scalar(data + i, len - i, stats);
+    for (int lane = 0; lane < 16; lane++) {
+        if (min_lanes[lane] < stats->min) stats->min = min_lanes[lane];
+        if (max_lanes[lane] > stats->max) stats->max = max_lanes[lane];
+    }
+    stats->sum += wasm_u32x4_extract_lane(sum32, 0) + wasm_u32x4_extract_lane(sum32, 1) +
+                  wasm_u32x4_extract_lane(sum32, 2) + wasm_u32x4_extract_lane(sum32, 3);
+    stats->zeros += wasm_u32x4_extract_lane(zeros32, 0) + wasm_u32x4_extract_lane(zeros32, 1) +
+                    wasm_u32x4_extract_lane(zeros32, 2) + wasm_u32x4_extract_lane(zeros32, 3);
+}
+#endif
+
+// Run a kernel over the buffer chunk by chunk, as the processing loop does; returns the time taken in ns
+static uint64_t run_stats_kernel(stats_kernel_t kernel, const unsigned char *buffer, byte_stats_t *total)
+{
+    uint64_t start = ocre_time_ns();
+    total->sum = 0;
+    total->zeros = 0;
+    total->min = 255;
+    total->max = 0;
+    for (int chunk = 0; chunk < DATA_SIZE / CHUNK_SIZE; chunk++) {
+        byte_stats_t stats;
+        kernel(buffer + chunk * CHUNK_SIZE, CHUNK_SIZE, &stats);
+        total->sum += stats.sum;
+        total->zeros += stats.zeros;
+        if (stats.min < total->min) total->min = stats.min;
+        if (stats.max > total->max) total->max = stats.max;
+    }
+    return ocre_time_ns() - start;
+}
+
+static double rate_mb_s(uint64_t ns)
+{
+    return ns ? (double)DATA_SIZE / (1024 * 1024) / ((double)ns / 1e9) : 0.0;
+}
+
 // Generate test data and perform computations to create ~1MB output
 int main()
 {  
@@ -82,7 +188,8 @@ int main()
            large_data_array4[123], lookup_table[100]);
 
     // Allocate memory for our big data processing
-    char *buffer = malloc(DATA_SIZE);
+    ocre_arena_init(&work_arena, work_storage, sizeof(work_storage), "big-sample");
+    char *buffer = ocre_arena_alloc(&work_arena, DATA_SIZE);
     if (!buffer) {
         printf("ERROR: Failed to allocate %d bytes\n", DATA_SIZE);
         return 1;
@@ -94,21 +201,46 @@ int main()
         buffer[i] = (char)((i * 7 + 42) % 256);
     }
 
+#ifdef __wasm_simd128__
+    printf("Statistics kernels: scalar and SIMD128\n");
+#else
+    printf("Statistics kernels: scalar only, configure with -DOCRE_SIMD=ON to compare with SIMD128\n");
+#endif
     printf("Starting data processing iterations...\n");
+    uint64_t scalar_total_ns = 0;
+#ifdef __wasm_simd128__
+    uint64_t simd_total_ns = 0;
+#endif
     
     // Perform multiple iterations of data processing
     for (int iter = 0; iter < ITERATIONS; iter++) {
         printf("\n--- ITERATION %d/%d ---\n", iter + 1, ITERATIONS);
         
-        // Process data in chunks
-        unsigned long checksum = 0;
-        int zero_count = 0;
-        int max_value = 0;
-        int min_value = 255;
+        // Checksum and statistics of the whole buffer, timed per kernel
+        byte_stats_t stats;
+        uint64_t scalar_ns = run_stats_kernel(byte_stats_scalar, (const unsigned char *)buffer, &stats);
+        scalar_total_ns += scalar_ns;
+#ifdef __wasm_simd128__
+        byte_stats_t simd_stats;
+        uint64_t simd_ns = run_stats_kernel(byte_stats_simd, (const unsigned char *)buffer, &simd_stats);
+        simd_total_ns += simd_ns;
+        if (simd_stats.sum != stats.sum || simd_stats.zeros != stats.zeros ||
+            simd_stats.min != stats.min || simd_stats.max != stats.max) {
+            printf("ERROR: SIMD statistics differ: checksum 0x%08X, %u zeros, range %u - %u\n",
+                   (unsigned)simd_stats.sum, (unsigned)simd_stats.zeros, simd_stats.min, simd_stats.max);
+            return 1;
+        }
+#endif
         
+        // Process data in chunks
         for (int chunk = 0; chunk < DATA_SIZE / CHUNK_SIZE; chunk++) {
             int chunk_start = chunk * CHUNK_SIZE;
             unsigned char chunk_sum = 0;
+            if (chunk % 100 == 0) {
+                byte_stats_t chunk_stats;
+                byte_stats_scalar((const unsigned char *)buffer + chunk_start, CHUNK_SIZE, &chunk_stats);
+                chunk_sum = (unsigned char)chunk_stats.sum;
+            }
             
             // Use static arrays in processing to prevent optimization
             int array_index = chunk % 199999;
@@ -123,12 +255,6 @@ int main()
             // Analyze this chunk
             for (int i = 0; i < CHUNK_SIZE; i++) {
                 unsigned char byte_val = (unsigned char)buffer[chunk_start + i];
-                chunk_sum += byte_val;
-                checksum += byte_val;
-                
-                if (byte_val == 0) zero_count++;
-                if (byte_val > max_value) max_value = byte_val;
-                if (byte_val < min_value) min_value = byte_val;
                 
                 // Perform some mathematical operations
                 double sin_val = sin((double)byte_val / 255.0 * 3.14159);
@@ -146,11 +272,16 @@ int main()
         }
         
         printf("Iteration %d complete:\n", iter + 1);
-        printf("  Total checksum: 0x%08lX\n", checksum);
-        printf("  Zero bytes: %d\n", zero_count);
-        printf("  Value range: %d - %d\n", min_value, max_value);
-        printf("  Processing rate: %.2f MB/s (simulated)\n", 
-               (double)DATA_SIZE / (1024 * 1024) / (0.1 * (iter + 1)));
+        printf("  Total checksum: 0x%08X\n", (unsigned)stats.sum);
+        printf("  Zero bytes: %u\n", (unsigned)stats.zeros);
+        printf("  Value range: %u - %u\n", stats.min, stats.max);
+        printf("  Scalar statistics: %llu us, %.2f MB/s\n",
+               (unsigned long long)(scalar_ns / 1000), rate_mb_s(scalar_ns));
+#ifdef __wasm_simd128__
+        printf("  SIMD statistics: %llu us, %.2f MB/s, %.2fx scalar\n",
+               (unsigned long long)(simd_ns / 1000), rate_mb_s(simd_ns),
+               simd_ns ? (double)scalar_ns / simd_ns : 0.0);
+#endif
         
         // Generate some hex dump output for verification
         printf("Sample data (first 256 bytes):\n");
@@ -211,9 +342,20 @@ int main()
         final_checksum += (unsigned char)buffer[i];
     }
     printf("0x%08lX\n", final_checksum);
+    printf("Statistics kernels over %d iterations: scalar %.2f MB/s", ITERATIONS,
+           rate_mb_s(scalar_total_ns / ITERATIONS));
+#ifdef __wasm_simd128__
+    printf(", SIMD %.2f MB/s, speedup %.2fx", rate_mb_s(simd_total_ns / ITERATIONS),
+           simd_total_ns ? (double)scalar_total_ns / simd_total_ns : 0.0);
+#endif
+    printf("\n");
     
     printf("\nMemory cleanup...\n");
-    free(buffer);
+    ocre_sdk_stats_t stats;
+    ocre_sdk_get_stats(&stats);
+    printf("Arena: %u of %u bytes in use, high water %u\n",
+           stats.memory.in_use, stats.memory.capacity, stats.memory.high_water);
+    ocre_arena_reset(&work_arena);
     printf("Big sample execution completed successfully!\n");
     
     return 0;
@@ -11,6 +11,9 @@
 #include <stdbool.h>
 #include <ocre_api.h>
 
+// Resolved once in main() so the timer callback avoids a name lookup per blink
+static ocre_gpio_pin_t led0;
+
 // Timer callback function
 static void my_timer_function(void)
 {
@@ -19,8 +22,8 @@ static void my_timer_function(void)
     static int blink_count = 0;
 
     // Active-low: RESET (low) = ON, SET (high) = OFF
-    int ret = led_state ? ocre_gpio_set_by_name("led0", OCRE_GPIO_PIN_RESET)
-                        : ocre_gpio_set_by_name("led0", OCRE_GPIO_PIN_SET); 
+    int ret = led_state ? ocre_gpio_pin_set(led0.port, led0.pin, OCRE_GPIO_PIN_RESET)
+                        : ocre_gpio_pin_set(led0.port, led0.pin, OCRE_GPIO_PIN_SET);
 
     if (ret != 0)
     {
@@ -52,7 +55,8 @@ int main(void)
     // Configure LED 
     // "led0" - Device tree configuration must be available 
     // Or the application will not work 
-    if (ocre_gpio_configure_by_name("led0", OCRE_GPIO_DIR_OUTPUT) != 0)
+    if (ocre_gpio_resolve("led0", &led0) != 0 ||
+        ocre_gpio_configure(led0.port, led0.pin, OCRE_GPIO_DIR_OUTPUT) != 0)
     {
         printf("LED config failed\n");
         return -1;
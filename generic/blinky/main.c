@@ -59,8 +59,7 @@ int main(void)
 
     while (1)
     {
-        ocre_process_events();
-        ocre_sleep(10);
+        ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, OCRE_WAIT_FOREVER);
     }
 
     printf("Generic Blinky exiting.\n");
@@ -1,7 +1,22 @@
-// ipv4_tcp_echo_server_send_recv.c
+// Multi-client TCP echo server on WASI sockets, driven by poll()
+//
+// Environment:
+//   ECHO_QUIET=1          No greeting or per-message output, totals every 10 seconds instead
+//   ECHO_LOAD=<n>         Load mode: also drive n connections against ECHO_LOAD_HOST and
+//                         report connections handled and bytes per second, implies quiet
+//   ECHO_LOAD_HOST=<ip>   Server to load, default 127.0.0.1 (this container)
+//   ECHO_LOAD_SECONDS=<s> Load duration, default 10
+//   ECHO_LOAD_SIZE=<n>    Bytes per echoed message, default 512
+//   ECHO_LOAD_ROUNDS=<n>  Messages per load connection before it reconnects, default 100
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
@@ -9,80 +24,82 @@
 
 #define PORT 8000
 #define BUFFER_SIZE 1024
+#define MAX_CLIENTS 16
+#define MAX_LOAD_CONNECTIONS 8
+#define STATS_INTERVAL_MS 10000
 #define GREETING "\nHi there, I am an echo server! Whatever you type I will echo back to you.\n"
 
-void handle_client(int client_fd, struct sockaddr_in *client_addr)
-{
+typedef struct {
+    int fd;
+    size_t offset;  // Start of the bytes still to echo back in buffer
+    size_t pending; // Received bytes not yet echoed back
     char buffer[BUFFER_SIZE];
-    char client_msg[BUFFER_SIZE];
-    ssize_t bytes_received;
-    char client_ip[INET_ADDRSTRLEN];
+} client_t;
 
-    // Get client IP address
-    inet_ntop(AF_INET, &(client_addr->sin_addr), client_ip, INET_ADDRSTRLEN);
-    printf("Client connected from %s:%d\n", client_ip, ntohs(client_addr->sin_port));
-    printf("**********************************************\n");
-    fflush(stdout);
-
-    // Send greeting message
-    if (send(client_fd, GREETING, strlen(GREETING), 0) == -1) {
-        perror("send");
-        return;
-    }
+typedef struct {
+    int fd;
+    uint32_t rounds; // Messages echoed on this connection
+    size_t sent;     // Bytes of the current message sent
+    size_t received; // Bytes of the current message echoed back
+} load_conn_t;
 
-    // Echo loop
-    while ((bytes_received = recv(client_fd, buffer, BUFFER_SIZE, 0)) > 0) {
-        // Copy received data to client_msg
-        memcpy(client_msg, buffer, bytes_received);
-        client_msg[bytes_received] = '\0';
+static client_t clients[MAX_CLIENTS];
+static load_conn_t load_conns[MAX_LOAD_CONNECTIONS];
+static struct pollfd fds[1 + MAX_CLIENTS + MAX_LOAD_CONNECTIONS];
+static int fd_owner[1 + MAX_CLIENTS + MAX_LOAD_CONNECTIONS]; // Client index, or MAX_CLIENTS + load index
+static bool quiet;
 
-        // Strip trailing newlines and carriage returns
-        int len = strlen(client_msg);
-        while (len > 0 && (client_msg[len-1] == '\n' || client_msg[len-1] == '\r')) {
-            client_msg[--len] = '\0';
-        }
+// Server totals
+static int client_count;
+static uint64_t connections_accepted;
+static uint64_t bytes_echoed;
 
-        printf("You said: '%s'\n", client_msg);
-        fflush(stdout);
+// Load generator settings and totals
+static int load_connections;
+static struct sockaddr_in load_addr;
+static size_t load_size;
+static uint32_t load_rounds;
+static char load_message[BUFFER_SIZE];
+static char load_sink[BUFFER_SIZE];
+static uint64_t load_completed;
+static uint64_t load_failed;
+static uint64_t load_bytes;
 
-        // Echo back the message
-        if (send(client_fd, buffer, bytes_received, 0) == -1) {
-            perror("send");
-            break;
-        }
-    }
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-    if (bytes_received < 0) {
-        perror("recv");
-    }
+static int env_int(const char *name, int fallback)
+{
+    const char *value = getenv(name);
+    return value && value[0] ? atoi(value) : fallback;
+}
 
-    printf("Client disconnected.\n");
-    close(client_fd);
+static int set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
 }
 
-int main(void)
+static bool would_block(void)
 {
-    int server_fd, client_fd;
-    struct sockaddr_in server_addr, client_addr;
-    socklen_t client_len = sizeof(client_addr);
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
 
-    // Display startup banner
-    printf("\n**********************************************\n");
-    printf("Echo server starting...\n");
-    printf("Echo server listening on port %d\n", PORT);
-    printf("**********************************************\n");
-    printf("To connect:\n");
-    printf("1. Find this device's IP: net iface\n");
-    printf("2. Telnet to the device: telnet <IP> 8000\n");
-    printf("3. Type messages to test the echo server!\n");
-    printf("**********************************************\n");
-    fflush(stdout);
+// =============================================================================
+// SERVER
+// =============================================================================
 
-    // Create socket
-    server_fd = socket(AF_INET, SOCK_STREAM, 0); // IPv4 + TCP
+static int server_open(void)
+{
+    struct sockaddr_in server_addr;
+    int server_fd = socket(AF_INET, SOCK_STREAM, 0); // IPv4 + TCP
     if (server_fd < 0) {
         perror("socket");
-        return 1;
+        return -1;
     }
 
     // Configure server address
@@ -91,33 +108,372 @@ int main(void)
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(PORT);
 
-    // Bind socket to address
     if (bind(server_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
         perror("bind");
         close(server_fd);
-        return 1;
+        return -1;
     }
-
-    // Start listening for connections
-    if (listen(server_fd, 1) < 0) {
+    if (listen(server_fd, MAX_CLIENTS) < 0 || set_nonblocking(server_fd) < 0) {
         perror("listen");
         close(server_fd);
-        return 1;
+        return -1;
     }
+    return server_fd;
+}
+
+static void client_close(client_t *client)
+{
+    close(client->fd);
+    client->fd = -1;
+    client->pending = 0;
+    client_count--;
+    if (!quiet) {
+        printf("Client disconnected.\n");
+        fflush(stdout);
+    }
+}
+
+static void client_accept(int server_fd)
+{
+    struct sockaddr_in client_addr;
 
-    // Main server loop
     while (1) {
-        client_len = sizeof(client_addr);
-        client_fd = accept(server_fd, (struct sockaddr *)&client_addr, &client_len);
+        socklen_t client_len = sizeof(client_addr);
+        int fd = accept(server_fd, (struct sockaddr *)&client_addr, &client_len);
+        if (fd < 0) {
+            break;
+        }
+        client_t *client = NULL;
+        for (int i = 0; i < MAX_CLIENTS && client == NULL; i++) {
+            if (clients[i].fd < 0) {
+                client = &clients[i];
+            }
+        }
+        if (client == NULL || set_nonblocking(fd) < 0) {
+            if (!quiet) {
+                printf("Connection refused, %d clients connected\n", client_count);
+            }
+            close(fd);
+            continue;
+        }
+        client->fd = fd;
+        client->offset = 0;
+        client->pending = 0;
+        client_count++;
+        connections_accepted++;
+        if (!quiet) {
+            char client_ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
+            printf("Client connected from %s:%d (%d connected)\n", client_ip, ntohs(client_addr.sin_port),
+                   client_count);
+            printf("**********************************************\n");
+            fflush(stdout);
+            // Best effort, the socket buffer is empty on a new connection
+            send(fd, GREETING, strlen(GREETING), 0);
+        }
+    }
+    if (!would_block()) {
+        perror("accept");
+    }
+}
 
-        if (client_fd < 0) {
-            perror("accept");
+// Send what is left of the last received data, false once the client is closed
+static bool client_flush(client_t *client)
+{
+    while (client->pending > 0) {
+        ssize_t sent = send(client->fd, client->buffer + client->offset, client->pending, 0);
+        if (sent < 0) {
+            if (would_block()) {
+                return true; // Polled for POLLOUT until the rest went out
+            }
+            perror("send");
+            client_close(client);
+            return false;
+        }
+        client->offset += sent;
+        client->pending -= sent;
+        bytes_echoed += sent;
+    }
+    return true;
+}
+
+static void client_read(client_t *client)
+{
+    ssize_t bytes_received = recv(client->fd, client->buffer, BUFFER_SIZE, 0);
+    if (bytes_received <= 0) {
+        if (bytes_received < 0 && would_block()) {
+            return;
+        }
+        if (bytes_received < 0) {
+            perror("recv");
+        }
+        client_close(client);
+        return;
+    }
+    if (!quiet) {
+        // Strip trailing newlines and carriage returns
+        int len = (int)bytes_received;
+        while (len > 0 && (client->buffer[len - 1] == '\n' || client->buffer[len - 1] == '\r')) {
+            len--;
+        }
+        printf("You said: '%.*s'\n", len, client->buffer);
+        fflush(stdout);
+    }
+    client->offset = 0;
+    client->pending = bytes_received;
+    client_flush(client);
+}
+
+// =============================================================================
+// LOAD GENERATOR
+// =============================================================================
+
+static void load_open(load_conn_t *conn)
+{
+    memset(conn, 0, sizeof(*conn));
+    conn->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (conn->fd < 0) {
+        load_failed++;
+        return;
+    }
+    // Connect blocking: the handshake completes in the listen backlog, even if this
+    // container is the server
+    if (connect(conn->fd, (struct sockaddr *)&load_addr, sizeof(load_addr)) < 0 || set_nonblocking(conn->fd) < 0) {
+        close(conn->fd);
+        conn->fd = -1;
+        load_failed++;
+    }
+}
+
+static void load_close(load_conn_t *conn, bool reopen)
+{
+    close(conn->fd);
+    conn->fd = -1;
+    if (reopen) {
+        load_open(conn);
+    }
+}
+
+static void load_write(load_conn_t *conn)
+{
+    ssize_t sent = send(conn->fd, load_message + conn->sent, load_size - conn->sent, 0);
+    if (sent < 0) {
+        if (!would_block()) {
+            load_failed++;
+            load_close(conn, true);
+        }
+        return;
+    }
+    conn->sent += sent;
+}
+
+static void load_read(load_conn_t *conn)
+{
+    ssize_t received = recv(conn->fd, load_sink, sizeof(load_sink), 0);
+    if (received <= 0) {
+        if (received == 0 || !would_block()) {
+            load_failed++;
+            load_close(conn, true);
+        }
+        return;
+    }
+    load_bytes += received;
+    conn->received += received;
+    if (conn->received >= load_size) {
+        // Whole message echoed, start the next one or reconnect
+        conn->sent = 0;
+        conn->received = 0;
+        if (++conn->rounds >= load_rounds) {
+            load_completed++;
+            load_close(conn, true);
+        }
+    }
+}
+
+static int load_setup(void)
+{
+    const char *host = getenv("ECHO_LOAD_HOST");
+    memset(&load_addr, 0, sizeof(load_addr));
+    load_addr.sin_family = AF_INET;
+    load_addr.sin_port = htons(PORT);
+    if (inet_pton(AF_INET, host && host[0] ? host : "127.0.0.1", &load_addr.sin_addr) != 1) {
+        printf("Invalid ECHO_LOAD_HOST %s\n", host);
+        return -1;
+    }
+    if (load_connections > MAX_LOAD_CONNECTIONS) {
+        load_connections = MAX_LOAD_CONNECTIONS;
+    }
+    load_size = (size_t)env_int("ECHO_LOAD_SIZE", 512);
+    if (load_size == 0 || load_size > BUFFER_SIZE) {
+        load_size = BUFFER_SIZE;
+    }
+    load_rounds = (uint32_t)env_int("ECHO_LOAD_ROUNDS", 100);
+    if (load_rounds == 0) {
+        load_rounds = 1;
+    }
+    for (size_t i = 0; i < load_size; i++) {
+        load_message[i] = (char)('a' + i % 26);
+    }
+    for (int i = 0; i < load_connections; i++) {
+        load_open(&load_conns[i]);
+    }
+    return 0;
+}
+
+static void load_report(uint64_t elapsed_ms)
+{
+    double seconds = elapsed_ms > 0 ? elapsed_ms / 1000.0 : 1.0;
+    printf("Load: %d connections, %zu byte messages, %u per connection\n", load_connections, load_size,
+           load_rounds);
+    printf("Load: connections handled=%llu failed=%llu bytes=%llu seconds=%.1f\n",
+           (unsigned long long)load_completed, (unsigned long long)load_failed, (unsigned long long)load_bytes,
+           seconds);
+    printf("Load: %.0f bytes/s, %.1f connections/s\n", load_bytes / seconds, load_completed / seconds);
+}
+
+// =============================================================================
+// MAIN LOOP
+// =============================================================================
+
+static int poll_setup(int server_fd)
+{
+    int nfds = 0;
+    if (server_fd >= 0) {
+        fds[nfds].fd = server_fd;
+        fds[nfds].events = POLLIN;
+        fd_owner[nfds++] = -1;
+    }
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].fd >= 0) {
+            // Stop reading while an echo is stuck, until the client reads it
+            fds[nfds].fd = clients[i].fd;
+            fds[nfds].events = clients[i].pending > 0 ? POLLOUT : POLLIN;
+            fd_owner[nfds++] = i;
+        }
+    }
+    for (int i = 0; i < load_connections; i++) {
+        if (load_conns[i].fd >= 0) {
+            fds[nfds].fd = load_conns[i].fd;
+            fds[nfds].events = POLLIN | (load_conns[i].sent < load_size ? POLLOUT : 0);
+            fd_owner[nfds++] = MAX_CLIENTS + i;
+        }
+    }
+    for (int i = 0; i < nfds; i++) {
+        fds[i].revents = 0;
+    }
+    return nfds;
+}
+
+static void poll_dispatch(int nfds)
+{
+    for (int i = 0; i < nfds; i++) {
+        short revents = fds[i].revents;
+        int owner = fd_owner[i];
+        if (revents == 0) {
             continue;
         }
+        if (owner < 0) {
+            client_accept(fds[i].fd);
+        } else if (owner < MAX_CLIENTS) {
+            client_t *client = &clients[owner];
+            if (client->pending > 0) {
+                client_flush(client);
+            } else {
+                client_read(client);
+            }
+        } else {
+            load_conn_t *conn = &load_conns[owner - MAX_CLIENTS];
+            if (conn->fd >= 0 && (revents & POLLOUT)) {
+                load_write(conn);
+            }
+            if (conn->fd >= 0 && (revents & (POLLIN | POLLHUP | POLLERR))) {
+                load_read(conn);
+            }
+        }
+    }
+}
 
-        handle_client(client_fd, &client_addr);
+int main(void)
+{
+    load_connections = env_int("ECHO_LOAD", 0);
+    quiet = env_int("ECHO_QUIET", 0) != 0 || load_connections > 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
     }
 
-    close(server_fd);
+    // Display startup banner
+    printf("\n**********************************************\n");
+    printf("Echo server starting...\n");
+    printf("Echo server listening on port %d, up to %d clients\n", PORT, MAX_CLIENTS);
+    printf("**********************************************\n");
+    if (!quiet) {
+        printf("To connect:\n");
+        printf("1. Find this device's IP: net iface\n");
+        printf("2. Telnet to the device: telnet <IP> 8000\n");
+        printf("3. Type messages to test the echo server!\n");
+        printf("**********************************************\n");
+    }
+    fflush(stdout);
+
+    int server_fd = server_open();
+    if (server_fd < 0) {
+        if (load_connections == 0) {
+            return 1;
+        }
+        printf("Not serving, only generating load\n");
+    }
+    if (load_connections > 0 && load_setup() < 0) {
+        return 1;
+    }
+
+    uint64_t start = now_ms();
+    uint64_t load_end = start + (uint64_t)env_int("ECHO_LOAD_SECONDS", 10) * 1000;
+    uint64_t next_stats = start + STATS_INTERVAL_MS;
+    uint64_t last_bytes = 0;
+
+    while (1) {
+        uint64_t now = now_ms();
+        if (load_connections > 0 && now >= load_end) {
+            load_report(now - start);
+            break;
+        }
+        if (quiet && now >= next_stats) {
+            if (bytes_echoed != last_bytes) {
+                printf("Server: clients=%d connections=%llu bytes=%llu (%.0f bytes/s)\n", client_count,
+                       (unsigned long long)connections_accepted, (unsigned long long)bytes_echoed,
+                       (bytes_echoed - last_bytes) * 1000.0 / STATS_INTERVAL_MS);
+                fflush(stdout);
+                last_bytes = bytes_echoed;
+            }
+            next_stats = now + STATS_INTERVAL_MS;
+        }
+
+        int nfds = poll_setup(server_fd);
+        uint64_t wake = load_connections > 0 && load_end < next_stats ? load_end : next_stats;
+        int timeout = quiet ? (int)(wake - now) : -1;
+        int ready = poll(fds, nfds, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+        poll_dispatch(nfds);
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].fd >= 0) {
+            close(clients[i].fd);
+        }
+    }
+    for (int i = 0; i < load_connections; i++) {
+        if (load_conns[i].fd >= 0) {
+            close(load_conns[i].fd);
+        }
+    }
+    if (server_fd >= 0) {
+        close(server_fd);
+    }
     return 0;
 }
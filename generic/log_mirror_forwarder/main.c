@@ -1,6 +1,8 @@
-// main.c – WebSocket push, MQTT-safe publish, 200-line window, status endpoint
+// main.c – Batched WebSocket push and MQTT publish, fixed-size line window, status endpoint
 // Mongoose 7.x
 #include "mongoose.h"
+#include "ocre_api.h"
+#include "ocre_assets.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,17 +11,46 @@
 #include <pthread.h>
 
 #define LOG_FILE      "/log/syslog"
-#define WEB_ROOT      "/web"
 #define DEFAULT_LINES 200
-#define MAX_RESPONSE  (512 * 1024)
+#ifndef LOG_WINDOW_LINES
+#define LOG_WINDOW_LINES DEFAULT_LINES
+#endif
+#ifndef LOG_WINDOW_BYTES
+#define LOG_WINDOW_BYTES (LOG_WINDOW_LINES * 128)  // Oldest lines are dropped early if lines run longer
+#endif
+// New lines are forwarded in batches, flushed when any of these limits is reached
+#ifndef LOG_BATCH_LINES
+#define LOG_BATCH_LINES 64
+#endif
+#ifndef LOG_BATCH_BYTES
+#define LOG_BATCH_BYTES 4096
+#endif
+#ifndef LOG_BATCH_MS
+#define LOG_BATCH_MS 100
+#endif
+#if LOG_BATCH_LINES > LOG_WINDOW_LINES || LOG_BATCH_BYTES > LOG_WINDOW_BYTES / 2
+#error "A pending batch must fit in the line window"
+#endif
+#define LOG_POLL_MS   200  // Tail period when the runtime has no file watches
 #define MQTT_HOST_DEFAULT "127.0.0.1"
 #define MQTT_PORT_DEFAULT 1883
 
-// ===== In-memory ring (last 200 lines) =====
-static char *lines[DEFAULT_LINES];
-static int line_count = 0;
+// ===== In-memory ring (last LOG_WINDOW_LINES lines) =====
+// Lines are stored back to back in one byte ring. Positions count bytes ever
+// written, so a position maps to ring[pos % LOG_WINDOW_BYTES] and the window is
+// always [line_start[first_line], ring_end), at most two contiguous slices.
+static char ring[LOG_WINDOW_BYTES];
+static uint64_t line_start[LOG_WINDOW_LINES];  // Indexed by line number % LOG_WINDOW_LINES
+static uint64_t first_line = 0, line_count = 0;
+static uint64_t ring_end = 0;
 pthread_mutex_t line_lock = PTHREAD_MUTEX_INITIALIZER;
 
+// ===== Pending batch =====
+// Lines not yet forwarded are the tail of the ring, [batch_start, ring_end)
+static uint64_t batch_start = 0;
+static uint32_t batch_lines = 0;
+static uint64_t batch_since_ms = 0;
+
 // ===== MQTT state =====
 static struct mg_connection *mqtt_conn = NULL;
 static int mqtt_ready = 0;
@@ -28,93 +59,145 @@ static int mqtt_port = MQTT_PORT_DEFAULT;
 
 // ===== WebSocket state =====
 static int ws_clients = 0;
-struct qnode { char *s; size_t n; struct qnode *next; };
-static struct { struct qnode *head, *tail; pthread_mutex_t mu; } wsq = {NULL, NULL, PTHREAD_MUTEX_INITIALIZER};
-
-// Forward decls
-static void ws_enqueue_line(const char *line, size_t len);
-static void ws_broadcast_pending(struct mg_mgr *mgr);
 
 // ===== Utilities =====
-static size_t tail_last_n_lines(const char *path, int keep, char *out, size_t cap) {
-  int fd = open(path, O_RDONLY);
-  if (fd < 0) return 0;
+// Offset in fd where its last `keep` lines begin
+static off_t tail_offset(int fd, int keep) {
   off_t end = lseek(fd, 0, SEEK_END);
-  if (end < 0) { close(fd); return 0; }
-  const size_t BUFSZ = 4096;
-  char buf[BUFSZ];
+  if (end < 0) return -1;
+  char buf[512];
   off_t pos = end;
   int nl = 0;
 
-  while (pos > 0 && nl <= keep) {
-    size_t chunk = (pos >= (off_t) BUFSZ) ? BUFSZ : (size_t) pos;
+  while (pos > 0) {
+    size_t chunk = (pos >= (off_t) sizeof(buf)) ? sizeof(buf) : (size_t) pos;
     pos -= chunk;
-    if (lseek(fd, pos, SEEK_SET) < 0) break;
+    if (lseek(fd, pos, SEEK_SET) < 0) return -1;
     ssize_t r = read(fd, buf, chunk);
-    if (r <= 0) break;
+    if (r <= 0) return -1;
     for (ssize_t i = r - 1; i >= 0; --i) {
-      if (buf[i] == '\n' && ++nl > keep) { pos += i + 1; goto found; }
+      if (buf[i] == '\n' && ++nl > keep) return pos + i + 1;
     }
   }
-found:
-  if (pos < 0) pos = 0;
-  if (lseek(fd, pos, SEEK_SET) < 0) { close(fd); return 0; }
-  size_t total = 0;
-  for (;;) {
-    ssize_t r = read(fd, buf, BUFSZ);
-    if (r <= 0) break;
-    size_t to_copy = (size_t) r;
-    if (total + to_copy > cap) to_copy = cap - total;
-    memcpy(out + total, buf, to_copy);
-    total += to_copy;
-    if (total >= cap) break;
-  }
-  close(fd);
-  return total;
+  return 0;
+}
+
+static void ring_copy_in(uint64_t pos, const char *src, size_t len) {
+  size_t off = (size_t) (pos % LOG_WINDOW_BYTES);
+  size_t first = LOG_WINDOW_BYTES - off < len ? LOG_WINDOW_BYTES - off : len;
+  memcpy(ring + off, src, first);
+  memcpy(ring, src + first, len - first);
+}
+
+// Bytes in [from, to) of the ring as up to two slices, returns the slice count
+static int ring_slices(uint64_t from, uint64_t to, struct mg_str out[2]) {
+  size_t off = (size_t) (from % LOG_WINDOW_BYTES), len = (size_t) (to - from);
+  size_t first = LOG_WINDOW_BYTES - off < len ? LOG_WINDOW_BYTES - off : len;
+  out[0] = mg_str_n(ring + off, first);
+  out[1] = mg_str_n(ring, len - first);
+  return len == 0 ? 0 : (len > first ? 2 : 1);
+}
+
+// Queues ring bytes [from, to) to c as one WebSocket text frame
+static void ws_send_range(struct mg_connection *c, uint64_t from, uint64_t to) {
+  struct mg_str parts[2];
+  int n = ring_slices(from, to, parts);
+  for (int i = 0; i < n; i++) mg_send(c, parts[i].buf, parts[i].len);
+  mg_ws_wrap(c, (size_t) (to - from), WEBSOCKET_OP_TEXT);
 }
 
 // Store a line into the in-memory ring ONLY (no MQTT/WS side-effects)
 static void store_line_only(const char *line, size_t len) {
+  if (len > LOG_WINDOW_BYTES) {
+    line += len - LOG_WINDOW_BYTES;  // Keep the end of an oversized line
+    len = LOG_WINDOW_BYTES;
+  }
   pthread_mutex_lock(&line_lock);
-  if (line_count == DEFAULT_LINES) {
-    free(lines[0]);
-    memmove(lines, lines + 1, sizeof(lines[0]) * (DEFAULT_LINES - 1));
+  // Drop the oldest lines until both the index and the bytes have room
+  while (line_count == LOG_WINDOW_LINES ||
+         (line_count > 0 && ring_end + len - line_start[first_line % LOG_WINDOW_LINES] > LOG_WINDOW_BYTES)) {
+    first_line++;
     line_count--;
   }
-  lines[line_count++] = strndup(line, len);
+  ring_copy_in(ring_end, line, len);
+  line_start[(first_line + line_count++) % LOG_WINDOW_LINES] = ring_end;
+  ring_end += len;
   pthread_mutex_unlock(&line_lock);
 }
 
-// Publish a line to MQTT if connected
-static void mqtt_publish_line(const char *line, size_t len) {
+// Publish ring bytes [from, to) to MQTT if connected. This is mg_mqtt_pub() for
+// QoS 0 over MQTT 3.1.1, writing the payload from the ring slices in place.
+static void mqtt_publish_range(uint64_t from, uint64_t to) {
   if (mqtt_ready && mqtt_conn) {
-    struct mg_mqtt_opts pub = {0};
-    pub.topic = mg_str("demo/syslog/lines");
-    pub.message = mg_str_n(line, len);
-    mg_mqtt_pub(mqtt_conn, &pub);
+    struct mg_str topic = mg_str("demo/syslog/lines"), parts[2];
+    uint8_t topic_len[2] = {(uint8_t) (topic.len >> 8), (uint8_t) topic.len};
+    int n = ring_slices(from, to, parts);
+    mg_mqtt_send_header(mqtt_conn, MQTT_CMD_PUBLISH, 0, (uint32_t) (2 + topic.len + (to - from)));
+    mg_send(mqtt_conn, topic_len, sizeof(topic_len));
+    mg_send(mqtt_conn, topic.buf, topic.len);
+    for (int i = 0; i < n; i++) mg_send(mqtt_conn, parts[i].buf, parts[i].len);
   }
 }
 
-// Process a NEW line: store + publish (if ready) + enqueue for WS
-static void process_new_line(const char *line, size_t len) {
+// Forward the pending batch as one WS frame per client and one MQTT publish
+static void batch_flush(struct mg_mgr *mgr) {
+  if (batch_lines == 0) return;
+  if (batch_lines < LOG_BATCH_LINES && ring_end - batch_start < LOG_BATCH_BYTES &&
+      mg_millis() - batch_since_ms < LOG_BATCH_MS) return;
+
+  pthread_mutex_lock(&line_lock);
+  uint64_t oldest = line_start[first_line % LOG_WINDOW_LINES];
+  if (batch_start < oldest) batch_start = oldest;  // A burst outran the window, forward what is left
+  mqtt_publish_range(batch_start, ring_end);
+  for (struct mg_connection *c = mgr->conns; c != NULL; c = c->next) {
+    if (c->is_websocket) ws_send_range(c, batch_start, ring_end);
+  }
+  batch_lines = 0;
+  pthread_mutex_unlock(&line_lock);
+}
+
+// Process a NEW line: store + add to the pending batch, forwarded once it is full
+static void process_new_line(const char *line, size_t len, void *arg) {
+  if (batch_lines == 0) {
+    batch_start = ring_end;
+    batch_since_ms = mg_millis();
+  }
   store_line_only(line, len);
-  mqtt_publish_line(line, len);
-  ws_enqueue_line(line, len);
+  batch_lines++;
+  batch_flush((struct mg_mgr *) arg);
 }
 
-static void preload_last_lines() {
-  static char buf[MAX_RESPONSE];
-  size_t nbytes = tail_last_n_lines(LOG_FILE, DEFAULT_LINES, buf, sizeof(buf));
-  char *p = buf, *line = p, *end = buf + nbytes;
-  for (; p < end; p++) {
-    if (*p == '\n') {
-      size_t len = (size_t) (p - line + 1);
-      store_line_only(line, len);     // PRELOAD: store only, no MQTT/WS
-      line = p + 1;
+
+// Splits buf into lines, carrying a partial line over to the next call
+static void feed_lines(const char *buf, size_t n, void (*fn)(const char *, size_t, void *), void *arg) {
+  static size_t linelen = 0;
+  static char linebuf[4096];
+  for (size_t i = 0; i < n; i++) {
+    linebuf[linelen++] = buf[i];
+    if (buf[i] == '\n' || linelen == sizeof(linebuf)) {
+      if (linebuf[linelen - 1] != '\n') linebuf[linelen - 1] = '\n';
+      fn(linebuf, linelen, arg);
+      linelen = 0;
     }
   }
 }
 
+static void preload_line(const char *line, size_t len, void *arg) {
+  (void) arg;
+  store_line_only(line, len);  // PRELOAD: store only, no MQTT/WS
+}
+
+// Reads the last lines straight into the ring, leaving fd at the end of the file
+static void preload_last_lines(int fd) {
+  off_t pos = tail_offset(fd, LOG_WINDOW_LINES);
+  if (pos < 0 || lseek(fd, pos, SEEK_SET) < 0) return;
+  char buf[512];
+  ssize_t r;
+  while ((r = read(fd, buf, sizeof(buf))) > 0) {
+    feed_lines(buf, (size_t) r, preload_line, NULL);
+  }
+}
+
 // ===== MQTT =====
 static void mqtt_handler(struct mg_connection *c, int ev, void *ev_data) {
   (void) ev_data;
@@ -169,18 +252,41 @@ static void serve_status(struct mg_connection *c) {
   );
 }
 
+// The page is packed from web_root/ into the module at build time by ocre_add_assets()
+extern const ocre_asset_bundle_t web_assets;
+
+// Served from memory and revalidated by ETag, so a reload costs a 304
+static void serve_static(struct mg_connection *c, struct mg_http_message *hm) {
+  const ocre_asset_t *asset = ocre_asset_find(&web_assets, hm->uri.buf, hm->uri.len);
+  struct mg_str *ae = mg_http_get_header(hm, "Accept-Encoding");
+  struct mg_str *inm = mg_http_get_header(hm, "If-None-Match");
+  ocre_asset_body_t body;
+
+  if (asset == NULL ||
+      ocre_asset_select(&web_assets, asset, ae != NULL && mg_match(*ae, mg_str("#gzip#"), NULL), &body) != OCRE_SUCCESS) {
+    mg_http_reply(c, 404, "Content-Type: text/plain\r\n", "Not found\n");
+  } else if (inm != NULL && ocre_asset_etag_match(body.etag, inm->buf, inm->len)) {
+    mg_printf(c, "HTTP/1.1 304 Not Modified\r\nEtag: %s\r\nCache-Control: no-cache\r\n"
+              "Vary: Accept-Encoding\r\nContent-Length: 0\r\n\r\n", body.etag);
+  } else {
+    mg_printf(c, "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n%s%s%sEtag: %s\r\nCache-Control: no-cache\r\n"
+              "Vary: Accept-Encoding\r\nContent-Length: %lu\r\n\r\n",
+              asset->mime, body.encoding ? "Content-Encoding: " : "", body.encoding ? body.encoding : "",
+              body.encoding ? "\r\n" : "", body.etag, (unsigned long) body.size);
+    if (mg_strcmp(hm->method, mg_str("HEAD")) != 0) mg_send(c, body.data, body.size);
+  }
+}
+
 static void serve_log(struct mg_connection *c) {
-  // Respond with the last 200 lines (ephemeral window)
+  // Respond with the line window, sent straight from the ring
+  struct mg_str parts[2];
   pthread_mutex_lock(&line_lock);
-  size_t total = 0;
-  for (int i = 0; i < line_count; i++) total += strlen(lines[i]);
-  char *resp = (char *) malloc(total + 1);
-  if (!resp) { pthread_mutex_unlock(&line_lock); mg_http_reply(c, 500, "", "OOM\n"); return; }
-  resp[0] = 0;
-  for (int i = 0; i < line_count; i++) strcat(resp, lines[i]);
+  uint64_t from = line_count ? line_start[first_line % LOG_WINDOW_LINES] : ring_end;
+  int n = ring_slices(from, ring_end, parts);
+  mg_printf(c, "HTTP/1.1 200 OK\r\nContent-Type: text/plain; charset=utf-8\r\nCache-Control: no-store\r\n"
+               "Content-Length: %lu\r\n\r\n", (unsigned long) (ring_end - from));
+  for (int i = 0; i < n; i++) mg_send(c, parts[i].buf, parts[i].len);
   pthread_mutex_unlock(&line_lock);
-  mg_http_reply(c, 200, "Content-Type: text/plain; charset=utf-8\r\nCache-Control: no-store\r\n", "%s", resp);
-  free(resp);
 }
 
 static void serve_download(struct mg_connection *c, struct mg_http_message *hm) {
@@ -191,37 +297,6 @@ static void serve_download(struct mg_connection *c, struct mg_http_message *hm)
   mg_http_serve_file(c, hm, LOG_FILE, &opts);
 }
 
-// ===== WS queue helpers =====
-static void ws_enqueue_line(const char *line, size_t len) {
-  struct qnode *nn = (struct qnode *) malloc(sizeof(*nn));
-  if (!nn) return;
-  nn->s = (char *) malloc(len);
-  if (!nn->s) { free(nn); return; }
-  memcpy(nn->s, line, len);
-  nn->n = len;
-  nn->next = NULL;
-  pthread_mutex_lock(&wsq.mu);
-  if (wsq.tail) { wsq.tail->next = nn; wsq.tail = nn; }
-  else { wsq.head = wsq.tail = nn; }
-  pthread_mutex_unlock(&wsq.mu);
-}
-
-static void ws_broadcast_pending(struct mg_mgr *mgr) {
-  for (;;) {
-    pthread_mutex_lock(&wsq.mu);
-    struct qnode *n = wsq.head;
-    if (n) { wsq.head = n->next; if (!wsq.head) wsq.tail = NULL; }
-    pthread_mutex_unlock(&wsq.mu);
-    if (!n) break;
-
-    for (struct mg_connection *c = mgr->conns; c != NULL; c = c->next) {
-      if (c->is_websocket) mg_ws_send(c, n->s, n->n, WEBSOCKET_OP_TEXT);
-    }
-    free(n->s);
-    free(n);
-  }
-}
-
 // ===== HTTP/WS handler =====
 static void ev_handler(struct mg_connection *c, int ev, void *ev_data) {
   switch (ev) {
@@ -241,21 +316,19 @@ static void ev_handler(struct mg_connection *c, int ev, void *ev_data) {
       if (mg_match(hm->uri, mg_str("/config"), NULL)) { serve_config(c, hm, c->mgr); return; }
       if (mg_match(hm->uri, mg_str("/status"), NULL)) { serve_status(c); return; }
 
-      struct mg_http_serve_opts opts = {
-        .root_dir = WEB_ROOT,
-        .extra_headers = "Cache-Control: no-store\r\n"
-      };
-      mg_http_serve_dir(c, hm, &opts);
+      serve_static(c, hm);
       break;
     }
     case MG_EV_WS_OPEN:
       ws_clients++;
       fprintf(stderr, "[WS] Client connected (total %d)\n", ws_clients);
 
-      // Send the backlog immediately
+      // Send the backlog immediately as one frame. Pending lines follow with the next batch.
       pthread_mutex_lock(&line_lock);
-      for (int i = 0; i < line_count; i++) {
-        mg_ws_send(c, lines[i], strlen(lines[i]), WEBSOCKET_OP_TEXT);
+      {
+        uint64_t from = line_count ? line_start[first_line % LOG_WINDOW_LINES] : ring_end;
+        uint64_t to = batch_lines ? batch_start : ring_end;
+        if (to > from) ws_send_range(c, from, to);
       }
       pthread_mutex_unlock(&line_lock);
       break;
@@ -277,13 +350,37 @@ static void ev_handler(struct mg_connection *c, int ev, void *ev_data) {
   }
 }
 
-// ===== Log tail timer =====
+// ===== Log tailing =====
+// The host reports appends to LOG_FILE through a file watch, so the container sleeps
+// while the log is idle. Runtimes without file watches fall back to a timer.
 static int log_fd = -1;
-static size_t linelen = 0;
-static char linebuf[4096];
+static ocre_file_watch_t log_watch;
+
+// Read everything appended since the last call
+static void log_read_available(struct mg_mgr *mgr) {
+  static char buf[4096];
+  ssize_t r;
+  while (log_fd >= 0 && (r = read(log_fd, buf, sizeof(buf))) > 0) {
+    feed_lines(buf, (size_t) r, process_new_line, mgr);
+  }
+}
+
+static void log_watch_fn(ocre_file_watch_t *watch, uint32_t changes, void *user_data) {
+  (void) watch;
+  if (changes & (OCRE_FILE_CHANGE_DELETED | OCRE_FILE_CHANGE_CREATED)) {
+    // Replaced or rotated away: follow the file now at the path from its start
+    if (log_fd >= 0) close(log_fd);
+    log_fd = open(LOG_FILE, O_RDONLY);
+    fprintf(stderr, "[LOG] %s %s\n", LOG_FILE, log_fd >= 0 ? "reopened" : "removed");
+  } else if (changes & OCRE_FILE_CHANGE_TRUNCATED) {
+    if (log_fd >= 0) lseek(log_fd, 0, SEEK_SET);
+  } else if (log_fd < 0) {
+    log_fd = open(LOG_FILE, O_RDONLY);
+  }
+  log_read_available((struct mg_mgr *) user_data);
+}
 
 static void log_timer_fn(void *arg) {
-  struct mg_mgr *mgr = (struct mg_mgr *) arg;
   if (log_fd < 0) {
     log_fd = open(LOG_FILE, O_RDONLY);
     if (log_fd >= 0) {
@@ -294,26 +391,13 @@ static void log_timer_fn(void *arg) {
       return;
     }
   }
-
-  char buf[512];
-  ssize_t r = read(log_fd, buf, sizeof(buf));
-  if (r > 0) {
-    for (ssize_t i = 0; i < r; i++) {
-      linebuf[linelen++] = buf[i];
-      if (buf[i] == '\n' || linelen == sizeof(linebuf)) {
-        if (linebuf[linelen - 1] != '\n') linebuf[linelen - 1] = '\n';
-        process_new_line(linebuf, linelen);
-        linelen = 0;
-      }
-    }
-  }
-  // else nothing new: timer will fire again
+  log_read_available((struct mg_mgr *) arg);
 }
 
-
 int main(void) {
   setvbuf(stdout, NULL, _IONBF, 0);
-  preload_last_lines();
+  log_fd = open(LOG_FILE, O_RDONLY);
+  if (log_fd >= 0) preload_last_lines(log_fd);
 
   struct mg_mgr mgr;
   mg_mgr_init(&mgr);
@@ -322,7 +406,7 @@ int main(void) {
     fprintf(stderr, "Failed to listen on %s\n", addr);
     return 1;
   }
-  fprintf(stderr, "Serving static from %s and log from %s on %s\n", WEB_ROOT, LOG_FILE, addr);
+  fprintf(stderr, "Serving %lu static files and log from %s on %s\n", (unsigned long) web_assets.count, LOG_FILE, addr);
 
   // Threads not working for now
   // pthread_t tid;
@@ -335,12 +419,18 @@ int main(void) {
   // thr_ret = pthread_detach(tid);
   // printf("pthread_detach returned %d\n", thr_ret);
 
-  // New: poll every 200 ms
-  mg_timer_add(&mgr, 200, MG_TIMER_REPEAT, log_timer_fn, &mgr);
+  if (ocre_file_watch_start(&log_watch, LOG_FILE, OCRE_FILE_CHANGE_ALL, 0, log_watch_fn, &mgr) == OCRE_SUCCESS) {
+    fprintf(stderr, "[LOG] Watching %s for changes\n", LOG_FILE);
+  } else {
+    mg_timer_add(&mgr, LOG_POLL_MS, MG_TIMER_REPEAT, log_timer_fn, &mgr);
+  }
 
+  // mg_mgr_poll() waits in ocre_poll(), so file watch events wake it like sockets do.
+  // Only a pending batch needs a deadline.
   for (;;) {
-    mg_mgr_poll(&mgr, 100);
-    ws_broadcast_pending(&mgr);
+    mg_mgr_poll(&mgr, batch_lines ? LOG_BATCH_MS : 1000);
+    ocre_process_events_ex(OCRE_EVENT_FLAG_NONE, 0);
+    batch_flush(&mgr);
   }
   mg_mgr_free(&mgr);
   return 0;
@@ -6,19 +6,27 @@
 
  */
 #include <ocre_api.h>
+#include <ocre_cbor.h>
 #include <stdio.h>
 #include <string.h>
 
 #define TIMER_ID 1
 #define TOPIC "temperature/inside"
-#define CONTENT_TYPE "text/plain"
+#define CONTENT_TYPE OCRE_CBOR_CONTENT_TYPE
 
 void timer_handler(void);
 
+static int topic_handle;
+
 // WASM entry point
 int main(void)
 {
   setvbuf(stdout, NULL, _IONBF, 0); 
+  topic_handle = ocre_topic_open(TOPIC, CONTENT_TYPE);
+  if (topic_handle < 0)
+  {
+    printf("Failed to open topic %s\n", TOPIC);
+  }
   if (ocre_timer_create(TIMER_ID) != OCRE_SUCCESS)
   {
     printf("Failed to create timer %d\n", TIMER_ID);
@@ -42,11 +50,18 @@ int main(void)
 void timer_handler(void)
 {
   static int message_count = 0;
-  char payload[32];
-  snprintf(payload, sizeof(payload), "Temperature inside %d", message_count++);
-  if (ocre_publish_message(TOPIC, CONTENT_TYPE, payload, strlen(payload) + 1) == OCRE_SUCCESS)
+  uint8_t payload[OCRE_CBOR_READING_MAX_LEN];
+  ocre_cbor_writer_t writer;
+  ocre_cbor_reading_t reading = {
+      .channel = TIMER_ID,
+      .timestamp_us = ocre_time_us(),
+      .value = message_count++,
+  };
+  ocre_cbor_writer_init(&writer, payload, sizeof(payload));
+  ocre_cbor_put_reading(&writer, &reading);
+  if (ocre_publish_by_handle(topic_handle, payload, writer.len) == OCRE_SUCCESS)
   {
-    printf("Published: %s to topic %s\n", payload, TOPIC);
+    printf("Published: temperature inside %g (%u bytes) to topic %s\n", reading.value, writer.len, TOPIC);
   }
   else
   {
@@ -6,10 +6,15 @@
 
  */
 #include <ocre_api.h>
+#include <ocre_cbor.h>
 #include <stdio.h>
 #include <string.h>
 
 #define TOPIC "temperature/"
+#define CONTENT_TYPE OCRE_CBOR_CONTENT_TYPE
+
+// Known publishers' topics, opened so their messages arrive as topic handles
+static const char *known_topics[] = {"temperature/inside", "temperature/outside"};
 
 void message_handler(const char *topic, const char *content_type, const void *payload, uint32_t payload_len);
 
@@ -23,6 +28,14 @@ int main(void)
     printf("Error: Failed to register message callback for %s\n", TOPIC);
   }
 
+  for (size_t i = 0; i < sizeof(known_topics) / sizeof(known_topics[0]); i++)
+  {
+    if (ocre_topic_open(known_topics[i], CONTENT_TYPE) < 0)
+    {
+      printf("Error: Failed to open topic %s\n", known_topics[i]);
+    }
+  }
+
   ret = ocre_subscribe_message(TOPIC);
   if (ret != OCRE_SUCCESS)
   {
@@ -40,7 +53,22 @@ int main(void)
 
 void message_handler(const char *topic, const char *content_type, const void *payload, uint32_t payload_len)
 {
-  if (topic && content_type && payload)
+  ocre_cbor_reader_t reader;
+  ocre_cbor_reading_t reading;
+  if (topic && content_type && payload && strcmp(content_type, OCRE_CBOR_CONTENT_TYPE) == 0)
+  {
+    ocre_cbor_reader_init(&reader, payload, payload_len);
+    if (ocre_cbor_get_reading(&reader, &reading) == OCRE_SUCCESS)
+    {
+      printf("Received reading: topic=%s, channel=%u, timestamp=%llu us, value=%g\n",
+             topic, reading.channel, (unsigned long long)reading.timestamp_us, reading.value);
+    }
+    else
+    {
+      printf("Malformed reading on topic %s\n", topic);
+    }
+  }
+  else if (topic && content_type && payload)
   {
     printf("Received message: topic=%s, content_type=%s, payload=%s, len=%u\n",
            topic, content_type, (const char *)payload, payload_len);
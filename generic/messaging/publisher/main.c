@@ -15,10 +15,17 @@
 
 void timer_handler(void);
 
+static int topic_handle;
+
 // WASM entry point
 int main(void)
 {
   setvbuf(stdout, NULL, _IONBF, 0); 
+  topic_handle = ocre_topic_open(TOPIC, CONTENT_TYPE);
+  if (topic_handle < 0)
+  {
+    printf("Failed to open topic %s\n", TOPIC);
+  }
   if (ocre_timer_create(TIMER_ID) != OCRE_SUCCESS)
   {
     printf("Failed to create timer %d\n", TIMER_ID);
@@ -34,7 +41,7 @@ int main(void)
   printf("Publisher initialized: timer %d started, publishing to %s\n", TIMER_ID, TOPIC);
   while (1)
   {
-    ocre_process_events();
+    ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, OCRE_WAIT_FOREVER);
   }
   return 0;
 }
@@ -43,8 +50,14 @@ void timer_handler(void)
 {
   static int message_count = 0;
   char payload[32];
+  if (ocre_publish_credits(topic_handle) == 0)
+  {
+    // Subscribers are behind, skip this sample rather than have the broker drop it
+    printf("Subscribers busy, skipping message %d\n", message_count++);
+    return;
+  }
   snprintf(payload, sizeof(payload), "Test message %d", message_count++);
-  if (ocre_publish_message(TOPIC, CONTENT_TYPE, payload, strlen(payload) + 1) == OCRE_SUCCESS)
+  if (ocre_publish_by_handle(topic_handle, payload, strlen(payload) + 1) == OCRE_SUCCESS)
   {
     printf("Published: %s to topic %s\n", payload, TOPIC);
   }
@@ -33,7 +33,7 @@ int main(void)
   printf("Subscriber initialized: listening on %s\n", TOPIC);
   while (1)
   {
-    ocre_process_events();
+    ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, OCRE_WAIT_FOREVER);
   }
   return 0;
 }
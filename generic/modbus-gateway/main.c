@@ -0,0 +1,168 @@
+#include "mongoose.h"
+#include "ocre_api.h"
+#include "ocre_modbus.h"
+
+#define GATEWAY_POLL_MS       100    // Poll period of every device
+#define GATEWAY_TIMEOUT_MS    500    // Per-request timeout
+#define GATEWAY_RECONNECT_MS  2000
+#define GATEWAY_REPORT_MS     5000
+#define GATEWAY_MAX_INFLIGHT  4      // Outstanding transactions per connection
+#define GATEWAY_MAX_GAP       4      // Registers bridged when merging ranges
+#define GATEWAY_MAX_BLOCKS    4
+
+// Register layout of the b_u585i_iot02a modbus-server sample
+#define REGISTER_LED          0x00
+#define REGISTER_ACCEL_X      0x02
+#define REGISTER_GYRO_X       0x08
+#define REGISTER_TEMP         0x16
+#define REGISTER_COUNT        0x18
+
+typedef struct {
+    const char *url;
+    uint8_t unit_id;
+    struct mg_connection *conn;
+    uint64_t reconnect_us;
+    ocre_modbus_client_t client;
+    ocre_modbus_transaction_t transactions[GATEWAY_MAX_INFLIGHT];
+    ocre_modbus_schedule_t schedule;
+    ocre_modbus_poll_item_t items[4];
+    ocre_modbus_poll_block_t blocks[GATEWAY_MAX_BLOCKS];
+    uint16_t registers[REGISTER_COUNT]; // Mirror of the device registers
+    uint32_t polls_ok;
+    uint32_t polls_failed;
+} device_t;
+
+// Add a line per downstream device, each gets its own connection
+static device_t devices[] = {
+    { .url = "tcp://127.0.0.1:1502", .unit_id = 1 },
+};
+
+#define DEVICE_COUNT (sizeof(devices) / sizeof(devices[0]))
+
+static int device_send(void *io, const uint8_t *data, size_t len) {
+    device_t *dev = io;
+    if (dev->conn == NULL || dev->conn->is_connecting) {
+        return OCRE_ERROR_INVALID;
+    }
+    return mg_send(dev->conn, data, len) ? OCRE_SUCCESS : OCRE_ERROR_NO_MEMORY;
+}
+
+static void item_polled(ocre_modbus_schedule_t *schedule, ocre_modbus_poll_item_t *item, void *user_data) {
+    device_t *dev = user_data;
+    if (item->status == OCRE_MODBUS_EX_NONE) {
+        dev->polls_ok++;
+    }
+    else {
+        dev->polls_failed++;
+    }
+}
+
+// Each range is copied straight into the device's register mirror.
+// LED and accelerometer are adjacent, the gyro is within GATEWAY_MAX_GAP of them,
+// so the schedule reads them with one request and the temperature with a second.
+static int device_init(device_t *dev) {
+    const struct { uint16_t start, count; } ranges[] = {
+        { REGISTER_LED, 2 },
+        { REGISTER_ACCEL_X, 6 },
+        { REGISTER_GYRO_X, 6 },
+        { REGISTER_TEMP, 2 },
+    };
+    for (int i = 0; i < 4; i++) {
+        dev->items[i] = (ocre_modbus_poll_item_t) {
+            .values = &dev->registers[ranges[i].start],
+            .start = ranges[i].start,
+            .count = ranges[i].count,
+            .unit_id = dev->unit_id,
+            .table = OCRE_MODBUS_HOLDING_REGISTERS,
+        };
+    }
+
+    ocre_modbus_client_init(&dev->client, dev->transactions, GATEWAY_MAX_INFLIGHT, GATEWAY_TIMEOUT_MS,
+                            device_send, dev);
+    int blocks = ocre_modbus_schedule_init(&dev->schedule, &dev->client, dev->items, 4, dev->blocks,
+                                           GATEWAY_MAX_BLOCKS, GATEWAY_MAX_GAP, GATEWAY_POLL_MS,
+                                           item_polled, dev);
+    if (blocks < 0) {
+        printf("%s: bad poll schedule (%d)\n", dev->url, blocks);
+        return -1;
+    }
+    printf("%s: 4 ranges polled with %d requests\n", dev->url, blocks);
+    return 0;
+}
+
+static void device_handler(struct mg_connection *c, int ev, void *ev_data) {
+    device_t *dev = c->fn_data;
+
+    if (ev == MG_EV_CONNECT) {
+        printf("%s: connected\n", dev->url);
+    }
+    else if (ev == MG_EV_READ) {
+        int used = ocre_modbus_client_process(&dev->client, (const uint8_t *)c->recv.buf, c->recv.len);
+        if (used < 0) {
+            // Framing is lost, reconnect
+            c->is_closing = 1;
+            used = c->recv.len;
+        }
+        mg_iobuf_del(&c->recv, 0, used);
+    }
+    else if (ev == MG_EV_ERROR) {
+        printf("%s: %s\n", dev->url, (char *)ev_data);
+    }
+    else if (ev == MG_EV_CLOSE) {
+        dev->conn = NULL;
+        dev->reconnect_us = ocre_time_us() + GATEWAY_RECONNECT_MS * 1000ULL;
+        ocre_modbus_client_reset(&dev->client); // Outstanding requests fail with OCRE_MODBUS_STATUS_CLOSED
+    }
+}
+
+static void report(void) {
+    for (size_t i = 0; i < DEVICE_COUNT; i++) {
+        device_t *dev = &devices[i];
+        printf("%s: %s, %u ok, %u failed, LED %u, accel x %.3f, temp %.2f\n", dev->url,
+               dev->conn ? "up" : "down", dev->polls_ok, dev->polls_failed, dev->registers[REGISTER_LED],
+               ocre_modbus_registers_to_float(&dev->registers[REGISTER_ACCEL_X]),
+               ocre_modbus_registers_to_float(&dev->registers[REGISTER_TEMP]));
+    }
+}
+
+int main(void) {
+    setvbuf(stdout, NULL, _IONBF, 0);             // Logs don't show up reliably so disable stdout buffering
+
+    struct mg_mgr mgr;
+    mg_mgr_init(&mgr);
+
+    for (size_t i = 0; i < DEVICE_COUNT; i++) {
+        if (device_init(&devices[i]) != 0) {
+            return -1;
+        }
+    }
+
+    uint64_t next_report_us = ocre_time_us() + GATEWAY_REPORT_MS * 1000ULL;
+    for (;;) {
+        mg_mgr_poll(&mgr, 10);
+
+        uint64_t now = ocre_time_us();
+        for (size_t i = 0; i < DEVICE_COUNT; i++) {
+            device_t *dev = &devices[i];
+            if (dev->conn == NULL) {
+                if (now >= dev->reconnect_us) {
+                    dev->conn = mg_connect(&mgr, dev->url, device_handler, dev);
+                    dev->reconnect_us = now + GATEWAY_RECONNECT_MS * 1000ULL;
+                }
+                continue;
+            }
+            ocre_modbus_client_poll(&dev->client);
+            if (!dev->conn->is_connecting) {
+                ocre_modbus_schedule_run(&dev->schedule);
+            }
+        }
+
+        if (now >= next_report_us) {
+            report();
+            next_report_us = now + GATEWAY_REPORT_MS * 1000ULL;
+        }
+    }
+
+    mg_mgr_free(&mgr);
+    return 0;
+}
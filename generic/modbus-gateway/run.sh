@@ -0,0 +1 @@
+iwasm --addr-pool=0.0.0.0/0 build/modbus-gateway.wasm
\ No newline at end of file
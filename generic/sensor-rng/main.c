@@ -8,6 +8,69 @@
  */
 #include <stdio.h>
 #include <ocre_api.h>
+#include <ocre_task.h>
+
+static int rng_sensor_id = -1;
+static int rng_resolved_id = -1;
+static int reading_count = 0;
+static ocre_task_t rng_task;
+
+static void read_rng(void)
+{
+    reading_count++;
+    printf("\n--- RNG Reading #%d ---\n", reading_count);
+
+    // Read using the ID resolved from the name
+    printf("Reading by name:\n");
+    int channel_count_by_name = rng_resolved_id >= 0 ? ocre_sensors_get_channel_count(rng_resolved_id) : -1;
+    if (channel_count_by_name > 0)
+    {
+        for (int j = 0; j < channel_count_by_name; j++)
+        {
+            int channel_type = ocre_sensors_get_channel_type(rng_resolved_id, j);
+            if (channel_type >= 0)
+            {
+                int value = ocre_sensors_read(rng_resolved_id, channel_type);
+                printf("  Channel %d (type %d): Random value = %d\n", j, channel_type, value);
+            }
+        }
+    }
+    else
+    {
+        printf("  Failed to get channel count by name\n");
+    }
+
+    // Read using handle-based API (if available)
+    if (rng_sensor_id != -1)
+    {
+        printf("Reading by handle:\n");
+        int channel_count_by_id = ocre_sensors_get_channel_count(rng_sensor_id);
+        for (int j = 0; j < channel_count_by_id; j++)
+        {
+            int channel_type = ocre_sensors_get_channel_type(rng_sensor_id, j);
+            ocre_sensor_sample_t sample;
+            if (channel_type >= 0 && ocre_sensors_read_sample(rng_sensor_id, channel_type, &sample) == 0)
+            {
+                // The RNG reports whole numbers, so the integer part is the value
+                printf("  Channel %d (type %d): Random value = %d at %llu us\n", j, channel_type,
+                       (int)(ocre_sensor_sample_to_milli(&sample) / 1000), (unsigned long long)sample.timestamp_us);
+            }
+        }
+    }
+}
+
+// The reading loop runs as a cooperative task, so events are still dispatched while it waits
+static int rng_task_func(ocre_task_t *task, void *user_data)
+{
+    OCRE_TASK_BEGIN(task);
+    while (1)
+    {
+        read_rng();
+        printf("Waiting 3 seconds before next reading...\n");
+        ocre_task_sleep(task, 3000); // Wait 3 seconds
+    }
+    OCRE_TASK_END(task);
+}
 
 int main(void)
 {
@@ -53,7 +116,6 @@ int main(void)
     printf("\n=== Finding RNG Sensor by Handle ===\n");
 
     // Search for RNG sensor by iterating through all sensors
-    int rng_sensor_id = -1;
     ocre_sensor_handle_t rng_handle_by_id = -1;
 
     for (int sensor_id = 0; sensor_id < nr_of_sensors; sensor_id++)
@@ -95,51 +157,13 @@ int main(void)
     printf("\n=== Starting Continuous RNG Reading ===\n");
     printf("Reading RNG sensor every 3 seconds...\n");
 
-    int reading_count = 0;
+    // Resolve the name once so the readings do not pass strings to the host
+    rng_resolved_id = ocre_sensors_resolve("RNG Sensor");
 
-    while (1)
+    ocre_task_start(&rng_task, rng_task_func, NULL);
+    while (ocre_task_is_running(&rng_task))
     {
-        reading_count++;
-        printf("\n--- RNG Reading #%d ---\n", reading_count);
-
-        // Read using name-based API
-        printf("Reading by name:\n");
-        int channel_count_by_name = ocre_sensors_get_channel_count_by_name("RNG Sensor");
-        if (channel_count_by_name > 0)
-        {
-            for (int j = 0; j < channel_count_by_name; j++)
-            {
-                int channel_type = ocre_sensors_get_channel_type_by_name("RNG Sensor", j);
-                if (channel_type >= 0)
-                {
-                    int value = ocre_sensors_read_by_name("RNG Sensor", channel_type);
-                    printf("  Channel %d (type %d): Random value = %d\n", j, channel_type, value);
-                }
-            }
-        }
-        else
-        {
-            printf("  Failed to get channel count by name\n");
-        }
-
-        // Read using handle-based API (if available)
-        if (rng_sensor_id != -1)
-        {
-            printf("Reading by handle:\n");
-            int channel_count_by_id = ocre_sensors_get_channel_count(rng_sensor_id);
-            for (int j = 0; j < channel_count_by_id; j++)
-            {
-                int channel_type = ocre_sensors_get_channel_type(rng_sensor_id, j);
-                if (channel_type >= 0)
-                {
-                    int value = ocre_sensors_read(rng_sensor_id, channel_type);
-                    printf("  Channel %d (type %d): Random value = %d\n", j, channel_type, value);
-                }
-            }
-        }
-
-        printf("Waiting 3 seconds before next reading...\n");
-        ocre_sleep(3000); // Wait 3 seconds
+        ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, OCRE_WAIT_FOREVER);
     }
 
     printf("RNG Sensor Reader exiting.\n");
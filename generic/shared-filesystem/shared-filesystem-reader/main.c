@@ -1,39 +1,53 @@
 #include <stdio.h>
+#include <stdbool.h>
 #include <string.h>
-#include <errno.h>
-#include <unistd.h>
+#include <ocre_api.h>
+#include <ocre_shared_file.h>
 
 #define SHARED_FILE "shared/shared_data.txt"
 #define BUF_SIZE 32
+#define VERSION_COUNT 10 // Versions the writer publishes per run
+#define IDLE_TIMEOUT_MS 30000
+
+static bool watching; // The version already on disk has been delivered
+static int new_versions;
+
+static void on_update(ocre_shared_reader_t *reader, const void *data, uint32_t len, uint64_t generation,
+                      void *user_data) {
+    // The data is a complete version, read once after the writer renamed it into place
+    printf("generation %llu: %.*s\n", (unsigned long long)generation, (int)len, (const char *)data);
+    if (watching) {
+        new_versions++;
+    }
+}
 
 int main(void) {
     setvbuf(stdout, NULL, _IONBF, 0); 
     
     printf("Shared filesystem reader started\n");
     
-    // Open file for reading
-    FILE *file = fopen(SHARED_FILE, "r");
-    if (!file) {
-        printf("fopen failed for \"%s\": %s (%d)\n", SHARED_FILE, strerror(errno), errno);
+    static char buffer[BUF_SIZE];
+    static ocre_shared_reader_t reader;
+    int rc = ocre_shared_reader_start(&reader, SHARED_FILE, buffer, sizeof(buffer), on_update, NULL);
+    if (rc != OCRE_SUCCESS) {
+        printf("ocre_shared_reader_start failed for \"%s\": %d\n", SHARED_FILE, rc);
         return -1;
     }
-    printf("fopen success: %s\n", SHARED_FILE);
+    // Generations continue from earlier runs, so count what the writer publishes from now on
+    watching = true;
+    printf("Watching %s\n", SHARED_FILE);
     
-    // Read file content
-    char buffer[BUF_SIZE];
-    size_t nitems = fread(buffer, sizeof(char), sizeof(buffer) - 1, file);
-    printf("fread: %zu bytes\n", nitems);
-    
-    // Null-terminate the buffer
-    buffer[nitems] = '\0';
-    printf("buffer read = %s\n", buffer);
-    
-    // Close the file
-    int rc = fclose(file);
-    printf("fclose returned %d\n", rc);
+    // Sleeps until the writer publishes; nothing is reread in between
+    while (new_versions < VERSION_COUNT) {
+        if (ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, IDLE_TIMEOUT_MS) == 0) {
+            printf("No new version for %d ms\n", IDLE_TIMEOUT_MS);
+            break;
+        }
+    }
     
+    ocre_shared_reader_stop(&reader);
     printf("Reader completed successfully\n");
     fflush(stdout);
     
     return 0;
-} 
\ No newline at end of file
+}
@@ -7,7 +7,8 @@ if [ ! -d "../shared-filesystem-writer/shared" ]; then
     exit 1
 fi
 
-# Run the simple reader container with the same shared filesystem mounted
+# Run the simple reader container with the same shared filesystem mounted; start it while
+# the writer runs to see each version printed as it lands
 echo "Running simple shared filesystem reader container..."
 iwasm --map-dir=/shared::../shared-filesystem-writer/shared build/shared-filesystem-reader.wasm
 
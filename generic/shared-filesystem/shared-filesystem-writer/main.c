@@ -3,9 +3,13 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <unistd.h>
+#include <ocre_api.h>
+#include <ocre_shared_file.h>
 
 #define SHARED_DIR "/shared"
 #define SHARED_FILE "/shared/shared_data.txt"
+#define VERSION_COUNT 10
+#define PUBLISH_INTERVAL_MS 1000
 
 int main(void) {
     setvbuf(stdout, NULL, _IONBF, 0); 
@@ -35,25 +39,29 @@ int main(void) {
         printf("mkdir success: %s\n", SHARED_DIR);
     }
     
-    // Open file for writing
-    FILE *file = fopen(SHARED_FILE, "w");
-    if (!file) {
-        printf("fopen failed for \"%s\": %s (%d)\n", SHARED_FILE, strerror(errno), errno);
+    ocre_shared_writer_t writer;
+    rc = ocre_shared_writer_open(&writer, SHARED_FILE);
+    if (rc != OCRE_SUCCESS) {
+        printf("ocre_shared_writer_open failed for \"%s\": %d\n", SHARED_FILE, rc);
         return -1;
     }
-    printf("fopen success: %s\n", SHARED_FILE);
-    
-    // Write "Hello World" to file
-    const char *data = "Hello World";
-    size_t nitems = fwrite(data, sizeof(char), strlen(data), file);
-    printf("fwrite returned %zu bytes\n", nitems);
-    
-    // Close the fileg
-    rc = fclose(file);
-    printf("fclose returned %d\n", rc);
-    
+    printf("Continuing after generation %llu\n", (unsigned long long)ocre_shared_writer_generation(&writer));
+
+    // Each version replaces the previous one whole; readers are told when it lands
+    for (int i = 0; i < VERSION_COUNT; i++) {
+        char data[64];
+        int len = snprintf(data, sizeof(data), "Hello World %d", i + 1);
+        rc = ocre_shared_publish(&writer, data, len);
+        if (rc != OCRE_SUCCESS) {
+            printf("ocre_shared_publish failed: %d\n", rc);
+            return -1;
+        }
+        printf("Published generation %llu: %s\n", (unsigned long long)ocre_shared_writer_generation(&writer), data);
+        ocre_sleep(PUBLISH_INTERVAL_MS);
+    }
+
     printf("Writer completed successfully\n");
     fflush(stdout);
-    
+
     return 0;
-} 
\ No newline at end of file
+}
@@ -0,0 +1,63 @@
+// Shared by all pages: the HTML is static, live values come from the JSON API
+function $(id) { return document.getElementById(id); }
+function show(id, value) { if ($(id)) $(id).textContent = value; }
+
+function updateStatus() {
+  fetch('/api/status')
+    .then(r => r.json())
+    .then(data => {
+      show('counter', data.counter);
+      show('uptime', data.uptime);
+      show('port', data.port);
+      show('build', data.build);
+    })
+    .catch(e => {});
+}
+
+function updateCounter(action) {
+  fetch('/api/counter', { method: 'POST',
+                          headers: {'Content-Type': 'application/json'},
+                          body: JSON.stringify({action: action}) })
+    .then(r => r.json()).then(data => show('counter', data.counter));
+}
+
+let ws = null;
+function connectWebSocket() {
+  ws = new WebSocket('ws://' + window.location.host + '/ws');
+  ws.onopen = function() { show('ws-status', 'Connected'); log('<strong>Connected to WebSocket!</strong>'); };
+  ws.onclose = function() {
+    show('ws-status', 'Disconnected');
+    log('<strong>WebSocket disconnected.</strong>');
+    setTimeout(connectWebSocket, 3000);
+  };
+  ws.onmessage = function(event) {
+    log('Echo: ' + event.data);
+    try {
+      let data = JSON.parse(event.data);
+      if (data.counter !== undefined) show('counter', data.counter);
+    } catch (e) {}
+  };
+}
+
+function log(html) {
+  let messages = $('messages');
+  if (!messages) return;
+  messages.innerHTML += '<div>' + html + '</div>';
+  messages.scrollTop = messages.scrollHeight;
+}
+
+function sendMessage() {
+  let input = $('messageInput');
+  if (ws && ws.readyState === 1 && input.value) { ws.send(input.value); input.value = ''; }
+}
+
+if ($('messageInput')) {
+  $('messageInput').addEventListener('keypress', function(e) { if (e.key === 'Enter') sendMessage(); });
+}
+if ($('ws-status') || $('messages')) {
+  try { connectWebSocket(); } catch (e) {}
+}
+if ($('uptime')) {
+  updateStatus();
+  setInterval(updateStatus, 5000);
+}
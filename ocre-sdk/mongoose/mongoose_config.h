@@ -58,6 +58,7 @@ extern "C" {
 #endif
 
 #include "wasi_socket_ext.h"
+#include "ocre_api.h"
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -76,9 +77,40 @@ extern "C" {
 #define MG_ENABLE_POSIX_FS 1
 #endif
 
+// Build profiles, selected by the library target an app links (see ocre-sdk/CMakeLists.txt)
+#if defined(OCRE_MG_PROFILE_THROUGHPUT)
+// Larger IO buffers mean fewer reallocations and fewer, larger socket calls
+#ifndef MG_IO_SIZE
+#define MG_IO_SIZE 4096
+#endif
+#ifndef MG_MAX_RECV_SIZE
+#define MG_MAX_RECV_SIZE (256UL * 1024UL)
+#endif
+#ifndef MG_ENABLE_PROFILE
+#define MG_ENABLE_PROFILE 1 // Per-connection event timeline in mg_connection::prof
+#endif
+#else
+// Size profile for 64 KB containers: small buffer growth steps and receive cap
+#ifndef MG_IO_SIZE
+#define MG_IO_SIZE 256
+#endif
+#ifndef MG_MAX_RECV_SIZE
+#define MG_MAX_RECV_SIZE (16UL * 1024UL)
+#endif
+#ifndef MG_MAX_HTTP_HEADERS
+#define MG_MAX_HTTP_HEADERS 16
+#endif
+#ifndef MG_SOCK_LISTEN_BACKLOG_SIZE
+#define MG_SOCK_LISTEN_BACKLOG_SIZE 8
+#endif
 #ifndef MG_ENABLE_PROFILE
 #define MG_ENABLE_PROFILE 0
 #endif
+#endif
+
+// Block on sockets and Ocre events together, so mg_mgr_poll() wakes for either.
+// Apps that receive Ocre events must dispatch them after each mg_mgr_poll().
+#define poll(fds, nfds, timeout) ocre_poll(fds, nfds, timeout)
 
 #endif // MG_ARCH_WASM
 
@@ -0,0 +1,350 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#include "ocre_alloc.h"
+#include <stdio.h>
+#include <string.h>
+
+static ocre_alloc_stats_t *allocators[OCRE_MAX_ALLOCATORS] = {0};
+
+static uint32_t align_up(uint32_t value)
+{
+    return (value + OCRE_ALLOC_ALIGN - 1) & ~(uint32_t)(OCRE_ALLOC_ALIGN - 1);
+}
+
+// Align the start of a buffer, returns the usable size or 0 if nothing is left
+static uint32_t align_buffer(void *buffer, uint32_t size, uint8_t **base)
+{
+    uint32_t skip = align_up((uint32_t)(uintptr_t)buffer) - (uint32_t)(uintptr_t)buffer;
+    *base = (uint8_t *)buffer + skip;
+    return size > skip ? size - skip : 0;
+}
+
+static void unregister_allocator(ocre_alloc_stats_t *stats)
+{
+    for (int i = 0; i < OCRE_MAX_ALLOCATORS; i++)
+    {
+        if (allocators[i] == stats)
+        {
+            allocators[i] = NULL;
+        }
+    }
+}
+
+static int register_allocator(ocre_alloc_stats_t *stats, const char *name, uint32_t capacity)
+{
+    unregister_allocator(stats); // Initialized again
+    int slot = -1;
+    for (int i = 0; i < OCRE_MAX_ALLOCATORS && slot < 0; i++)
+    {
+        if (allocators[i] == NULL)
+        {
+            slot = i;
+        }
+    }
+    if (slot < 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No available slots for allocators\n");
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->name = name;
+    stats->capacity = capacity;
+    allocators[slot] = stats;
+    return OCRE_SUCCESS;
+}
+
+static void account(ocre_alloc_stats_t *stats, uint32_t bytes)
+{
+    stats->in_use += bytes;
+    stats->allocations++;
+    if (stats->in_use > stats->high_water)
+    {
+        stats->high_water = stats->in_use;
+    }
+}
+
+// =============================================================================
+// ARENAS
+// =============================================================================
+
+int ocre_arena_init(ocre_arena_t *arena, void *buffer, uint32_t size, const char *name)
+{
+    if (arena == NULL || buffer == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint8_t *base;
+    uint32_t capacity = align_buffer(buffer, size, &base);
+    int ret = register_allocator(&arena->stats, name, capacity);
+    if (ret != OCRE_SUCCESS)
+    {
+        return ret;
+    }
+    arena->base = base;
+    return OCRE_SUCCESS;
+}
+
+void *ocre_arena_alloc(ocre_arena_t *arena, uint32_t size)
+{
+    if (arena == NULL || arena->base == NULL)
+    {
+        return NULL;
+    }
+    uint32_t offset = arena->stats.in_use;
+    if (size > arena->stats.capacity - offset)
+    {
+        arena->stats.failures++;
+        return NULL;
+    }
+    // Keep the next allocation aligned; the padding counts as in use
+    uint32_t rounded = align_up(size);
+    if (rounded > arena->stats.capacity - offset)
+    {
+        rounded = arena->stats.capacity - offset;
+    }
+    account(&arena->stats, rounded);
+    return arena->base + offset;
+}
+
+char *ocre_arena_strndup(ocre_arena_t *arena, const char *s, uint32_t n)
+{
+    if (s == NULL)
+    {
+        return NULL;
+    }
+    uint32_t len = (uint32_t)strnlen(s, n);
+    char *copy = ocre_arena_alloc(arena, len + 1);
+    if (copy)
+    {
+        memcpy(copy, s, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+uint32_t ocre_arena_mark(const ocre_arena_t *arena)
+{
+    return arena ? arena->stats.in_use : 0;
+}
+
+void ocre_arena_release(ocre_arena_t *arena, uint32_t mark)
+{
+    if (arena && mark <= arena->stats.in_use)
+    {
+        arena->stats.in_use = mark;
+    }
+}
+
+void ocre_arena_reset(ocre_arena_t *arena)
+{
+    ocre_arena_release(arena, 0);
+}
+
+void ocre_arena_deinit(ocre_arena_t *arena)
+{
+    if (arena)
+    {
+        unregister_allocator(&arena->stats);
+        memset(arena, 0, sizeof(*arena));
+    }
+}
+
+// =============================================================================
+// POOLS
+// =============================================================================
+
+// Written after the link word of each freed block, where the block has room for it
+#define POOL_FREE_MAGIC 0x0CF4EE0CU
+#define POOL_MAGIC_END (sizeof(void *) + sizeof(uint32_t))
+
+static void pool_set_magic(const ocre_pool_t *pool, void *block, uint32_t magic)
+{
+    if (pool->block_size >= POOL_MAGIC_END)
+    {
+        memcpy((uint8_t *)block + sizeof(void *), &magic, sizeof(magic));
+    }
+}
+
+// Whether block is already on the free list; the magic makes this O(1) for live blocks,
+// and as user data may hold the same value the list walk confirms it
+static bool pool_block_free(const ocre_pool_t *pool, const void *block)
+{
+    if (pool->block_size >= POOL_MAGIC_END)
+    {
+        uint32_t magic;
+        memcpy(&magic, (const uint8_t *)block + sizeof(void *), sizeof(magic));
+        if (magic != POOL_FREE_MAGIC)
+        {
+            return false;
+        }
+    }
+    for (const void *free_block = pool->free_list; free_block; memcpy(&free_block, free_block, sizeof(void *)))
+    {
+        if (free_block == block)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int ocre_pool_init(ocre_pool_t *pool, void *buffer, uint32_t size, uint32_t block_size, const char *name)
+{
+    if (pool == NULL || buffer == NULL || block_size == 0)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint8_t *base;
+    uint32_t usable = align_buffer(buffer, size, &base);
+    block_size = align_up(block_size);
+    if (usable < block_size)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint32_t block_count = usable / block_size;
+    int ret = register_allocator(&pool->stats, name, block_count * block_size);
+    if (ret != OCRE_SUCCESS)
+    {
+        return ret;
+    }
+    pool->base = base;
+    pool->block_size = block_size;
+    pool->block_count = block_count;
+    // Blocks are carved from the buffer on first use, so init does not touch all of it
+    pool->untouched = 0;
+    pool->free_list = NULL;
+    return OCRE_SUCCESS;
+}
+
+void *ocre_pool_alloc(ocre_pool_t *pool)
+{
+    if (pool == NULL || pool->base == NULL)
+    {
+        return NULL;
+    }
+    void *block = pool->free_list;
+    if (block)
+    {
+        memcpy(&pool->free_list, block, sizeof(void *));
+        pool_set_magic(pool, block, 0);
+    }
+    else if (pool->untouched < pool->block_count)
+    {
+        block = pool->base + pool->untouched++ * pool->block_size;
+    }
+    else
+    {
+        pool->stats.failures++;
+        return NULL;
+    }
+    account(&pool->stats, pool->block_size);
+    return block;
+}
+
+int ocre_pool_free(ocre_pool_t *pool, void *block)
+{
+    if (block == NULL)
+    {
+        return OCRE_SUCCESS;
+    }
+    if (pool == NULL || pool->base == NULL || (uint8_t *)block < pool->base)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint32_t offset = (uint32_t)((uint8_t *)block - pool->base);
+    if (offset % pool->block_size != 0 || offset / pool->block_size >= pool->untouched ||
+        pool->stats.in_use < pool->block_size)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: %p is not an allocated block of pool %s\n", block, pool->stats.name ? pool->stats.name : "");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (pool_block_free(pool, block))
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: %p freed twice in pool %s\n", block, pool->stats.name ? pool->stats.name : "");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    memcpy(block, &pool->free_list, sizeof(void *));
+    pool_set_magic(pool, block, POOL_FREE_MAGIC);
+    pool->free_list = block;
+    pool->stats.in_use -= pool->block_size;
+    return OCRE_SUCCESS;
+}
+
+uint32_t ocre_pool_available(const ocre_pool_t *pool)
+{
+    if (pool == NULL || pool->block_size == 0)
+    {
+        return 0;
+    }
+    return pool->block_count - pool->stats.in_use / pool->block_size;
+}
+
+void ocre_pool_deinit(ocre_pool_t *pool)
+{
+    if (pool)
+    {
+        unregister_allocator(&pool->stats);
+        memset(pool, 0, sizeof(*pool));
+    }
+}
+
+// =============================================================================
+// STATISTICS
+// =============================================================================
+
+uint32_t ocre_alloc_get_stats(ocre_alloc_stats_t *stats, uint32_t max)
+{
+    uint32_t count = 0;
+    for (int i = 0; i < OCRE_MAX_ALLOCATORS && stats != NULL && count < max; i++)
+    {
+        if (allocators[i])
+        {
+            stats[count++] = *allocators[i];
+        }
+    }
+    return count;
+}
+
+void ocre_alloc_get_totals(ocre_memory_stats_t *totals)
+{
+    if (totals == NULL)
+    {
+        return;
+    }
+    memset(totals, 0, sizeof(*totals));
+    for (int i = 0; i < OCRE_MAX_ALLOCATORS; i++)
+    {
+        if (allocators[i])
+        {
+            totals->allocators++;
+            totals->capacity += allocators[i]->capacity;
+            totals->in_use += allocators[i]->in_use;
+            totals->high_water += allocators[i]->high_water;
+            totals->failures += allocators[i]->failures;
+        }
+    }
+}
+
+void ocre_alloc_reset_stats(void)
+{
+    for (int i = 0; i < OCRE_MAX_ALLOCATORS; i++)
+    {
+        if (allocators[i])
+        {
+            allocators[i]->high_water = allocators[i]->in_use;
+            allocators[i]->allocations = 0;
+            allocators[i]->failures = 0;
+        }
+    }
+}
@@ -0,0 +1,216 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#ifndef OCRE_ALLOC_H
+#define OCRE_ALLOC_H
+
+#include "ocre_api.h"
+
+/**
+ * @file ocre_alloc.h
+ * @brief Fixed-footprint arenas and block pools over caller-provided storage.
+ *
+ * For containers capped at a few pages of linear memory, where malloc() fragments the
+ * heap under sustained load: an arena hands out memory by bumping a pointer and is
+ * reset as a whole, such as once per request; a pool hands out equal blocks in O(1) and
+ * takes them back in any order. Neither ever grows, so a container's memory use is fixed
+ * at build time. Every arena and pool reports its usage in ocre_sdk_get_stats().
+ *
+ * Not thread-safe: use one per thread, or allocate only from the event loop.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef OCRE_MAX_ALLOCATORS
+#define OCRE_MAX_ALLOCATORS 8           /**< Arenas and pools reporting statistics at once */
+#endif
+
+#define OCRE_ALLOC_ALIGN 8 /**< Alignment of every arena allocation and pool block */
+
+    /**
+     * @brief Usage counters of one arena or pool
+     */
+    typedef struct
+    {
+        const char *name;     /**< Name given at init, for reports */
+        uint32_t capacity;    /**< Usable bytes */
+        uint32_t in_use;      /**< Bytes handed out and not yet released */
+        uint32_t high_water;  /**< Most bytes in use since init or the last stats reset */
+        uint32_t allocations; /**< Successful allocations */
+        uint32_t failures;    /**< Allocations refused for lack of space */
+    } ocre_alloc_stats_t;
+
+    /**
+     * @brief Bump allocator state
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct
+    {
+        ocre_alloc_stats_t stats; /**< Counters, first so the registry can point at them */
+        uint8_t *base;            /**< Aligned start of the storage */
+    } ocre_arena_t;
+
+    /**
+     * @brief Fixed-size block pool state
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct
+    {
+        ocre_alloc_stats_t stats; /**< Counters, first so the registry can point at them */
+        uint8_t *base;            /**< Aligned start of the blocks */
+        uint32_t block_size;      /**< Block size, a multiple of OCRE_ALLOC_ALIGN */
+        uint32_t block_count;     /**< Blocks in the storage */
+        uint32_t untouched;       /**< Index of the first block never handed out */
+        void *free_list;          /**< Freed blocks, linked through their first word */
+    } ocre_pool_t;
+
+    // =============================================================================
+    // Arenas
+    // =============================================================================
+
+    /**
+     * @brief Set up an arena over a buffer
+     * @param arena Arena to initialize
+     * @param buffer Storage, must outlive the arena
+     * @param size Size of @p buffer in bytes
+     * @param name Name for statistics, may be NULL
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on invalid parameters,
+     *         OCRE_ERROR_NO_MEMORY if OCRE_MAX_ALLOCATORS are registered already
+     */
+    int ocre_arena_init(ocre_arena_t *arena, void *buffer, uint32_t size, const char *name);
+
+    /**
+     * @brief Allocate from an arena
+     * @param arena Initialized arena
+     * @param size Bytes needed
+     * @return Memory aligned to OCRE_ALLOC_ALIGN, or NULL if the arena is full
+     */
+    void *ocre_arena_alloc(ocre_arena_t *arena, uint32_t size);
+
+    /**
+     * @brief Copy at most @p n characters of a string into an arena, NUL-terminated
+     * @param arena Initialized arena
+     * @param s String to copy
+     * @param n Most characters to copy
+     * @return The copy, or NULL if the arena is full
+     */
+    char *ocre_arena_strndup(ocre_arena_t *arena, const char *s, uint32_t n);
+
+    /**
+     * @brief Current position of an arena, to release back to later
+     * @param arena Initialized arena
+     * @return Bytes in use
+     */
+    uint32_t ocre_arena_mark(const ocre_arena_t *arena);
+
+    /**
+     * @brief Free everything allocated since a mark was taken
+     * @param arena Initialized arena
+     * @param mark Value returned by ocre_arena_mark()
+     */
+    void ocre_arena_release(ocre_arena_t *arena, uint32_t mark);
+
+    /**
+     * @brief Free everything allocated from an arena
+     * @param arena Initialized arena
+     */
+    void ocre_arena_reset(ocre_arena_t *arena);
+
+    /**
+     * @brief Unregister an arena; its buffer is the caller's again
+     * @param arena Initialized arena
+     */
+    void ocre_arena_deinit(ocre_arena_t *arena);
+
+    // =============================================================================
+    // Pools
+    // =============================================================================
+
+    /**
+     * @brief Split a buffer into equal blocks
+     * @param pool Pool to initialize
+     * @param buffer Storage, must outlive the pool
+     * @param size Size of @p buffer in bytes
+     * @param block_size Bytes per block, rounded up to OCRE_ALLOC_ALIGN
+     * @param name Name for statistics, may be NULL
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if not even one block fits,
+     *         OCRE_ERROR_NO_MEMORY if OCRE_MAX_ALLOCATORS are registered already
+     */
+    int ocre_pool_init(ocre_pool_t *pool, void *buffer, uint32_t size, uint32_t block_size, const char *name);
+
+    /**
+     * @brief Take a block from a pool, in O(1)
+     * @param pool Initialized pool
+     * @return Block of the pool's block size, or NULL if all are in use
+     */
+    void *ocre_pool_alloc(ocre_pool_t *pool);
+
+    /**
+     * @brief Return a block to its pool, in O(1)
+     *
+     * A block freed twice is detected and refused rather than linked into the free list
+     * again. Freed blocks are marked behind their first word; a live block only costs a
+     * walk of the free list if its data happens to hold the mark.
+     *
+     * @param pool Pool the block came from
+     * @param block Block returned by ocre_pool_alloc(), NULL is ignored
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if @p block is not an allocated
+     *         block of @p pool, including a block that was already freed
+     */
+    int ocre_pool_free(ocre_pool_t *pool, void *block);
+
+    /**
+     * @brief Blocks still available
+     * @param pool Initialized pool
+     * @return Number of blocks ocre_pool_alloc() can still hand out
+     */
+    uint32_t ocre_pool_available(const ocre_pool_t *pool);
+
+    /**
+     * @brief Unregister a pool; its buffer is the caller's again
+     * @param pool Initialized pool
+     */
+    void ocre_pool_deinit(ocre_pool_t *pool);
+
+    // =============================================================================
+    // Statistics
+    // =============================================================================
+
+    /**
+     * @brief Read the counters of the registered arenas and pools
+     * @param stats Receives up to @p max entries, in registration order
+     * @param max Capacity of @p stats
+     * @return Number of entries written
+     */
+    uint32_t ocre_alloc_get_stats(ocre_alloc_stats_t *stats, uint32_t max);
+
+    /**
+     * @brief Sum the counters of every registered arena and pool
+     *
+     * Used by ocre_sdk_get_stats() for ocre_sdk_stats_t.memory.
+     *
+     * @param totals Receives the sums
+     */
+    void ocre_alloc_get_totals(ocre_memory_stats_t *totals);
+
+    /**
+     * @brief Restart the high-water marks at the current usage and clear the counters
+     *
+     * Called by ocre_sdk_reset_stats().
+     */
+    void ocre_alloc_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCRE_ALLOC_H */
@@ -6,405 +6,2858 @@
 
  */
 #include "ocre_api.h"
+#include "ocre_alloc.h"
+#include "ocre_task.h"
+#ifdef OCRE_SDK_THREADS
+#include "ocre_workqueue.h"
+#endif
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 // Callback storage
-static void (*timer_callbacks[OCRE_MAX_CALLBACKS])(void) = {0};
-static void (*gpio_callbacks[OCRE_MAX_CALLBACKS])(void) = {0};
-static message_callback_func_t message_callbacks[OCRE_MAX_CALLBACKS] = {0};
-static char message_callback_topics[OCRE_MAX_CALLBACKS][OCRE_MAX_TOPIC_LEN] = {{0}};
-static int gpio_callback_pins[OCRE_MAX_CALLBACKS] = {-1};
-static int gpio_callback_ports[OCRE_MAX_CALLBACKS] = {-1};
+static void (*timer_callbacks[OCRE_MAX_TIMER_CALLBACKS])(void) = {0};
+static timer_callback_ex_func_t timer_callbacks_ex[OCRE_MAX_TIMER_CALLBACKS] = {0};
+
+// Soft timer wheel, level 0 holds the next 64 ticks and each level above is 64 times coarser
+#define SOFT_TIMER_WHEEL_SIZE (1U << OCRE_SOFT_TIMER_WHEEL_BITS)
+#define SOFT_TIMER_WHEEL_MASK (SOFT_TIMER_WHEEL_SIZE - 1U)
+#define SOFT_TIMER_SLOT(tick, level) (((tick) >> ((level) * OCRE_SOFT_TIMER_WHEEL_BITS)) & SOFT_TIMER_WHEEL_MASK)
+
+static ocre_soft_timer_t *soft_timer_wheel[OCRE_SOFT_TIMER_WHEEL_LEVELS][SOFT_TIMER_WHEEL_SIZE] = {0};
+static uint32_t soft_timer_tick = 0; // Next wheel tick to expire
+static uint32_t soft_timer_count = 0;
+static bool soft_timer_host_created = false;
+static bool soft_timer_host_running = false;
+// GPIO callbacks: (port, pin) maps directly to slot + 1 in a dense callback table
+#define GPIO_PIN_INDEX(port, pin) ((port) * CONFIG_OCRE_GPIO_PINS_PER_PORT + (pin))
+#define GPIO_PIN_SLOTS (CONFIG_OCRE_GPIO_MAX_PORTS * CONFIG_OCRE_GPIO_PINS_PER_PORT)
+typedef struct
+{
+    gpio_callback_func_t callback;
+    gpio_callback_ex_func_t callback_ex;
+    void *user_data;
+    uint8_t edges; /**< OCRE_GPIO_EDGE_* mask the callback wants */
+} gpio_callback_entry_t;
+
+#if OCRE_MAX_GPIO_CALLBACKS > UINT8_MAX
+#error "OCRE_MAX_GPIO_CALLBACKS must fit gpio_callback_index"
+#endif
+static uint8_t gpio_callback_index[GPIO_PIN_SLOTS] = {0};
+static gpio_callback_entry_t gpio_callbacks[OCRE_MAX_GPIO_CALLBACKS] = {0};
+
+// Interned topic strings: each entry is a reference count byte followed by the
+// NUL-terminated string. A reference is the string's offset, so 0 means none.
+#if OCRE_TOPIC_POOL_SIZE > UINT16_MAX
+#error "OCRE_TOPIC_POOL_SIZE must fit topic_ref_t"
+#endif
+typedef uint16_t topic_ref_t;
+static char topic_pool[OCRE_TOPIC_POOL_SIZE];
+static uint32_t topic_pool_used = 0;
+static uint32_t topic_pool_pins = 0; // Dispatched or retained messages pointing into the pool
+
+// Topic index: a trie with one node per topic level, holding the callback of the
+// filter ending there. Links are node indices, 0 meaning none since the root can
+// never be a child. Free nodes have no level.
+#if OCRE_MAX_TOPIC_NODES > INT16_MAX
+#error "OCRE_MAX_TOPIC_NODES must fit the int16_t node links"
+#endif
+typedef struct
+{
+    topic_ref_t level;
+    int16_t parent;
+    int16_t first_child;
+    int16_t next_sibling;
+    message_callback_func_t callback;
+} topic_node_t;
+
+static topic_node_t topic_nodes[OCRE_MAX_TOPIC_NODES] = {0};
+static uint32_t message_callback_count = 0;
+
+// Fragmented message subscriptions
+typedef struct
+{
+    topic_ref_t topic;
+    message_chunk_callback_func_t chunk_callback; /**< Incremental delivery, or NULL to reassemble */
+    message_callback_func_t complete_callback;    /**< Called once a reassembled payload is complete */
+    uint8_t *buf;
+    uint32_t buf_size;
+    uint32_t stream_id;
+    uint32_t received;
+    bool assembling;
+} message_stream_t;
+
+static message_stream_t message_streams[OCRE_MAX_STREAM_CALLBACKS] = {0};
+
+// Topic handles, used to resolve the strings of handle-tagged message events
+typedef struct
+{
+    int handle;
+    topic_ref_t topic;
+    topic_ref_t content_type;
+    ocre_writable_callback_t writable_callback;
+    void *writable_user_data;
+} topic_handle_t;
+
+static topic_handle_t topic_handles[OCRE_MAX_TOPIC_HANDLES] = {0};
+
+// Channel records are a 32-bit length followed by the data, padded to 4 bytes
+#define CHANNEL_RECORD_HEADER sizeof(uint32_t)
+#define CHANNEL_RECORD_SIZE(len) (CHANNEL_RECORD_HEADER + (((len) + 3U) & ~3U))
+#define CHANNEL_WRAP 0xFFFFFFFFU // Length marking the unused end of the ring
+
+static ocre_channel_t *channels[OCRE_MAX_CHANNELS] = {0};
+
+static ocre_msg_pool_t *rx_pools[OCRE_MAX_RX_POOLS] = {0};
+static ocre_sensor_stream_t *sensor_streams[OCRE_MAX_SENSOR_STREAMS] = {0};
+static ocre_gpio_capture_t *gpio_captures[OCRE_MAX_GPIO_CAPTURES] = {0};
+static ocre_file_watch_t *file_watches[OCRE_MAX_FILE_WATCHES] = {0};
+
+// Names resolved to GPIO pins or sensor IDs; strings share the topic pool
+typedef enum
+{
+    RESOLVED_GPIO = 1,
+    RESOLVED_SENSOR,
+} resolved_kind_t;
+
+typedef struct
+{
+    topic_ref_t name;
+    uint8_t kind;
+    int value;
+    int extra;
+} resolved_name_t;
+
+static resolved_name_t resolved_names[OCRE_MAX_RESOLVED_NAMES] = {0};
+
+// Event loop state
+static ocre_event_policy_t event_policy = {OCRE_DEFAULT_EVENTS_PER_LOOP, 0};
+static uint8_t event_priorities[OCRE_RESOURCE_TYPE_COUNT] = {
+    [OCRE_RESOURCE_TYPE_TIMER] = OCRE_EVENT_PRIORITY_TIMER,
+    [OCRE_RESOURCE_TYPE_GPIO] = OCRE_EVENT_PRIORITY_GPIO,
+    [OCRE_RESOURCE_TYPE_SENSOR] = OCRE_EVENT_PRIORITY_SENSOR,
+    [OCRE_RESOURCE_TYPE_MESSAGE] = OCRE_EVENT_PRIORITY_MESSAGE,
+    [OCRE_RESOURCE_TYPE_CHANNEL] = OCRE_EVENT_PRIORITY_CHANNEL,
+    [OCRE_RESOURCE_TYPE_FLOW] = OCRE_EVENT_PRIORITY_FLOW,
+    [OCRE_RESOURCE_TYPE_GPIO_CAPTURE] = OCRE_EVENT_PRIORITY_GPIO_CAPTURE,
+    [OCRE_RESOURCE_TYPE_FILE_WATCH] = OCRE_EVENT_PRIORITY_FILE_WATCH,
+    [OCRE_RESOURCE_TYPE_WORKQUEUE] = OCRE_EVENT_PRIORITY_WORKQUEUE,
+};
+static event_data_t pending_events[OCRE_EVENT_BATCH_SIZE];
+static uint32_t pending_head = 0;
+static uint32_t pending_count = 0;
+#ifdef OCRE_SDK_TIMING
+static uint64_t pending_fetch_us = 0;
+#endif
+
+static ocre_sdk_stats_t sdk_stats = {0};
+
+#ifdef OCRE_SDK_TRACE
+#if (OCRE_TRACE_RING_SIZE & (OCRE_TRACE_RING_SIZE - 1)) != 0
+#error "OCRE_TRACE_RING_SIZE must be a power of two"
+#endif
+static ocre_trace_ring_t trace_ring = {OCRE_TRACE_MAGIC, OCRE_TRACE_RING_SIZE, 0};
+static uint32_t trace_tail = 0;
+#endif
+
+// Message being dispatched, valid only while its callbacks run
+static ocre_msg_t *current_message = NULL;
+static bool current_message_retained = false;
+
+// Exports the host calls for each resource type, registered once on first use
+static const char *const dispatcher_exports[OCRE_RESOURCE_TYPE_COUNT] = {
+    [OCRE_RESOURCE_TYPE_TIMER] = "timer_callback",
+    [OCRE_RESOURCE_TYPE_GPIO] = "gpio_callback",
+    [OCRE_RESOURCE_TYPE_SENSOR] = "sensor_callback",
+    [OCRE_RESOURCE_TYPE_MESSAGE] = "message_callback",
+    [OCRE_RESOURCE_TYPE_CHANNEL] = "channel_callback",
+    [OCRE_RESOURCE_TYPE_FLOW] = "flow_callback",
+    [OCRE_RESOURCE_TYPE_GPIO_CAPTURE] = "gpio_capture_callback",
+    [OCRE_RESOURCE_TYPE_FILE_WATCH] = "file_watch_callback",
+    [OCRE_RESOURCE_TYPE_WORKQUEUE] = "workqueue_callback",
+};
+static uint32_t dispatchers_registered = 0; // Bit per resource type
+
+// =============================================================================
+// TOPIC POOL
+// =============================================================================
+
+static const char *topic_str(topic_ref_t ref)
+{
+    return &topic_pool[ref];
+}
+
+// Reference count byte of an entry, unsigned so counts above 127 do not wrap
+static uint8_t *topic_refs(uint32_t pos)
+{
+    return (uint8_t *)&topic_pool[pos];
+}
+
+// Return a reference to a copy of str, shared with equal strings already interned
+static topic_ref_t topic_intern(const char *str, size_t len)
+{
+    uint32_t pos = 0;
+    while (pos < topic_pool_used)
+    {
+        uint8_t *refs = topic_refs(pos);
+        const char *entry = &topic_pool[pos + 1];
+        size_t entry_len = strlen(entry);
+        // A saturated entry is left alone and the string interned again
+        if (entry_len == len && memcmp(entry, str, len) == 0 && *refs < UINT8_MAX)
+        {
+            (*refs)++;
+            return (topic_ref_t)(pos + 1);
+        }
+        pos += entry_len + 2;
+    }
+    if (topic_pool_used + len + 2 > OCRE_TOPIC_POOL_SIZE)
+    {
+        return 0;
+    }
+    *topic_refs(pos) = 1;
+    memcpy(&topic_pool[pos + 1], str, len);
+    topic_pool[pos + 1 + len] = '\0';
+    topic_pool_used += len + 2;
+    return (topic_ref_t)(pos + 1);
+}
+
+static void topic_ref_moved(topic_ref_t *ref, topic_ref_t removed, uint32_t size)
+{
+    if (*ref > removed)
+    {
+        *ref -= size;
+    }
+}
+
+// Remove the entry at start and move the ones after it down
+static void topic_remove(uint32_t start)
+{
+    topic_ref_t ref = (topic_ref_t)(start + 1);
+    uint32_t size = strlen(&topic_pool[ref]) + 2;
+    memmove(&topic_pool[start], &topic_pool[start + size], topic_pool_used - start - size);
+    topic_pool_used -= size;
+    for (int i = 1; i < OCRE_MAX_TOPIC_NODES; i++)
+    {
+        topic_ref_moved(&topic_nodes[i].level, ref, size);
+    }
+    for (int i = 0; i < OCRE_MAX_STREAM_CALLBACKS; i++)
+    {
+        topic_ref_moved(&message_streams[i].topic, ref, size);
+    }
+    for (int i = 0; i < OCRE_MAX_TOPIC_HANDLES; i++)
+    {
+        topic_ref_moved(&topic_handles[i].topic, ref, size);
+        topic_ref_moved(&topic_handles[i].content_type, ref, size);
+    }
+    for (int i = 0; i < OCRE_MAX_RESOLVED_NAMES; i++)
+    {
+        topic_ref_moved(&resolved_names[i].name, ref, size);
+    }
+}
+
+// Drop a reference; unused entries are removed and the pool compacted, unless a
+// message still points into it, then the entry stays until the last pin is dropped
+static void topic_release(topic_ref_t ref)
+{
+    if (ref == 0 || --*topic_refs(ref - 1) > 0)
+    {
+        return;
+    }
+    if (topic_pool_pins == 0)
+    {
+        topic_remove(ref - 1);
+    }
+}
 
-// Initialize callback arrays
-static void init_callback_system(void)
+static void topic_pool_unpin(void)
 {
-    static bool initialized = false;
-    if (!initialized)
+    if (--topic_pool_pins > 0)
+    {
+        return;
+    }
+    uint32_t pos = 0;
+    while (pos < topic_pool_used)
     {
-        for (int i = 0; i < OCRE_MAX_CALLBACKS; i++)
+        if (*topic_refs(pos) == 0)
+        {
+            topic_remove(pos);
+        }
+        else
         {
-            timer_callbacks[i] = NULL;
-            gpio_callbacks[i] = NULL;
-            message_callbacks[i] = NULL;
-            message_callback_topics[i][0] = '\0';
-            gpio_callback_pins[i] = -1;
-            gpio_callback_ports[i] = -1;
+            pos += strlen(&topic_pool[pos + 1]) + 2;
         }
-        initialized = true;
     }
 }
 
+static bool topic_pool_owns(const void *ptr)
+{
+    return (const char *)ptr >= topic_pool && (const char *)ptr < topic_pool + OCRE_TOPIC_POOL_SIZE;
+}
+
 // =============================================================================
-// INTERNAL CALLBACK DISPATCHERS
+// TOPIC INDEX
 // =============================================================================
 
-void OCRE_EXPORT("timer_callback") timer_callback(int timer_id)
+static bool is_level(const char *level, size_t len, const char *name)
+{
+    return strlen(name) == len && memcmp(name, level, len) == 0;
+}
+
+// Iterate the levels of a filter; a trailing '/' stands for a final "#" level
+static const char *next_filter_level(const char *level, size_t *len)
+{
+    if (level[0] == '\0')
+    {
+        return NULL;
+    }
+    const char *end = strchr(level, '/');
+    *len = end ? (size_t)(end - level) : strlen(level);
+    return end ? end + 1 : level + *len;
+}
+
+static int validate_topic_filter(const char *filter)
+{
+    size_t len = 0;
+    const char *level = filter;
+    const char *next;
+    while ((next = next_filter_level(level, &len)) != NULL)
+    {
+        bool has_wildcard = memchr(level, '+', len) || memchr(level, '#', len);
+        if ((has_wildcard && len != 1) ||
+            (level[0] == '#' && next[0] != '\0'))
+        {
+            return OCRE_ERROR_INVALID;
+        }
+        level = next;
+    }
+    return OCRE_SUCCESS;
+}
+
+static int topic_node_child(int node, const char *level, size_t len, bool create)
+{
+    for (int child = topic_nodes[node].first_child; child; child = topic_nodes[child].next_sibling)
+    {
+        if (is_level(level, len, topic_str(topic_nodes[child].level)))
+        {
+            return child;
+        }
+    }
+    if (!create)
+    {
+        return 0;
+    }
+    for (int i = 1; i < OCRE_MAX_TOPIC_NODES; i++)
+    {
+        if (topic_nodes[i].level == 0)
+        {
+            topic_ref_t ref = topic_intern(level, len);
+            if (ref == 0)
+            {
+                return 0;
+            }
+            topic_node_t *child = &topic_nodes[i];
+            memset(child, 0, sizeof(*child));
+            child->level = ref;
+            child->parent = node;
+            child->next_sibling = topic_nodes[node].first_child;
+            topic_nodes[node].first_child = i;
+            return i;
+        }
+    }
+    return 0;
+}
+
+// Release nodes that no longer carry callbacks or children
+static void topic_node_prune(int node)
+{
+    while (node && !topic_nodes[node].callback && !topic_nodes[node].first_child)
+    {
+        int parent = topic_nodes[node].parent;
+        int16_t *link = &topic_nodes[parent].first_child;
+        while (*link != node)
+        {
+            link = &topic_nodes[*link].next_sibling;
+        }
+        *link = topic_nodes[node].next_sibling;
+        topic_ref_t level = topic_nodes[node].level;
+        topic_nodes[node].level = 0;
+        topic_release(level);
+        node = parent;
+    }
+}
+
+// Find (or create) the node for a validated filter, 0 if unknown or the index is full
+static int topic_filter_node(const char *filter, bool create)
+{
+    int node = 0;
+    size_t len = 0;
+    const char *level = filter;
+    const char *next;
+    while ((next = next_filter_level(level, &len)) != NULL)
+    {
+        int child = topic_node_child(node, level, len, create);
+        if (!child)
+        {
+            // Drop the part of the path created so far
+            topic_node_prune(node);
+            return 0;
+        }
+        node = child;
+        level = next;
+    }
+    if (filter[strlen(filter) - 1] == '/')
+    {
+        int child = topic_node_child(node, "#", 1, create);
+        if (!child)
+        {
+            topic_node_prune(node);
+        }
+        node = child;
+    }
+    return node;
+}
+
+static int collect_topic_callback(int node, int16_t *matches, int count)
+{
+    if (topic_nodes[node].callback && count < OCRE_MAX_MESSAGE_CALLBACKS)
+    {
+        matches[count++] = node;
+    }
+    return count;
+}
+
+static int match_topic_node(int node, const char *level, int16_t *matches, int count)
+{
+    const char *end = strchr(level, '/');
+    size_t len = end ? (size_t)(end - level) : strlen(level);
+    for (int child = topic_nodes[node].first_child; child; child = topic_nodes[child].next_sibling)
+    {
+        const char *name = topic_str(topic_nodes[child].level);
+        if (strcmp(name, "#") == 0)
+        {
+            count = collect_topic_callback(child, matches, count);
+        }
+        else if (strcmp(name, "+") == 0 || is_level(level, len, name))
+        {
+            if (end)
+            {
+                count = match_topic_node(child, end + 1, matches, count);
+            }
+            else
+            {
+                // "a/#" also matches "a" itself
+                count = collect_topic_callback(child, matches, count);
+                int any = topic_node_child(child, "#", 1, false);
+                if (any)
+                {
+                    count = collect_topic_callback(any, matches, count);
+                }
+            }
+        }
+    }
+    return count;
+}
+
+// Linear matcher with the same semantics as the index, for small tables
+static bool topic_filter_matches(const char *filter, const char *topic)
+{
+    size_t len = 0;
+    const char *level = filter;
+    const char *next;
+    while ((next = next_filter_level(level, &len)) != NULL)
+    {
+        if (len == 1 && level[0] == '#')
+        {
+            return true;
+        }
+        const char *end = strchr(topic, '/');
+        size_t topic_len = end ? (size_t)(end - topic) : strlen(topic);
+        if (!(len == 1 && level[0] == '+') && (len != topic_len || memcmp(level, topic, len) != 0))
+        {
+            return false;
+        }
+        level = next;
+        if (!end)
+        {
+            // Topic exhausted: matches if the filter is too, or only a "#" level remains
+            return level[0] == '\0' || strcmp(level, "#") == 0;
+        }
+        topic = end + 1;
+        if (level[0] == '\0')
+        {
+            // Trailing '/' in the filter
+            return filter[strlen(filter) - 1] == '/';
+        }
+    }
+    return false;
+}
+
+// =============================================================================
+// SOFT TIMER WHEEL
+// =============================================================================
+
+static uint32_t soft_timer_ms_to_ticks(uint32_t ms)
+{
+    uint32_t ticks = ms / OCRE_SOFT_TIMER_TICK_MS + (ms % OCRE_SOFT_TIMER_TICK_MS != 0);
+    if (ticks == 0)
+    {
+        return 1;
+    }
+    return ticks > OCRE_SOFT_TIMER_MAX_TICKS ? OCRE_SOFT_TIMER_MAX_TICKS : ticks;
+}
+
+// Put the timer in the finest level whose span still covers its expiry
+static void soft_timer_link(ocre_soft_timer_t *timer)
+{
+    uint32_t delta = timer->expires - soft_timer_tick;
+    int level = 0;
+    while (level < OCRE_SOFT_TIMER_WHEEL_LEVELS - 1 && delta >= (1U << ((level + 1) * OCRE_SOFT_TIMER_WHEEL_BITS)))
+    {
+        level++;
+    }
+    ocre_soft_timer_t **head = &soft_timer_wheel[level][SOFT_TIMER_SLOT(timer->expires, level)];
+    timer->next = *head;
+    if (*head)
+    {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+static void soft_timer_unlink(ocre_soft_timer_t *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next)
+    {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+// Move the timers of the current slot of a level down, returns the slot index
+static uint32_t soft_timer_cascade(int level)
 {
-    init_callback_system();
-    if (timer_id >= 0 && timer_id < OCRE_MAX_CALLBACKS && timer_callbacks[timer_id])
+    uint32_t slot = SOFT_TIMER_SLOT(soft_timer_tick, level);
+    ocre_soft_timer_t *timer = soft_timer_wheel[level][slot];
+    soft_timer_wheel[level][slot] = NULL;
+    while (timer)
     {
+        ocre_soft_timer_t *next = timer->next;
+        soft_timer_link(timer);
+        timer = next;
+    }
+    return slot;
+}
+
+static int soft_timer_host_start(void)
+{
+    if (soft_timer_host_running)
+    {
+        return OCRE_SUCCESS;
+    }
+    if (!soft_timer_host_created)
+    {
+        // Modules that never use soft timers keep the ID as a user timer
+        if (OCRE_SOFT_TIMER_HOST_ID < OCRE_MAX_TIMER_CALLBACKS &&
+            (timer_callbacks[OCRE_SOFT_TIMER_HOST_ID] || timer_callbacks_ex[OCRE_SOFT_TIMER_HOST_ID]))
+        {
 #ifdef OCRE_SDK_LOG
-        printf("Executing timer callback for ID: %d\n", timer_id);
+            printf("Error: Soft timers need timer ID %d, which has a user callback\n", OCRE_SOFT_TIMER_HOST_ID);
 #endif
-        timer_callbacks[timer_id]();
+            return OCRE_ERROR_BUSY;
+        }
+        if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_TIMER) != OCRE_SUCCESS)
+        {
+#ifdef OCRE_SDK_LOG
+            printf("Failed to register timer dispatcher\n");
+#endif
+            return OCRE_ERROR_INVALID;
+        }
+        int ret = ocre_timer_create(OCRE_SOFT_TIMER_HOST_ID);
+        if (ret != OCRE_SUCCESS)
+        {
+#ifdef OCRE_SDK_LOG
+            printf("Error: Failed to create soft timer host timer %d\n", OCRE_SOFT_TIMER_HOST_ID);
+#endif
+            return ret;
+        }
+        soft_timer_host_created = true;
     }
-    else
+    int ret = ocre_timer_start(OCRE_SOFT_TIMER_HOST_ID, OCRE_SOFT_TIMER_TICK_MS, 1);
+    if (ret != OCRE_SUCCESS)
     {
 #ifdef OCRE_SDK_LOG
-        printf("No timer callback registered for ID: %d\n", timer_id);
+        printf("Error: Failed to start soft timer host timer %d\n", OCRE_SOFT_TIMER_HOST_ID);
 #endif
+        return ret;
     }
+    soft_timer_host_running = true;
+    return OCRE_SUCCESS;
 }
 
-void OCRE_EXPORT("gpio_callback") gpio_callback(int pin, int state, int port)
+// Stop ticking while no soft timer is armed
+static void soft_timer_host_idle(void)
 {
-    init_callback_system();
-#ifdef OCRE_SDK_LOG
-    printf("GPIO event triggered: pin=%d, port=%d, state=%d\n", pin, port, state);
-#endif
-    for (int i = 0; i < OCRE_MAX_CALLBACKS; i++)
+    if (soft_timer_count == 0 && soft_timer_host_running)
+    {
+        ocre_timer_stop(OCRE_SOFT_TIMER_HOST_ID);
+        soft_timer_host_running = false;
+    }
+}
+
+static void soft_timer_advance(void)
+{
+    uint32_t slot = soft_timer_tick & SOFT_TIMER_WHEEL_MASK;
+    if (slot == 0)
     {
-        if (gpio_callback_pins[i] == pin && gpio_callback_ports[i] == port && gpio_callbacks[i])
+        for (int level = 1; level < OCRE_SOFT_TIMER_WHEEL_LEVELS && soft_timer_cascade(level) == 0; level++)
         {
-#ifdef OCRE_SDK_LOG
-            printf("Executing GPIO callback for pin: %d, port: %d\n", pin, port);
-#endif
-            gpio_callbacks[i]();
-            return;
         }
     }
+
+    // Detach the expired slot so callbacks can re-arm or stop any timer, including listed ones
+    ocre_soft_timer_t *expired = soft_timer_wheel[0][slot];
+    soft_timer_wheel[0][slot] = NULL;
+    if (expired)
+    {
+        expired->pprev = &expired;
+    }
+    soft_timer_tick++;
+
+    while (expired)
+    {
+        ocre_soft_timer_t *timer = expired;
+        soft_timer_unlink(timer);
+        if (timer->period)
+        {
+            timer->expires += timer->period;
+            soft_timer_link(timer);
+        }
+        else
+        {
+            soft_timer_count--;
+        }
+        timer->callback(timer, timer->user_data);
+    }
+}
+
+// One host expiry, plus any coalesced overruns, per wheel tick
+static void soft_timer_expire(uint32_t overruns)
+{
+    uint64_t ticks = (uint64_t)overruns + 1;
+    while (ticks-- > 0 && soft_timer_count > 0)
+    {
+        soft_timer_advance();
+    }
+    soft_timer_host_idle();
+}
+
+int ocre_soft_timer_init(ocre_soft_timer_t *timer, ocre_soft_timer_func_t callback, void *user_data)
+{
+    if (timer == NULL || callback == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    memset(timer, 0, sizeof(*timer));
+    timer->callback = callback;
+    timer->user_data = user_data;
+    return OCRE_SUCCESS;
+}
+
+int ocre_soft_timer_start(ocre_soft_timer_t *timer, uint32_t timeout_ms, uint32_t period_ms)
+{
+    if (timer == NULL || timer->callback == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (timer->pprev)
+    {
+        soft_timer_unlink(timer);
+        soft_timer_count--;
+    }
+    timer->expires = soft_timer_tick + soft_timer_ms_to_ticks(timeout_ms) - 1;
+    timer->period = period_ms ? soft_timer_ms_to_ticks(period_ms) : 0;
+    soft_timer_link(timer);
+    soft_timer_count++;
+
+    int ret = soft_timer_host_start();
+    if (ret != OCRE_SUCCESS)
+    {
+        soft_timer_unlink(timer);
+        soft_timer_count--;
+        return ret;
+    }
+    return OCRE_SUCCESS;
+}
+
+int ocre_soft_timer_stop(ocre_soft_timer_t *timer)
+{
+    if (timer == NULL || timer->pprev == NULL)
+    {
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    soft_timer_unlink(timer);
+    soft_timer_count--;
+    soft_timer_host_idle();
+    return OCRE_SUCCESS;
+}
+
+bool ocre_soft_timer_is_active(const ocre_soft_timer_t *timer)
+{
+    return timer != NULL && timer->pprev != NULL;
+}
+
+int ocre_soft_timer_get_remaining(const ocre_soft_timer_t *timer)
+{
+    if (!ocre_soft_timer_is_active(timer))
+    {
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    return (int)((timer->expires - soft_timer_tick + 1) * OCRE_SOFT_TIMER_TICK_MS);
+}
+
+// =============================================================================
+// INTERNAL CALLBACK DISPATCHERS
+// =============================================================================
+
+static void dispatch_timer(int timer_id, uint32_t overruns)
+{
+    if (timer_id == OCRE_SOFT_TIMER_HOST_ID && soft_timer_host_created)
+    {
+        soft_timer_expire(overruns);
+    }
+    else if (timer_id >= 0 && timer_id < OCRE_MAX_TIMER_CALLBACKS && timer_callbacks_ex[timer_id])
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Executing timer callback for ID: %d (overruns: %u)\n", timer_id, overruns);
+#endif
+        timer_callbacks_ex[timer_id](timer_id, overruns);
+    }
+    else if (timer_id >= 0 && timer_id < OCRE_MAX_TIMER_CALLBACKS && timer_callbacks[timer_id])
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Executing timer callback for ID: %d\n", timer_id);
+#endif
+        timer_callbacks[timer_id]();
+    }
+    else
+    {
+        sdk_stats.events_unmatched++;
+#ifdef OCRE_SDK_LOG
+        printf("No timer callback registered for ID: %d\n", timer_id);
+#endif
+    }
+}
+
+void OCRE_EXPORT("timer_callback") timer_callback(int timer_id)
+{
+    dispatch_timer(timer_id, 0);
+}
+
+static bool gpio_pin_valid(int port, int pin)
+{
+    return port >= 0 && port < CONFIG_OCRE_GPIO_MAX_PORTS && pin >= 0 && pin < CONFIG_OCRE_GPIO_PINS_PER_PORT;
+}
+
+static gpio_callback_entry_t *gpio_callback_entry(int port, int pin)
+{
+    if (!gpio_pin_valid(port, pin) || gpio_callback_index[GPIO_PIN_INDEX(port, pin)] == 0)
+    {
+        return NULL;
+    }
+    return &gpio_callbacks[gpio_callback_index[GPIO_PIN_INDEX(port, pin)] - 1];
+}
+
+static int set_gpio_callback(int port, int pin, gpio_callback_func_t callback, gpio_callback_ex_func_t callback_ex,
+                             void *user_data, uint8_t edges)
+{
+    gpio_callback_entry_t *entry = gpio_callback_entry(port, pin);
+    if (entry == NULL)
+    {
+        for (int i = 0; i < OCRE_MAX_GPIO_CALLBACKS; i++)
+        {
+            if (gpio_callbacks[i].callback == NULL && gpio_callbacks[i].callback_ex == NULL)
+            {
+                entry = &gpio_callbacks[i];
+                gpio_callback_index[GPIO_PIN_INDEX(port, pin)] = i + 1;
+                break;
+            }
+        }
+    }
+    if (entry == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No available slots for GPIO callbacks\n");
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    entry->callback = callback;
+    entry->callback_ex = callback_ex;
+    entry->user_data = user_data;
+    entry->edges = edges;
+    return OCRE_SUCCESS;
+}
+
+void OCRE_EXPORT("gpio_callback") gpio_callback(int pin, int state, int port)
+{
+#ifdef OCRE_SDK_LOG
+    printf("GPIO event triggered: pin=%d, port=%d, state=%d\n", pin, port, state);
+#endif
+    gpio_callback_entry_t *entry = gpio_callback_entry(port, pin);
+    if (entry)
+    {
+        // The host filters edges too; this keeps the contract if it delivers both
+        if (!(entry->edges & (state ? OCRE_GPIO_EDGE_RISING : OCRE_GPIO_EDGE_FALLING)))
+        {
+            return;
+        }
+#ifdef OCRE_SDK_LOG
+        printf("Executing GPIO callback for pin: %d, port: %d\n", pin, port);
+#endif
+        if (entry->callback_ex)
+        {
+            entry->callback_ex(port, pin, state ? OCRE_GPIO_PIN_SET : OCRE_GPIO_PIN_RESET, entry->user_data);
+        }
+        else
+        {
+            entry->callback();
+        }
+        return;
+    }
+    sdk_stats.events_unmatched++;
+#ifdef OCRE_SDK_LOG
+    printf("No GPIO callback registered for pin: %d, port: %d\n", pin, port);
+#endif
+}
+
+// Fragments carry OCRE_FRAGMENT_CONTENT_SUFFIX after the original content type
+static bool is_fragment(const char *content_type)
+{
+    size_t type_len = strlen(content_type);
+    size_t suffix_len = sizeof(OCRE_FRAGMENT_CONTENT_SUFFIX) - 1;
+    return type_len > suffix_len && strcmp(content_type + type_len - suffix_len, OCRE_FRAGMENT_CONTENT_SUFFIX) == 0;
+}
+
+static void reassemble_fragment(message_stream_t *stream, const char *topic, const char *content_type,
+                                const ocre_fragment_header_t *header, const uint8_t *chunk, uint32_t chunk_len)
+{
+    if (header->offset == 0)
+    {
+        stream->stream_id = header->stream_id;
+        stream->received = 0;
+        stream->assembling = header->total_len <= stream->buf_size;
+#ifdef OCRE_SDK_LOG
+        if (!stream->assembling)
+        {
+            printf("Error: Stream of %u bytes on %s exceeds buffer of %u bytes\n", header->total_len, topic, stream->buf_size);
+        }
+#endif
+    }
+    if (!stream->assembling || stream->stream_id != header->stream_id || stream->received != header->offset)
+    {
+        // Lost or foreign fragment, drop until the next stream starts
+        stream->assembling = false;
+        return;
+    }
+    memcpy(stream->buf + header->offset, chunk, chunk_len);
+    stream->received += chunk_len;
+    if (stream->received == header->total_len)
+    {
+        stream->assembling = false;
+        stream->complete_callback(topic, content_type, stream->buf, header->total_len);
+    }
+}
+
+static void dispatch_fragment(char *topic, char *content_type, uint8_t *payload, uint32_t payload_len)
+{
+    ocre_fragment_header_t header;
+    if (payload_len < sizeof(header))
+    {
+        return;
+    }
+    memcpy(&header, payload, sizeof(header));
+    const uint8_t *chunk = payload + sizeof(header);
+    uint32_t chunk_len = payload_len - sizeof(header);
+    if (header.magic != OCRE_FRAGMENT_MAGIC || header.offset > header.total_len ||
+        chunk_len > header.total_len - header.offset)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Malformed fragment on topic %s\n", topic);
+#endif
+        return;
+    }
+
+    // Strip the marker in place, the buffer belongs to the module
+    content_type[strlen(content_type) - (sizeof(OCRE_FRAGMENT_CONTENT_SUFFIX) - 1)] = '\0';
+
+    for (int i = 0; i < OCRE_MAX_STREAM_CALLBACKS; i++)
+    {
+        message_stream_t *stream = &message_streams[i];
+        if (stream->topic == 0 || !topic_filter_matches(topic_str(stream->topic), topic))
+        {
+            continue;
+        }
+        if (stream->chunk_callback)
+        {
+            stream->chunk_callback(topic, content_type, chunk, chunk_len, header.offset, header.total_len);
+        }
+        else
+        {
+            reassemble_fragment(stream, topic, content_type, &header, chunk, chunk_len);
+        }
+    }
+}
+
+void OCRE_EXPORT("message_callback") message_callback(uint32_t message_id, char *topic_ptr, char *content_type_ptr, uint8_t *payload_ptr, uint32_t payload_len)
+{
+#ifdef OCRE_SDK_LOG
+    printf("Message ID: %d\n", message_id);
+    printf("Topic: %s\n", topic_ptr);
+    printf("Content-Type: %s\n", content_type_ptr);
+    printf("Payload: %s\n", payload_ptr);
+    printf("Payload len: %d\n", payload_len);
+
+    printf("Message event triggered: topic=%s, content_type=%s, payload_len=%d\n", topic_ptr, content_type_ptr, payload_len);
+#endif
+    if (is_fragment(content_type_ptr))
+    {
+        dispatch_fragment(topic_ptr, content_type_ptr, payload_ptr, payload_len);
+        return;
+    }
+
+    // Collect first so callbacks may (un)register topics while being called
+    int16_t matches[OCRE_MAX_MESSAGE_CALLBACKS];
+    message_callback_func_t callbacks[OCRE_MAX_MESSAGE_CALLBACKS];
+    int count = match_topic_node(0, topic_ptr, matches, 0);
+    for (int i = 0; i < count; i++)
+    {
+        callbacks[i] = topic_nodes[matches[i]].callback;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        // Skip callbacks unregistered by an earlier one
+        if (topic_nodes[matches[i]].callback == callbacks[i])
+        {
+#ifdef OCRE_SDK_LOG
+            printf("Executing message callback for topic: %s\n", topic_ptr);
+#endif
+            callbacks[i](topic_ptr, content_type_ptr, payload_ptr, payload_len);
+        }
+    }
+    if (count == 0)
+    {
+        sdk_stats.events_unmatched++;
+#ifdef OCRE_SDK_LOG
+        printf("No message callback registered for topic: %s\n", topic_ptr);
+#endif
+    }
+}
+
+static topic_handle_t *topic_handle_entry(int handle)
+{
+    for (int i = 0; i < OCRE_MAX_TOPIC_HANDLES; i++)
+    {
+        if (topic_handles[i].handle == handle && handle > 0)
+        {
+            return &topic_handles[i];
+        }
+    }
+    return NULL;
+}
+
+static bool rx_pool_contains(const ocre_msg_pool_t *pool, const void *ptr)
+{
+    return ptr != NULL && (const uint8_t *)ptr >= pool->slots &&
+           (const uint8_t *)ptr < pool->slots + pool->slot_size * pool->slot_count;
+}
+
+static ocre_msg_pool_t *rx_pool_owner(const void *ptr)
+{
+    for (int i = 0; i < OCRE_MAX_RX_POOLS; i++)
+    {
+        if (rx_pools[i] && rx_pool_contains(rx_pools[i], ptr))
+        {
+            return rx_pools[i];
+        }
+    }
+    return NULL;
+}
+
+static void rx_pool_recycle(ocre_msg_pool_t *pool, const void *ptr)
+{
+    uint32_t index = (uint32_t)((const uint8_t *)ptr - pool->slots) / pool->slot_size;
+    ((ocre_msg_slot_t *)(pool->slots + index * pool->slot_size))->released = 1;
+    sdk_stats.rx_pool_messages++;
+
+    // The host fills slots in ring order, so the tail only passes released ones and a
+    // retained message holds back the slots after it
+    uint32_t tail = pool->ring.tail;
+    uint32_t head = __atomic_load_n(&pool->ring.head, __ATOMIC_SEQ_CST);
+    while (tail != head)
+    {
+        ocre_msg_slot_t *slot = (ocre_msg_slot_t *)(pool->slots + (tail % pool->slot_count) * pool->slot_size);
+        if (!slot->released)
+        {
+            break;
+        }
+        slot->released = 0;
+        tail++;
+    }
+    __atomic_store_n(&pool->ring.tail, tail, __ATOMIC_SEQ_CST);
+}
+
+static void free_message_buffers(const ocre_msg_t *msg)
+{
+    // Messages in a receive pool slot are recycled in place, without a host call
+    const void *data = msg->payload ? (const void *)msg->payload : (const void *)msg->topic;
+    ocre_msg_pool_t *pool = rx_pool_owner(data);
+    if (pool)
+    {
+        rx_pool_recycle(pool, data);
+        return;
+    }
+
+    // Strings of handle-tagged messages are the SDK's own, only the payload is host-allocated
+    uint32_t topic = topic_pool_owns(msg->topic) ? 0 : (uint32_t)msg->topic;
+    uint32_t content_type = topic_pool_owns(msg->content_type) ? 0 : (uint32_t)msg->content_type;
+    if (ocre_messaging_free_module_event_data(topic, content_type, (uint32_t)msg->payload) != OCRE_SUCCESS)
+    {
+        sdk_stats.free_failures++;
+#ifdef OCRE_SDK_LOG
+        printf("Error: Module event data wasn't freed successfully");
+#endif
+    }
+}
+
+static void dispatch_message(const event_data_t *event_data)
+{
+    // Callbacks see the host-allocated buffers directly; they are released
+    // once the callbacks return unless one of them retained the message.
+    ocre_msg_t msg = {
+        .mid = event_data->id,
+        .topic = (char *)event_data->port,
+        .content_type = (char *)event_data->state,
+        .payload = (void *)event_data->extra,
+        .payload_len = event_data->payload_len,
+    };
+    if (event_data->port == 0)
+    {
+        // Handle-tagged: id is the topic handle and state the message ID
+        topic_handle_t *entry = topic_handle_entry((int)event_data->id);
+        if (entry == NULL)
+        {
+#ifdef OCRE_SDK_LOG
+            printf("Error: Message for unknown topic handle %u\n", event_data->id);
+#endif
+            sdk_stats.events_unmatched++;
+            msg.content_type = NULL;
+            free_message_buffers(&msg);
+            return;
+        }
+        msg.mid = event_data->state;
+        msg.topic = (char *)topic_str(entry->topic);
+        msg.content_type = (char *)topic_str(entry->content_type);
+    }
+    // A callback closing the handle must not move the strings under the others
+    bool pinned = topic_pool_owns(msg.topic);
+    topic_pool_pins += pinned;
+    ocre_msg_t *prev_message = current_message;
+    bool prev_retained = current_message_retained;
+
+    current_message = &msg;
+    current_message_retained = false;
+    message_callback(msg.mid, msg.topic, msg.content_type, msg.payload, msg.payload_len);
+    if (!current_message_retained)
+    {
+        free_message_buffers(&msg);
+        if (pinned)
+        {
+            topic_pool_unpin();
+        }
+    }
+    current_message = prev_message;
+    current_message_retained = prev_retained;
+}
+
+void OCRE_EXPORT("channel_callback") channel_callback(int handle)
+{
+    for (int i = 0; i < OCRE_MAX_CHANNELS; i++)
+    {
+        ocre_channel_t *channel = channels[i];
+        if (channel && channel->handle == handle && channel->callback)
+        {
+            channel->callback(channel, channel->user_data);
+            return;
+        }
+    }
+    sdk_stats.events_unmatched++;
+#ifdef OCRE_SDK_LOG
+    printf("No channel callback registered for handle: %d\n", handle);
+#endif
+}
+
+// Hand a run of records to the callback and update the interval estimate
+static void gpio_capture_deliver(ocre_gpio_capture_t *capture, const ocre_gpio_edge_record_t *edges, uint32_t count)
+{
+    uint64_t first = capture->last_timestamp_ns ? capture->last_timestamp_ns : edges[0].timestamp_ns;
+    uint32_t intervals = capture->last_timestamp_ns ? count : count - 1;
+    capture->last_timestamp_ns = edges[count - 1].timestamp_ns;
+    if (intervals > 0)
+    {
+        capture->interval_ns = (capture->last_timestamp_ns - first) / intervals;
+    }
+    capture->callback(capture, edges, count, capture->user_data);
+}
+
+void OCRE_EXPORT("gpio_capture_callback") gpio_capture_callback(int handle)
+{
+    for (int i = 0; i < OCRE_MAX_GPIO_CAPTURES; i++)
+    {
+        ocre_gpio_capture_t *capture = gpio_captures[i];
+        if (capture && capture->handle == handle)
+        {
+            uint32_t tail = capture->ring.tail;
+            uint32_t head = __atomic_load_n(&capture->ring.head, __ATOMIC_ACQUIRE);
+            while (head != tail)
+            {
+                uint32_t pos = tail % capture->record_count;
+                uint32_t count = head - tail;
+                if (count > capture->record_count - pos)
+                {
+                    count = capture->record_count - pos;
+                }
+                gpio_capture_deliver(capture, &capture->records[pos], count);
+                if (gpio_captures[i] != capture)
+                {
+                    return; // Stopped from its own callback
+                }
+                tail += count;
+                __atomic_store_n(&capture->ring.tail, tail, __ATOMIC_RELEASE);
+            }
+            return;
+        }
+    }
+    sdk_stats.events_unmatched++;
+#ifdef OCRE_SDK_LOG
+    printf("No GPIO capture registered for handle: %d\n", handle);
+#endif
+}
+
+void OCRE_EXPORT("file_watch_callback") file_watch_callback(int handle, uint32_t changes)
+{
+    for (int i = 0; i < OCRE_MAX_FILE_WATCHES; i++)
+    {
+        ocre_file_watch_t *watch = file_watches[i];
+        if (watch && watch->handle == handle)
+        {
+            watch->callback(watch, changes, watch->user_data);
+            return;
+        }
+    }
+    sdk_stats.events_unmatched++;
+#ifdef OCRE_SDK_LOG
+    printf("No file watch registered for handle: %d\n", handle);
+#endif
+}
+
+void OCRE_EXPORT("sensor_callback") sensor_callback(int handle)
+{
+    for (int i = 0; i < OCRE_MAX_SENSOR_STREAMS; i++)
+    {
+        ocre_sensor_stream_t *stream = sensor_streams[i];
+        if (stream && stream->handle == handle)
+        {
+            // Drain everything, the host only signals when it writes into an empty buffer
+            uint32_t tail = stream->ring.tail;
+            while (__atomic_load_n(&stream->ring.head, __ATOMIC_SEQ_CST) != tail)
+            {
+                const ocre_sensor_block_t *block =
+                    (const ocre_sensor_block_t *)&stream->blocks[(tail % stream->block_count) * stream->block_size];
+                stream->callback(stream, block, stream->user_data);
+                if (sensor_streams[i] != stream)
+                {
+                    return; // Stopped from its own callback
+                }
+                tail++;
+                // Sequentially consistent with the host's head store, as for channels
+                __atomic_store_n(&stream->ring.tail, tail, __ATOMIC_SEQ_CST);
+            }
+            return;
+        }
+    }
+    sdk_stats.events_unmatched++;
+#ifdef OCRE_SDK_LOG
+    printf("No sensor stream registered for handle: %d\n", handle);
+#endif
+}
+
+void OCRE_EXPORT("flow_callback") flow_callback(int handle, uint32_t credits)
+{
+    topic_handle_t *entry = topic_handle_entry(handle);
+    if (entry && entry->writable_callback)
+    {
+        entry->writable_callback(handle, credits, entry->writable_user_data);
+        return;
+    }
+    sdk_stats.events_unmatched++;
+#ifdef OCRE_SDK_LOG
+    printf("No writable callback registered for topic handle: %d\n", handle);
+#endif
+}
+
+static void dispatch_event(const event_data_t *event_data)
+{
+#ifdef OCRE_SDK_LOG
+    printf("Ocre process event retrieved: type=%u, id=%d, port(topic)=%u, state(content)=%u, extra(payload)=%u payload_len=%d\n", event_data->type, event_data->id, event_data->port, event_data->state, event_data->extra, event_data->payload_len);
+#endif
+    if (event_data->type < OCRE_RESOURCE_TYPE_COUNT)
+    {
+        sdk_stats.events_dispatched[event_data->type]++;
+    }
+    switch (event_data->type)
+    {
+    case OCRE_RESOURCE_TYPE_TIMER:
+        // extra carries the number of expiries the host coalesced into this one
+        dispatch_timer(event_data->id, event_data->extra);
+        break;
+    case OCRE_RESOURCE_TYPE_GPIO:
+        gpio_callback(event_data->id, event_data->state, event_data->port);
+        break;
+    case OCRE_RESOURCE_TYPE_SENSOR:
+        sensor_callback(event_data->id);
+        break;
+    case OCRE_RESOURCE_TYPE_MESSAGE:
+        dispatch_message(event_data);
+        break;
+    case OCRE_RESOURCE_TYPE_CHANNEL:
+        channel_callback(event_data->id);
+        break;
+    case OCRE_RESOURCE_TYPE_GPIO_CAPTURE:
+        gpio_capture_callback(event_data->id);
+        break;
+    case OCRE_RESOURCE_TYPE_FILE_WATCH:
+        // extra carries the changes the host coalesced into this event
+        file_watch_callback(event_data->id, event_data->extra);
+        break;
+#ifdef OCRE_SDK_THREADS
+    case OCRE_RESOURCE_TYPE_WORKQUEUE:
+        workqueue_callback(event_data->id);
+        break;
+#endif
+    case OCRE_RESOURCE_TYPE_FLOW:
+        // extra carries the credits available when the host queued the event
+        flow_callback(event_data->id, event_data->extra);
+        break;
+    default:
+        sdk_stats.events_unmatched++;
+#ifdef OCRE_SDK_LOG
+        printf("Unknown event: type=%d, id=%d, port=%d, state=%d\n",
+               event_data->type, event_data->id, event_data->port, event_data->state);
+#endif
+        break;
+    }
+}
+
+static void stats_histogram_add(uint32_t *histogram, uint64_t us)
+{
+    uint32_t bucket = 0;
+    while (us > 0 && bucket < OCRE_STATS_HISTOGRAM_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    histogram[bucket]++;
+}
+
+#ifdef OCRE_SDK_TRACE
+static uint16_t trace_saturate(uint32_t value)
+{
+    return value > UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+}
+
+static void trace_event(const event_data_t *event_data, uint64_t start_us, uint64_t end_us)
+{
+    ocre_trace_record_t *record = &trace_ring.records[trace_ring.head & (OCRE_TRACE_RING_SIZE - 1)];
+    record->timestamp_us = (uint32_t)start_us;
+    record->duration_us = (uint32_t)(end_us - start_us);
+    record->id = event_data->id;
+    record->type = (uint16_t)event_data->type;
+    switch (event_data->type)
+    {
+    case OCRE_RESOURCE_TYPE_TIMER:
+        record->extra = trace_saturate(event_data->extra);
+        break;
+    case OCRE_RESOURCE_TYPE_GPIO:
+        record->extra = (uint16_t)((event_data->port & 0xFF) << 8 | (event_data->state & 0xFF));
+        break;
+    case OCRE_RESOURCE_TYPE_MESSAGE:
+        record->extra = trace_saturate(event_data->payload_len);
+        break;
+    default:
+        record->extra = 0;
+        break;
+    }
+    trace_ring.head++;
+}
+#endif
+
+static uint8_t event_priority(const event_data_t *event_data)
+{
+    return event_data->type < OCRE_RESOURCE_TYPE_COUNT ? event_priorities[event_data->type] : OCRE_EVENT_PRIORITY_LOWEST;
+}
+
+// Stable insertion sort by priority, batches are small
+static void sort_pending_events(void)
+{
+    for (uint32_t i = 1; i < pending_count; i++)
+    {
+        event_data_t event_data = pending_events[i];
+        uint8_t priority = event_priority(&event_data);
+        uint32_t j = i;
+        while (j > 0 && event_priority(&pending_events[j - 1]) > priority)
+        {
+            pending_events[j] = pending_events[j - 1];
+            j--;
+        }
+        pending_events[j] = event_data;
+    }
+}
+
+// Merge repeated expiries of the same timer into the first one, adding to its overrun count
+static void coalesce_pending_timers(void)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < pending_count; i++)
+    {
+        event_data_t *event_data = &pending_events[i];
+        bool merged = false;
+        if (event_data->type == OCRE_RESOURCE_TYPE_TIMER)
+        {
+            for (uint32_t j = 0; j < count; j++)
+            {
+                if (pending_events[j].type == OCRE_RESOURCE_TYPE_TIMER && pending_events[j].id == event_data->id)
+                {
+                    pending_events[j].extra += event_data->extra + 1;
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        if (!merged)
+        {
+            pending_events[count++] = *event_data;
+        }
+    }
+    pending_count = count;
+}
+
+// Refill the pending batch from the host, returns number of events the host handed over,
+// before coalescing shrinks the batch
+static int fetch_events(void)
+{
+    uint32_t count = 0;
+    int ret = ocre_get_events(pending_events, OCRE_EVENT_BATCH_SIZE, &count);
+    if (ret != OCRE_SUCCESS)
+    {
+        return ret;
+    }
+    pending_head = 0;
+    pending_count = count > OCRE_EVENT_BATCH_SIZE ? OCRE_EVENT_BATCH_SIZE : count;
+#ifdef OCRE_SDK_TIMING
+    pending_fetch_us = ocre_time_us();
+#endif
+    uint32_t fetched = pending_count;
+    coalesce_pending_timers();
+    sort_pending_events();
+    return (int)fetched;
+}
+
+// Events left over from a previous call are already local and ready tasks have to run,
+// so nothing may block in the host while either is true
+static bool dispatch_ready(void)
+{
+#ifdef OCRE_SDK_THREADS
+    if (ocre_workqueue_stalled())
+    {
+        return true;
+    }
+#endif
+    return pending_count > 0 || ocre_task_ready();
+}
+
+int ocre_process_events_ex(uint32_t flags, int timeout_ms)
+{
+    uint32_t event_count = 0;
+    uint64_t deadline = 0;
+    bool host_empty = false;
+
+    if ((flags & OCRE_EVENT_FLAG_WAIT) && !dispatch_ready())
+    {
+        int ret = ocre_wait_events(timeout_ms);
+        if (ret == OCRE_ERROR_TIMEOUT)
+        {
+            return 0;
+        }
+        if (ret != OCRE_SUCCESS)
+        {
+#ifdef OCRE_SDK_LOG
+            printf("Error: Waiting for events failed (%d)\n", ret);
+#endif
+            return ret;
+        }
+    }
+
+    if (event_policy.max_time_us > 0)
+    {
+        deadline = ocre_time_us() + event_policy.max_time_us;
+    }
+
+    // Drain back-to-back: the host queue is only polled, never slept on
+    while (event_policy.max_events == OCRE_EVENT_DRAIN || event_count < event_policy.max_events)
+    {
+        if (pending_count == 0)
+        {
+            // A short batch means the host queue was empty, skip the extra round trip
+            int fetched = host_empty ? 0 : fetch_events();
+            if (fetched <= 0)
+            {
+                break;
+            }
+            host_empty = (uint32_t)fetched < OCRE_EVENT_BATCH_SIZE;
+        }
+
+        // Take the event off the batch before dispatch so callbacks may re-enter
+        event_data_t event_data = pending_events[pending_head++];
+        pending_count--;
+        // Each timestamp is a host call, only taken when something reads it
+#if defined(OCRE_SDK_TIMING) || defined(OCRE_SDK_TRACE)
+        uint64_t start_us = ocre_time_us();
+#endif
+#ifdef OCRE_SDK_TIMING
+        stats_histogram_add(sdk_stats.batch_wait_us, start_us - pending_fetch_us);
+#endif
+        dispatch_event(&event_data);
+        ocre_task_event(&event_data);
+#if defined(OCRE_SDK_TIMING) || defined(OCRE_SDK_TRACE)
+        uint64_t end_us = ocre_time_us();
+#else
+        uint64_t end_us = deadline ? ocre_time_us() : 0;
+#endif
+#ifdef OCRE_SDK_TIMING
+        stats_histogram_add(sdk_stats.callback_duration_us, end_us - start_us);
+#endif
+#ifdef OCRE_SDK_TRACE
+        trace_event(&event_data, start_us, end_us);
+#endif
+        event_count++;
+
+        if (deadline && end_us >= deadline)
+        {
+            break;
+        }
+    }
+
+#ifdef OCRE_SDK_THREADS
+    ocre_workqueue_run_stalled();
+#endif
+    ocre_task_run();
+    return (int)event_count;
+}
+
+int ocre_poll(struct pollfd *fds, uint32_t nfds, int timeout_ms)
+{
+    // Fetched events and ready tasks can run right away, only check the descriptors
+    if (dispatch_ready())
+    {
+        timeout_ms = 0;
+    }
+    return ocre_poll_events(fds, nfds, timeout_ms);
+}
+
+int ocre_set_event_policy(const ocre_event_policy_t *policy)
+{
+    if (policy == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    event_policy = *policy;
+    return OCRE_SUCCESS;
+}
+
+int ocre_get_event_policy(ocre_event_policy_t *policy)
+{
+    if (policy == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    *policy = event_policy;
+    return OCRE_SUCCESS;
+}
+
+int ocre_set_event_priority(ocre_resource_type_t type, uint8_t priority)
+{
+    if (type >= OCRE_RESOURCE_TYPE_COUNT)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    event_priorities[type] = priority;
+    // Only a hint: hosts with a single queue still get local ordering per batch
+    if (ocre_set_event_queue_priority(type, priority) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Host does not support per-type event queues, ordering locally\n");
+#endif
+    }
+    return OCRE_SUCCESS;
+}
+
+int ocre_sdk_get_stats(ocre_sdk_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    *stats = sdk_stats;
+    if (ocre_get_event_queue_stats(&stats->host) != OCRE_SUCCESS)
+    {
+        memset(&stats->host, 0, sizeof(stats->host));
+    }
+    ocre_alloc_get_totals(&stats->memory);
+    return OCRE_SUCCESS;
+}
+
+void ocre_sdk_reset_stats(void)
+{
+    memset(&sdk_stats, 0, sizeof(sdk_stats));
+    ocre_alloc_reset_stats();
+}
+
+const ocre_trace_ring_t *OCRE_EXPORT("ocre_trace_ring") ocre_trace_get_ring(void)
+{
+#ifdef OCRE_SDK_TRACE
+    return &trace_ring;
+#else
+    return NULL;
+#endif
+}
+
+uint32_t ocre_trace_read(ocre_trace_record_t *records, uint32_t max)
+{
+    uint32_t count = 0;
+#ifdef OCRE_SDK_TRACE
+    if (records == NULL)
+    {
+        return 0;
+    }
+    if (trace_ring.head - trace_tail > OCRE_TRACE_RING_SIZE)
+    {
+        trace_tail = trace_ring.head - OCRE_TRACE_RING_SIZE;
+    }
+    while (count < max && trace_tail != trace_ring.head)
+    {
+        records[count++] = trace_ring.records[trace_tail++ & (OCRE_TRACE_RING_SIZE - 1)];
+    }
+#else
+    (void)records;
+    (void)max;
+#endif
+    return count;
+}
+
+int ocre_message_retain(ocre_msg_t *msg)
+{
+    if (msg == NULL || current_message == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No message is being dispatched\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (current_message_retained)
+    {
+        // One owner only, a second one would free the buffers twice
+#ifdef OCRE_SDK_LOG
+        printf("Error: Message already retained by another callback\n");
+#endif
+        return OCRE_ERROR_BUSY;
+    }
+    *msg = *current_message;
+    current_message_retained = true;
+    return OCRE_SUCCESS;
+}
+
+int ocre_message_release(ocre_msg_t *msg)
+{
+    if (msg == NULL || msg->topic == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    bool pinned = topic_pool_owns(msg->topic);
+    free_message_buffers(msg);
+    memset(msg, 0, sizeof(*msg));
+    if (pinned)
+    {
+        topic_pool_unpin(); // Held since dispatch for the strings of a handle-tagged message
+    }
+    return OCRE_SUCCESS;
+}
+
+uint64_t ocre_time_us(void)
+{
+    return ocre_time_ns() / 1000ULL;
+}
+
+void ocre_process_events(void)
+{
+    if (ocre_process_events_ex(OCRE_EVENT_FLAG_NONE, 0) <= 0 && !dispatch_ready())
+    {
+        ocre_sleep(10);
+    }
+}
+
+// =============================================================================
+// PUBLIC API FUNCTIONS
+// =============================================================================
+
+int ocre_dispatcher_ensure(ocre_resource_type_t type)
+{
+    if ((uint32_t)type >= OCRE_RESOURCE_TYPE_COUNT)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (dispatchers_registered & (1U << type))
+    {
+        return OCRE_SUCCESS;
+    }
+    int ret = ocre_register_dispatcher(type, dispatcher_exports[type]);
+    if (ret == OCRE_SUCCESS)
+    {
+        dispatchers_registered |= 1U << type;
+    }
+    return ret;
+}
+
+int ocre_register_timer_callback(int timer_id, timer_callback_func_t callback)
+{
+    if (timer_id < 0 || timer_id >= OCRE_MAX_TIMER_CALLBACKS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Timer ID %d out of range (0-%d)\n", timer_id, OCRE_MAX_TIMER_CALLBACKS - 1);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (timer_id == OCRE_SOFT_TIMER_HOST_ID && soft_timer_host_created)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Timer ID %d is in use by the soft timers\n", timer_id);
+#endif
+        return OCRE_ERROR_BUSY;
+    }
+    if (callback == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Timer callback is NULL for ID %d\n", timer_id);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_TIMER) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register timer dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    timer_callbacks[timer_id] = callback;
+    timer_callbacks_ex[timer_id] = NULL;
+#ifdef OCRE_SDK_LOG
+    printf("Timer callback registered for ID: %d\n", timer_id);
+#endif
+    return OCRE_SUCCESS;
+}
+
+int ocre_register_timer_callback_ex(int timer_id, timer_callback_ex_func_t callback)
+{
+    if (timer_id < 0 || timer_id >= OCRE_MAX_TIMER_CALLBACKS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Timer ID %d out of range (0-%d)\n", timer_id, OCRE_MAX_TIMER_CALLBACKS - 1);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (timer_id == OCRE_SOFT_TIMER_HOST_ID && soft_timer_host_created)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Timer ID %d is in use by the soft timers\n", timer_id);
+#endif
+        return OCRE_ERROR_BUSY;
+    }
+    if (callback == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Timer callback is NULL for ID %d\n", timer_id);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_TIMER) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register timer dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    timer_callbacks[timer_id] = NULL;
+    timer_callbacks_ex[timer_id] = callback;
+#ifdef OCRE_SDK_LOG
+    printf("Timer callback registered for ID: %d\n", timer_id);
+#endif
+    return OCRE_SUCCESS;
+}
+
+int ocre_register_gpio_callback(int pin, int port, gpio_callback_func_t callback)
+{
+    if (callback == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: GPIO callback is NULL for pin %d, port %d\n", pin, port);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (!gpio_pin_valid(port, pin))
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Invalid pin %d or port %d\n", pin, port);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_GPIO) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register GPIO dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    int ret = set_gpio_callback(port, pin, callback, NULL, NULL, OCRE_GPIO_EDGE_BOTH);
+    if (ret != OCRE_SUCCESS)
+    {
+        return ret;
+    }
+#ifdef OCRE_SDK_LOG
+    printf("GPIO callback registered for pin: %d, port: %d\n", pin, port);
+#endif
+    return ocre_gpio_register_callback(port, pin);
+}
+
+int ocre_register_gpio_callback_ex(int port, int pin, ocre_gpio_edge_t edge, gpio_callback_ex_func_t callback, void *user_data)
+{
+    if (callback == NULL || (edge & OCRE_GPIO_EDGE_BOTH) == 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: GPIO callback is NULL or no edge selected for pin %d, port %d\n", pin, port);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (!gpio_pin_valid(port, pin))
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Invalid pin %d or port %d\n", pin, port);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_GPIO) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register GPIO dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    int ret = set_gpio_callback(port, pin, NULL, callback, user_data, (uint8_t)(edge & OCRE_GPIO_EDGE_BOTH));
+    if (ret != OCRE_SUCCESS)
+    {
+        return ret;
+    }
+#ifdef OCRE_SDK_LOG
+    printf("GPIO callback registered for pin: %d, port: %d, edge: %d\n", pin, port, edge);
+#endif
+    return ocre_gpio_register_callback_edge(port, pin, edge);
+}
+
+int ocre_register_message_callback(const char *topic, message_callback_func_t callback)
+{
+    if (!topic || topic[0] == '\0')
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Topic is NULL or empty\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (callback == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Message callback is NULL for topic %s\n", topic);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (strlen(topic) >= OCRE_MAX_TOPIC_LEN || validate_topic_filter(topic) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Invalid topic filter %s\n", topic);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    int node = topic_filter_node(topic, false);
+    if (node && topic_nodes[node].callback)
+    {
+        // Same filter registered again, just replace the callback
+        topic_nodes[node].callback = callback;
+        return OCRE_SUCCESS;
+    }
+    if (message_callback_count >= OCRE_MAX_MESSAGE_CALLBACKS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No available slots for message callbacks\n");
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_MESSAGE) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register message dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    node = topic_filter_node(topic, true);
+    if (!node)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No space left in the topic index for %s\n", topic);
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    topic_nodes[node].callback = callback;
+    message_callback_count++;
+#ifdef OCRE_SDK_LOG
+    printf("Message callback registered for topic: %s (node %d)\n", topic, node);
+#endif
+
+    return OCRE_SUCCESS;
+}
+int ocre_unregister_timer_callback(int timer_id)
+{
+    if (timer_id < 0 || timer_id >= OCRE_MAX_TIMER_CALLBACKS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Timer ID %d out of range (0-%d)\n", timer_id, OCRE_MAX_TIMER_CALLBACKS - 1);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (timer_callbacks[timer_id] == NULL && timer_callbacks_ex[timer_id] == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No timer callback registered for ID %d\n", timer_id);
+#endif
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    timer_callbacks[timer_id] = NULL;
+    timer_callbacks_ex[timer_id] = NULL;
+#ifdef OCRE_SDK_LOG
+    printf("Timer callback unregistered for ID: %d\n", timer_id);
+#endif
+    return OCRE_SUCCESS;
+}
+
+int ocre_unregister_gpio_callback(int pin, int port)
+{
+    gpio_callback_entry_t *entry = gpio_callback_entry(port, pin);
+    if (entry == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No GPIO callback registered for pin %d, port %d\n", pin, port);
+#endif
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    memset(entry, 0, sizeof(*entry));
+    gpio_callback_index[GPIO_PIN_INDEX(port, pin)] = 0;
+#ifdef OCRE_SDK_LOG
+    printf("GPIO callback unregistered for pin: %d, port: %d\n", pin, port);
+#endif
+    return ocre_gpio_unregister_callback(port, pin);
+}
+
+int ocre_unregister_message_callback(const char *topic)
+{
+    if (!topic || topic[0] == '\0')
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Topic is NULL or empty\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    int node = topic_filter_node(topic, false);
+    if (!node || topic_nodes[node].callback == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No message callback registered for topic %s\n", topic);
+#endif
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    topic_nodes[node].callback = NULL;
+    message_callback_count--;
+    topic_node_prune(node);
+#ifdef OCRE_SDK_LOG
+    printf("Message callback unregistered for topic: %s\n", topic);
+#endif
+    return OCRE_SUCCESS;
+}
+
+static int register_message_stream(const char *topic, message_chunk_callback_func_t chunk_callback,
+                                   void *buf, uint32_t buf_size, message_callback_func_t complete_callback)
+{
+    if (!topic || topic[0] == '\0' || strlen(topic) >= OCRE_MAX_TOPIC_LEN)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Topic is NULL or empty\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    int slot = -1;
+    for (int i = 0; i < OCRE_MAX_STREAM_CALLBACKS; i++)
+    {
+        if (message_streams[i].topic && strcmp(topic_str(message_streams[i].topic), topic) == 0)
+        {
+            slot = i;
+            break;
+        }
+        if (slot == -1 && message_streams[i].topic == 0)
+        {
+            slot = i;
+        }
+    }
+    if (slot == -1)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No available slots for message streams\n");
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_MESSAGE) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register message dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    message_stream_t *stream = &message_streams[slot];
+    topic_ref_t ref = stream->topic ? stream->topic : topic_intern(topic, strlen(topic));
+    if (ref == 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No space left in the topic pool for %s\n", topic);
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    memset(stream, 0, sizeof(*stream));
+    stream->topic = ref;
+    stream->chunk_callback = chunk_callback;
+    stream->complete_callback = complete_callback;
+    stream->buf = buf;
+    stream->buf_size = buf_size;
+#ifdef OCRE_SDK_LOG
+    printf("Message stream registered for topic: %s (slot %d)\n", topic, slot);
+#endif
+    return OCRE_SUCCESS;
+}
+
+int ocre_register_message_chunk_callback(const char *topic, message_chunk_callback_func_t callback)
+{
+    if (callback == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    return register_message_stream(topic, callback, NULL, 0, NULL);
+}
+
+int ocre_register_message_reassembly(const char *topic, void *buf, uint32_t buf_size, message_callback_func_t callback)
+{
+    if (callback == NULL || buf == NULL || buf_size == 0)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    return register_message_stream(topic, NULL, buf, buf_size, callback);
+}
+
+int ocre_unregister_message_stream(const char *topic)
+{
+    if (!topic || topic[0] == '\0')
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    for (int i = 0; i < OCRE_MAX_STREAM_CALLBACKS; i++)
+    {
+        if (message_streams[i].topic && strcmp(topic_str(message_streams[i].topic), topic) == 0)
+        {
+            topic_ref_t ref = message_streams[i].topic;
+            memset(&message_streams[i], 0, sizeof(message_streams[i]));
+            topic_release(ref);
+            return OCRE_SUCCESS;
+        }
+    }
+    return OCRE_ERROR_NOT_FOUND;
+}
+
+int ocre_topic_open(const char *topic, const char *content_type)
+{
+    if (topic == NULL || content_type == NULL || validate_topic_filter(topic) != OCRE_SUCCESS ||
+        strpbrk(topic, "+#") != NULL || is_fragment(content_type))
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Invalid topic handle parameters\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    topic_handle_t *entry = NULL;
+    for (int i = 0; i < OCRE_MAX_TOPIC_HANDLES && entry == NULL; i++)
+    {
+        if (topic_handles[i].handle == 0)
+        {
+            entry = &topic_handles[i];
+        }
+    }
+    if (entry == NULL)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No available slots for topic handles\n");
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    int handle = ocre_topic_register(topic, content_type);
+    if (handle <= 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Failed to register topic handle for %s\n", topic);
+#endif
+        return handle < 0 ? handle : OCRE_ERROR_INVALID;
+    }
+    if (topic_handle_entry(handle))
+    {
+        // The host hands out one handle per pair
+        return handle;
+    }
+    topic_ref_t topic_ref = topic_intern(topic, strlen(topic));
+    topic_ref_t content_type_ref = topic_intern(content_type, strlen(content_type));
+    if (topic_ref == 0 || content_type_ref == 0)
+    {
+        topic_release(topic_ref);
+        topic_release(content_type_ref);
+        ocre_topic_unregister(handle);
+#ifdef OCRE_SDK_LOG
+        printf("Error: Topic pool full\n");
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    entry->handle = handle;
+    entry->topic = topic_ref;
+    entry->content_type = content_type_ref;
+#ifdef OCRE_SDK_LOG
+    printf("Topic handle %d opened for %s (%s)\n", handle, topic, content_type);
+#endif
+    return handle;
+}
+
+int ocre_topic_close(int handle)
+{
+    topic_handle_t *entry = topic_handle_entry(handle);
+    if (entry == NULL)
+    {
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    if (entry->writable_callback)
+    {
+        ocre_publish_notify_credits(handle, 0);
+    }
+    ocre_topic_unregister(handle);
+    // Clear each ref before releasing it, compaction fixes up the one still stored
+    topic_ref_t content_type_ref = entry->content_type;
+    entry->content_type = 0;
+    topic_release(content_type_ref);
+    topic_ref_t topic_ref = entry->topic;
+    entry->topic = 0;
+    topic_release(topic_ref);
+    memset(entry, 0, sizeof(*entry));
+    return OCRE_SUCCESS;
+}
+
+int ocre_register_writable_callback(int handle, uint32_t threshold, ocre_writable_callback_t callback, void *user_data)
+{
+    topic_handle_t *entry = topic_handle_entry(handle);
+    if (entry == NULL)
+    {
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    if (callback && threshold == 0)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (callback && ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_FLOW) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register flow dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    int ret = ocre_publish_notify_credits(handle, callback ? threshold : 0);
+    if (ret != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Host rejected credit notifications for topic handle %d\n", handle);
+#endif
+        return ret;
+    }
+    entry->writable_callback = callback;
+    entry->writable_user_data = user_data;
+    return OCRE_SUCCESS;
+}
+
+int ocre_publish_message_stream(const char *topic, const char *content_type, const ocre_iovec_t *iov, uint32_t iovcnt)
+{
+    static uint32_t next_stream_id = 0;
+    char fragment_type[OCRE_MAX_CONTENT_TYPE_LEN];
+    ocre_iovec_t fragment_iov[OCRE_MAX_FRAGMENT_IOV + 1];
+    ocre_fragment_header_t header;
+    uint32_t total_len = 0;
+
+    if (!topic || !content_type || (!iov && iovcnt > 0))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    int type_len = snprintf(fragment_type, sizeof(fragment_type), "%s%s", content_type, OCRE_FRAGMENT_CONTENT_SUFFIX);
+    if (type_len < 0 || type_len >= (int)sizeof(fragment_type))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    for (uint32_t i = 0; i < iovcnt; i++)
+    {
+        total_len += iov[i].len;
+    }
+
+    header.magic = OCRE_FRAGMENT_MAGIC;
+    header.stream_id = ++next_stream_id;
+    header.offset = 0;
+    header.total_len = total_len;
+
+    // Each fragment is the header followed by slices of the caller's buffers, no staging copy
+    uint32_t idx = 0;
+    uint32_t pos = 0;
+    uint32_t offset = 0;
+    do
+    {
+        uint32_t room = OCRE_FRAGMENT_DATA_LEN;
+        uint32_t fragment_iovcnt = 1;
+        header.offset = offset;
+        fragment_iov[0].base = &header;
+        fragment_iov[0].len = sizeof(header);
+        while (room > 0 && idx < iovcnt && fragment_iovcnt <= OCRE_MAX_FRAGMENT_IOV)
+        {
+            uint32_t avail = iov[idx].len - pos;
+            if (avail == 0)
+            {
+                idx++;
+                pos = 0;
+                continue;
+            }
+            uint32_t take = avail < room ? avail : room;
+            fragment_iov[fragment_iovcnt].base = (const uint8_t *)iov[idx].base + pos;
+            fragment_iov[fragment_iovcnt].len = take;
+            fragment_iovcnt++;
+            pos += take;
+            room -= take;
+            offset += take;
+        }
+        int ret = ocre_publish_message_iov(topic, fragment_type, fragment_iov, fragment_iovcnt);
+        if (ret != OCRE_SUCCESS)
+        {
+#ifdef OCRE_SDK_LOG
+            printf("Error: Publishing fragment at offset %u of %u failed\n", header.offset, total_len);
+#endif
+            return ret;
+        }
+    } while (offset < total_len);
+
+    return OCRE_SUCCESS;
+}
+
+// =============================================================================
+// MESSAGE RECEIVE POOLS
+// =============================================================================
+
+int ocre_subscribe_message_pool(ocre_msg_pool_t *pool, const char *topic, void *buffer, uint32_t buffer_size,
+                                uint32_t message_size)
+{
+    if (pool == NULL || topic == NULL || buffer == NULL || ((uint32_t)buffer & 7U) != 0 || message_size == 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Invalid receive pool parameters\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    uint32_t slot_size = OCRE_MSG_SLOT_SIZE(message_size);
+    uint32_t slot_count = buffer_size / slot_size;
+    if (slot_count < 2)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Receive pool buffer holds fewer than two slots of %u bytes\n", slot_size);
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    int index = -1;
+    for (int i = 0; i < OCRE_MAX_RX_POOLS && index < 0; i++)
+    {
+        if (rx_pools[i] == NULL)
+        {
+            index = i;
+        }
+    }
+    if (index < 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No available slots for receive pools\n");
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    memset(pool, 0, sizeof(*pool));
+    memset(buffer, 0, slot_size * slot_count);
+    pool->slots = buffer;
+    pool->slot_size = slot_size;
+    pool->slot_count = slot_count;
+
+    // Registered before subscribing, so the first messages already land in the slots
+    int handle = ocre_messaging_rx_pool_open(topic, &pool->ring, buffer, slot_size, slot_count);
+    if (handle <= 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Failed to open receive pool for %s (%d)\n", topic, handle);
+#endif
+        memset(pool, 0, sizeof(*pool));
+        return handle < 0 ? handle : OCRE_ERROR_INVALID;
+    }
+    pool->handle = handle;
+    rx_pools[index] = pool;
+    int ret = ocre_subscribe_message(topic);
+    if (ret != OCRE_SUCCESS)
+    {
+        ocre_release_message_pool(pool);
+        return ret;
+    }
+#ifdef OCRE_SDK_LOG
+    printf("Receive pool %d for %s: %u slots of %u bytes\n", handle, topic, slot_count, slot_size);
+#endif
+    return OCRE_SUCCESS;
+}
+
+// Drop fetched message events that point into a pool's slots
+static void rx_pool_purge(const ocre_msg_pool_t *pool)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < pending_count; i++)
+    {
+        const event_data_t *event_data = &pending_events[pending_head + i];
+        if (event_data->type == OCRE_RESOURCE_TYPE_MESSAGE &&
+            (rx_pool_contains(pool, (const void *)event_data->extra) ||
+             rx_pool_contains(pool, (const void *)event_data->port)))
+        {
+            continue;
+        }
+        pending_events[pending_head + count++] = *event_data;
+    }
+    pending_count = count;
+
+    // The message being dispatched loses its slot, do not recycle it afterwards
+    if (current_message && rx_pool_contains(pool, current_message->payload))
+    {
+        current_message_retained = true;
+    }
+}
+
+int ocre_release_message_pool(ocre_msg_pool_t *pool)
+{
+    for (int i = 0; i < OCRE_MAX_RX_POOLS; i++)
+    {
+        if (pool != NULL && rx_pools[i] == pool)
+        {
+            // The host stops writing and drops its queued events first, then the
+            // events already fetched are dropped before their slots are unknown
+            int ret = ocre_messaging_rx_pool_close(pool->handle);
+            rx_pool_purge(pool);
+            rx_pools[i] = NULL;
+            memset(pool, 0, sizeof(*pool));
+            return ret;
+        }
+    }
+    return OCRE_ERROR_NOT_FOUND;
+}
+
+// =============================================================================
+// CHANNELS
+// =============================================================================
+
+int ocre_channel_open(ocre_channel_t *channel, const char *name, uint32_t capacity, ocre_channel_role_t role,
+                      ocre_channel_callback_t callback, void *user_data)
+{
+    if (channel == NULL || name == NULL || capacity < 2 * CHANNEL_RECORD_HEADER || (capacity & (capacity - 1)) != 0 ||
+        (role == OCRE_CHANNEL_CONSUMER && callback == NULL))
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Invalid channel parameters\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    int slot = -1;
+    for (int i = 0; i < OCRE_MAX_CHANNELS && slot < 0; i++)
+    {
+        if (channels[i] == NULL)
+        {
+            slot = i;
+        }
+    }
+    if (slot < 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No available slots for channels\n");
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    if (role == OCRE_CHANNEL_CONSUMER && ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_CHANNEL) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register channel dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    uint32_t addr = 0;
+    int handle = ocre_channel_map(name, sizeof(ocre_channel_ring_t) + capacity, &addr);
+    if (handle <= 0 || addr == 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Failed to map channel %s\n", name);
+#endif
+        return handle < 0 ? handle : OCRE_ERROR_INVALID;
+    }
+    memset(channel, 0, sizeof(*channel));
+    channel->handle = handle;
+    channel->role = role;
+    channel->ring = (ocre_channel_ring_t *)addr;
+    channel->capacity = capacity;
+    channel->callback = role == OCRE_CHANNEL_CONSUMER ? callback : NULL;
+    channel->user_data = user_data;
+    channels[slot] = channel;
 #ifdef OCRE_SDK_LOG
-    printf("No GPIO callback registered for pin: %d, port: %d\n", pin, port);
+    printf("Channel %s opened as %s, handle %d\n", name, role == OCRE_CHANNEL_PRODUCER ? "producer" : "consumer", handle);
 #endif
+    return OCRE_SUCCESS;
 }
 
-void OCRE_EXPORT("message_callback") message_callback(uint32_t message_id, char *topic_ptr, char *content_type_ptr, uint8_t *payload_ptr, uint32_t payload_len)
+int ocre_channel_close(ocre_channel_t *channel)
 {
-    init_callback_system();
-#ifdef OCRE_SDK_LOG
-    printf("Message ID: %d\n", message_id);
-    printf("Topic: %s\n", topic_ptr);
-    printf("Content-Type: %s\n", content_type_ptr);
-    printf("Payload: %s\n", payload_ptr);
-    printf("Payload len: %d\n", payload_len);
-
-    printf("Message event triggered: topic=%s, content_type=%s, payload_len=%d\n", topic_ptr, content_type_ptr, payload_len);
-#endif
-    for (int i = 0; i < OCRE_MAX_CALLBACKS; i++)
+    for (int i = 0; i < OCRE_MAX_CHANNELS; i++)
     {
-        if (message_callbacks[i] && strncmp(message_callback_topics[i], topic_ptr, strlen(message_callback_topics[i])) == 0)
+        if (channel != NULL && channels[i] == channel)
         {
-#ifdef OCRE_SDK_LOG
-            printf("Executing message callback for topic: %s\n", topic_ptr);
-#endif
-            message_callbacks[i](topic_ptr, content_type_ptr, payload_ptr, payload_len);
-            return;
+            channels[i] = NULL;
+            int ret = ocre_channel_unmap(channel->handle);
+            memset(channel, 0, sizeof(*channel));
+            return ret;
         }
     }
-#ifdef OCRE_SDK_LOG
-    printf("No message callback registered for topic: %s\n", topic_ptr);
-#endif
+    return OCRE_ERROR_NOT_FOUND;
 }
 
-void ocre_process_events(void)
+void *ocre_channel_reserve(ocre_channel_t *channel, uint32_t len)
 {
-    int event_count = 0;
-    const int max_events_per_loop = 5;
-
-    char topic_copy[OCRE_MAX_TOPIC_LEN];
-    char content_type_copy[OCRE_MAX_CONTENT_TYPE_LEN];
-    uint8_t payload_copy[OCRE_MAX_PAYLOAD_LEN];
+    if (channel == NULL || channel->ring == NULL || channel->role != OCRE_CHANNEL_PRODUCER || len >= CHANNEL_WRAP - 3U)
+    {
+        return NULL;
+    }
+    ocre_channel_ring_t *ring = channel->ring;
+    uint32_t size = CHANNEL_RECORD_SIZE(len);
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t pos = head & (channel->capacity - 1);
 
-    event_data_t event_data;
-    while (event_count < max_events_per_loop)
+    // Records never straddle the end, the remainder is skipped instead
+    uint32_t skip = channel->capacity - pos < size ? channel->capacity - pos : 0;
+    if (channel->capacity - (head - tail) < skip + size)
     {
-        int ret = ocre_get_event(
-            (uint32_t)&event_data.type,
-            (uint32_t)&event_data.id,
-            (uint32_t)&event_data.port,
-            (uint32_t)&event_data.state,
-            (uint32_t)&event_data.extra,
-            (uint32_t)&event_data.payload_len);
-        ocre_sleep(10);
-        if (ret != OCRE_SUCCESS)
-        {
-                break;
-        }
-#ifdef OCRE_SDK_LOG
-        printf("Ocre process event retrieved: type=%u, id=%d, port(topic)=%u, state(content)=%u, extra(payload)=%u payload_len=%d\n", event_data.type, event_data.id, event_data.port, event_data.state, event_data.extra, event_data.payload_len);
-#endif
-        switch (event_data.type)
-        {
-        case OCRE_RESOURCE_TYPE_TIMER:
-            timer_callback(event_data.id);
-            break;
-        case OCRE_RESOURCE_TYPE_GPIO:
-            gpio_callback(event_data.id, event_data.state, event_data.port);
-            break;
-        case OCRE_RESOURCE_TYPE_MESSAGE:
-            // Copy topic
-            strncpy(topic_copy, (const char *)event_data.port, OCRE_MAX_TOPIC_LEN - 1);
-            topic_copy[OCRE_MAX_TOPIC_LEN - 1] = '\0';
+        return NULL;
+    }
+    if (skip)
+    {
+        memcpy(&ring->data[pos], &(uint32_t){CHANNEL_WRAP}, CHANNEL_RECORD_HEADER);
+        pos = 0;
+    }
+    memcpy(&ring->data[pos], &len, CHANNEL_RECORD_HEADER);
+    channel->reserved = skip + size;
+    return &ring->data[pos + CHANNEL_RECORD_HEADER];
+}
 
-            // Copy content_type
-            strncpy(content_type_copy, (const char *)event_data.state, OCRE_MAX_CONTENT_TYPE_LEN - 1);
-            content_type_copy[OCRE_MAX_CONTENT_TYPE_LEN - 1] = '\0';
+int ocre_channel_commit(ocre_channel_t *channel)
+{
+    if (channel == NULL || channel->ring == NULL || channel->reserved == 0)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    ocre_channel_ring_t *ring = channel->ring;
+    uint32_t head = ring->head;
+    // Sequentially consistent with the consumer's tail store, so one of the two sees the other
+    __atomic_store_n(&ring->head, head + channel->reserved, __ATOMIC_SEQ_CST);
+    channel->reserved = 0;
+    if (__atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) == head)
+    {
+        return ocre_channel_notify(channel->handle);
+    }
+    return OCRE_SUCCESS;
+}
 
-            // Copy payload
-            uint32_t len = event_data.payload_len > OCRE_MAX_PAYLOAD_LEN ? OCRE_MAX_PAYLOAD_LEN : event_data.payload_len;
-            memcpy(payload_copy, (const uint8_t *)event_data.extra, len);
+int ocre_channel_write(ocre_channel_t *channel, const void *data, uint32_t len)
+{
+    void *record = ocre_channel_reserve(channel, len);
+    if (record == NULL)
+    {
+        return channel == NULL || channel->ring == NULL ? OCRE_ERROR_INVALID : OCRE_ERROR_BUSY;
+    }
+    memcpy(record, data, len);
+    return ocre_channel_commit(channel);
+}
 
-            if (ocre_messaging_free_module_event_data(event_data.port, event_data.state, event_data.extra) != OCRE_SUCCESS)
-            {
-#ifdef OCRE_SDK_LOG
-                printf("Error: Module event data wasn't freed successfully");
-#endif
-            }
+// Locate the oldest record, returns bytes to advance the tail by or 0 if empty
+static uint32_t channel_next(ocre_channel_t *channel, uint32_t *pos, uint32_t *len)
+{
+    if (channel == NULL || channel->ring == NULL || channel->role != OCRE_CHANNEL_CONSUMER)
+    {
+        return 0;
+    }
+    ocre_channel_ring_t *ring = channel->ring;
+    uint32_t tail = ring->tail;
+    if (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == tail)
+    {
+        return 0;
+    }
+    uint32_t skip = 0;
+    *pos = tail & (channel->capacity - 1);
+    memcpy(len, &ring->data[*pos], CHANNEL_RECORD_HEADER);
+    if (*len == CHANNEL_WRAP)
+    {
+        // The marker and the record after it were committed together
+        skip = channel->capacity - *pos;
+        *pos = 0;
+        memcpy(len, &ring->data[0], CHANNEL_RECORD_HEADER);
+    }
+    return skip + CHANNEL_RECORD_SIZE(*len);
+}
 
-            message_callback(event_data.id, topic_copy, content_type_copy, payload_copy, len);
-            break;
-        default:
-#ifdef OCRE_SDK_LOG
-            printf("Unknown event: type=%d, id=%d, port=%d, state=%d\n",
-                   event_data.type, event_data.id, event_data.port, event_data.state);
-#endif
-            break;
-        }
-        event_count++;
+const void *ocre_channel_peek(ocre_channel_t *channel, uint32_t *len)
+{
+    uint32_t pos = 0;
+    uint32_t record_len = 0;
+    if (channel_next(channel, &pos, &record_len) == 0)
+    {
+        return NULL;
     }
+    if (len)
+    {
+        *len = record_len;
+    }
+    return &channel->ring->data[pos + CHANNEL_RECORD_HEADER];
+}
 
-    if (event_count == 0)
+int ocre_channel_consume(ocre_channel_t *channel)
+{
+    uint32_t pos = 0;
+    uint32_t len = 0;
+    uint32_t advance = channel_next(channel, &pos, &len);
+    if (advance == 0)
     {
-        ocre_sleep(10);
+        return OCRE_ERROR_NOT_FOUND;
     }
+    __atomic_store_n(&channel->ring->tail, channel->ring->tail + advance, __ATOMIC_SEQ_CST);
+    return OCRE_SUCCESS;
 }
 
 // =============================================================================
-// PUBLIC API FUNCTIONS
+// GPIO EDGE CAPTURE
 // =============================================================================
 
-int ocre_register_timer_callback(int timer_id, timer_callback_func_t callback)
+int ocre_gpio_capture_start(ocre_gpio_capture_t *capture, int port, int pin, ocre_gpio_edge_t edge,
+                            ocre_gpio_edge_record_t *records, uint32_t record_count, uint32_t batch,
+                            uint32_t max_latency_ms, ocre_gpio_capture_callback_t callback, void *user_data)
 {
-    init_callback_system();
-    if (timer_id < 0 || timer_id >= OCRE_MAX_CALLBACKS)
+    if (capture == NULL || !gpio_pin_valid(port, pin) || records == NULL || batch == 0 || record_count <= batch ||
+        callback == NULL)
     {
 #ifdef OCRE_SDK_LOG
-        printf("Error: Timer ID %d out of range (0-%d)\n", timer_id, OCRE_MAX_CALLBACKS - 1);
+        printf("Error: Invalid GPIO capture parameters\n");
 #endif
         return OCRE_ERROR_INVALID;
     }
-    if (callback == NULL)
+    int slot = -1;
+    for (int i = 0; i < OCRE_MAX_GPIO_CAPTURES && slot < 0; i++)
+    {
+        if (gpio_captures[i] == NULL)
+        {
+            slot = i;
+        }
+    }
+    if (slot < 0)
     {
 #ifdef OCRE_SDK_LOG
-        printf("Error: Timer callback is NULL for ID %d\n", timer_id);
+        printf("Error: No available slots for GPIO captures\n");
 #endif
-        return OCRE_ERROR_INVALID;
+        return OCRE_ERROR_NO_MEMORY;
     }
-    if (ocre_register_dispatcher(OCRE_RESOURCE_TYPE_TIMER, "timer_callback") != OCRE_SUCCESS)
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_GPIO_CAPTURE) != OCRE_SUCCESS)
     {
 #ifdef OCRE_SDK_LOG
-        printf("Failed to register timer dispatcher\n");
+        printf("Failed to register GPIO capture dispatcher\n");
 #endif
         return OCRE_ERROR_INVALID;
     }
-    timer_callbacks[timer_id] = callback;
+    memset(capture, 0, sizeof(*capture));
+    capture->records = records;
+    capture->record_count = record_count;
+    capture->callback = callback;
+    capture->user_data = user_data;
+    int handle = ocre_gpio_capture_open(port, pin, edge, &capture->ring, records, record_count, batch, max_latency_ms);
+    if (handle <= 0)
+    {
 #ifdef OCRE_SDK_LOG
-    printf("Timer callback registered for ID: %d\n", timer_id);
+        printf("Error: Failed to start capture on GPIO %d.%d (%d)\n", port, pin, handle);
+#endif
+        memset(capture, 0, sizeof(*capture));
+        return handle < 0 ? handle : OCRE_ERROR_INVALID;
+    }
+    capture->handle = handle;
+    gpio_captures[slot] = capture;
+#ifdef OCRE_SDK_LOG
+    printf("Capturing GPIO %d.%d edges in batches of %u, handle %d\n", port, pin, batch, handle);
 #endif
     return OCRE_SUCCESS;
 }
 
-int ocre_register_gpio_callback(int pin, int port, gpio_callback_func_t callback)
+int ocre_gpio_capture_stop(ocre_gpio_capture_t *capture)
 {
-    init_callback_system();
-    if (callback == NULL)
+    for (int i = 0; i < OCRE_MAX_GPIO_CAPTURES; i++)
     {
-#ifdef OCRE_SDK_LOG
-        printf("Error: GPIO callback is NULL for pin %d, port %d\n", pin, port);
-#endif
-        return OCRE_ERROR_INVALID;
+        if (capture != NULL && gpio_captures[i] == capture)
+        {
+            gpio_captures[i] = NULL;
+            int ret = ocre_gpio_capture_close(capture->handle);
+            memset(capture, 0, sizeof(*capture));
+            return ret;
+        }
     }
-    if (pin < 0 || pin >= CONFIG_OCRE_GPIO_PINS_PER_PORT || port < 0 || port >= CONFIG_OCRE_GPIO_MAX_PORTS)
+    return OCRE_ERROR_NOT_FOUND;
+}
+
+uint32_t ocre_gpio_capture_edges(const ocre_gpio_capture_t *capture)
+{
+    return capture ? __atomic_load_n(&capture->ring.edges, __ATOMIC_RELAXED) : 0;
+}
+
+uint32_t ocre_gpio_capture_dropped(const ocre_gpio_capture_t *capture)
+{
+    return capture ? __atomic_load_n(&capture->ring.dropped, __ATOMIC_RELAXED) : 0;
+}
+
+uint64_t ocre_gpio_capture_interval_ns(const ocre_gpio_capture_t *capture)
+{
+    return capture ? capture->interval_ns : 0;
+}
+
+// =============================================================================
+// FILE WATCHES
+// =============================================================================
+
+int ocre_file_watch_start(ocre_file_watch_t *watch, const char *path, uint32_t changes,
+                          uint32_t min_interval_ms, ocre_file_watch_callback_t callback, void *user_data)
+{
+    if (watch == NULL || path == NULL || (changes & OCRE_FILE_CHANGE_ALL) == 0 || callback == NULL)
     {
 #ifdef OCRE_SDK_LOG
-        printf("Error: Invalid pin %d or port %d\n", pin, port);
+        printf("Error: Invalid file watch parameters\n");
 #endif
         return OCRE_ERROR_INVALID;
     }
     int slot = -1;
-    for (int i = 0; i < OCRE_MAX_CALLBACKS; i++)
+    for (int i = 0; i < OCRE_MAX_FILE_WATCHES && slot < 0; i++)
     {
-        if (gpio_callback_pins[i] == pin && gpio_callback_ports[i] == port)
-        {
-            slot = i;
-            break;
-        }
-        if (slot == -1 && gpio_callback_pins[i] == -1)
+        if (file_watches[i] == NULL)
         {
             slot = i;
         }
     }
-    if (slot == -1)
+    if (slot < 0)
     {
 #ifdef OCRE_SDK_LOG
-        printf("Error: No available slots for GPIO callbacks\n");
+        printf("Error: No available slots for file watches\n");
 #endif
         return OCRE_ERROR_NO_MEMORY;
     }
-    if (ocre_register_dispatcher(OCRE_RESOURCE_TYPE_GPIO, "gpio_callback") != OCRE_SUCCESS)
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_FILE_WATCH) != OCRE_SUCCESS)
     {
 #ifdef OCRE_SDK_LOG
-        printf("Failed to register GPIO dispatcher\n");
+        printf("Failed to register file watch dispatcher\n");
 #endif
         return OCRE_ERROR_INVALID;
     }
-    gpio_callback_pins[slot] = pin;
-    gpio_callback_ports[slot] = port;
-    gpio_callbacks[slot] = callback;
-#ifdef OCRE_SDK_LOG
-    printf("GPIO callback registered for pin: %d, port: %d (slot %d)\n", pin, port, slot);
-#endif
-    return ocre_gpio_register_callback(port, pin);
-}
-
-int ocre_register_message_callback(const char *topic, message_callback_func_t callback)
-{
-    init_callback_system();
-    if (!topic || topic[0] == '\0')
+    int handle = ocre_file_watch_open(path, changes & OCRE_FILE_CHANGE_ALL, min_interval_ms);
+    if (handle <= 0)
     {
 #ifdef OCRE_SDK_LOG
-        printf("Error: Topic is NULL or empty\n");
+        printf("Error: Failed to watch %s (%d)\n", path, handle);
 #endif
-        return OCRE_ERROR_INVALID;
+        return handle < 0 ? handle : OCRE_ERROR_INVALID;
     }
-    if (callback == NULL)
-    {
+    memset(watch, 0, sizeof(*watch));
+    watch->handle = handle;
+    watch->callback = callback;
+    watch->user_data = user_data;
+    file_watches[slot] = watch;
 #ifdef OCRE_SDK_LOG
-        printf("Error: Message callback is NULL for topic %s\n", topic);
+    printf("Watching %s, handle %d\n", path, handle);
 #endif
-        return OCRE_ERROR_INVALID;
-    }
-    int slot = -1;
-    for (int i = 0; i < OCRE_MAX_CALLBACKS; i++)
+    return OCRE_SUCCESS;
+}
+
+int ocre_file_watch_stop(ocre_file_watch_t *watch)
+{
+    for (int i = 0; i < OCRE_MAX_FILE_WATCHES; i++)
     {
-        if (message_callbacks[i] && strcmp(message_callback_topics[i], topic) == 0)
+        if (watch != NULL && file_watches[i] == watch)
         {
-            slot = i;
-            break;
+            file_watches[i] = NULL;
+            int ret = ocre_file_watch_close(watch->handle);
+            memset(watch, 0, sizeof(*watch));
+            return ret;
         }
-        if (slot == -1 && message_callback_topics[i][0] == '\0')
+    }
+    return OCRE_ERROR_NOT_FOUND;
+}
+
+// =============================================================================
+// NAME RESOLUTION
+// =============================================================================
+
+static const resolved_name_t *resolve_lookup(const char *name, resolved_kind_t kind)
+{
+    for (int i = 0; i < OCRE_MAX_RESOLVED_NAMES; i++)
+    {
+        if (resolved_names[i].kind == kind && strcmp(topic_str(resolved_names[i].name), name) == 0)
         {
-            slot = i;
+            return &resolved_names[i];
         }
     }
-    if (slot == -1)
+    return NULL;
+}
+
+// Best effort: when the cache or pool is full the name is simply resolved again next time
+static void resolve_store(const char *name, resolved_kind_t kind, int value, int extra)
+{
+    for (int i = 0; i < OCRE_MAX_RESOLVED_NAMES; i++)
     {
-#ifdef OCRE_SDK_LOG
-        printf("Error: No available slots for message callbacks\n");
-#endif
-        return OCRE_ERROR_NO_MEMORY;
+        if (resolved_names[i].kind == 0)
+        {
+            topic_ref_t ref = topic_intern(name, strlen(name));
+            if (ref != 0)
+            {
+                resolved_names[i].name = ref;
+                resolved_names[i].kind = kind;
+                resolved_names[i].value = value;
+                resolved_names[i].extra = extra;
+            }
+            return;
+        }
     }
-    if (ocre_register_dispatcher(OCRE_RESOURCE_TYPE_MESSAGE, "message_callback") != OCRE_SUCCESS)
+}
+
+int ocre_gpio_resolve(const char *name, ocre_gpio_pin_t *pin)
+{
+    if (name == NULL || pin == NULL)
     {
-#ifdef OCRE_SDK_LOG
-        printf("Failed to register message dispatcher\n");
-#endif
         return OCRE_ERROR_INVALID;
     }
-    strncpy(message_callback_topics[slot], topic, OCRE_MAX_TOPIC_LEN - 1);
-    message_callback_topics[slot][OCRE_MAX_TOPIC_LEN - 1] = '\0';
-    message_callbacks[slot] = callback;
+    const resolved_name_t *entry = resolve_lookup(name, RESOLVED_GPIO);
+    if (entry == NULL)
+    {
+        int port_num = 0;
+        int pin_num = 0;
+        int ret = ocre_gpio_get_pin_by_name(name, &port_num, &pin_num);
+        if (ret != OCRE_SUCCESS)
+        {
 #ifdef OCRE_SDK_LOG
-    printf("Message callback registered for topic: %s (slot %d)\n", topic, slot);
+            printf("Error: GPIO name %s not found (%d)\n", name, ret);
 #endif
-
+            return ret;
+        }
+        resolve_store(name, RESOLVED_GPIO, port_num, pin_num);
+        pin->port = port_num;
+        pin->pin = pin_num;
+        return OCRE_SUCCESS;
+    }
+    pin->port = entry->value;
+    pin->pin = entry->extra;
     return OCRE_SUCCESS;
 }
-int ocre_unregister_timer_callback(int timer_id)
+
+int ocre_sensors_resolve(const char *sensor_name)
 {
-    init_callback_system();
-    if (timer_id < 0 || timer_id >= OCRE_MAX_CALLBACKS)
+    if (sensor_name == NULL)
     {
-#ifdef OCRE_SDK_LOG
-        printf("Error: Timer ID %d out of range (0-%d)\n", timer_id, OCRE_MAX_CALLBACKS - 1);
-#endif
         return OCRE_ERROR_INVALID;
     }
-    if (timer_callbacks[timer_id] == NULL)
+    const resolved_name_t *entry = resolve_lookup(sensor_name, RESOLVED_SENSOR);
+    if (entry)
     {
-#ifdef OCRE_SDK_LOG
-        printf("Error: No timer callback registered for ID %d\n", timer_id);
-#endif
-        return OCRE_ERROR_NOT_FOUND;
+        return entry->value;
     }
-    timer_callbacks[timer_id] = NULL;
+    int sensor_id = ocre_sensors_get_handle_by_name(sensor_name);
+    if (sensor_id < 0)
+    {
 #ifdef OCRE_SDK_LOG
-    printf("Timer callback unregistered for ID: %d\n", timer_id);
+        printf("Error: Sensor name %s not found (%d)\n", sensor_name, sensor_id);
 #endif
-    return OCRE_SUCCESS;
+        return sensor_id;
+    }
+    resolve_store(sensor_name, RESOLVED_SENSOR, sensor_id, 0);
+    return sensor_id;
 }
 
-int ocre_unregister_gpio_callback(int pin, int port)
+void ocre_resolve_cache_clear(void)
 {
-    init_callback_system();
-    int slot = -1;
-    for (int i = 0; i < OCRE_MAX_CALLBACKS; i++)
+    for (int i = 0; i < OCRE_MAX_RESOLVED_NAMES; i++)
     {
-        if (gpio_callback_pins[i] == pin && gpio_callback_ports[i] == port)
-        {
-            slot = i;
-            break;
-        }
+        topic_ref_t ref = resolved_names[i].name;
+        resolved_names[i].name = 0;
+        resolved_names[i].kind = 0;
+        topic_release(ref);
     }
-    if (slot == -1 || gpio_callbacks[slot] == NULL)
+}
+
+// =============================================================================
+// SENSOR SAMPLES
+// =============================================================================
+
+float ocre_sensor_sample_to_float(const ocre_sensor_sample_t *sample)
+{
+    if (sample->type == OCRE_SENSOR_VALUE_FLOAT)
     {
-#ifdef OCRE_SDK_LOG
-        printf("Error: No GPIO callback registered for pin %d, port %d\n", pin, port);
-#endif
-        return OCRE_ERROR_NOT_FOUND;
+        return sample->value.f;
     }
-    gpio_callback_pins[slot] = -1;
-    gpio_callback_ports[slot] = -1;
-    gpio_callbacks[slot] = NULL;
-#ifdef OCRE_SDK_LOG
-    printf("GPIO callback unregistered for pin: %d, port: %d\n", pin, port);
-#endif
-    return ocre_gpio_unregister_callback(port, pin);
+    return (float)sample->value.fixed.val1 + (float)sample->value.fixed.val2 / 1000000.0f;
 }
 
-int ocre_unregister_message_callback(const char *topic)
+double ocre_sensor_sample_to_double(const ocre_sensor_sample_t *sample)
 {
-    init_callback_system();
-    if (!topic || topic[0] == '\0')
+    if (sample->type == OCRE_SENSOR_VALUE_FLOAT)
+    {
+        return sample->value.f;
+    }
+    return (double)sample->value.fixed.val1 + (double)sample->value.fixed.val2 / 1000000.0;
+}
+
+int64_t ocre_sensor_sample_to_milli(const ocre_sensor_sample_t *sample)
+{
+    if (sample->type == OCRE_SENSOR_VALUE_FLOAT)
+    {
+        return (int64_t)(sample->value.f * 1000.0f);
+    }
+    // Integer only, so fixed-point values are not rounded through a float
+    return (int64_t)sample->value.fixed.val1 * 1000 + sample->value.fixed.val2 / 1000;
+}
+
+// =============================================================================
+// SENSOR STREAMS
+// =============================================================================
+
+int ocre_sensors_stream_start(ocre_sensor_stream_t *stream, int sensor_id, const int *channels,
+                              int channel_count, uint32_t rate_hz, uint32_t batch, void *buffer,
+                              uint32_t buffer_size, ocre_sensor_stream_callback_t callback, void *user_data)
+{
+    if (stream == NULL || channels == NULL || channel_count <= 0 || batch == 0 || buffer == NULL ||
+        ((uint32_t)buffer & 7U) != 0 || callback == NULL)
     {
 #ifdef OCRE_SDK_LOG
-        printf("Error: Topic is NULL or empty\n");
+        printf("Error: Invalid sensor stream parameters\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    uint32_t block_size = OCRE_SENSOR_BLOCK_SIZE(channel_count, batch);
+    uint32_t block_count = buffer_size / block_size;
+    if (block_count < 2)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Sensor stream buffer holds fewer than two blocks of %u bytes\n", block_size);
 #endif
         return OCRE_ERROR_INVALID;
     }
     int slot = -1;
-    for (int i = 0; i < OCRE_MAX_CALLBACKS; i++)
+    for (int i = 0; i < OCRE_MAX_SENSOR_STREAMS && slot < 0; i++)
     {
-        if (message_callbacks[i] && strcmp(message_callback_topics[i], topic) == 0)
+        if (sensor_streams[i] == NULL)
         {
             slot = i;
-            break;
         }
     }
-    if (slot == -1 || message_callbacks[slot] == NULL)
+    if (slot < 0)
     {
 #ifdef OCRE_SDK_LOG
-        printf("Error: No message callback registered for topic %s\n", topic);
+        printf("Error: No available slots for sensor streams\n");
 #endif
-        return OCRE_ERROR_NOT_FOUND;
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_SENSOR) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register sensor dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
     }
-    message_callback_topics[slot][0] = '\0';
-    message_callbacks[slot] = NULL;
+    memset(stream, 0, sizeof(*stream));
+    stream->blocks = buffer;
+    stream->block_size = block_size;
+    stream->block_count = block_count;
+    stream->channel_count = channel_count;
+    stream->callback = callback;
+    stream->user_data = user_data;
+    int handle = ocre_sensors_stream_open(sensor_id, channels, channel_count, rate_hz, batch, &stream->ring, buffer,
+                                          block_count);
+    if (handle <= 0)
+    {
 #ifdef OCRE_SDK_LOG
-    printf("Message callback unregistered for topic: %s\n", topic);
+        printf("Error: Failed to open stream for sensor %d (%d)\n", sensor_id, handle);
+#endif
+        memset(stream, 0, sizeof(*stream));
+        return handle < 0 ? handle : OCRE_ERROR_INVALID;
+    }
+    stream->handle = handle;
+    sensor_streams[slot] = stream;
+#ifdef OCRE_SDK_LOG
+    printf("Sensor %d streaming %d channels at %u Hz, %u samples per block, handle %d\n", sensor_id, channel_count,
+           rate_hz, batch, handle);
 #endif
     return OCRE_SUCCESS;
 }
+
+int ocre_sensors_stream_stop(ocre_sensor_stream_t *stream)
+{
+    for (int i = 0; i < OCRE_MAX_SENSOR_STREAMS; i++)
+    {
+        if (stream != NULL && sensor_streams[i] == stream)
+        {
+            sensor_streams[i] = NULL;
+            int ret = ocre_sensors_stream_close(stream->handle);
+            memset(stream, 0, sizeof(*stream));
+            return ret;
+        }
+    }
+    return OCRE_ERROR_NOT_FOUND;
+}
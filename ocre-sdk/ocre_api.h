@@ -44,17 +44,109 @@ extern "C"
 #define OCRE_ERROR_NOT_FOUND -3
 #define OCRE_ERROR_BUSY -4
 #define OCRE_ERROR_NO_MEMORY -5
+#define OCRE_ERROR_IO -6
+#define OCRE_ERROR_NO_SPACE -7
 
 // Configuration
+//
+// Capacities can be overridden per target, e.g. from CMake before add_subdirectory(ocre-sdk):
+//   set(OCRE_MAX_MESSAGE_CALLBACKS 4)
 #define OCRE_MAX_TIMERS 16
 #define OCRE_MAX_SENSORS 32
+#ifndef OCRE_MAX_CALLBACKS
 #define OCRE_MAX_CALLBACKS 64
+#endif
+#ifndef OCRE_MAX_TIMER_CALLBACKS
+#define OCRE_MAX_TIMER_CALLBACKS OCRE_MAX_CALLBACKS    /**< Timer IDs accepted by the callback table */
+#endif
+#ifndef OCRE_MAX_MESSAGE_CALLBACKS
+#define OCRE_MAX_MESSAGE_CALLBACKS OCRE_MAX_CALLBACKS  /**< Registered message topic filters */
+#endif
 #define OCRE_MAX_TOPIC_LEN 128
+#ifndef OCRE_MAX_TOPIC_NODES
+#define OCRE_MAX_TOPIC_NODES 128       /**< Topic index nodes, one per distinct filter level */
+#endif
+#ifndef OCRE_TOPIC_POOL_SIZE
+#define OCRE_TOPIC_POOL_SIZE 1024      /**< Bytes for interned topic strings */
+#endif
 #define OCRE_MAX_CONTENT_TYPE_LEN 128
 #define OCRE_MAX_PAYLOAD_LEN 1024
+#ifndef OCRE_MAX_STREAM_CALLBACKS
+#define OCRE_MAX_STREAM_CALLBACKS 8
+#endif
+#ifndef OCRE_MAX_TOPIC_HANDLES
+#define OCRE_MAX_TOPIC_HANDLES 16      /**< Topic handles open at once */
+#endif
+#ifndef OCRE_MAX_CHANNELS
+#define OCRE_MAX_CHANNELS 4            /**< Shared-memory channels open at once */
+#endif
+#ifndef OCRE_MAX_GPIO_CAPTURES
+#define OCRE_MAX_GPIO_CAPTURES 2       /**< GPIO pins in edge capture mode at once */
+#endif
+#ifndef OCRE_MAX_FILE_WATCHES
+#define OCRE_MAX_FILE_WATCHES 2        /**< Files watched for changes at once */
+#endif
+#ifndef OCRE_MAX_RX_POOLS
+#define OCRE_MAX_RX_POOLS 2            /**< Message receive pools subscribed at once */
+#endif
+#ifndef OCRE_MAX_SENSOR_STREAMS
+#define OCRE_MAX_SENSOR_STREAMS 2      /**< Sensor streams started at once */
+#endif
+#ifndef OCRE_MAX_RESOLVED_NAMES
+#define OCRE_MAX_RESOLVED_NAMES 16     /**< GPIO and sensor names cached by the *_resolve() calls */
+#endif
+#ifndef OCRE_MAX_FRAGMENT_IOV
+#define OCRE_MAX_FRAGMENT_IOV 8
+#endif
 #define CONFIG_MAX_SENSOR_NAME_LENGTH 125
 #define OCRE_API_POSIX_BUF_SIZE 65
 
+// Event processing
+#define OCRE_WAIT_FOREVER -1       /**< Timeout value to block until an event arrives */
+#define OCRE_EVENT_FLAG_NONE 0x0   /**< Poll the event queue without blocking */
+#define OCRE_EVENT_FLAG_WAIT 0x1   /**< Block in the host until an event arrives or the timeout expires */
+#define OCRE_EVENT_DRAIN 0         /**< Event budget value that drains the queue until empty */
+#ifndef OCRE_DEFAULT_EVENTS_PER_LOOP
+#define OCRE_DEFAULT_EVENTS_PER_LOOP 5 /**< Default maximum events dispatched per call */
+#endif
+#define OCRE_EVENT_PRIORITY_HIGHEST 0   /**< Dispatched first */
+#define OCRE_EVENT_PRIORITY_LOWEST 255  /**< Dispatched last */
+#define OCRE_EVENT_PRIORITY_TIMER 0     /**< Default priority of timer events */
+#define OCRE_EVENT_PRIORITY_GPIO 1      /**< Default priority of GPIO events */
+#define OCRE_EVENT_PRIORITY_SENSOR 2    /**< Default priority of sensor events */
+#define OCRE_EVENT_PRIORITY_MESSAGE 3   /**< Default priority of message events */
+#define OCRE_EVENT_PRIORITY_CHANNEL 3   /**< Default priority of channel doorbell events */
+#define OCRE_EVENT_PRIORITY_FLOW 2      /**< Default priority of publish credit events */
+#define OCRE_EVENT_PRIORITY_GPIO_CAPTURE 1 /**< Default priority of GPIO edge capture events */
+#define OCRE_EVENT_PRIORITY_FILE_WATCH 3 /**< Default priority of file change events */
+#define OCRE_EVENT_PRIORITY_WORKQUEUE 2 /**< Default priority of work completion events */
+#ifndef OCRE_EVENT_BATCH_SIZE
+#define OCRE_EVENT_BATCH_SIZE 8    /**< Maximum events fetched per ocre_get_events() host call */
+#endif
+#ifndef OCRE_STATS_HISTOGRAM_BUCKETS
+#define OCRE_STATS_HISTOGRAM_BUCKETS 16 /**< Power-of-two microsecond buckets per histogram */
+#endif
+
+// Tracing, enabled by building with OCRE_SDK_TRACE
+#ifndef OCRE_TRACE_RING_SIZE
+#define OCRE_TRACE_RING_SIZE 256        /**< Records kept in the trace ring, must be a power of two */
+#endif
+#define OCRE_TRACE_MAGIC 0x5452434FU    /**< "OCRT", marks the start of the trace ring */
+
+// Soft timers
+#ifndef OCRE_SOFT_TIMER_HOST_ID
+#define OCRE_SOFT_TIMER_HOST_ID OCRE_MAX_TIMERS /**< Host timer driving the soft timer wheel once a soft timer is used */
+#endif
+#if OCRE_SOFT_TIMER_HOST_ID < 1 || OCRE_SOFT_TIMER_HOST_ID > OCRE_MAX_TIMERS
+#error "OCRE_SOFT_TIMER_HOST_ID must be a host timer ID between 1 and OCRE_MAX_TIMERS"
+#endif
+#ifndef OCRE_SOFT_TIMER_TICK_MS
+#define OCRE_SOFT_TIMER_TICK_MS 10              /**< Soft timer resolution in milliseconds */
+#endif
+#define OCRE_SOFT_TIMER_WHEEL_BITS 6            /**< log2 of the slots per wheel level */
+#define OCRE_SOFT_TIMER_WHEEL_LEVELS 4          /**< Wheel levels, bounding the longest timeout */
+#define OCRE_SOFT_TIMER_MAX_TICKS ((1U << (OCRE_SOFT_TIMER_WHEEL_BITS * OCRE_SOFT_TIMER_WHEEL_LEVELS)) - 1U)
+
 // GPIO Configuration
 #ifndef CONFIG_OCRE_GPIO_MAX_PINS
 #define CONFIG_OCRE_GPIO_MAX_PINS 32
@@ -65,16 +157,9 @@ extern "C"
 #ifndef CONFIG_OCRE_GPIO_PINS_PER_PORT
 #define CONFIG_OCRE_GPIO_PINS_PER_PORT 16
 #endif
-
-    /**
-     * @brief Internal state tracking for the OCRE SDK
-     */
-    typedef struct
-    {
-        bool initialized;        /**< Indicates if the SDK is initialized */
-        uint32_t active_timers;  /**< Number of active timers */
-        uint32_t active_sensors; /**< Number of active sensors */
-    } ocre_sdk_state_t;
+#ifndef OCRE_MAX_GPIO_CALLBACKS
+#define OCRE_MAX_GPIO_CALLBACKS 16
+#endif
 
     /**
      * @brief Structure for event data
@@ -89,6 +174,15 @@ extern "C"
         uint32_t payload_len; /**< Payload length (for message events) */
     } event_data_t;
 
+    /**
+     * @brief Dispatch budget applied to each ocre_process_events_ex() call
+     */
+    typedef struct
+    {
+        uint32_t max_events;  /**< Maximum events per call, or OCRE_EVENT_DRAIN to drain until empty */
+        uint32_t max_time_us; /**< Maximum dispatch time per call in microseconds, 0 for no limit */
+    } ocre_event_policy_t;
+
     // =============================================================================
     // Resource Types
     // =============================================================================
@@ -102,6 +196,11 @@ extern "C"
         OCRE_RESOURCE_TYPE_GPIO,    /**< GPIO resource */
         OCRE_RESOURCE_TYPE_SENSOR,  /**< Sensor resource */
         OCRE_RESOURCE_TYPE_MESSAGE, /**< Message resource */
+        OCRE_RESOURCE_TYPE_CHANNEL, /**< Shared-memory channel doorbell */
+        OCRE_RESOURCE_TYPE_FLOW,    /**< Publish credits available again */
+        OCRE_RESOURCE_TYPE_GPIO_CAPTURE, /**< Batch of captured GPIO edges */
+        OCRE_RESOURCE_TYPE_FILE_WATCH, /**< Watched file changed */
+        OCRE_RESOURCE_TYPE_WORKQUEUE, /**< Work items completed, see ocre_workqueue.h */
         OCRE_RESOURCE_TYPE_COUNT    /**< Number of resource types */
     } ocre_resource_type_t;
 
@@ -111,6 +210,14 @@ extern "C"
 
     /**
      * @brief Create a timer with specified ID
+     *
+     * OCRE_SOFT_TIMER_HOST_ID, the last ID by default, drives the soft timers. A module
+     * that never starts a soft timer, which includes ocre_task_sleep(), timed task waits
+     * and log writer latency deadlines, may use it as any other ID. Otherwise whichever
+     * comes second fails with OCRE_ERROR_BUSY: ocre_soft_timer_start(), or the callback
+     * registration for that ID. Such a module uses the IDs below it, or moves the soft
+     * timers by defining OCRE_SOFT_TIMER_HOST_ID.
+     *
      * @param id Timer identifier (must be between 1 and OCRE_MAX_TIMERS)
      * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on error
      */
@@ -146,6 +253,91 @@ extern "C"
      */
     int ocre_timer_get_remaining(int id);
 
+    /**
+     * @brief Start a timer with a microsecond interval
+     * @param id Timer identifier
+     * @param interval_us Timer interval in microseconds
+     * @param is_periodic True for periodic timer, false for one-shot
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on error
+     */
+    int ocre_timer_start_us(int id, uint32_t interval_us, int is_periodic);
+
+    // =============================================================================
+    // Soft Timer API
+    // =============================================================================
+
+    struct ocre_soft_timer;
+
+    /**
+     * @brief Soft timer callback function type
+     * @param timer Timer that expired
+     * @param user_data Pointer given to ocre_soft_timer_init()
+     */
+    typedef void (*ocre_soft_timer_func_t)(struct ocre_soft_timer *timer, void *user_data);
+
+    /**
+     * @brief Software timer kept in the SDK timer wheel
+     *
+     * Storage is owned by the caller, so the number of soft timers is only bounded by
+     * memory. Fields are private to the SDK, set them up with ocre_soft_timer_init().
+     */
+    typedef struct ocre_soft_timer
+    {
+        struct ocre_soft_timer *next;   /**< Next timer in the same wheel slot */
+        struct ocre_soft_timer **pprev; /**< Link pointing at this timer, NULL when inactive */
+        ocre_soft_timer_func_t callback; /**< Called on expiry */
+        void *user_data;                /**< Passed back to the callback */
+        uint32_t expires;               /**< Wheel tick of the next expiry */
+        uint32_t period;                /**< Period in ticks, 0 for one-shot */
+    } ocre_soft_timer_t;
+
+    /**
+     * @brief Initialize a soft timer
+     * @param timer Timer to initialize
+     * @param callback Function called on each expiry
+     * @param user_data Pointer passed back to @p callback
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on error
+     */
+    int ocre_soft_timer_init(ocre_soft_timer_t *timer, ocre_soft_timer_func_t callback, void *user_data);
+
+    /**
+     * @brief Arm a soft timer, restarting it if it is already active
+     *
+     * All soft timers share host timer OCRE_SOFT_TIMER_HOST_ID, which is started while
+     * any soft timer is active and must then not be used directly, see ocre_timer_create(). Insert and cancel are O(1),
+     * expiries are dispatched from ocre_process_events() like other timer events. Times
+     * are rounded up to OCRE_SOFT_TIMER_TICK_MS and clamped to OCRE_SOFT_TIMER_MAX_TICKS.
+     * The timer may be restarted or stopped from its own callback.
+     *
+     * @param timer Initialized timer
+     * @param timeout_ms Time until the first expiry in milliseconds
+     * @param period_ms Period of later expiries in milliseconds, 0 for one-shot
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_BUSY if a user callback is registered for
+     *         OCRE_SOFT_TIMER_HOST_ID, negative error code if the host timer could not be started
+     */
+    int ocre_soft_timer_start(ocre_soft_timer_t *timer, uint32_t timeout_ms, uint32_t period_ms);
+
+    /**
+     * @brief Cancel a soft timer
+     * @param timer Timer to cancel
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NOT_FOUND if the timer was not active
+     */
+    int ocre_soft_timer_stop(ocre_soft_timer_t *timer);
+
+    /**
+     * @brief Check whether a soft timer is armed
+     * @param timer Timer to check
+     * @return true if the timer is active
+     */
+    bool ocre_soft_timer_is_active(const ocre_soft_timer_t *timer);
+
+    /**
+     * @brief Get remaining time of a soft timer
+     * @param timer Timer to query
+     * @return Remaining time in milliseconds, or OCRE_ERROR_NOT_FOUND if the timer is not active
+     */
+    int ocre_soft_timer_get_remaining(const ocre_soft_timer_t *timer);
+
     // =============================================================================
     // GPIO API
     // =============================================================================
@@ -168,6 +360,16 @@ extern "C"
         OCRE_GPIO_PIN_SET = 1    /**< GPIO pin high state */
     } ocre_gpio_pin_state_t;
 
+    /**
+     * @brief GPIO edges that trigger a callback
+     */
+    typedef enum
+    {
+        OCRE_GPIO_EDGE_RISING = 0x1,  /**< Trigger on transitions to OCRE_GPIO_PIN_SET */
+        OCRE_GPIO_EDGE_FALLING = 0x2, /**< Trigger on transitions to OCRE_GPIO_PIN_RESET */
+        OCRE_GPIO_EDGE_BOTH = 0x3     /**< Trigger on any transition */
+    } ocre_gpio_edge_t;
+
     /**
      * @brief Initialize GPIO subsystem
      * @return OCRE_SUCCESS on success, negative error code on failure
@@ -208,6 +410,35 @@ extern "C"
      */
     int ocre_gpio_pin_toggle(int port, int pin);
 
+#define OCRE_GPIO_PIN_MASK(pin) (1U << (pin)) /**< Port mask bit of a pin */
+
+    /**
+     * @brief Set several output pins of a port at the same instant
+     *
+     * Pins outside @p mask are left unchanged. Maps onto Zephyr gpio_port_set_masked().
+     *
+     * @param port GPIO port number
+     * @param mask Pins to update, OCRE_GPIO_PIN_MASK() bits
+     * @param value New levels of the pins in @p mask, a set bit drives the pin high
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_gpio_port_set_masked(int port, uint32_t mask, uint32_t value);
+
+    /**
+     * @brief Read every pin of a port at the same instant
+     * @param port GPIO port number
+     * @return Pin levels as OCRE_GPIO_PIN_MASK() bits, negative error code on failure
+     */
+    int ocre_gpio_port_get(int port);
+
+    /**
+     * @brief Toggle several output pins of a port at the same instant
+     * @param port GPIO port number
+     * @param mask Pins to toggle, OCRE_GPIO_PIN_MASK() bits
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_gpio_port_toggle(int port, uint32_t mask);
+
     /**
      * @brief Register callback for GPIO pin state changes
      * @param port GPIO port number
@@ -216,6 +447,18 @@ extern "C"
      */
     int ocre_gpio_register_callback(int port, int pin);
 
+    /**
+     * @brief Register callback for selected GPIO pin edges
+     *
+     * Edges that were not selected are filtered in the host and never queued.
+     *
+     * @param port GPIO port number
+     * @param pin GPIO pin number
+     * @param edge Edges that should raise an event
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_gpio_register_callback_edge(int port, int pin, ocre_gpio_edge_t edge);
+
     /**
      * @brief Unregister GPIO pin callback
      * @param port GPIO port number
@@ -268,160 +511,1224 @@ extern "C"
      */
     int ocre_gpio_unregister_callback_by_name(const char *name);
 
+    /**
+     * @brief GPIO pin resolved from its name
+     */
+    typedef struct
+    {
+        int port; /**< GPIO port number */
+        int pin;  /**< GPIO pin number */
+    } ocre_gpio_pin_t;
+
+    /**
+     * @brief Look up the port and pin of a named GPIO
+     * @param name GPIO pin name
+     * @param port Receives the port number
+     * @param pin Receives the pin number
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_gpio_get_pin_by_name(const char *name, int *port, int *pin);
+
+    /**
+     * @brief Resolve a GPIO name once for use with the port/pin calls
+     *
+     * The result is cached in the SDK, so only the first call for a name crosses into
+     * the host. Use the returned port and pin with ocre_gpio_pin_set() and friends to
+     * keep strings off the hot path.
+     *
+     * @param name GPIO pin name
+     * @param pin Receives the port and pin
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_gpio_resolve(const char *name, ocre_gpio_pin_t *pin);
+
     // =============================================================================
-    // Event API
+    // GPIO Edge Capture API
     // =============================================================================
 
     /**
-     * @brief Timer callback function type
+     * @brief One captured edge
      */
-    typedef void (*timer_callback_func_t)(void);
+    typedef struct
+    {
+        uint64_t timestamp_ns; /**< Host monotonic time of the edge, as ocre_time_ns(), taken in the ISR */
+        uint32_t state;        /**< Pin level after the edge (OCRE_GPIO_PIN_RESET or OCRE_GPIO_PIN_SET) */
+        uint32_t reserved;     /**< Keeps records 8-byte aligned */
+    } ocre_gpio_edge_record_t;
 
     /**
-     * @brief GPIO callback function type
+     * @brief Record indices and counters shared between the host and the SDK
      */
-    typedef void (*gpio_callback_func_t)(void);
+    typedef struct
+    {
+        uint32_t head;    /**< Records written, advanced by the host */
+        uint32_t tail;    /**< Records consumed, advanced by the SDK */
+        uint32_t edges;   /**< Edges seen since capture started, including dropped ones */
+        uint32_t dropped; /**< Edges not recorded because the buffer was full */
+    } ocre_gpio_capture_ring_t;
+
+    struct ocre_gpio_capture;
 
     /**
-     * @brief Message callback function type
-     * @param topic The topic of the received message
-     * @param content_type The content type of the message
-     * @param payload The message payload
-     * @param payload_len The length of the payload
+     * @brief GPIO edge capture callback function type
+     *
+     * Called once per contiguous run of records, so twice for a batch that wraps around
+     * the end of the buffer.
+     *
+     * @param capture The capture the edges belong to
+     * @param edges Records in place in the capture buffer, oldest first, valid until the callback returns
+     * @param count Number of records in @p edges
+     * @param user_data Pointer given to ocre_gpio_capture_start()
      */
-    typedef void (*message_callback_func_t)(const char *topic, const char *content_type, const void *payload, uint32_t payload_len);
+    typedef void (*ocre_gpio_capture_callback_t)(struct ocre_gpio_capture *capture,
+                                                 const ocre_gpio_edge_record_t *edges, uint32_t count,
+                                                 void *user_data);
 
     /**
-     * @brief Get event data for a specific resource
-     * @param type_offset Offset for resource type
-     * @param id_offset Offset for resource ID
-     * @param port_offset Offset for port number
-     * @param state_offset Offset for state
-     * @param extra_offset Offset for extra data
-     * @param payload_len_offset Offset for payload length
-     * @return OCRE_SUCCESS on success, negative error code on failure
+     * @brief GPIO edge capture state
+     *
+     * Fields are private to the SDK, use the ocre_gpio_capture_*() accessors.
      */
-    int ocre_get_event(uint32_t type_offset, uint32_t id_offset, uint32_t port_offset,
-                       uint32_t state_offset, uint32_t extra_offset, uint32_t payload_len_offset);
+    typedef struct ocre_gpio_capture
+    {
+        int handle;                            /**< Host capture handle */
+        ocre_gpio_capture_ring_t ring;         /**< Indices and counters shared with the host */
+        ocre_gpio_edge_record_t *records;      /**< Record storage given to ocre_gpio_capture_start() */
+        uint32_t record_count;                 /**< Records in the buffer */
+        uint64_t last_timestamp_ns;            /**< Newest delivered edge */
+        uint64_t interval_ns;                  /**< Mean time between edges over the last batch */
+        ocre_gpio_capture_callback_t callback; /**< Called for each run of records */
+        void *user_data;                       /**< Passed back to the callback */
+    } ocre_gpio_capture_t;
 
     /**
-     * @brief Process the events from runtime
+     * @brief Ask the host to timestamp edges of a pin into a record buffer
+     *
+     * The host queues an OCRE_RESOURCE_TYPE_GPIO_CAPTURE event with the capture handle as id
+     * once @p batch records are pending, or @p max_latency_ms after the oldest pending one.
+     *
+     * @param port GPIO port number
+     * @param pin GPIO pin number
+     * @param edge Edges to capture
+     * @param ring Indices and counters the host advances and reads
+     * @param records Record storage
+     * @param record_count Records in @p records
+     * @param batch Pending records that trigger an event
+     * @param max_latency_ms Longest time a record waits for its event, 0 to wait for a full batch
+     * @return Capture handle (> 0) on success, negative error code on failure
      */
-    void ocre_process_events(void);
+    int ocre_gpio_capture_open(int port, int pin, ocre_gpio_edge_t edge, ocre_gpio_capture_ring_t *ring,
+                               ocre_gpio_edge_record_t *records, uint32_t record_count, uint32_t batch,
+                               uint32_t max_latency_ms);
 
     /**
-     * @brief Register timer callback
-     * @param timer_id Timer identifier
-     * @param callback Callback function to register
+     * @brief Stop edge capture on a pin
+     * @param handle Handle returned by ocre_gpio_capture_open()
      * @return OCRE_SUCCESS on success, negative error code on failure
      */
-    int ocre_register_timer_callback(int timer_id, timer_callback_func_t callback);
+    int ocre_gpio_capture_close(int handle);
 
     /**
-     * @brief Register GPIO callback
-     * @param pin GPIO pin number
+     * @brief Start capturing timestamped edges of an input pin
+     *
+     * Edges are recorded by the host in interrupt context and delivered in batches from
+     * ocre_process_events(), so kilohertz inputs cost one event per batch instead of one
+     * per edge. Replaces any GPIO callback registered for the pin while capture runs.
+     *
+     * @param capture Capture to initialize
      * @param port GPIO port number
-     * @param callback Callback function to register
+     * @param pin GPIO pin number
+     * @param edge Edges to capture
+     * @param records Record storage, must stay valid until ocre_gpio_capture_stop()
+     * @param record_count Records in @p records, more than @p batch to absorb dispatch latency
+     * @param batch Records per event
+     * @param max_latency_ms Longest time an edge waits for delivery, 0 to wait for a full batch
+     * @param callback Called for each run of records
+     * @param user_data Pointer passed back to @p callback
      * @return OCRE_SUCCESS on success, negative error code on failure
      */
-    int ocre_register_gpio_callback(int pin, int port, gpio_callback_func_t callback);
+    int ocre_gpio_capture_start(ocre_gpio_capture_t *capture, int port, int pin, ocre_gpio_edge_t edge,
+                                ocre_gpio_edge_record_t *records, uint32_t record_count, uint32_t batch,
+                                uint32_t max_latency_ms, ocre_gpio_capture_callback_t callback, void *user_data);
 
     /**
-     * @brief Register message callback
-     * @param topic The topic to subscribe to
-     * @param callback Callback function to register
+     * @brief Stop a capture; records still in the buffer are discarded
+     * @param capture Capture to stop
      * @return OCRE_SUCCESS on success, negative error code on failure
      */
-    int ocre_register_message_callback(const char *topic, message_callback_func_t callback);
+    int ocre_gpio_capture_stop(ocre_gpio_capture_t *capture);
 
     /**
-     * @brief Unregister timer callback
-     * @param timer_id Timer identifier
-     * @return OCRE_SUCCESS on success, negative error code on failure
+     * @brief Get the number of edges seen since the capture started
+     *
+     * Counted by the host, so it includes edges dropped from a full buffer and is exact
+     * for pulse counting.
+     *
+     * @param capture Capture to query
+     * @return Edge count, wrapping at 2^32
      */
-    int ocre_unregister_timer_callback(int timer_id);
+    uint32_t ocre_gpio_capture_edges(const ocre_gpio_capture_t *capture);
 
     /**
-     * @brief Unregister GPIO callback
-     * @param pin GPIO pin number
-     * @param port GPIO port number
-     * @return OCRE_SUCCESS on success, negative error code on failure
+     * @brief Get the number of edges dropped because the buffer was full
+     * @param capture Capture to query
+     * @return Dropped edge count
      */
-    int ocre_unregister_gpio_callback(int pin, int port);
+    uint32_t ocre_gpio_capture_dropped(const ocre_gpio_capture_t *capture);
 
     /**
-     * @brief Unregister message callback
-     * @param topic The topic to unsubscribe from
-     * @return OCRE_SUCCESS on success, negative error code on failure
+     * @brief Get the mean time between edges over the last delivered batch
+     *
+     * With a single edge direction captured this is the signal period, for RPM or
+     * frequency measurement.
+     *
+     * @param capture Capture to query
+     * @return Interval in nanoseconds, 0 before two edges were delivered
      */
-    int ocre_unregister_message_callback(const char *topic);
+    uint64_t ocre_gpio_capture_interval_ns(const ocre_gpio_capture_t *capture);
 
     // =============================================================================
-    // Messages API
+    // Event API
     // =============================================================================
 
     /**
-     * @brief Structure for OCRE messages
+     * @brief Timer callback function type
      */
-    typedef struct ocre_msg
-    {
-        uint32_t mid;         /**< Message ID - increments on each message */
-        char *topic;          /**< URL of the request */
-        char *content_type;   /**< Payload format (MIME type) */
-        void *payload;        /**< Payload of the request */
-        uint32_t payload_len; /**< Length in bytes of the payload */
-    } ocre_msg_t;
+    typedef void (*timer_callback_func_t)(void);
 
     /**
-     * @brief Initialize OCRE Messaging System
+     * @brief Timer callback function type with overrun count
+     *
+     * When a periodic timer expires again before its event is dispatched, the host
+     * queues a single event and counts the extra expiries instead of queuing one event
+     * per expiry. The event's extra field carries that count.
+     *
+     * @param timer_id Timer identifier
+     * @param overruns Number of expiries coalesced into this call, 0 if none were missed
      */
-    void ocre_msg_system_init(void);
+    typedef void (*timer_callback_ex_func_t)(int timer_id, uint32_t overruns);
 
     /**
-     * @brief Publish a message to the specified target
-     * @param topic The name of the topic on which to publish the message
-     * @param content_type The content type of the message; it is recommended to use a MIME type
-     * @param payload A buffer containing the message contents
-     * @param payload_len The length of the payload buffer
-     * @return OCRE_SUCCESS on success, negative error code on failure
+     * @brief GPIO callback function type
      */
-    int ocre_publish_message(const char *topic, const char *content_type, const void *payload, uint32_t payload_len);
+    typedef void (*gpio_callback_func_t)(void);
 
     /**
-     * @brief Subscribe to messages on the specified topic
-     * @param topic The name of the topic on which to subscribe
-     * @return OCRE_SUCCESS on success, negative error code on failure
+     * @brief Extended GPIO callback function type
+     * @param port GPIO port number
+     * @param pin GPIO pin number
+     * @param state Pin state after the edge
+     * @param user_data Pointer given at registration
      */
-    int ocre_subscribe_message(const char *topic);
+    typedef void (*gpio_callback_ex_func_t)(int port, int pin, ocre_gpio_pin_state_t state, void *user_data);
 
     /**
-     * @brief Frees allocated memory for a messaging event in the WASM module.
-     *
-     * This function releases the allocated memory for the topic, content-type, and payload
-     * associated with a messaging event received by the WASM module. It should be called
-     * after processing the message in ocre_process_events() to prevent memory leaks.
+     * @brief Message callback function type
      *
-     * @param topic_offset    Offset in WASM memory for the message topic.
-     * @param content_offset  Offset in WASM memory for the message content-type.
-     * @param payload_offset  Offset in WASM memory for the message payload.
+     * The pointers refer directly to the buffers the host allocated in module memory
+     * and are only valid until the callback returns. Call ocre_message_retain() from
+     * within the callback to keep them longer.
      *
-     * @return OCRE_SUCCESS on success, negative error code on failure.
+     * @param topic The topic of the received message
+     * @param content_type The content type of the message
+     * @param payload The message payload
+     * @param payload_len The length of the payload
      */
-    int ocre_messaging_free_module_event_data(uint32_t topic_offset, uint32_t content_offset, uint32_t payload_offset);
+    typedef void (*message_callback_func_t)(const char *topic, const char *content_type, const void *payload, uint32_t payload_len);
 
-    // =============================================================================
-    // Utility API
-    // =============================================================================
+    /**
+     * @brief Message chunk callback function type for fragmented messages
+     * @param topic The topic of the received message
+     * @param content_type The content type of the whole message
+     * @param chunk The bytes of this fragment
+     * @param chunk_len The length of this fragment
+     * @param offset Offset of this fragment within the whole payload
+     * @param total_len Length of the whole payload
+     */
+    typedef void (*message_chunk_callback_func_t)(const char *topic, const char *content_type, const void *chunk,
+                                                  uint32_t chunk_len, uint32_t offset, uint32_t total_len);
 
     /**
-     * @brief Sleep for specified duration
-     * @param milliseconds Sleep duration in milliseconds
+     * @brief Get event data for a specific resource
+     * @param type_offset Offset for resource type
+     * @param id_offset Offset for resource ID
+     * @param port_offset Offset for port number
+     * @param state_offset Offset for state
+     * @param extra_offset Offset for extra data
+     * @param payload_len_offset Offset for payload length
      * @return OCRE_SUCCESS on success, negative error code on failure
      */
-    int ocre_sleep(int milliseconds);
+    int ocre_get_event(uint32_t type_offset, uint32_t id_offset, uint32_t port_offset,
+                       uint32_t state_offset, uint32_t extra_offset, uint32_t payload_len_offset);
 
-/**
- * @brief Pause execution indefinitely (implementation-specific)
+    /**
+     * @brief Get up to @p max pending events in a single host call
+     * @param buf Array in module memory that receives the events
+     * @param max Capacity of @p buf in events
+     * @param count Receives the number of events written to @p buf
+     * @return OCRE_SUCCESS on success (including an empty queue with *count == 0),
+     *         negative error code on failure
+     */
+    int ocre_get_events(event_data_t *buf, uint32_t max, uint32_t *count);
+
+    /**
+     * @brief Block until at least one event is queued for this module
+     * @param timeout_ms Maximum time to wait in milliseconds, 0 to poll, or OCRE_WAIT_FOREVER
+     * @return OCRE_SUCCESS if an event is pending, OCRE_ERROR_TIMEOUT if none arrived in time,
+     *         negative error code on failure
+     */
+    int ocre_wait_events(int timeout_ms);
+
+    /**
+     * @brief Process the events from runtime
+     *
+     * Drains pending events and sleeps 10 ms when none were found. Kept for
+     * compatibility with busy loops; new code should prefer ocre_process_events_ex().
+     */
+    void ocre_process_events(void);
+
+    /**
+     * @brief Process the events from runtime with explicit wait behaviour
+     *
+     * With OCRE_EVENT_FLAG_WAIT the call blocks in the host until an event arrives
+     * or @p timeout_ms expires, then dispatches queued events back-to-back without
+     * sleeping. Without it the queue is polled once and the call returns immediately.
+     * Cooperative tasks (ocre_task.h) whose wait is over run after the events; the call
+     * does not block while any task is ready.
+     *
+     * @param flags Combination of OCRE_EVENT_FLAG_* values
+     * @param timeout_ms Wait timeout in milliseconds, or OCRE_WAIT_FOREVER (ignored without OCRE_EVENT_FLAG_WAIT)
+     * @return Number of events dispatched (0 on timeout), negative error code on failure
+     */
+    int ocre_process_events_ex(uint32_t flags, int timeout_ms);
+
+    struct pollfd;
+
+    /**
+     * @brief Host wait on descriptors and the module's event queue together
+     * @param fds Descriptors to watch, as for poll()
+     * @param nfds Number of entries in @p fds
+     * @param timeout_ms Maximum wait in milliseconds, 0 to poll, or OCRE_WAIT_FOREVER
+     * @return Number of descriptors with events, 0 on timeout or on a queued Ocre event,
+     *         negative error code on failure
+     */
+    int ocre_poll_events(struct pollfd *fds, uint32_t nfds, int timeout_ms);
+
+    /**
+     * @brief Wait on sockets and Ocre events in one call
+     *
+     * Behaves like poll(), but also returns as soon as an Ocre event is queued for this
+     * module, so one loop can block on both and react to either without a polling
+     * interval. Events are not dispatched here: follow the call with
+     * ocre_process_events_ex(OCRE_EVENT_FLAG_NONE, 0). Does not block while events
+     * fetched earlier still wait for dispatch or a task is ready to run.
+     *
+     * Mongoose uses it when its poll() is mapped to ocre_poll() in mongoose_config.h.
+     *
+     * @param fds Descriptors to watch, as for poll()
+     * @param nfds Number of entries in @p fds, 0 to wait for events only
+     * @param timeout_ms Maximum wait in milliseconds, 0 to poll, or OCRE_WAIT_FOREVER
+     * @return Number of descriptors with events, 0 on timeout or when only Ocre events
+     *         are pending, negative error code on failure
+     */
+    int ocre_poll(struct pollfd *fds, uint32_t nfds, int timeout_ms);
+
+    /**
+     * @brief Set the dispatch budget for subsequent event processing calls
+     *
+     * The time budget is checked after each callback returns, so a single slow
+     * callback can overrun it. Events that were fetched but not dispatched are
+     * kept and handled first by the next call.
+     *
+     * @param policy Budget to apply; max_events defaults to OCRE_DEFAULT_EVENTS_PER_LOOP
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if @p policy is NULL
+     */
+    int ocre_set_event_policy(const ocre_event_policy_t *policy);
+
+    /**
+     * @brief Tell the host the priority of a resource type's events
+     *
+     * Lets the host keep one queue per priority and hand out higher-priority events first.
+     *
+     * @param type Resource type
+     * @param priority Priority, lower values are dispatched first
+     * @return OCRE_SUCCESS on success, negative error code if the host keeps a single queue
+     */
+    int ocre_set_event_queue_priority(ocre_resource_type_t type, uint32_t priority);
+
+    /**
+     * @brief Set the dispatch priority of a resource type
+     *
+     * Within each fetched batch, events are dispatched in priority order (lower first)
+     * and FIFO among equal priorities. Defaults are timers, then GPIO, sensors and
+     * messages. The priority is also passed to the host with
+     * ocre_set_event_queue_priority() so it can order its queue the same way.
+     *
+     * @param type Resource type
+     * @param priority Priority between OCRE_EVENT_PRIORITY_HIGHEST and OCRE_EVENT_PRIORITY_LOWEST
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID for an unknown type
+     */
+    int ocre_set_event_priority(ocre_resource_type_t type, uint8_t priority);
+
+    /**
+     * @brief Get the current dispatch budget
+     * @param policy Receives the active policy
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if @p policy is NULL
+     */
+    int ocre_get_event_policy(ocre_event_policy_t *policy);
+
+    /**
+     * @brief Event queue counters kept by the host for this module
+     */
+    typedef struct
+    {
+        uint32_t queue_depth;        /**< Events currently queued */
+        uint32_t queue_high_water;   /**< Deepest the queue has been */
+        uint32_t queue_drops;        /**< Events dropped because the queue was full */
+        uint32_t messages_truncated; /**< Messages cut to the broker's payload limit */
+    } ocre_host_event_stats_t;
+
+    /**
+     * @brief Totals over the arenas and pools of ocre_alloc.h
+     */
+    typedef struct
+    {
+        uint32_t allocators; /**< Arenas and pools registered */
+        uint32_t capacity;   /**< Bytes they manage */
+        uint32_t in_use;     /**< Bytes handed out */
+        uint32_t high_water; /**< Sum of their high-water marks */
+        uint32_t failures;   /**< Allocations refused for lack of space */
+    } ocre_memory_stats_t;
+
+    /**
+     * @brief Event loop statistics
+     *
+     * Histogram bucket 0 counts durations under 1 us and bucket i counts durations in
+     * [2^(i-1), 2^i) us; the last bucket also counts everything longer. Events carry no
+     * host timestamp, so the latency from the host enqueueing an event is not measured.
+     * The histograms cost two host clock reads per event and are only filled in builds
+     * with OCRE_SDK_TIMING, they stay zero otherwise.
+     */
+    typedef struct
+    {
+        uint32_t events_dispatched[OCRE_RESOURCE_TYPE_COUNT]; /**< Events dispatched, per resource type */
+        uint32_t events_unmatched;                           /**< Events with no registered callback or of unknown type */
+        uint32_t free_failures;                              /**< Message buffers the host failed to free */
+        uint32_t rx_pool_messages;                           /**< Messages received in a pool slot and recycled in place */
+        uint32_t batch_wait_us[OCRE_STATS_HISTOGRAM_BUCKETS];        /**< Time from the ocre_get_events() batch fetch to dispatch, the wait in the host queue is not included */
+        uint32_t callback_duration_us[OCRE_STATS_HISTOGRAM_BUCKETS]; /**< Time spent dispatching each event */
+        ocre_host_event_stats_t host;                        /**< Host queue counters, zero if unsupported */
+        ocre_memory_stats_t memory;                          /**< Arena and pool usage */
+    } ocre_sdk_stats_t;
+
+    /**
+     * @brief Read the host's event queue counters for this module
+     * @param stats Receives the counters
+     * @return OCRE_SUCCESS on success, negative error code if the host does not keep them
+     */
+    int ocre_get_event_queue_stats(ocre_host_event_stats_t *stats);
+
+    /**
+     * @brief Get event loop statistics
+     *
+     * SDK counters cover events dispatched through ocre_process_events() and
+     * ocre_process_events_ex(). The host counters and the arena and pool totals are
+     * read on each call.
+     *
+     * @param stats Receives the statistics
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if @p stats is NULL
+     */
+    int ocre_sdk_get_stats(ocre_sdk_stats_t *stats);
+
+    /**
+     * @brief Reset the SDK counters; host counters are not affected
+     *
+     * Arena and pool high-water marks restart at their current usage.
+     */
+    void ocre_sdk_reset_stats(void);
+
+    /**
+     * @brief Trace record of one dispatched event
+     */
+    typedef struct
+    {
+        uint32_t timestamp_us; /**< Low 32 bits of ocre_time_us() when dispatch started */
+        uint32_t duration_us;  /**< Time spent dispatching the event */
+        uint32_t id;           /**< Timer ID, GPIO pin or message ID */
+        uint16_t type;         /**< Resource type (OCRE_RESOURCE_TYPE_*) */
+        uint16_t extra;        /**< Timer overruns, GPIO port << 8 | state, or message payload length; saturated */
+    } ocre_trace_record_t;
+
+    /**
+     * @brief Trace ring in module memory
+     *
+     * Written in place with no locking; once full, the oldest records are overwritten.
+     * The newest record is records[(head - 1) % size].
+     */
+    typedef struct
+    {
+        uint32_t magic;                                  /**< OCRE_TRACE_MAGIC */
+        uint32_t size;                                   /**< Number of records, OCRE_TRACE_RING_SIZE */
+        uint32_t head;                                   /**< Total records written */
+        ocre_trace_record_t records[OCRE_TRACE_RING_SIZE]; /**< Record storage */
+    } ocre_trace_ring_t;
+
+    /**
+     * @brief Get the trace ring
+     *
+     * Also exported to the host as "ocre_trace_ring", returning the ring's offset in
+     * module memory so host tools can dump it without the module's help.
+     *
+     * @return The ring, or NULL if the SDK was built without OCRE_SDK_TRACE
+     */
+    const ocre_trace_ring_t *ocre_trace_get_ring(void);
+
+    /**
+     * @brief Copy out trace records not read yet, oldest first
+     *
+     * Records overwritten before they were read are skipped.
+     *
+     * @param records Buffer that receives the records
+     * @param max Capacity of @p records
+     * @return Number of records copied, 0 if there are none or tracing is disabled
+     */
+    uint32_t ocre_trace_read(ocre_trace_record_t *records, uint32_t max);
+
+    /**
+     * @brief Register timer callback
+     * @param timer_id Timer identifier
+     * @param callback Callback function to register
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_BUSY for OCRE_SOFT_TIMER_HOST_ID once soft
+     *         timers use it, other negative error code on failure
+     */
+    int ocre_register_timer_callback(int timer_id, timer_callback_func_t callback);
+
+    /**
+     * @brief Register timer callback that receives the overrun count
+     *
+     * Replaces a callback registered with ocre_register_timer_callback() for the same ID.
+     * Plain callbacks are called once per coalesced expiry, without the count.
+     *
+     * @param timer_id Timer identifier
+     * @param callback Callback function to register
+     * @return As for ocre_register_timer_callback()
+     */
+    int ocre_register_timer_callback_ex(int timer_id, timer_callback_ex_func_t callback);
+
+    /**
+     * @brief Register GPIO callback
+     * @param pin GPIO pin number
+     * @param port GPIO port number
+     * @param callback Callback function to register
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_register_gpio_callback(int pin, int port, gpio_callback_func_t callback);
+
+    /**
+     * @brief Register GPIO callback for selected edges, with pin state and user context
+     *
+     * Registers the pin with the host via ocre_gpio_register_callback_edge(). Replaces any
+     * callback previously registered for the pin. Unregister with ocre_unregister_gpio_callback().
+     *
+     * @param port GPIO port number
+     * @param pin GPIO pin number
+     * @param edge Edges that trigger the callback
+     * @param callback Callback function to register
+     * @param user_data Pointer passed back to @p callback
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_register_gpio_callback_ex(int port, int pin, ocre_gpio_edge_t edge, gpio_callback_ex_func_t callback, void *user_data);
+
+    /**
+     * @brief Register message callback
+     *
+     * @p topic is a filter in MQTT style: '+' matches exactly one level and a final '#'
+     * matches any number of remaining levels, including none. A trailing '/' is
+     * shorthand for a final '#' ("test/" matches "test/topic"). Every callback whose
+     * filter matches a message is called. Registering the same filter again replaces
+     * its callback.
+     *
+     * @param topic The topic filter to subscribe to
+     * @param callback Callback function to register
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_register_message_callback(const char *topic, message_callback_func_t callback);
+
+    /**
+     * @brief Unregister timer callback
+     * @param timer_id Timer identifier
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_unregister_timer_callback(int timer_id);
+
+    /**
+     * @brief Unregister GPIO callback
+     * @param pin GPIO pin number
+     * @param port GPIO port number
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_unregister_gpio_callback(int pin, int port);
+
+    /**
+     * @brief Unregister message callback
+     * @param topic The topic to unsubscribe from
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_unregister_message_callback(const char *topic);
+
+    // =============================================================================
+    // Messages API
+    // =============================================================================
+
+    /**
+     * @brief Structure for OCRE messages
+     */
+    typedef struct ocre_msg
+    {
+        uint32_t mid;         /**< Message ID - increments on each message */
+        char *topic;          /**< URL of the request */
+        char *content_type;   /**< Payload format (MIME type) */
+        void *payload;        /**< Payload of the request */
+        uint32_t payload_len; /**< Length in bytes of the payload */
+    } ocre_msg_t;
+
+    /**
+     * @brief Scatter/gather element for publishing from several buffers
+     */
+    typedef struct
+    {
+        const void *base; /**< Start of the buffer */
+        uint32_t len;     /**< Length of the buffer in bytes */
+    } ocre_iovec_t;
+
+    /**
+     * @brief Header prefixed to each fragment of a streamed message
+     */
+    typedef struct
+    {
+        uint32_t magic;     /**< OCRE_FRAGMENT_MAGIC */
+        uint32_t stream_id; /**< Identifies the fragments of one message */
+        uint32_t offset;    /**< Offset of the fragment data within the whole payload */
+        uint32_t total_len; /**< Length of the whole payload */
+    } ocre_fragment_header_t;
+
+#define OCRE_FRAGMENT_MAGIC 0x4652434FU /**< "OCRF" */
+#define OCRE_FRAGMENT_CONTENT_SUFFIX ";ocre-fragment"
+#define OCRE_FRAGMENT_DATA_LEN (OCRE_MAX_PAYLOAD_LEN - sizeof(ocre_fragment_header_t))
+
+    /**
+     * @brief Initialize OCRE Messaging System
+     */
+    void ocre_msg_system_init(void);
+
+    /**
+     * @brief Publish a message to the specified target
+     * @param topic The name of the topic on which to publish the message
+     * @param content_type The content type of the message; it is recommended to use a MIME type
+     * @param payload A buffer containing the message contents
+     * @param payload_len The length of the payload buffer
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_publish_message(const char *topic, const char *content_type, const void *payload, uint32_t payload_len);
+
+    /**
+     * @brief Subscribe to messages on the specified topic
+     * @param topic The name of the topic on which to subscribe
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_subscribe_message(const char *topic);
+
+    /**
+     * @brief What the broker does when a subscriber's queue is full
+     */
+    typedef enum
+    {
+        OCRE_OVERFLOW_DROP_NEWEST, /**< Discard the message being published (default) */
+        OCRE_OVERFLOW_DROP_OLDEST, /**< Discard the oldest queued message to make room */
+        OCRE_OVERFLOW_BLOCK        /**< Block the publisher until there is room or the timeout expires */
+    } ocre_overflow_policy_t;
+
+    /**
+     * @brief Set the overflow policy of this module's subscription
+     *
+     * Dropped messages are counted in ocre_host_event_stats_t.queue_drops.
+     *
+     * @param topic Topic filter passed to ocre_subscribe_message()
+     * @param policy Overflow policy
+     * @param timeout_ms Longest a publisher blocks with OCRE_OVERFLOW_BLOCK before the publish
+     *        fails with OCRE_ERROR_BUSY; ignored by the other policies
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_subscribe_set_overflow_policy(const char *topic, ocre_overflow_policy_t policy, int timeout_ms);
+
+    /**
+     * @brief Publish a message gathered from several buffers in one host call
+     * @param topic The name of the topic on which to publish the message
+     * @param content_type The content type of the message
+     * @param iov Array of buffers forming the payload, in order
+     * @param iovcnt Number of entries in @p iov
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_publish_message_iov(const char *topic, const char *content_type, const ocre_iovec_t *iov, uint32_t iovcnt);
+
+    /**
+     * @brief Publish a batch of messages in one host call
+     *
+     * The broker delivers the batch in order and fans it out to subscribers under a
+     * single lock acquisition. The mid field of each message is ignored.
+     *
+     * @param msgs Messages to publish; topic, content_type and payload are read from module memory
+     * @param count Number of entries in @p msgs
+     * @return Number of messages published, which is less than @p count if the broker stopped
+     *         at a failing message, or negative error code if the batch was rejected
+     */
+    int ocre_publish_messages(const ocre_msg_t *msgs, uint32_t count);
+
+    /**
+     * @brief Register a topic and content type pair with the host broker
+     * @param topic Topic name
+     * @param content_type Content type of messages on the topic
+     * @return Topic handle (> 0) on success, negative error code on failure
+     */
+    int ocre_topic_register(const char *topic, const char *content_type);
+
+    /**
+     * @brief Release a topic handle with the host broker
+     * @param handle Handle returned by ocre_topic_register()
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_topic_unregister(int handle);
+
+    /**
+     * @brief Open a handle for a topic and content type
+     *
+     * The strings are passed to the host once. Messages published with
+     * ocre_publish_by_handle() skip the per-message string copy and match, and messages
+     * received on the same topic and content type arrive tagged with the handle, so the
+     * host no longer allocates their topic and content type in this module's heap.
+     * Callbacks of such messages see the SDK's copies of the strings, which stay valid
+     * until ocre_topic_close(), and for a message being dispatched or retained until its
+     * callbacks return or it is released, even if a callback closes the handle. Opening
+     * the same pair again returns the same handle.
+     *
+     * @param topic Topic name, without wildcards
+     * @param content_type Content type of messages on the topic
+     * @return Topic handle (> 0) on success, negative error code on failure
+     */
+    int ocre_topic_open(const char *topic, const char *content_type);
+
+    /**
+     * @brief Close a topic handle
+     * @param handle Handle returned by ocre_topic_open()
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NOT_FOUND if the handle is not open
+     */
+    int ocre_topic_close(int handle);
+
+    /**
+     * @brief Publish a message on a topic handle
+     * @param handle Handle returned by ocre_topic_open()
+     * @param payload A buffer containing the message contents
+     * @param payload_len The length of the payload buffer
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_publish_by_handle(int handle, const void *payload, uint32_t payload_len);
+
+    /**
+     * @brief Get the publish credits of a topic handle
+     *
+     * One credit is room for one message in every subscriber queue the topic reaches,
+     * so this many messages can be published without any being dropped or blocking.
+     *
+     * @param handle Handle returned by ocre_topic_open()
+     * @return Available credits, or negative error code on failure
+     */
+    int ocre_publish_credits(int handle);
+
+    /**
+     * @brief Ask the host for a flow event when a topic handle's credits reach a threshold
+     * @param handle Handle returned by ocre_topic_open()
+     * @param threshold Credits at which to queue the event, 0 to cancel
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_publish_notify_credits(int handle, uint32_t threshold);
+
+    /**
+     * @brief Writable callback function type
+     * @param handle Topic handle that has room again
+     * @param credits Credits available when the event was queued
+     * @param user_data Pointer given at registration
+     */
+    typedef void (*ocre_writable_callback_t)(int handle, uint32_t credits, void *user_data);
+
+    /**
+     * @brief Call back when a topic handle is writable again
+     *
+     * The callback runs each time the handle's credits rise from below @p threshold to at
+     * least @p threshold, so a producer can publish until ocre_publish_credits() reaches
+     * zero, pause, and resume from the callback instead of spinning on retries. Replaces
+     * any writable callback of the handle; cleared by ocre_topic_close().
+     *
+     * @param handle Handle returned by ocre_topic_open()
+     * @param threshold Credits at which the handle counts as writable, at least 1
+     * @param callback Callback function to register, NULL to unregister
+     * @param user_data Pointer passed back to @p callback
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NOT_FOUND if the handle is not open,
+     *         negative error code on failure
+     */
+    int ocre_register_writable_callback(int handle, uint32_t threshold, ocre_writable_callback_t callback, void *user_data);
+
+    /**
+     * @brief Publish a payload of any size as a stream of fragments
+     *
+     * The payload is split into fragments of at most OCRE_MAX_PAYLOAD_LEN bytes, each
+     * published with ocre_publish_message_iov() straight from the caller's buffers.
+     * Subscribers receive them through ocre_register_message_chunk_callback() or
+     * ocre_register_message_reassembly(). Only one stream per topic should be in flight.
+     *
+     * @param topic The name of the topic on which to publish the message
+     * @param content_type The content type of the whole message
+     * @param iov Array of buffers forming the payload, in order
+     * @param iovcnt Number of entries in @p iov
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_publish_message_stream(const char *topic, const char *content_type, const ocre_iovec_t *iov, uint32_t iovcnt);
+
+    /**
+     * @brief Receive fragmented messages incrementally
+     * @param topic The topic to receive streams on
+     * @param callback Called once per fragment, in publish order
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_register_message_chunk_callback(const char *topic, message_chunk_callback_func_t callback);
+
+    /**
+     * @brief Receive fragmented messages reassembled into a caller-provided buffer
+     *
+     * Streams larger than @p buf_size, or with missing fragments, are dropped.
+     *
+     * @param topic The topic to receive streams on
+     * @param buf Buffer that receives the whole payload; must stay valid while registered
+     * @param buf_size Size of @p buf in bytes
+     * @param callback Called with @p buf once the whole payload has arrived
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_register_message_reassembly(const char *topic, void *buf, uint32_t buf_size, message_callback_func_t callback);
+
+    /**
+     * @brief Unregister a chunk or reassembly callback
+     * @param topic The topic the stream was registered on
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_unregister_message_stream(const char *topic);
+
+    /**
+     * @brief Frees allocated memory for a messaging event in the WASM module.
+     *
+     * This function releases the allocated memory for the topic, content-type, and payload
+     * associated with a messaging event received by the WASM module. It should be called
+     * after processing the message in ocre_process_events() to prevent memory leaks.
+     *
+     * @param topic_offset    Offset in WASM memory for the message topic.
+     * @param content_offset  Offset in WASM memory for the message content-type.
+     * @param payload_offset  Offset in WASM memory for the message payload.
+     *
+     * @return OCRE_SUCCESS on success, negative error code on failure.
+     */
+    int ocre_messaging_free_module_event_data(uint32_t topic_offset, uint32_t content_offset, uint32_t payload_offset);
+
+    /**
+     * @brief Keep the message currently being dispatched beyond its callback
+     *
+     * Must be called from within a message callback. The buffers are then not freed
+     * when the callback returns and remain valid until ocre_message_release(). A message
+     * has a single owner: once one callback retained it, further calls for the same
+     * message fail, and a callback that needs the data as well has to copy it.
+     *
+     * @param msg Receives the topic, content type and payload of the current message
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if no message is being dispatched,
+     *         OCRE_ERROR_BUSY if the message is already retained
+     */
+    int ocre_message_retain(ocre_msg_t *msg);
+
+    /**
+     * @brief Release a message kept with ocre_message_retain()
+     * @param msg Message to release; cleared on return
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if @p msg is not a retained message
+     */
+    int ocre_message_release(ocre_msg_t *msg);
+
+    /**
+     * @brief Header of a message receive slot, followed by the message the host wrote
+     */
+    typedef struct
+    {
+        uint32_t released; /**< Used by the SDK to recycle slots in order, not written by the host */
+        uint32_t reserved; /**< Keeps the message 8-byte aligned */
+    } ocre_msg_slot_t;
+
+/**
+ * @brief Bytes taken by one receive slot for messages of up to @p message_size bytes
+ *
+ * @p message_size covers the NUL-terminated topic and content type, when the host
+ * writes them, and the payload.
+ */
+#define OCRE_MSG_SLOT_SIZE(message_size) (sizeof(ocre_msg_slot_t) + (((uint32_t)(message_size) + 7U) & ~7U))
+
+    /**
+     * @brief Slot indices shared between the host and the SDK
+     */
+    typedef struct
+    {
+        uint32_t head; /**< Slots written, advanced by the host */
+        uint32_t tail; /**< Slots recycled, advanced by the SDK */
+    } ocre_msg_ring_t;
+
+    /**
+     * @brief Message receive pool state
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct ocre_msg_pool
+    {
+        int handle;           /**< Host pool handle */
+        ocre_msg_ring_t ring; /**< Indices shared with the host */
+        uint8_t *slots;       /**< Slot storage given to ocre_subscribe_message_pool() */
+        uint32_t slot_size;   /**< Bytes per slot */
+        uint32_t slot_count;  /**< Slots in the storage */
+    } ocre_msg_pool_t;
+
+    /**
+     * @brief Register a ring of receive slots for the messages of a subscription
+     *
+     * The host writes each message that fits into the slot at @c head, unless all slots
+     * are in use, and queues its event with the topic, content type and payload pointing
+     * into the slot. Messages that do not fit are allocated in the module heap as before.
+     *
+     * @param topic Topic filter passed to ocre_subscribe_message()
+     * @param ring Indices the host advances and reads
+     * @param slots Slot storage, @p slot_count slots of @p slot_size bytes
+     * @param slot_size Bytes per slot, from OCRE_MSG_SLOT_SIZE()
+     * @param slot_count Slots in @p slots
+     * @return Pool handle (> 0) on success, negative error code on failure
+     */
+    int ocre_messaging_rx_pool_open(const char *topic, ocre_msg_ring_t *ring, void *slots, uint32_t slot_size,
+                                    uint32_t slot_count);
+
+    /**
+     * @brief Stop delivering into a receive pool
+     *
+     * The host no longer writes into the slots and discards queued events of the pool.
+     *
+     * @param handle Handle returned by ocre_messaging_rx_pool_open()
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_messaging_rx_pool_close(int handle);
+
+    /**
+     * @brief Subscribe to a topic with messages delivered into caller-provided slots
+     *
+     * Like ocre_subscribe_message(), but the host writes the messages straight into a
+     * ring of fixed-size slots in @p buffer, which the SDK recycles once the callbacks
+     * return or the message is released. Pooled messages cost no module heap allocation
+     * and no ocre_messaging_free_module_event_data() call. A retained message keeps its
+     * slot, and later slots are only reused once it is released. The buffer must stay
+     * valid and untouched until ocre_release_message_pool().
+     *
+     * @param pool Pool to initialize
+     * @param topic The name of the topic on which to subscribe
+     * @param buffer 8-byte aligned slot storage
+     * @param buffer_size Size of @p buffer, at least two slots
+     * @param message_size Largest message to receive into a slot, see OCRE_MSG_SLOT_SIZE()
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_subscribe_message_pool(ocre_msg_pool_t *pool, const char *topic, void *buffer, uint32_t buffer_size,
+                                    uint32_t message_size);
+
+    /**
+     * @brief Stop delivering into a receive pool, after which its buffer may be reused
+     *
+     * The topic subscription stays: later messages are allocated in the module heap as
+     * without a pool. Messages of the pool that are queued and not yet dispatched are
+     * dropped. Retained messages of the pool must be released before.
+     *
+     * @param pool Pool to release
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NOT_FOUND if the pool is not registered,
+     *         negative error code on failure
+     */
+    int ocre_release_message_pool(ocre_msg_pool_t *pool);
+
+    // =============================================================================
+    // Channel API
+    // =============================================================================
+
+#define OCRE_CHANNEL_CACHE_LINE 64 /**< Head and tail are kept on separate cache lines */
+
+    /**
+     * @brief Channel role of the opening container
+     */
+    typedef enum
+    {
+        OCRE_CHANNEL_PRODUCER, /**< Writes records and rings the doorbell */
+        OCRE_CHANNEL_CONSUMER  /**< Reads records, woken by doorbell events */
+    } ocre_channel_role_t;
+
+    /**
+     * @brief Ring control block at the start of a channel's shared region
+     */
+    typedef struct
+    {
+        uint32_t head;                                      /**< Bytes written, advanced by the producer */
+        uint8_t head_pad[OCRE_CHANNEL_CACHE_LINE - sizeof(uint32_t)];
+        uint32_t tail;                                      /**< Bytes consumed, advanced by the consumer */
+        uint8_t tail_pad[OCRE_CHANNEL_CACHE_LINE - sizeof(uint32_t)];
+        uint8_t data[];                                     /**< Record storage */
+    } ocre_channel_ring_t;
+
+    struct ocre_channel;
+
+    /**
+     * @brief Channel doorbell callback function type
+     *
+     * Called in the consumer when the producer commits to an empty ring. Read until
+     * ocre_channel_peek() returns NULL, later records do not ring again until then.
+     *
+     * @param channel The channel with records to read
+     * @param user_data Pointer given to ocre_channel_open()
+     */
+    typedef void (*ocre_channel_callback_t)(struct ocre_channel *channel, void *user_data);
+
+    /**
+     * @brief Single-producer, single-consumer channel over memory shared by two containers
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct ocre_channel
+    {
+        int handle;                       /**< Host channel handle */
+        ocre_channel_role_t role;         /**< Role of this end */
+        ocre_channel_ring_t *ring;        /**< Shared region, mapped into this module */
+        uint32_t capacity;                /**< Bytes of record storage, a power of two */
+        uint32_t reserved;                /**< Bytes reserved by the producer and not committed */
+        ocre_channel_callback_t callback; /**< Doorbell callback of the consumer */
+        void *user_data;                  /**< Passed back to the callback */
+    } ocre_channel_t;
+
+    /**
+     * @brief Map a named shared region into this module
+     *
+     * The host creates the region zero-filled on first use and maps the same memory into
+     * every container that maps the name.
+     *
+     * @param name Channel name shared by both containers
+     * @param size Region size in bytes
+     * @param addr Receives the region's address in this module
+     * @return Channel handle (> 0) on success, negative error code on failure
+     */
+    int ocre_channel_map(const char *name, uint32_t size, uint32_t *addr);
+
+    /**
+     * @brief Unmap a shared region
+     * @param handle Handle returned by ocre_channel_map()
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_channel_unmap(int handle);
+
+    /**
+     * @brief Queue a doorbell event for the other end of a channel
+     * @param handle Handle returned by ocre_channel_map()
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_channel_notify(int handle);
+
+    /**
+     * @brief Open one end of a shared-memory channel
+     *
+     * Payloads are written in place in memory mapped into both containers, so they are
+     * never copied by the host or allocated in the consumer's heap. Each channel has one
+     * producer and one consumer; use one channel per pair for fan-out. Across cores the
+     * module must be built with wasm atomics (-matomics) for the ring indices to be
+     * ordered.
+     *
+     * @param channel Channel to initialize
+     * @param name Channel name shared by both containers
+     * @param capacity Bytes of record storage, a power of two; both ends must agree
+     * @param role Role of this end
+     * @param callback Doorbell callback, required for the consumer, ignored for the producer
+     * @param user_data Pointer passed back to @p callback
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_channel_open(ocre_channel_t *channel, const char *name, uint32_t capacity, ocre_channel_role_t role,
+                          ocre_channel_callback_t callback, void *user_data);
+
+    /**
+     * @brief Close one end of a channel
+     * @param channel Channel to close
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_channel_close(ocre_channel_t *channel);
+
+    /**
+     * @brief Reserve room for a record to be written in place
+     *
+     * The record becomes visible to the consumer with ocre_channel_commit().
+     *
+     * @param channel Producer end
+     * @param len Record length in bytes
+     * @return Pointer to @p len writable bytes in the shared ring, or NULL if the ring is full
+     */
+    void *ocre_channel_reserve(ocre_channel_t *channel, uint32_t len);
+
+    /**
+     * @brief Publish the reserved record and ring the doorbell if the ring was empty
+     * @param channel Producer end
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if nothing was reserved
+     */
+    int ocre_channel_commit(ocre_channel_t *channel);
+
+    /**
+     * @brief Copy a record into the channel
+     * @param channel Producer end
+     * @param data Record contents
+     * @param len Record length in bytes
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_BUSY if the ring is full
+     */
+    int ocre_channel_write(ocre_channel_t *channel, const void *data, uint32_t len);
+
+    /**
+     * @brief Get the oldest unread record in place
+     * @param channel Consumer end
+     * @param len Receives the record length
+     * @return Pointer to the record in the shared ring, valid until ocre_channel_consume(), or NULL if empty
+     */
+    const void *ocre_channel_peek(ocre_channel_t *channel, uint32_t *len);
+
+    /**
+     * @brief Release the record returned by ocre_channel_peek()
+     * @param channel Consumer end
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NOT_FOUND if the ring is empty
+     */
+    int ocre_channel_consume(ocre_channel_t *channel);
+
+    // =============================================================================
+    // File Watch API
+    // =============================================================================
+
+    /**
+     * @brief Changes reported for a watched file, combined as a bit mask
+     */
+    typedef enum
+    {
+        OCRE_FILE_CHANGE_MODIFIED = 0x1,  /**< Data was written or appended */
+        OCRE_FILE_CHANGE_TRUNCATED = 0x2, /**< The file got shorter, such as on log rotation */
+        OCRE_FILE_CHANGE_CREATED = 0x4,   /**< The file now exists, or was replaced by a new one */
+        OCRE_FILE_CHANGE_DELETED = 0x8,   /**< The file was removed or renamed away */
+        OCRE_FILE_CHANGE_ALL = 0xF        /**< Every change */
+    } ocre_file_change_t;
+
+    struct ocre_file_watch;
+
+    /**
+     * @brief File watch callback function type
+     * @param watch The watch that fired
+     * @param changes OCRE_FILE_CHANGE_* bits for every change since the previous callback
+     * @param user_data Pointer given to ocre_file_watch_start()
+     */
+    typedef void (*ocre_file_watch_callback_t)(struct ocre_file_watch *watch, uint32_t changes, void *user_data);
+
+    /**
+     * @brief File watch state
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct ocre_file_watch
+    {
+        int handle;                          /**< Host watch handle */
+        ocre_file_watch_callback_t callback; /**< Called when the file changes */
+        void *user_data;                     /**< Passed back to the callback */
+    } ocre_file_watch_t;
+
+    /**
+     * @brief Ask the host to report changes to a file
+     *
+     * The host queues an OCRE_RESOURCE_TYPE_FILE_WATCH event with the watch handle as id
+     * and the changes in extra. Changes made while an event is still queued are OR-ed into
+     * it, so a burst of writes costs one event.
+     *
+     * @param path Path in the container's filesystem; the file does not need to exist yet
+     * @param changes OCRE_FILE_CHANGE_* bits to report
+     * @param min_interval_ms Shortest time between two events, 0 for no limit
+     * @return Watch handle (> 0) on success, negative error code on failure
+     */
+    int ocre_file_watch_open(const char *path, uint32_t changes, uint32_t min_interval_ms);
+
+    /**
+     * @brief Stop reporting changes to a file
+     * @param handle Handle returned by ocre_file_watch_open()
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_file_watch_close(int handle);
+
+    /**
+     * @brief Watch a file for changes
+     *
+     * Replaces polling a file on a timer: the callback runs from ocre_process_events() only
+     * after the file changed, so tailing a log costs nothing while it is idle and can read
+     * everything that was appended in one go.
+     *
+     * @param watch Watch to initialize
+     * @param path Path in the container's filesystem
+     * @param changes OCRE_FILE_CHANGE_* bits to report
+     * @param min_interval_ms Shortest time between two callbacks, 0 for no limit
+     * @param callback Called with the changes since the previous callback
+     * @param user_data Pointer passed back to @p callback
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_file_watch_start(ocre_file_watch_t *watch, const char *path, uint32_t changes,
+                              uint32_t min_interval_ms, ocre_file_watch_callback_t callback, void *user_data);
+
+    /**
+     * @brief Stop a file watch
+     * @param watch Watch to stop
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_file_watch_stop(ocre_file_watch_t *watch);
+
+    // =============================================================================
+    // Utility API
+    // =============================================================================
+
+    /**
+     * @brief Sleep for specified duration
+     * @param milliseconds Sleep duration in milliseconds
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_sleep(int milliseconds);
+
+    /**
+     * @brief Sleep for specified duration in microseconds
+     * @param microseconds Sleep duration in microseconds
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_sleep_us(uint32_t microseconds);
+
+    /**
+     * @brief Read the host monotonic clock
+     *
+     * Backed by the host's cycle counter, so the resolution is that of the target's
+     * hardware clock. The origin is unspecified; use differences between two readings.
+     *
+     * @return Monotonic time in nanoseconds
+     */
+    uint64_t ocre_time_ns(void);
+
+    /**
+     * @brief Read the host monotonic clock in microseconds
+     * @return Monotonic time in microseconds, see ocre_time_ns()
+     */
+    uint64_t ocre_time_us(void);
+
+/**
+ * @brief Pause execution indefinitely (implementation-specific)
  * @return OCRE_SUCCESS on success, negative error code on failure
  */
 #define ocre_pause() ocre_sleep(9999999)
@@ -521,6 +1828,228 @@ extern "C"
      */
     double ocre_sensors_read_by_name(const char *sensor_name, int channel_type);
 
+    /**
+     * @brief Read several channels of a sensor from one sample in a single host call
+     *
+     * The host fetches one sample from the driver and returns every requested channel
+     * from it, so the values are consistent with each other.
+     *
+     * @param sensor_id ID of the sensor, as for ocre_sensors_read()
+     * @param channels Channel types to read
+     * @param out Receives the value of each channel, in the order of @p channels
+     * @param n Number of entries in @p channels and @p out
+     * @return Number of values written to @p out, negative error code on failure
+     */
+    int ocre_sensors_read_channels(int sensor_id, const int *channels, double *out, int n);
+
+    /**
+     * @brief Representation of a sensor sample value
+     */
+    typedef enum
+    {
+        OCRE_SENSOR_VALUE_FIXED, /**< Integer and millionths parts, as a Zephyr struct sensor_value */
+        OCRE_SENSOR_VALUE_FLOAT  /**< 32-bit float */
+    } ocre_sensor_value_type_t;
+
+    /**
+     * @brief Sensor reading in the driver's native representation
+     */
+    typedef struct
+    {
+        uint64_t timestamp_us; /**< Host monotonic time the sample was taken, as ocre_time_us() */
+        uint16_t type;         /**< Value representation (ocre_sensor_value_type_t) */
+        uint16_t channel;      /**< Channel type the value belongs to */
+        union
+        {
+            struct
+            {
+                int32_t val1; /**< Integer part */
+                int32_t val2; /**< Fractional part in millionths, same sign as val1 */
+            } fixed;
+            float f; /**< Value when type is OCRE_SENSOR_VALUE_FLOAT */
+        } value;
+    } ocre_sensor_sample_t;
+
+    /**
+     * @brief Read a sensor channel without converting its value
+     * @param sensor_id ID of the sensor, as for ocre_sensors_read()
+     * @param channel_type Type of the channel to read
+     * @param sample Receives the value and the time it was taken
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_sensors_read_sample(int sensor_id, int channel_type, ocre_sensor_sample_t *sample);
+
+    /**
+     * @brief Read several channels of a sensor from one sample without converting their values
+     *
+     * All values come from one driver fetch and share its timestamp.
+     *
+     * @param sensor_id ID of the sensor, as for ocre_sensors_read()
+     * @param channels Channel types to read
+     * @param out Receives the sample of each channel, in the order of @p channels
+     * @param n Number of entries in @p channels and @p out
+     * @return Number of samples written to @p out, negative error code on failure
+     */
+    int ocre_sensors_read_samples(int sensor_id, const int *channels, ocre_sensor_sample_t *out, int n);
+
+    /**
+     * @brief Convert a sample value to float
+     * @param sample Sample to convert
+     * @return Value of the sample
+     */
+    float ocre_sensor_sample_to_float(const ocre_sensor_sample_t *sample);
+
+    /**
+     * @brief Convert a sample value to double
+     * @param sample Sample to convert
+     * @return Value of the sample
+     */
+    double ocre_sensor_sample_to_double(const ocre_sensor_sample_t *sample);
+
+    /**
+     * @brief Convert a sample value to an integer in thousandths
+     * @param sample Sample to convert
+     * @return Value of the sample multiplied by 1000, truncated
+     */
+    int64_t ocre_sensor_sample_to_milli(const ocre_sensor_sample_t *sample);
+
+    /**
+     * @brief Resolve a sensor name once for use with the ID-based calls
+     *
+     * The result of ocre_sensors_get_handle_by_name() is cached in the SDK, so only the
+     * first call for a name crosses into the host.
+     *
+     * @param sensor_name Name of the sensor
+     * @return Sensor ID on success, negative error code on failure
+     */
+    int ocre_sensors_resolve(const char *sensor_name);
+
+    /**
+     * @brief Forget all names cached by ocre_gpio_resolve() and ocre_sensors_resolve()
+     */
+    void ocre_resolve_cache_clear(void);
+
+    // =============================================================================
+    // Sensor Streaming API
+    // =============================================================================
+
+    /**
+     * @brief Block of samples written by the host into a stream buffer
+     *
+     * Values are sample-major: value @c c of sample @c s is
+     * <tt>values[s * channel_count + c]</tt>, in the order of the stream's channels.
+     */
+    typedef struct
+    {
+        uint64_t timestamp_us; /**< Host monotonic time of the first sample, as ocre_time_us() */
+        uint32_t period_us;    /**< Time between consecutive samples in the block */
+        uint32_t sample_count; /**< Samples in the block, at most the stream's batch */
+        uint32_t dropped;      /**< Samples lost to a full buffer since the previous block */
+        uint32_t reserved;     /**< Keeps the values 8-byte aligned */
+        double values[];       /**< sample_count * channel_count values */
+    } ocre_sensor_block_t;
+
+/**
+ * @brief Bytes taken by one block of a stream in its buffer
+ * @param channel_count Channels per sample
+ * @param batch Samples per block
+ */
+#define OCRE_SENSOR_BLOCK_SIZE(channel_count, batch) \
+    (sizeof(ocre_sensor_block_t) + (uint32_t)(channel_count) * (uint32_t)(batch) * sizeof(double))
+
+    /**
+     * @brief Block indices shared between the host and the SDK
+     */
+    typedef struct
+    {
+        uint32_t head; /**< Blocks written, advanced by the host */
+        uint32_t tail; /**< Blocks consumed, advanced by the SDK */
+    } ocre_sensor_ring_t;
+
+    struct ocre_sensor_stream;
+
+    /**
+     * @brief Sensor stream callback function type
+     * @param stream The stream the block belongs to
+     * @param block Samples in place in the stream buffer, valid until the callback returns
+     * @param user_data Pointer given to ocre_sensors_stream_start()
+     */
+    typedef void (*ocre_sensor_stream_callback_t)(struct ocre_sensor_stream *stream, const ocre_sensor_block_t *block,
+                                                  void *user_data);
+
+    /**
+     * @brief Sensor stream state
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct ocre_sensor_stream
+    {
+        int handle;                             /**< Host stream handle */
+        ocre_sensor_ring_t ring;                /**< Indices shared with the host */
+        uint8_t *blocks;                        /**< Block storage given to ocre_sensors_stream_start() */
+        uint32_t block_size;                    /**< Bytes per block */
+        uint32_t block_count;                   /**< Blocks in the buffer */
+        uint32_t channel_count;                 /**< Channels per sample */
+        ocre_sensor_stream_callback_t callback; /**< Called for each block */
+        void *user_data;                        /**< Passed back to the callback */
+    } ocre_sensor_stream_t;
+
+    /**
+     * @brief Ask the host to sample a sensor into a block buffer
+     *
+     * Queues an OCRE_RESOURCE_TYPE_SENSOR event with the stream handle as id when it writes
+     * a block into an empty buffer.
+     *
+     * @param sensor_id ID of the sensor, as for ocre_sensors_read()
+     * @param channels Channel types to sample
+     * @param channel_count Number of entries in @p channels
+     * @param rate_hz Sampling rate, 0 to sample on the sensor's data-ready trigger
+     * @param batch Samples per block
+     * @param ring Indices the host advances and reads
+     * @param blocks Block storage, @p block_count blocks of OCRE_SENSOR_BLOCK_SIZE() bytes
+     * @param block_count Blocks in @p blocks
+     * @return Stream handle (> 0) on success, negative error code on failure
+     */
+    int ocre_sensors_stream_open(int sensor_id, const int *channels, int channel_count, uint32_t rate_hz,
+                                 uint32_t batch, ocre_sensor_ring_t *ring, void *blocks, uint32_t block_count);
+
+    /**
+     * @brief Stop host sampling for a stream
+     * @param handle Handle returned by ocre_sensors_stream_open()
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_sensors_stream_close(int handle);
+
+    /**
+     * @brief Start streaming samples of a sensor to a callback
+     *
+     * The host samples at @p rate_hz into @p buffer and wakes the module once per batch,
+     * so the container does not poll. Blocks are delivered from ocre_process_events().
+     * The buffer must stay valid and untouched until ocre_sensors_stream_stop().
+     *
+     * @param stream Stream to initialize
+     * @param sensor_id ID of the sensor, as for ocre_sensors_read()
+     * @param channels Channel types to sample
+     * @param channel_count Number of entries in @p channels
+     * @param rate_hz Sampling rate, 0 to sample on the sensor's data-ready trigger
+     * @param batch Samples per block
+     * @param buffer 8-byte aligned block storage
+     * @param buffer_size Size of @p buffer, at least two blocks of OCRE_SENSOR_BLOCK_SIZE()
+     * @param callback Called for each block
+     * @param user_data Pointer passed back to @p callback
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_sensors_stream_start(ocre_sensor_stream_t *stream, int sensor_id, const int *channels,
+                                  int channel_count, uint32_t rate_hz, uint32_t batch, void *buffer,
+                                  uint32_t buffer_size, ocre_sensor_stream_callback_t callback, void *user_data);
+
+    /**
+     * @brief Stop a stream; blocks still in the buffer are discarded
+     * @param stream Stream to stop
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_sensors_stream_stop(ocre_sensor_stream_t *stream);
+
     /**
      * @brief Register a dispatcher for a resource type
      * @param type Resource type to register the dispatcher for
@@ -529,6 +2058,18 @@ extern "C"
      */
     int ocre_register_dispatcher(ocre_resource_type_t type, const char *function_name);
 
+    /**
+     * @brief Register the SDK's dispatcher for a resource type, once
+     *
+     * The first call for a type registers its export with ocre_register_dispatcher(),
+     * later calls return without a host call, so registering and unregistering
+     * callbacks stays within the module.
+     *
+     * @param type Resource type events will be dispatched for
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_dispatcher_ensure(ocre_resource_type_t type);
+
     // =============================================================================
     // POSIX API
     // =============================================================================
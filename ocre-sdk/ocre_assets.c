@@ -0,0 +1,123 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#include "ocre_assets.h"
+#include <string.h>
+
+static const char index_name[] = "index.html";
+
+// Compare `path` with `suffix` appended against an entry path, in strcmp() order
+static int path_compare(const char *path, size_t len, const char *suffix, const char *entry)
+{
+    size_t entry_len = strlen(entry);
+    size_t n = len < entry_len ? len : entry_len;
+    int cmp = memcmp(path, entry, n);
+    if (cmp != 0 || n < len)
+    {
+        return cmp != 0 ? cmp : 1;
+    }
+    // `path` is a prefix of the entry, the suffix decides
+    return strcmp(suffix, entry + len);
+}
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+const ocre_asset_t *ocre_asset_find(const ocre_asset_bundle_t *bundle, const char *path, size_t len)
+{
+    if (bundle == NULL || path == NULL || len == 0)
+    {
+        return NULL;
+    }
+    const char *suffix = path[len - 1] == '/' ? index_name : "";
+    uint32_t lo = 0;
+    uint32_t hi = bundle->count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = path_compare(path, len, suffix, bundle->entries[mid].path);
+        if (cmp == 0)
+        {
+            return &bundle->entries[mid];
+        }
+        if (cmp < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+int ocre_asset_select(const ocre_asset_bundle_t *bundle, const ocre_asset_t *asset, bool accept_gzip,
+                      ocre_asset_body_t *body)
+{
+    if (bundle == NULL || asset == NULL || body == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if ((asset->flags & OCRE_ASSET_GZIP) && accept_gzip)
+    {
+        body->data = bundle->data + asset->gzip_offset;
+        body->size = asset->gzip_size;
+        body->encoding = "gzip";
+        body->etag = asset->gzip_etag;
+        return OCRE_SUCCESS;
+    }
+    if (!(asset->flags & OCRE_ASSET_PLAIN))
+    {
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    body->data = bundle->data + asset->offset;
+    body->size = asset->size;
+    body->encoding = NULL;
+    body->etag = asset->etag;
+    return OCRE_SUCCESS;
+}
+
+bool ocre_asset_etag_match(const char *etag, const char *header, size_t len)
+{
+    if (etag == NULL || header == NULL)
+    {
+        return false;
+    }
+    size_t etag_len = strlen(etag);
+    size_t i = 0;
+    while (i < len)
+    {
+        while (i < len && (is_space(header[i]) || header[i] == ','))
+        {
+            i++;
+        }
+        size_t start = i;
+        while (i < len && header[i] != ',')
+        {
+            i++;
+        }
+        size_t end = i;
+        while (end > start && is_space(header[end - 1]))
+        {
+            end--;
+        }
+        // If-None-Match uses the weak comparison, so "W/" makes no difference
+        if (end - start >= 2 && header[start] == 'W' && header[start + 1] == '/')
+        {
+            start += 2;
+        }
+        if ((end - start == 1 && header[start] == '*') ||
+            (end - start == etag_len && memcmp(header + start, etag, etag_len) == 0))
+        {
+            return true;
+        }
+    }
+    return false;
+}
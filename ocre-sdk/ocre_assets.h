@@ -0,0 +1,109 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#ifndef OCRE_ASSETS_H
+#define OCRE_ASSETS_H
+
+#include "ocre_api.h"
+
+/**
+ * @file ocre_assets.h
+ * @brief Read-only file bundles packed into the module at build time.
+ *
+ * ocre_add_assets() in ocre.cmake packs a directory into one constant array with a
+ * sorted index, compiled into the module's data segment. Looking up a file is a binary
+ * search, and its content is served straight from linear memory: no path lookup, open
+ * or read through WASI per request, and no copy. Each file carries precomputed ETags
+ * and, where it pays off, a gzipped variant.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define OCRE_ASSET_PLAIN 0x1 /**< The content is stored as is */
+#define OCRE_ASSET_GZIP 0x2  /**< A gzipped copy of the content is stored */
+
+    /**
+     * @brief Index entry of a packed file
+     */
+    typedef struct
+    {
+        const char *path;      /**< Path below the packed directory with a leading '/', such as "/index.html" */
+        const char *mime;      /**< Content-Type derived from the file extension */
+        const char *etag;      /**< Quoted ETag of the plain content */
+        const char *gzip_etag; /**< Quoted ETag of the gzipped copy */
+        uint32_t offset;       /**< Plain content in the bundle data */
+        uint32_t size;         /**< Length of the plain content */
+        uint32_t gzip_offset;  /**< Gzipped copy in the bundle data */
+        uint32_t gzip_size;    /**< Length of the gzipped copy */
+        uint32_t flags;        /**< OCRE_ASSET_* variants stored */
+    } ocre_asset_t;
+
+    /**
+     * @brief Packed directory, defined by the source ocre_add_assets() generates
+     */
+    typedef struct
+    {
+        const unsigned char *data;    /**< Contents of every file, back to back */
+        const ocre_asset_t *entries;  /**< Index, sorted by path */
+        uint32_t count;               /**< Number of entries */
+    } ocre_asset_bundle_t;
+
+    /**
+     * @brief Variant of a file chosen for a response
+     */
+    typedef struct
+    {
+        const unsigned char *data; /**< Bytes to send, inside the bundle */
+        uint32_t size;             /**< Length of data */
+        const char *encoding;      /**< "gzip" for Content-Encoding, NULL for the plain content */
+        const char *etag;          /**< Quoted ETag of this variant */
+    } ocre_asset_body_t;
+
+    /**
+     * @brief Look up a packed file
+     *
+     * A path ending in '/' finds the "index.html" of that directory.
+     *
+     * @param bundle Packed directory
+     * @param path Path with a leading '/', need not be NUL-terminated
+     * @param len Length of @p path
+     * @return The entry, or NULL if the bundle has no such file
+     */
+    const ocre_asset_t *ocre_asset_find(const ocre_asset_bundle_t *bundle, const char *path, size_t len);
+
+    /**
+     * @brief Pick the variant to send
+     *
+     * Prefers the gzipped copy when the client accepts it.
+     *
+     * @param bundle Bundle of @p asset
+     * @param asset Entry returned by ocre_asset_find()
+     * @param accept_gzip Whether the client accepts gzip content encoding
+     * @param body Receives the chosen variant
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NOT_FOUND if only a gzipped copy is stored
+     *         and the client does not accept it, OCRE_ERROR_INVALID on invalid parameters
+     */
+    int ocre_asset_select(const ocre_asset_bundle_t *bundle, const ocre_asset_t *asset, bool accept_gzip,
+                          ocre_asset_body_t *body);
+
+    /**
+     * @brief Check an If-None-Match header against an ETag
+     * @param etag Quoted ETag of the variant that would be sent
+     * @param header Header value: "*" or a comma-separated list of ETags, weak ones included
+     * @param len Length of @p header
+     * @return true if the client's copy is current and a 304 can be sent
+     */
+    bool ocre_asset_etag_match(const char *etag, const char *header, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCRE_ASSETS_H */
@@ -0,0 +1,447 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#include "ocre_cbor.h"
+#include <string.h>
+
+// Major types, in the top three bits of the initial byte
+#define CBOR_MAJOR_UINT 0
+#define CBOR_MAJOR_NEGINT 1
+#define CBOR_MAJOR_BYTES 2
+#define CBOR_MAJOR_TEXT 3
+#define CBOR_MAJOR_ARRAY 4
+#define CBOR_MAJOR_MAP 5
+#define CBOR_MAJOR_SIMPLE 7
+
+// Additional information values
+#define CBOR_INFO_UINT8 24
+#define CBOR_INFO_UINT16 25
+#define CBOR_INFO_UINT32 26
+#define CBOR_INFO_UINT64 27
+
+#define CBOR_FALSE 0xF4
+#define CBOR_TRUE 0xF5
+#define CBOR_NULL 0xF6
+#define CBOR_HALF 0xF9
+#define CBOR_FLOAT 0xFA
+#define CBOR_DOUBLE 0xFB
+
+// =============================================================================
+// ENCODER
+// =============================================================================
+
+static int cbor_write(ocre_cbor_writer_t *writer, const void *data, uint32_t len)
+{
+    if (writer->size - writer->len < len)
+    {
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    memcpy(writer->buf + writer->len, data, len);
+    writer->len += len;
+    return OCRE_SUCCESS;
+}
+
+// Write the initial byte and a big-endian argument of the given width
+static int cbor_write_head(ocre_cbor_writer_t *writer, uint8_t initial, uint64_t value, uint32_t width)
+{
+    uint8_t head[9];
+    head[0] = initial;
+    for (uint32_t i = 0; i < width; i++)
+    {
+        head[width - i] = (uint8_t)(value >> (8 * i));
+    }
+    return cbor_write(writer, head, width + 1);
+}
+
+// Shortest encoding of an item head, as required for preferred serialization
+static int cbor_put_head(ocre_cbor_writer_t *writer, uint8_t major, uint64_t value)
+{
+    uint8_t initial = (uint8_t)(major << 5);
+    if (value < CBOR_INFO_UINT8)
+    {
+        return cbor_write_head(writer, initial | (uint8_t)value, 0, 0);
+    }
+    if (value <= UINT8_MAX)
+    {
+        return cbor_write_head(writer, initial | CBOR_INFO_UINT8, value, 1);
+    }
+    if (value <= UINT16_MAX)
+    {
+        return cbor_write_head(writer, initial | CBOR_INFO_UINT16, value, 2);
+    }
+    if (value <= UINT32_MAX)
+    {
+        return cbor_write_head(writer, initial | CBOR_INFO_UINT32, value, 4);
+    }
+    return cbor_write_head(writer, initial | CBOR_INFO_UINT64, value, 8);
+}
+
+void ocre_cbor_writer_init(ocre_cbor_writer_t *writer, uint8_t *buf, uint32_t size)
+{
+    writer->buf = buf;
+    writer->size = buf ? size : 0;
+    writer->len = 0;
+}
+
+int ocre_cbor_put_uint(ocre_cbor_writer_t *writer, uint64_t value)
+{
+    return cbor_put_head(writer, CBOR_MAJOR_UINT, value);
+}
+
+int ocre_cbor_put_int(ocre_cbor_writer_t *writer, int64_t value)
+{
+    if (value < 0)
+    {
+        // -1 - n without overflowing on INT64_MIN
+        return cbor_put_head(writer, CBOR_MAJOR_NEGINT, (uint64_t)(-(value + 1)));
+    }
+    return cbor_put_head(writer, CBOR_MAJOR_UINT, (uint64_t)value);
+}
+
+int ocre_cbor_put_float(ocre_cbor_writer_t *writer, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return cbor_write_head(writer, CBOR_FLOAT, bits, 4);
+}
+
+int ocre_cbor_put_double(ocre_cbor_writer_t *writer, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return cbor_write_head(writer, CBOR_DOUBLE, bits, 8);
+}
+
+int ocre_cbor_put_bool(ocre_cbor_writer_t *writer, bool value)
+{
+    return cbor_write_head(writer, value ? CBOR_TRUE : CBOR_FALSE, 0, 0);
+}
+
+int ocre_cbor_put_null(ocre_cbor_writer_t *writer)
+{
+    return cbor_write_head(writer, CBOR_NULL, 0, 0);
+}
+
+int ocre_cbor_put_text(ocre_cbor_writer_t *writer, const char *text, uint32_t len)
+{
+    int ret = cbor_put_head(writer, CBOR_MAJOR_TEXT, len);
+    return ret == OCRE_SUCCESS ? cbor_write(writer, text, len) : ret;
+}
+
+int ocre_cbor_put_bytes(ocre_cbor_writer_t *writer, const void *data, uint32_t len)
+{
+    int ret = cbor_put_head(writer, CBOR_MAJOR_BYTES, len);
+    return ret == OCRE_SUCCESS ? cbor_write(writer, data, len) : ret;
+}
+
+int ocre_cbor_put_array(ocre_cbor_writer_t *writer, uint32_t count)
+{
+    return cbor_put_head(writer, CBOR_MAJOR_ARRAY, count);
+}
+
+int ocre_cbor_put_map(ocre_cbor_writer_t *writer, uint32_t count)
+{
+    return cbor_put_head(writer, CBOR_MAJOR_MAP, count);
+}
+
+int ocre_cbor_put_reading(ocre_cbor_writer_t *writer, const ocre_cbor_reading_t *reading)
+{
+    if (reading == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint32_t start = writer->len;
+    int ret = ocre_cbor_put_array(writer, 3);
+    if (ret == OCRE_SUCCESS)
+    {
+        ret = ocre_cbor_put_uint(writer, reading->channel);
+    }
+    if (ret == OCRE_SUCCESS)
+    {
+        ret = ocre_cbor_put_uint(writer, reading->timestamp_us);
+    }
+    if (ret == OCRE_SUCCESS)
+    {
+        float narrow = (float)reading->value;
+        ret = (double)narrow == reading->value ? ocre_cbor_put_float(writer, narrow)
+                                                : ocre_cbor_put_double(writer, reading->value);
+    }
+    if (ret != OCRE_SUCCESS)
+    {
+        // Leave no partial reading behind
+        writer->len = start;
+    }
+    return ret;
+}
+
+// =============================================================================
+// DECODER
+// =============================================================================
+
+void ocre_cbor_reader_init(ocre_cbor_reader_t *reader, const void *buf, uint32_t len)
+{
+    reader->buf = buf;
+    reader->len = buf ? len : 0;
+    reader->pos = 0;
+}
+
+// Read an item head; pos only advances on success
+static int cbor_read_head(ocre_cbor_reader_t *reader, uint8_t *major, uint8_t *info, uint64_t *value)
+{
+    if (reader->pos >= reader->len)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint8_t initial = reader->buf[reader->pos];
+    uint32_t width = 0;
+    *major = initial >> 5;
+    *info = initial & 0x1F;
+    if (*info < CBOR_INFO_UINT8)
+    {
+        *value = *info;
+    }
+    else if (*info <= CBOR_INFO_UINT64)
+    {
+        width = 1U << (*info - CBOR_INFO_UINT8);
+    }
+    else
+    {
+        // Indefinite lengths and reserved values are not supported
+        return OCRE_ERROR_INVALID;
+    }
+    if (reader->len - reader->pos - 1 < width)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (width)
+    {
+        *value = 0;
+        for (uint32_t i = 1; i <= width; i++)
+        {
+            *value = (*value << 8) | reader->buf[reader->pos + i];
+        }
+    }
+    reader->pos += 1 + width;
+    return OCRE_SUCCESS;
+}
+
+static int cbor_get_head(ocre_cbor_reader_t *reader, uint8_t expected, uint64_t *value)
+{
+    uint32_t pos = reader->pos;
+    uint8_t major, info;
+    if (cbor_read_head(reader, &major, &info, value) != OCRE_SUCCESS || major != expected)
+    {
+        reader->pos = pos;
+        return OCRE_ERROR_INVALID;
+    }
+    return OCRE_SUCCESS;
+}
+
+static int cbor_get_string(ocre_cbor_reader_t *reader, uint8_t major, const void **data, uint32_t *len)
+{
+    uint32_t pos = reader->pos;
+    uint64_t value;
+    if (cbor_get_head(reader, major, &value) != OCRE_SUCCESS)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (value > reader->len - reader->pos)
+    {
+        reader->pos = pos;
+        return OCRE_ERROR_INVALID;
+    }
+    *data = reader->buf + reader->pos;
+    *len = (uint32_t)value;
+    reader->pos += (uint32_t)value;
+    return OCRE_SUCCESS;
+}
+
+static double cbor_half_to_double(uint16_t half)
+{
+    int exponent = (half >> 10) & 0x1F;
+    double mantissa = half & 0x3FF;
+    double value;
+    if (exponent == 0)
+    {
+        value = mantissa / (1 << 24);
+    }
+    else if (exponent == 0x1F)
+    {
+        value = mantissa == 0 ? __builtin_inf() : __builtin_nan("");
+    }
+    else
+    {
+        value = (mantissa + 1024) * ((exponent >= 25) ? (double)(1 << (exponent - 25)) : 1.0 / (1 << (25 - exponent)));
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+ocre_cbor_type_t ocre_cbor_peek_type(const ocre_cbor_reader_t *reader)
+{
+    if (reader->pos >= reader->len)
+    {
+        return OCRE_CBOR_TYPE_INVALID;
+    }
+    uint8_t initial = reader->buf[reader->pos];
+    switch (initial >> 5)
+    {
+    case CBOR_MAJOR_UINT:
+        return OCRE_CBOR_TYPE_UINT;
+    case CBOR_MAJOR_NEGINT:
+        return OCRE_CBOR_TYPE_NEGINT;
+    case CBOR_MAJOR_BYTES:
+        return OCRE_CBOR_TYPE_BYTES;
+    case CBOR_MAJOR_TEXT:
+        return OCRE_CBOR_TYPE_TEXT;
+    case CBOR_MAJOR_ARRAY:
+        return OCRE_CBOR_TYPE_ARRAY;
+    case CBOR_MAJOR_MAP:
+        return OCRE_CBOR_TYPE_MAP;
+    case CBOR_MAJOR_SIMPLE:
+        switch (initial)
+        {
+        case CBOR_FALSE:
+        case CBOR_TRUE:
+            return OCRE_CBOR_TYPE_BOOL;
+        case CBOR_NULL:
+            return OCRE_CBOR_TYPE_NULL;
+        case CBOR_HALF:
+        case CBOR_FLOAT:
+        case CBOR_DOUBLE:
+            return OCRE_CBOR_TYPE_FLOAT;
+        default:
+            return OCRE_CBOR_TYPE_INVALID;
+        }
+    default:
+        // Tags are not supported
+        return OCRE_CBOR_TYPE_INVALID;
+    }
+}
+
+int ocre_cbor_get_uint(ocre_cbor_reader_t *reader, uint64_t *value)
+{
+    return cbor_get_head(reader, CBOR_MAJOR_UINT, value);
+}
+
+int ocre_cbor_get_int(ocre_cbor_reader_t *reader, int64_t *value)
+{
+    uint32_t pos = reader->pos;
+    uint8_t major, info;
+    uint64_t arg;
+    if (cbor_read_head(reader, &major, &info, &arg) != OCRE_SUCCESS ||
+        (major != CBOR_MAJOR_UINT && major != CBOR_MAJOR_NEGINT) || arg > INT64_MAX)
+    {
+        reader->pos = pos;
+        return OCRE_ERROR_INVALID;
+    }
+    *value = major == CBOR_MAJOR_UINT ? (int64_t)arg : -1 - (int64_t)arg;
+    return OCRE_SUCCESS;
+}
+
+int ocre_cbor_get_double(ocre_cbor_reader_t *reader, double *value)
+{
+    uint32_t pos = reader->pos;
+    uint8_t major, info;
+    uint64_t arg;
+    if (cbor_read_head(reader, &major, &info, &arg) != OCRE_SUCCESS)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (major == CBOR_MAJOR_UINT)
+    {
+        *value = (double)arg;
+    }
+    else if (major == CBOR_MAJOR_NEGINT)
+    {
+        *value = -1.0 - (double)arg;
+    }
+    else if (major == CBOR_MAJOR_SIMPLE && info == CBOR_INFO_UINT16)
+    {
+        *value = cbor_half_to_double((uint16_t)arg);
+    }
+    else if (major == CBOR_MAJOR_SIMPLE && info == CBOR_INFO_UINT32)
+    {
+        uint32_t bits = (uint32_t)arg;
+        float narrow;
+        memcpy(&narrow, &bits, sizeof(narrow));
+        *value = narrow;
+    }
+    else if (major == CBOR_MAJOR_SIMPLE && info == CBOR_INFO_UINT64)
+    {
+        memcpy(value, &arg, sizeof(*value));
+    }
+    else
+    {
+        reader->pos = pos;
+        return OCRE_ERROR_INVALID;
+    }
+    return OCRE_SUCCESS;
+}
+
+int ocre_cbor_get_bool(ocre_cbor_reader_t *reader, bool *value)
+{
+    ocre_cbor_type_t type = ocre_cbor_peek_type(reader);
+    if (type != OCRE_CBOR_TYPE_BOOL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    *value = reader->buf[reader->pos++] == CBOR_TRUE;
+    return OCRE_SUCCESS;
+}
+
+int ocre_cbor_get_text(ocre_cbor_reader_t *reader, const char **text, uint32_t *len)
+{
+    return cbor_get_string(reader, CBOR_MAJOR_TEXT, (const void **)text, len);
+}
+
+int ocre_cbor_get_bytes(ocre_cbor_reader_t *reader, const void **data, uint32_t *len)
+{
+    return cbor_get_string(reader, CBOR_MAJOR_BYTES, data, len);
+}
+
+int ocre_cbor_get_array(ocre_cbor_reader_t *reader, uint32_t *count)
+{
+    uint32_t pos = reader->pos;
+    uint64_t value;
+    if (cbor_get_head(reader, CBOR_MAJOR_ARRAY, &value) != OCRE_SUCCESS || value > UINT32_MAX)
+    {
+        reader->pos = pos;
+        return OCRE_ERROR_INVALID;
+    }
+    *count = (uint32_t)value;
+    return OCRE_SUCCESS;
+}
+
+int ocre_cbor_get_map(ocre_cbor_reader_t *reader, uint32_t *count)
+{
+    uint32_t pos = reader->pos;
+    uint64_t value;
+    if (cbor_get_head(reader, CBOR_MAJOR_MAP, &value) != OCRE_SUCCESS || value > UINT32_MAX)
+    {
+        reader->pos = pos;
+        return OCRE_ERROR_INVALID;
+    }
+    *count = (uint32_t)value;
+    return OCRE_SUCCESS;
+}
+
+int ocre_cbor_get_reading(ocre_cbor_reader_t *reader, ocre_cbor_reading_t *reading)
+{
+    uint32_t pos = reader->pos;
+    uint32_t count;
+    uint64_t channel;
+    if (reading == NULL || ocre_cbor_get_array(reader, &count) != OCRE_SUCCESS || count != 3 ||
+        ocre_cbor_get_uint(reader, &channel) != OCRE_SUCCESS || channel > UINT32_MAX ||
+        ocre_cbor_get_uint(reader, &reading->timestamp_us) != OCRE_SUCCESS ||
+        ocre_cbor_get_double(reader, &reading->value) != OCRE_SUCCESS)
+    {
+        reader->pos = pos;
+        return OCRE_ERROR_INVALID;
+    }
+    reading->channel = (uint32_t)channel;
+    return OCRE_SUCCESS;
+}
@@ -0,0 +1,266 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#ifndef OCRE_CBOR_H
+#define OCRE_CBOR_H
+
+#include "ocre_api.h"
+
+/**
+ * @file ocre_cbor.h
+ * @brief Minimal CBOR (RFC 8949) encoder and decoder for compact message payloads.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define OCRE_CBOR_CONTENT_TYPE "application/cbor" /**< Content type of CBOR payloads */
+#define OCRE_CBOR_READING_MAX_LEN 24              /**< Largest encoding of one ocre_cbor_reading_t */
+
+    /**
+     * @brief CBOR item types
+     */
+    typedef enum
+    {
+        OCRE_CBOR_TYPE_UINT,    /**< Unsigned integer */
+        OCRE_CBOR_TYPE_NEGINT,  /**< Negative integer */
+        OCRE_CBOR_TYPE_BYTES,   /**< Byte string */
+        OCRE_CBOR_TYPE_TEXT,    /**< UTF-8 text string */
+        OCRE_CBOR_TYPE_ARRAY,   /**< Array of items */
+        OCRE_CBOR_TYPE_MAP,     /**< Map of key/value pairs */
+        OCRE_CBOR_TYPE_FLOAT,   /**< Half, single or double precision float */
+        OCRE_CBOR_TYPE_BOOL,    /**< true or false */
+        OCRE_CBOR_TYPE_NULL,    /**< null */
+        OCRE_CBOR_TYPE_INVALID  /**< End of input, or an item this decoder does not support */
+    } ocre_cbor_type_t;
+
+    /**
+     * @brief Encoder writing into a caller-provided buffer
+     */
+    typedef struct
+    {
+        uint8_t *buf;  /**< Output buffer */
+        uint32_t size; /**< Capacity of @p buf */
+        uint32_t len;  /**< Bytes written so far */
+    } ocre_cbor_writer_t;
+
+    /**
+     * @brief Decoder reading from a payload in place
+     */
+    typedef struct
+    {
+        const uint8_t *buf; /**< Encoded input */
+        uint32_t len;       /**< Length of @p buf */
+        uint32_t pos;       /**< Offset of the next item */
+    } ocre_cbor_reader_t;
+
+    /**
+     * @brief Typed, timestamped sensor reading
+     *
+     * Encoded as the array [channel, timestamp_us, value]. The value is sent as a single
+     * precision float when that is exact, so a typical reading takes 10 to 15 bytes.
+     */
+    typedef struct
+    {
+        uint32_t channel;      /**< Sensor channel identifier */
+        uint64_t timestamp_us; /**< Sample time, e.g. from ocre_time_us() */
+        double value;          /**< Sample value */
+    } ocre_cbor_reading_t;
+
+    /**
+     * @brief Start encoding into a buffer
+     * @param writer Encoder to initialize
+     * @param buf Output buffer
+     * @param size Capacity of @p buf
+     */
+    void ocre_cbor_writer_init(ocre_cbor_writer_t *writer, uint8_t *buf, uint32_t size);
+
+    /**
+     * @brief Encode an unsigned integer
+     * @param writer Encoder
+     * @param value Value to encode
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_uint(ocre_cbor_writer_t *writer, uint64_t value);
+
+    /**
+     * @brief Encode a signed integer
+     * @param writer Encoder
+     * @param value Value to encode
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_int(ocre_cbor_writer_t *writer, int64_t value);
+
+    /**
+     * @brief Encode a single precision float
+     * @param writer Encoder
+     * @param value Value to encode
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_float(ocre_cbor_writer_t *writer, float value);
+
+    /**
+     * @brief Encode a double precision float
+     * @param writer Encoder
+     * @param value Value to encode
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_double(ocre_cbor_writer_t *writer, double value);
+
+    /**
+     * @brief Encode a boolean
+     * @param writer Encoder
+     * @param value Value to encode
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_bool(ocre_cbor_writer_t *writer, bool value);
+
+    /**
+     * @brief Encode null
+     * @param writer Encoder
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_null(ocre_cbor_writer_t *writer);
+
+    /**
+     * @brief Encode a text string
+     * @param writer Encoder
+     * @param text UTF-8 text, need not be NUL-terminated
+     * @param len Length of @p text in bytes
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_text(ocre_cbor_writer_t *writer, const char *text, uint32_t len);
+
+    /**
+     * @brief Encode a byte string
+     * @param writer Encoder
+     * @param data Bytes to encode
+     * @param len Length of @p data
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_bytes(ocre_cbor_writer_t *writer, const void *data, uint32_t len);
+
+    /**
+     * @brief Start an array; encode @p count items after it
+     * @param writer Encoder
+     * @param count Number of items in the array
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_array(ocre_cbor_writer_t *writer, uint32_t count);
+
+    /**
+     * @brief Start a map; encode @p count key/value pairs after it
+     * @param writer Encoder
+     * @param count Number of pairs in the map
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_map(ocre_cbor_writer_t *writer, uint32_t count);
+
+    /**
+     * @brief Encode a sensor reading
+     * @param writer Encoder
+     * @param reading Reading to encode
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the buffer is full
+     */
+    int ocre_cbor_put_reading(ocre_cbor_writer_t *writer, const ocre_cbor_reading_t *reading);
+
+    /**
+     * @brief Start decoding a payload
+     * @param reader Decoder to initialize
+     * @param buf Encoded payload
+     * @param len Length of @p buf
+     */
+    void ocre_cbor_reader_init(ocre_cbor_reader_t *reader, const void *buf, uint32_t len);
+
+    /**
+     * @brief Get the type of the next item without consuming it
+     * @param reader Decoder
+     * @return Type of the next item, OCRE_CBOR_TYPE_INVALID at the end of input
+     */
+    ocre_cbor_type_t ocre_cbor_peek_type(const ocre_cbor_reader_t *reader);
+
+    /**
+     * @brief Decode an unsigned integer
+     * @param reader Decoder
+     * @param value Receives the value
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on a type mismatch or truncated input
+     */
+    int ocre_cbor_get_uint(ocre_cbor_reader_t *reader, uint64_t *value);
+
+    /**
+     * @brief Decode a signed integer
+     * @param reader Decoder
+     * @param value Receives the value
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on a type mismatch, overflow or truncated input
+     */
+    int ocre_cbor_get_int(ocre_cbor_reader_t *reader, int64_t *value);
+
+    /**
+     * @brief Decode a number as a double; accepts floats of any precision and integers
+     * @param reader Decoder
+     * @param value Receives the value
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on a type mismatch or truncated input
+     */
+    int ocre_cbor_get_double(ocre_cbor_reader_t *reader, double *value);
+
+    /**
+     * @brief Decode a boolean
+     * @param reader Decoder
+     * @param value Receives the value
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on a type mismatch or truncated input
+     */
+    int ocre_cbor_get_bool(ocre_cbor_reader_t *reader, bool *value);
+
+    /**
+     * @brief Decode a text string in place
+     * @param reader Decoder
+     * @param text Receives a pointer into the payload; not NUL-terminated
+     * @param len Receives the length in bytes
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on a type mismatch or truncated input
+     */
+    int ocre_cbor_get_text(ocre_cbor_reader_t *reader, const char **text, uint32_t *len);
+
+    /**
+     * @brief Decode a byte string in place
+     * @param reader Decoder
+     * @param data Receives a pointer into the payload
+     * @param len Receives the length in bytes
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on a type mismatch or truncated input
+     */
+    int ocre_cbor_get_bytes(ocre_cbor_reader_t *reader, const void **data, uint32_t *len);
+
+    /**
+     * @brief Decode an array header
+     * @param reader Decoder
+     * @param count Receives the number of items that follow
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on a type mismatch or truncated input
+     */
+    int ocre_cbor_get_array(ocre_cbor_reader_t *reader, uint32_t *count);
+
+    /**
+     * @brief Decode a map header
+     * @param reader Decoder
+     * @param count Receives the number of key/value pairs that follow
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on a type mismatch or truncated input
+     */
+    int ocre_cbor_get_map(ocre_cbor_reader_t *reader, uint32_t *count);
+
+    /**
+     * @brief Decode a sensor reading
+     * @param reader Decoder
+     * @param reading Receives the reading
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if the next item is not a reading
+     */
+    int ocre_cbor_get_reading(ocre_cbor_reader_t *reader, ocre_cbor_reading_t *reading);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCRE_CBOR_H */
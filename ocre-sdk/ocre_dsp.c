@@ -0,0 +1,261 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#include "ocre_dsp.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+
+static float dsp_f32x4_sum(v128_t v)
+{
+    return (wasm_f32x4_extract_lane(v, 0) + wasm_f32x4_extract_lane(v, 1)) +
+           (wasm_f32x4_extract_lane(v, 2) + wasm_f32x4_extract_lane(v, 3));
+}
+#endif
+
+// =============================================================================
+// BLOCK HELPERS
+// =============================================================================
+
+void ocre_dsp_deinterleave(const double *values, uint32_t channel_count, uint32_t channel, uint32_t samples,
+                           float *out)
+{
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        out[i] = (float)values[i * channel_count + channel];
+    }
+}
+
+// =============================================================================
+// FIR FILTER
+// =============================================================================
+
+static float dsp_dot(const float *a, const float *b, uint32_t n)
+{
+    uint32_t i = 0;
+    float sum = 0.0f;
+#ifdef __wasm_simd128__
+    v128_t acc = wasm_f32x4_splat(0.0f);
+    for (; i + 4 <= n; i += 4)
+    {
+        acc = wasm_f32x4_add(acc, wasm_f32x4_mul(wasm_v128_load(&a[i]), wasm_v128_load(&b[i])));
+    }
+    sum = dsp_f32x4_sum(acc);
+#endif
+    for (; i < n; i++)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Store a sample twice, so the window starting at the newest one never wraps
+static void dsp_fir_push(ocre_dsp_fir_t *fir, float x)
+{
+    fir->pos = fir->pos == 0 ? fir->taps - 1 : fir->pos - 1;
+    fir->delay[fir->pos] = x;
+    fir->delay[fir->pos + fir->taps] = x;
+}
+
+static float dsp_fir_output(const ocre_dsp_fir_t *fir)
+{
+    return dsp_dot(fir->coeffs, &fir->delay[fir->pos], fir->taps);
+}
+
+int ocre_dsp_fir_init(ocre_dsp_fir_t *fir, const float *coeffs, uint32_t taps, float *delay)
+{
+    if (fir == NULL || coeffs == NULL || taps == 0 || delay == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    fir->coeffs = coeffs;
+    fir->delay = delay;
+    fir->taps = taps;
+    fir->pos = 0;
+    memset(delay, 0, 2 * taps * sizeof(float));
+    return OCRE_SUCCESS;
+}
+
+void ocre_dsp_fir_process(ocre_dsp_fir_t *fir, const float *in, float *out, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        dsp_fir_push(fir, in[i]);
+        out[i] = dsp_fir_output(fir);
+    }
+}
+
+// =============================================================================
+// IIR FILTER
+// =============================================================================
+
+int ocre_dsp_biquad_init(ocre_dsp_biquad_t *iir, const float *coeffs, uint32_t stages, float *state)
+{
+    if (iir == NULL || coeffs == NULL || stages == 0 || state == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    iir->coeffs = coeffs;
+    iir->state = state;
+    iir->stages = stages;
+    memset(state, 0, 2 * stages * sizeof(float));
+    return OCRE_SUCCESS;
+}
+
+void ocre_dsp_biquad_process(ocre_dsp_biquad_t *iir, const float *in, float *out, uint32_t n)
+{
+    const float *src = in;
+    // One section at a time over the whole block keeps its coefficients in locals
+    for (uint32_t s = 0; s < iir->stages; s++)
+    {
+        const float *c = &iir->coeffs[5 * s];
+        float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+        float s1 = iir->state[2 * s];
+        float s2 = iir->state[2 * s + 1];
+        for (uint32_t i = 0; i < n; i++)
+        {
+            float x = src[i];
+            float y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            out[i] = y;
+        }
+        iir->state[2 * s] = s1;
+        iir->state[2 * s + 1] = s2;
+        src = out;
+    }
+}
+
+// =============================================================================
+// MOVING AVERAGE
+// =============================================================================
+
+int ocre_dsp_moving_avg_init(ocre_dsp_moving_avg_t *avg, float *window, uint32_t len)
+{
+    if (avg == NULL || window == NULL || len == 0)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    avg->window = window;
+    avg->len = len;
+    avg->pos = 0;
+    avg->count = 0;
+    avg->sum = 0.0;
+    return OCRE_SUCCESS;
+}
+
+void ocre_dsp_moving_avg_process(ocre_dsp_moving_avg_t *avg, const float *in, float *out, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float x = in[i];
+        if (avg->count == avg->len)
+        {
+            avg->sum -= avg->window[avg->pos];
+        }
+        else
+        {
+            avg->count++;
+        }
+        avg->window[avg->pos] = x;
+        avg->pos = avg->pos + 1 == avg->len ? 0 : avg->pos + 1;
+        avg->sum += x;
+        out[i] = (float)(avg->sum / avg->count);
+    }
+}
+
+// =============================================================================
+// DECIMATION
+// =============================================================================
+
+int ocre_dsp_decimator_init(ocre_dsp_decimator_t *dec, uint32_t factor, const float *coeffs, uint32_t taps,
+                            float *delay)
+{
+    if (dec == NULL || factor == 0)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    dec->factor = factor;
+    dec->phase = 0;
+    return ocre_dsp_fir_init(&dec->fir, coeffs, taps, delay);
+}
+
+uint32_t ocre_dsp_decimate(ocre_dsp_decimator_t *dec, const float *in, float *out, uint32_t n)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        dsp_fir_push(&dec->fir, in[i]);
+        if (++dec->phase == dec->factor)
+        {
+            dec->phase = 0;
+            out[count++] = dsp_fir_output(&dec->fir);
+        }
+    }
+    return count;
+}
+
+// =============================================================================
+// WINDOW STATISTICS
+// =============================================================================
+
+int ocre_dsp_stats(const float *in, uint32_t n, ocre_dsp_stats_t *stats)
+{
+    if (in == NULL || n == 0 || stats == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint32_t i = 0;
+    float min = in[0];
+    float max = in[0];
+    float sum = 0.0f;
+    float sum_sq = 0.0f;
+#ifdef __wasm_simd128__
+    if (n >= 4)
+    {
+        v128_t vmin = wasm_v128_load(&in[0]);
+        v128_t vmax = vmin;
+        v128_t vsum = wasm_f32x4_splat(0.0f);
+        v128_t vsum_sq = vsum;
+        for (; i + 4 <= n; i += 4)
+        {
+            v128_t x = wasm_v128_load(&in[i]);
+            vmin = wasm_f32x4_pmin(vmin, x);
+            vmax = wasm_f32x4_pmax(vmax, x);
+            vsum = wasm_f32x4_add(vsum, x);
+            vsum_sq = wasm_f32x4_add(vsum_sq, wasm_f32x4_mul(x, x));
+        }
+        for (int lane = 0; lane < 4; lane++)
+        {
+            float lmin = wasm_f32x4_extract_lane(vmin, 0);
+            float lmax = wasm_f32x4_extract_lane(vmax, 0);
+            min = lmin < min ? lmin : min;
+            max = lmax > max ? lmax : max;
+            // Rotate the next lane into lane 0, extract_lane needs a constant index
+            vmin = wasm_i32x4_shuffle(vmin, vmin, 1, 2, 3, 0);
+            vmax = wasm_i32x4_shuffle(vmax, vmax, 1, 2, 3, 0);
+        }
+        sum = dsp_f32x4_sum(vsum);
+        sum_sq = dsp_f32x4_sum(vsum_sq);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float x = in[i];
+        min = x < min ? x : min;
+        max = x > max ? x : max;
+        sum += x;
+        sum_sq += x * x;
+    }
+    stats->min = min;
+    stats->max = max;
+    stats->mean = sum / n;
+    stats->rms = sqrtf(sum_sq / n);
+    return OCRE_SUCCESS;
+}
@@ -0,0 +1,216 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#ifndef OCRE_DSP_H
+#define OCRE_DSP_H
+
+#include "ocre_api.h"
+
+/**
+ * @file ocre_dsp.h
+ * @brief Filters, decimation and window statistics over float32 sample blocks.
+ *
+ * Kernels work on whole blocks, such as one channel of an ocre_sensor_block_t. When the
+ * library is built with OCRE_DSP_SIMD (-msimd128) the FIR, decimation and statistics
+ * kernels use WASM SIMD128, otherwise they fall back to scalar code with the same results
+ * up to float rounding. All state lives in caller-provided storage.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // =============================================================================
+    // Block Helpers
+    // =============================================================================
+
+    /**
+     * @brief Extract one channel of sample-major values as float32
+     *
+     * Matches the layout of ocre_sensor_block_t::values.
+     *
+     * @param values Interleaved values, @p samples * @p channel_count entries
+     * @param channel_count Values per sample
+     * @param channel Channel to extract
+     * @param samples Number of samples
+     * @param out Receives @p samples values
+     */
+    void ocre_dsp_deinterleave(const double *values, uint32_t channel_count, uint32_t channel, uint32_t samples,
+                               float *out);
+
+    // =============================================================================
+    // FIR Filter
+    // =============================================================================
+
+    /**
+     * @brief FIR filter state
+     */
+    typedef struct
+    {
+        const float *coeffs; /**< Taps, coeffs[0] applies to the newest sample */
+        float *delay;        /**< History, 2 * taps floats so every window is contiguous */
+        uint32_t taps;       /**< Number of taps */
+        uint32_t pos;        /**< Index of the newest sample in @p delay */
+    } ocre_dsp_fir_t;
+
+    /**
+     * @brief Initialize a FIR filter with zeroed history
+     * @param fir Filter to initialize
+     * @param coeffs Filter taps, kept by reference
+     * @param taps Number of taps
+     * @param delay Storage for 2 * @p taps floats
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on bad parameters
+     */
+    int ocre_dsp_fir_init(ocre_dsp_fir_t *fir, const float *coeffs, uint32_t taps, float *delay);
+
+    /**
+     * @brief Filter a block
+     * @param fir Filter state
+     * @param in Input samples
+     * @param out Output samples, may be @p in
+     * @param n Number of samples
+     */
+    void ocre_dsp_fir_process(ocre_dsp_fir_t *fir, const float *in, float *out, uint32_t n);
+
+    // =============================================================================
+    // IIR Filter
+    // =============================================================================
+
+    /**
+     * @brief Cascade of second-order IIR sections, transposed direct form II
+     *
+     * Each section is recursive, so this kernel is scalar in both builds.
+     */
+    typedef struct
+    {
+        const float *coeffs; /**< b0, b1, b2, a1, a2 per section, a0 normalized to 1 */
+        float *state;        /**< Two floats per section */
+        uint32_t stages;     /**< Number of sections */
+    } ocre_dsp_biquad_t;
+
+    /**
+     * @brief Initialize a biquad cascade with zeroed state
+     * @param iir Filter to initialize
+     * @param coeffs 5 * @p stages coefficients, kept by reference
+     * @param stages Number of sections
+     * @param state Storage for 2 * @p stages floats
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on bad parameters
+     */
+    int ocre_dsp_biquad_init(ocre_dsp_biquad_t *iir, const float *coeffs, uint32_t stages, float *state);
+
+    /**
+     * @brief Filter a block
+     * @param iir Filter state
+     * @param in Input samples
+     * @param out Output samples, may be @p in
+     * @param n Number of samples
+     */
+    void ocre_dsp_biquad_process(ocre_dsp_biquad_t *iir, const float *in, float *out, uint32_t n);
+
+    // =============================================================================
+    // Moving Average
+    // =============================================================================
+
+    /**
+     * @brief Moving average over the last @p len samples
+     */
+    typedef struct
+    {
+        float *window;  /**< The last @p len samples */
+        uint32_t len;   /**< Window length */
+        uint32_t pos;   /**< Next slot to overwrite */
+        uint32_t count; /**< Samples in the window, up to @p len */
+        double sum;     /**< Running sum, double so it does not drift over long runs */
+    } ocre_dsp_moving_avg_t;
+
+    /**
+     * @brief Initialize an empty moving average
+     * @param avg Average to initialize
+     * @param window Storage for @p len floats
+     * @param len Window length
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on bad parameters
+     */
+    int ocre_dsp_moving_avg_init(ocre_dsp_moving_avg_t *avg, float *window, uint32_t len);
+
+    /**
+     * @brief Average a block; until the window fills, outputs average the samples seen so far
+     * @param avg Average state
+     * @param in Input samples
+     * @param out Output samples, may be @p in
+     * @param n Number of samples
+     */
+    void ocre_dsp_moving_avg_process(ocre_dsp_moving_avg_t *avg, const float *in, float *out, uint32_t n);
+
+    // =============================================================================
+    // Decimation
+    // =============================================================================
+
+    /**
+     * @brief Anti-aliasing FIR filter followed by downsampling
+     */
+    typedef struct
+    {
+        ocre_dsp_fir_t fir; /**< Anti-aliasing filter */
+        uint32_t factor;    /**< Keep one output every @p factor inputs */
+        uint32_t phase;     /**< Inputs since the last output */
+    } ocre_dsp_decimator_t;
+
+    /**
+     * @brief Initialize a decimator
+     * @param dec Decimator to initialize
+     * @param factor Downsampling factor, at least 1
+     * @param coeffs Anti-aliasing filter taps, kept by reference
+     * @param taps Number of taps
+     * @param delay Storage for 2 * @p taps floats
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on bad parameters
+     */
+    int ocre_dsp_decimator_init(ocre_dsp_decimator_t *dec, uint32_t factor, const float *coeffs, uint32_t taps,
+                                float *delay);
+
+    /**
+     * @brief Decimate a block
+     *
+     * The filter is only evaluated for the samples that are kept.
+     *
+     * @param dec Decimator state
+     * @param in Input samples
+     * @param out Output samples, room for @p n / factor + 1 values
+     * @param n Number of input samples
+     * @return Number of samples written to @p out
+     */
+    uint32_t ocre_dsp_decimate(ocre_dsp_decimator_t *dec, const float *in, float *out, uint32_t n);
+
+    // =============================================================================
+    // Window Statistics
+    // =============================================================================
+
+    /**
+     * @brief Statistics of a block
+     */
+    typedef struct
+    {
+        float min;  /**< Smallest sample */
+        float max;  /**< Largest sample */
+        float mean; /**< Arithmetic mean */
+        float rms;  /**< Root mean square */
+    } ocre_dsp_stats_t;
+
+    /**
+     * @brief Compute min, max, mean and RMS of a block
+     * @param in Input samples
+     * @param n Number of samples, at least 1
+     * @param stats Receives the statistics
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on bad parameters
+     */
+    int ocre_dsp_stats(const float *in, uint32_t n, ocre_dsp_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCRE_DSP_H */
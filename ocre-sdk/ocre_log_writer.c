@@ -0,0 +1,454 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#include "ocre_log_writer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Write the whole range, returns 0 or the errno of the failed call
+static int write_all(int fd, const char *buf, uint32_t len, uint32_t *writes)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, buf, len);
+        __atomic_add_fetch(writes, 1, __ATOMIC_RELAXED);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return errno;
+        }
+        if (n == 0)
+        {
+            return EIO; // No progress, retrying would spin
+        }
+        buf += n;
+        len -= (uint32_t)n;
+    }
+    return 0;
+}
+
+static uint32_t flush_threshold(const ocre_log_writer_t *writer)
+{
+    uint32_t bytes = writer->config.flush_bytes;
+    return bytes && bytes <= writer->active_size ? bytes : writer->active_size / 2;
+}
+
+// Pending bytes up to the last block boundary of the file
+static uint32_t aligned_len(const ocre_log_writer_t *writer)
+{
+    uint32_t block = writer->config.block_size;
+    if (block == 0)
+    {
+        return writer->len;
+    }
+    uint64_t end = (writer->offset + writer->len) / block * block;
+    return end > writer->offset ? (uint32_t)(end - writer->offset) : 0;
+}
+
+// Record a failed write or sync, kept until ocre_log_writer_clear_error()
+static int fail(ocre_log_writer_t *writer, int err)
+{
+    writer->stats.last_errno = err;
+    writer->error = err == ENOSPC ? OCRE_ERROR_NO_SPACE : OCRE_ERROR_IO;
+    return writer->error;
+}
+
+// Write the first n pending bytes on the calling thread
+static int write_in_place(ocre_log_writer_t *writer, uint32_t n)
+{
+    int err = write_all(writer->fd, writer->active, n, &writer->stats.writes);
+    writer->len -= n;
+    memmove(writer->active, writer->active + n, writer->len);
+    if (err)
+    {
+        // Part of the range may be in the file already, retrying it could duplicate records
+        writer->stats.dropped += n;
+        return fail(writer, err);
+    }
+    writer->offset += n;
+    return OCRE_SUCCESS;
+}
+
+static int write_pending(ocre_log_writer_t *writer, uint32_t n);
+
+#ifdef OCRE_SDK_THREADS
+static int io_work(ocre_work_t *work)
+{
+    ocre_log_writer_t *writer = work->user_data;
+    return write_all(writer->fd, writer->io_buf, writer->io_len, &writer->stats.writes);
+}
+
+// Take back the other half once its write is over, result is the errno of the write
+static void io_finish(ocre_log_writer_t *writer, int result)
+{
+    writer->io_busy = 0;
+    if (result)
+    {
+        writer->stats.dropped += writer->io_len;
+        fail(writer, result);
+    }
+}
+
+// Runs on the dispatching thread once the item has left the queue, so it may be submitted again
+static void io_done(ocre_work_t *work, int result)
+{
+    ocre_log_writer_t *writer = work->user_data;
+    io_finish(writer, result);
+    // Records that piled up during the write go out now rather than on the next append
+    if (writer->error == 0 && writer->len >= flush_threshold(writer))
+    {
+        write_pending(writer, aligned_len(writer));
+    }
+}
+
+// Wait for the worker write in progress and the ones its completion started
+static void io_wait(ocre_log_writer_t *writer)
+{
+    while (writer->wq && writer->io_busy)
+    {
+        ocre_workqueue_wait(writer->wq, &writer->work);
+    }
+}
+#endif
+
+// Write the first n pending bytes, on the worker when there is one
+static int write_pending(ocre_log_writer_t *writer, uint32_t n)
+{
+    if (n == 0)
+    {
+        return OCRE_SUCCESS;
+    }
+#ifdef OCRE_SDK_THREADS
+    if (writer->wq)
+    {
+        if (writer->io_busy)
+        {
+            return OCRE_ERROR_BUSY;
+        }
+        if (writer->error)
+        {
+            return writer->error;
+        }
+        // Hand the active half to the worker and carry the unaligned tail over to the other one
+        char *other = writer->active == writer->buffer ? writer->buffer + writer->active_size : writer->buffer;
+        memcpy(other, writer->active + n, writer->len - n);
+        writer->io_buf = writer->active;
+        writer->io_len = n;
+        writer->io_busy = 1;
+        writer->active = other;
+        writer->len -= n;
+        writer->offset += n;
+        if (ocre_workqueue_submit(writer->wq, &writer->work) != OCRE_SUCCESS)
+        {
+            // Pool saturated, write on this thread instead
+            io_finish(writer, io_work(&writer->work));
+        }
+        return writer->error;
+    }
+#endif
+    return write_in_place(writer, n);
+}
+
+// Free at least `need` bytes in the active part
+static int make_room(ocre_log_writer_t *writer, uint32_t need)
+{
+    uint32_t n = aligned_len(writer);
+    if (writer->active_size - (writer->len - n) < need)
+    {
+        n = writer->len;
+    }
+    return write_pending(writer, n);
+}
+
+static void latency_expired(ocre_soft_timer_t *timer, void *user_data)
+{
+    ocre_log_writer_t *writer = user_data;
+    if (ocre_log_writer_flush(writer) == OCRE_ERROR_BUSY)
+    {
+        ocre_soft_timer_start(timer, OCRE_SOFT_TIMER_TICK_MS, 0); // Retry once the worker is done
+    }
+}
+
+static void appended(ocre_log_writer_t *writer, uint32_t len)
+{
+    writer->stats.records++;
+    writer->stats.bytes += len;
+    if (writer->len >= flush_threshold(writer))
+    {
+        write_pending(writer, aligned_len(writer)); // BUSY is retried by io_done()
+    }
+    if (writer->config.max_latency_ms && writer->len > 0 && !ocre_soft_timer_is_active(&writer->timer))
+    {
+        ocre_soft_timer_start(&writer->timer, writer->config.max_latency_ms, 0);
+    }
+}
+
+static bool writer_valid(const ocre_log_writer_t *writer)
+{
+    return writer != NULL && writer->buffer != NULL && writer->fd >= 0;
+}
+
+// Write everything pending on the calling thread, after any worker write in progress
+static int drain(ocre_log_writer_t *writer)
+{
+#ifdef OCRE_SDK_THREADS
+    io_wait(writer);
+#endif
+    if (writer->error)
+    {
+        return writer->error;
+    }
+    return write_in_place(writer, writer->len);
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+int ocre_log_writer_open(ocre_log_writer_t *writer, const char *path, char *buffer, uint32_t capacity,
+                         const ocre_log_writer_config_t *config)
+{
+    if (writer == NULL || path == NULL || buffer == NULL || capacity < 2)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = -1;
+    if (config)
+    {
+        writer->config = *config;
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Failed to open %s for appending (%d)\n", path, errno);
+#endif
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    off_t end = lseek(fd, 0, SEEK_END);
+    writer->fd = fd;
+    writer->offset = end > 0 ? (uint64_t)end : 0;
+    writer->buffer = buffer;
+    writer->capacity = capacity;
+    writer->active = buffer;
+    writer->active_size = capacity;
+    ocre_soft_timer_init(&writer->timer, latency_expired, writer);
+    return OCRE_SUCCESS;
+}
+
+#ifdef OCRE_SDK_THREADS
+int ocre_log_writer_use_workqueue(ocre_log_writer_t *writer, ocre_workqueue_t *wq)
+{
+    if (!writer_valid(writer))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    int ret = ocre_log_writer_barrier(writer);
+    if (ret != OCRE_SUCCESS)
+    {
+        return ret;
+    }
+    writer->wq = wq;
+    writer->active = writer->buffer;
+    writer->active_size = wq ? writer->capacity / 2 : writer->capacity;
+    ocre_work_init(&writer->work, io_work, io_done, writer);
+    return OCRE_SUCCESS;
+}
+#endif
+
+int ocre_log_writer_append(ocre_log_writer_t *writer, const void *data, uint32_t len)
+{
+    if (!writer_valid(writer) || (data == NULL && len > 0))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (writer->error)
+    {
+        return writer->error;
+    }
+    if (len > writer->active_size)
+    {
+        // Too large to buffer: everything before it, then the record itself
+        int ret = drain(writer);
+        if (ret == OCRE_SUCCESS)
+        {
+            int err = write_all(writer->fd, data, len, &writer->stats.writes);
+            if (err)
+            {
+                return fail(writer, err);
+            }
+            writer->offset += len;
+            writer->stats.records++;
+            writer->stats.bytes += len;
+        }
+        return ret;
+    }
+    if (writer->active_size - writer->len < len)
+    {
+        int ret = make_room(writer, len);
+        if (ret != OCRE_SUCCESS)
+        {
+            writer->stats.busy += ret == OCRE_ERROR_BUSY;
+            return ret;
+        }
+    }
+    memcpy(writer->active + writer->len, data, len);
+    writer->len += len;
+    appended(writer, len);
+    return OCRE_SUCCESS;
+}
+
+int ocre_log_writer_vprintf(ocre_log_writer_t *writer, const char *fmt, va_list args)
+{
+    if (!writer_valid(writer) || fmt == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (writer->error)
+    {
+        return writer->error;
+    }
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        uint32_t room = writer->active_size - writer->len;
+        va_list copy;
+        va_copy(copy, args);
+        int n = vsnprintf(writer->active + writer->len, room, fmt, copy);
+        va_end(copy);
+        if (n < 0)
+        {
+            return OCRE_ERROR_INVALID;
+        }
+        if ((uint32_t)n < room)
+        {
+            writer->len += (uint32_t)n;
+            appended(writer, (uint32_t)n);
+            return OCRE_SUCCESS;
+        }
+        if ((uint32_t)n >= writer->active_size)
+        {
+            return OCRE_ERROR_NO_MEMORY;
+        }
+        int ret = make_room(writer, (uint32_t)n + 1); // vsnprintf() also stores a NUL
+        if (ret != OCRE_SUCCESS)
+        {
+            writer->stats.busy += ret == OCRE_ERROR_BUSY;
+            return ret;
+        }
+    }
+    return OCRE_ERROR_NO_MEMORY;
+}
+
+int ocre_log_writer_printf(ocre_log_writer_t *writer, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int ret = ocre_log_writer_vprintf(writer, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+int ocre_log_writer_flush(ocre_log_writer_t *writer)
+{
+    if (!writer_valid(writer))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (writer->error)
+    {
+        return writer->error;
+    }
+    return write_pending(writer, writer->len);
+}
+
+int ocre_log_writer_barrier(ocre_log_writer_t *writer)
+{
+    if (!writer_valid(writer))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    int ret = drain(writer);
+    if (ret != OCRE_SUCCESS)
+    {
+        return ret;
+    }
+    if (writer->config.flags & OCRE_LOG_WRITER_SYNC)
+    {
+        writer->stats.syncs++;
+        if (fsync(writer->fd) != 0)
+        {
+            return fail(writer, errno);
+        }
+    }
+    ocre_soft_timer_stop(&writer->timer);
+    return OCRE_SUCCESS;
+}
+
+int ocre_log_writer_clear_error(ocre_log_writer_t *writer)
+{
+    if (!writer_valid(writer))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+#ifdef OCRE_SDK_THREADS
+    if (writer->wq && writer->io_busy)
+    {
+        return OCRE_ERROR_BUSY;
+    }
+#endif
+    if (writer->error == 0)
+    {
+        return OCRE_SUCCESS;
+    }
+    writer->error = 0;
+    // A failed write leaves the end of the file unknown, block alignment restarts from it
+    off_t end = lseek(writer->fd, 0, SEEK_END);
+    if (end >= 0)
+    {
+        writer->offset = (uint64_t)end;
+    }
+    if (writer->config.max_latency_ms && writer->len > 0 && !ocre_soft_timer_is_active(&writer->timer))
+    {
+        ocre_soft_timer_start(&writer->timer, writer->config.max_latency_ms, 0);
+    }
+    return OCRE_SUCCESS;
+}
+
+int ocre_log_writer_get_stats(const ocre_log_writer_t *writer, ocre_log_writer_stats_t *stats)
+{
+    if (writer == NULL || stats == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    *stats = writer->stats;
+    stats->writes = __atomic_load_n(&writer->stats.writes, __ATOMIC_RELAXED);
+    return OCRE_SUCCESS;
+}
+
+int ocre_log_writer_close(ocre_log_writer_t *writer)
+{
+    if (!writer_valid(writer))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    int ret = ocre_log_writer_barrier(writer);
+#ifdef OCRE_SDK_THREADS
+    io_wait(writer); // The barrier returns early on an error, the item must still leave the queue
+#endif
+    ocre_soft_timer_stop(&writer->timer);
+    close(writer->fd);
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = -1;
+    return ret;
+}
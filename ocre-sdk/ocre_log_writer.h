@@ -0,0 +1,198 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#ifndef OCRE_LOG_WRITER_H
+#define OCRE_LOG_WRITER_H
+
+#include "ocre_api.h"
+#include <stdarg.h>
+#ifdef OCRE_SDK_THREADS
+#include "ocre_workqueue.h"
+#endif
+
+/**
+ * @file ocre_log_writer.h
+ * @brief Buffered append-only file writer with group commit.
+ *
+ * Records are gathered in a caller-provided buffer and written out when enough bytes
+ * are pending, when the oldest one has waited long enough, or at an explicit barrier.
+ * Size-triggered writes end on a block boundary of the file, so a flash filesystem sees
+ * a few large, aligned writes instead of one small write and flush per record.
+ *
+ * In builds with OCRE_SDK_THREADS the writes can run on an ocre_workqueue worker. The
+ * buffer is then split in two halves: records go into one while the other is written.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define OCRE_LOG_WRITER_SYNC 0x1 /**< fsync() at every barrier, for records that must survive power loss */
+
+    /**
+     * @brief Flush thresholds, zero fields take the defaults
+     */
+    typedef struct
+    {
+        uint32_t flush_bytes;    /**< Pending bytes that trigger a write, default half the buffer (half a half with a worker) */
+        uint32_t block_size;     /**< Size-triggered writes end on a multiple of this file offset, 0 for no alignment */
+        uint32_t max_latency_ms; /**< Longest a record stays buffered, 0 to write only on size and barriers */
+        uint32_t flags;          /**< OCRE_LOG_WRITER_* flags */
+    } ocre_log_writer_config_t;
+
+    /**
+     * @brief Writer counters
+     */
+    typedef struct
+    {
+        uint32_t records;    /**< Records appended */
+        uint64_t bytes;      /**< Bytes appended */
+        uint32_t writes;     /**< write() calls made */
+        uint32_t syncs;      /**< fsync() calls made */
+        uint32_t busy;       /**< Appends refused because both halves were full */
+        uint64_t dropped;    /**< Bytes of failed writes, parts of them may have reached the file */
+        int last_errno;      /**< errno of the last failed write or sync, 0 if none */
+    } ocre_log_writer_stats_t;
+
+    /**
+     * @brief Writer state
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct
+    {
+        int fd;                          /**< File appended to */
+        ocre_log_writer_config_t config; /**< Thresholds in use */
+        char *buffer;                    /**< Storage given to ocre_log_writer_open() */
+        uint32_t capacity;               /**< Size of buffer */
+        char *active;                    /**< Part of buffer records are appended to */
+        uint32_t active_size;            /**< Size of the active part */
+        uint32_t len;                    /**< Bytes pending in the active part */
+        uint64_t offset;                 /**< File offset the pending bytes will be written at */
+        ocre_soft_timer_t timer;         /**< Latency deadline of the oldest pending record */
+        ocre_log_writer_stats_t stats;   /**< Counters */
+        int error;                       /**< Error of the last failed write, until ocre_log_writer_clear_error() */
+#ifdef OCRE_SDK_THREADS
+        ocre_workqueue_t *wq;            /**< Worker the writes run on, NULL to write in place */
+        ocre_work_t work;                /**< Write of the other half */
+        const char *io_buf;              /**< Bytes being written by the worker */
+        uint32_t io_len;                 /**< Length of io_buf */
+        uint32_t io_busy;                /**< Set from submission until the completion takes io_buf back */
+#endif
+    } ocre_log_writer_t;
+
+    /**
+     * @brief Open a file for buffered appending
+     * @param writer Writer to initialize
+     * @param path File to append to, created if missing
+     * @param buffer Record storage, must stay valid until ocre_log_writer_close()
+     * @param capacity Size of @p buffer in bytes
+     * @param config Thresholds, NULL for the defaults
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_log_writer_open(ocre_log_writer_t *writer, const char *path, char *buffer, uint32_t capacity,
+                             const ocre_log_writer_config_t *config);
+
+#ifdef OCRE_SDK_THREADS
+    /**
+     * @brief Run the writes on a worker thread from now on
+     *
+     * Splits the buffer in two halves. Call before appending. A half is reused once the
+     * completion of its write ran from ocre_process_events(), or from a barrier waiting
+     * for it.
+     *
+     * @param writer Open writer
+     * @param wq Started work queue, NULL to write in place again
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_log_writer_use_workqueue(ocre_log_writer_t *writer, ocre_workqueue_t *wq);
+#endif
+
+    /**
+     * @brief Append a record
+     *
+     * Records larger than the buffer are written straight through.
+     *
+     * @param writer Open writer
+     * @param data Record bytes
+     * @param len Record length
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_BUSY if the other half is written and this
+     *         one is full, until the write's completion is dispatched, OCRE_ERROR_NO_SPACE or OCRE_ERROR_IO after a write
+     *         failure, until ocre_log_writer_clear_error()
+     */
+    int ocre_log_writer_append(ocre_log_writer_t *writer, const void *data, uint32_t len);
+
+    /**
+     * @brief Append a formatted record, formatted in place in the buffer
+     * @param writer Open writer
+     * @param fmt printf() format
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_MEMORY if the record does not fit in
+     *         the buffer, other errors as for ocre_log_writer_append()
+     */
+    int ocre_log_writer_printf(ocre_log_writer_t *writer, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    /**
+     * @brief Append a formatted record from a va_list
+     * @param writer Open writer
+     * @param fmt printf() format
+     * @param args Format arguments
+     * @return As for ocre_log_writer_printf()
+     */
+    int ocre_log_writer_vprintf(ocre_log_writer_t *writer, const char *fmt, va_list args);
+
+    /**
+     * @brief Start writing everything pending, without waiting for a worker or syncing
+     * @param writer Open writer
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_log_writer_flush(ocre_log_writer_t *writer);
+
+    /**
+     * @brief Write everything appended so far before returning
+     *
+     * Waits for a worker write in progress, writes the rest on the calling thread and,
+     * with OCRE_LOG_WRITER_SYNC, syncs the file.
+     *
+     * @param writer Open writer
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_log_writer_barrier(ocre_log_writer_t *writer);
+
+    /**
+     * @brief Resume writing after a failed write or sync
+     *
+     * A failure is returned by every call until it is cleared, e.g. once space was freed.
+     * The bytes of the failed write are dropped and counted in the stats, the records
+     * appended after them are kept and written on the next trigger.
+     *
+     * @param writer Open writer
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_BUSY while a worker write is in progress,
+     *         OCRE_ERROR_INVALID on invalid parameters
+     */
+    int ocre_log_writer_clear_error(ocre_log_writer_t *writer);
+
+    /**
+     * @brief Get the writer counters
+     * @param writer Open writer
+     * @param stats Receives the counters
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on invalid parameters
+     */
+    int ocre_log_writer_get_stats(const ocre_log_writer_t *writer, ocre_log_writer_stats_t *stats);
+
+    /**
+     * @brief Write everything pending and close the file
+     * @param writer Writer to close
+     * @return OCRE_SUCCESS on success, negative error code if the final writes failed
+     */
+    int ocre_log_writer_close(ocre_log_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCRE_LOG_WRITER_H */
@@ -0,0 +1,867 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#include "ocre_modbus.h"
+#include <string.h>
+
+#define MBAP_PREFIX 6 // MBAP bytes before the ones counted by its length field
+
+// Quantity limits from the Modbus application protocol specification
+#define MAX_READ_BITS 2000
+#define MAX_WRITE_BITS 1968
+#define MAX_READ_REGISTERS 125
+#define MAX_WRITE_REGISTERS 123
+#define MAX_RW_WRITE_REGISTERS 121
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void put_u16(uint8_t *p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+}
+
+static uint8_t check_range(uint16_t start, uint16_t count, uint16_t max)
+{
+    if (count < 1 || count > max)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    return (uint32_t)start + count <= 0x10000 ? OCRE_MODBUS_EX_NONE : OCRE_MODBUS_EX_ILLEGAL_DATA_ADDRESS;
+}
+
+// =============================================================================
+// PDU HANDLERS
+// =============================================================================
+
+// Each handler gets the request PDU after the function code and writes the response PDU
+// after the function code. It returns an exception code and sets *res_len on success.
+
+static uint8_t read_bits(ocre_modbus_server_t *server, ocre_modbus_table_t table, const uint8_t *req,
+                         uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    if (server->map->read_bits == NULL)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_FUNCTION;
+    }
+    if (req_len != 4)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint16_t start = get_u16(&req[0]);
+    uint16_t count = get_u16(&req[2]);
+    uint8_t ex = check_range(start, count, MAX_READ_BITS);
+    if (ex != OCRE_MODBUS_EX_NONE)
+    {
+        return ex;
+    }
+    uint8_t byte_count = (count + 7) / 8;
+    memset(&res[1], 0, byte_count);
+    ex = server->map->read_bits(server->user_data, table, start, count, &res[1]);
+    if (ex == OCRE_MODBUS_EX_NONE)
+    {
+        res[0] = byte_count;
+        *res_len = 1 + byte_count;
+    }
+    return ex;
+}
+
+static uint8_t read_registers(ocre_modbus_server_t *server, ocre_modbus_table_t table, const uint8_t *req,
+                              uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    if (server->map->read_registers == NULL)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_FUNCTION;
+    }
+    if (req_len != 4)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint16_t start = get_u16(&req[0]);
+    uint16_t count = get_u16(&req[2]);
+    uint8_t ex = check_range(start, count, MAX_READ_REGISTERS);
+    if (ex != OCRE_MODBUS_EX_NONE)
+    {
+        return ex;
+    }
+    uint16_t values[MAX_READ_REGISTERS];
+    ex = server->map->read_registers(server->user_data, table, start, count, values);
+    if (ex == OCRE_MODBUS_EX_NONE)
+    {
+        res[0] = count * 2;
+        for (uint16_t i = 0; i < count; i++)
+        {
+            put_u16(&res[1 + 2 * i], values[i]);
+        }
+        *res_len = 1 + count * 2;
+    }
+    return ex;
+}
+
+static uint8_t write_single_coil(ocre_modbus_server_t *server, const uint8_t *req, uint16_t req_len, uint8_t *res,
+                                 uint16_t *res_len)
+{
+    if (server->map->write_bits == NULL)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_FUNCTION;
+    }
+    if (req_len != 4 || (get_u16(&req[2]) != 0xFF00 && get_u16(&req[2]) != 0x0000))
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint8_t bit = req[2] == 0xFF ? 1 : 0;
+    uint8_t ex = server->map->write_bits(server->user_data, get_u16(&req[0]), 1, &bit);
+    if (ex == OCRE_MODBUS_EX_NONE)
+    {
+        memcpy(res, req, 4); // Echo of the request
+        *res_len = 4;
+    }
+    return ex;
+}
+
+static uint8_t write_single_register(ocre_modbus_server_t *server, const uint8_t *req, uint16_t req_len,
+                                     uint8_t *res, uint16_t *res_len)
+{
+    if (server->map->write_registers == NULL)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_FUNCTION;
+    }
+    if (req_len != 4)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint16_t value = get_u16(&req[2]);
+    uint8_t ex = server->map->write_registers(server->user_data, get_u16(&req[0]), 1, &value);
+    if (ex == OCRE_MODBUS_EX_NONE)
+    {
+        memcpy(res, req, 4); // Echo of the request
+        *res_len = 4;
+    }
+    return ex;
+}
+
+static uint8_t write_multiple_coils(ocre_modbus_server_t *server, const uint8_t *req, uint16_t req_len,
+                                    uint8_t *res, uint16_t *res_len)
+{
+    if (server->map->write_bits == NULL)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_FUNCTION;
+    }
+    if (req_len < 5)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint16_t start = get_u16(&req[0]);
+    uint16_t count = get_u16(&req[2]);
+    if (req[4] != (count + 7) / 8 || req_len != 5 + req[4])
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint8_t ex = check_range(start, count, MAX_WRITE_BITS);
+    if (ex != OCRE_MODBUS_EX_NONE)
+    {
+        return ex;
+    }
+    ex = server->map->write_bits(server->user_data, start, count, &req[5]);
+    if (ex == OCRE_MODBUS_EX_NONE)
+    {
+        memcpy(res, req, 4); // Start and quantity
+        *res_len = 4;
+    }
+    return ex;
+}
+
+static uint8_t write_multiple_registers(ocre_modbus_server_t *server, const uint8_t *req, uint16_t req_len,
+                                        uint8_t *res, uint16_t *res_len)
+{
+    if (server->map->write_registers == NULL)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_FUNCTION;
+    }
+    if (req_len < 5)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint16_t start = get_u16(&req[0]);
+    uint16_t count = get_u16(&req[2]);
+    if (req[4] != count * 2 || req_len != 5 + req[4])
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint8_t ex = check_range(start, count, MAX_WRITE_REGISTERS);
+    if (ex != OCRE_MODBUS_EX_NONE)
+    {
+        return ex;
+    }
+    uint16_t values[MAX_WRITE_REGISTERS];
+    for (uint16_t i = 0; i < count; i++)
+    {
+        values[i] = get_u16(&req[5 + 2 * i]);
+    }
+    ex = server->map->write_registers(server->user_data, start, count, values);
+    if (ex == OCRE_MODBUS_EX_NONE)
+    {
+        memcpy(res, req, 4); // Start and quantity
+        *res_len = 4;
+    }
+    return ex;
+}
+
+static uint8_t read_write_multiple_registers(ocre_modbus_server_t *server, const uint8_t *req, uint16_t req_len,
+                                             uint8_t *res, uint16_t *res_len)
+{
+    if (server->map->read_registers == NULL || server->map->write_registers == NULL)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_FUNCTION;
+    }
+    if (req_len < 9)
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint16_t read_start = get_u16(&req[0]);
+    uint16_t read_count = get_u16(&req[2]);
+    uint16_t write_start = get_u16(&req[4]);
+    uint16_t write_count = get_u16(&req[6]);
+    if (req[8] != write_count * 2 || req_len != 9 + req[8])
+    {
+        return OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE;
+    }
+    uint8_t ex = check_range(read_start, read_count, MAX_READ_REGISTERS);
+    if (ex == OCRE_MODBUS_EX_NONE)
+    {
+        ex = check_range(write_start, write_count, MAX_RW_WRITE_REGISTERS);
+    }
+    if (ex != OCRE_MODBUS_EX_NONE)
+    {
+        return ex;
+    }
+    uint16_t values[MAX_READ_REGISTERS];
+    for (uint16_t i = 0; i < write_count; i++)
+    {
+        values[i] = get_u16(&req[9 + 2 * i]);
+    }
+    // The write is performed before the read
+    ex = server->map->write_registers(server->user_data, write_start, write_count, values);
+    if (ex != OCRE_MODBUS_EX_NONE)
+    {
+        return ex;
+    }
+    return read_registers(server, OCRE_MODBUS_HOLDING_REGISTERS, req, 4, res, res_len);
+}
+
+// =============================================================================
+// SERVER
+// =============================================================================
+
+int ocre_modbus_server_init(ocre_modbus_server_t *server, const ocre_modbus_map_t *map, void *user_data)
+{
+    if (server == NULL || map == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    server->map = map;
+    server->user_data = user_data;
+    return OCRE_SUCCESS;
+}
+
+size_t ocre_modbus_server_handle(ocre_modbus_server_t *server, const uint8_t *adu, size_t len, uint8_t *out)
+{
+    if (len < OCRE_MODBUS_MBAP_SIZE + 1)
+    {
+        return 0;
+    }
+    uint8_t function_code = adu[OCRE_MODBUS_MBAP_SIZE];
+    const uint8_t *req = &adu[OCRE_MODBUS_MBAP_SIZE + 1];
+    uint16_t req_len = len - OCRE_MODBUS_MBAP_SIZE - 1;
+    uint8_t *res = &out[OCRE_MODBUS_MBAP_SIZE + 1];
+    uint16_t res_len = 0;
+    uint8_t ex;
+
+    switch (function_code)
+    {
+    case OCRE_MODBUS_FC_READ_COILS:
+        ex = read_bits(server, OCRE_MODBUS_COILS, req, req_len, res, &res_len);
+        break;
+    case OCRE_MODBUS_FC_READ_DISCRETE_INPUTS:
+        ex = read_bits(server, OCRE_MODBUS_DISCRETE_INPUTS, req, req_len, res, &res_len);
+        break;
+    case OCRE_MODBUS_FC_READ_HOLDING_REGISTERS:
+        ex = read_registers(server, OCRE_MODBUS_HOLDING_REGISTERS, req, req_len, res, &res_len);
+        break;
+    case OCRE_MODBUS_FC_READ_INPUT_REGISTERS:
+        ex = read_registers(server, OCRE_MODBUS_INPUT_REGISTERS, req, req_len, res, &res_len);
+        break;
+    case OCRE_MODBUS_FC_WRITE_SINGLE_COIL:
+        ex = write_single_coil(server, req, req_len, res, &res_len);
+        break;
+    case OCRE_MODBUS_FC_WRITE_SINGLE_REGISTER:
+        ex = write_single_register(server, req, req_len, res, &res_len);
+        break;
+    case OCRE_MODBUS_FC_WRITE_MULTIPLE_COILS:
+        ex = write_multiple_coils(server, req, req_len, res, &res_len);
+        break;
+    case OCRE_MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+        ex = write_multiple_registers(server, req, req_len, res, &res_len);
+        break;
+    case OCRE_MODBUS_FC_READ_WRITE_MULTIPLE_REGISTERS:
+        ex = read_write_multiple_registers(server, req, req_len, res, &res_len);
+        break;
+    default:
+        ex = OCRE_MODBUS_EX_ILLEGAL_FUNCTION;
+        break;
+    }
+
+    if (ex != OCRE_MODBUS_EX_NONE)
+    {
+        function_code |= 0x80;
+        res[0] = ex;
+        res_len = 1;
+    }
+    memcpy(out, adu, 4); // Transaction and protocol IDs
+    put_u16(&out[4], 2 + res_len);
+    out[6] = adu[6]; // Unit ID
+    out[7] = function_code;
+    return OCRE_MODBUS_MBAP_SIZE + 1 + res_len;
+}
+
+int ocre_modbus_server_process(ocre_modbus_server_t *server, const uint8_t *in, size_t len, uint8_t *out,
+                               size_t out_size, size_t *out_len)
+{
+    size_t offset = 0;
+    *out_len = 0;
+    while (len - offset >= OCRE_MODBUS_MBAP_SIZE && out_size - *out_len >= OCRE_MODBUS_MAX_ADU_SIZE)
+    {
+        const uint8_t *adu = &in[offset];
+        uint16_t length = get_u16(&adu[4]); // Unit ID and PDU
+        if (get_u16(&adu[2]) != 0 || length < 2 || MBAP_PREFIX + length > OCRE_MODBUS_MAX_ADU_SIZE)
+        {
+            return OCRE_ERROR_INVALID; // Framing is lost, nothing after this can be trusted
+        }
+        size_t adu_len = MBAP_PREFIX + length;
+        if (len - offset < adu_len)
+        {
+            break; // Partial frame, keep it until the rest arrives
+        }
+        *out_len += ocre_modbus_server_handle(server, adu, adu_len, &out[*out_len]);
+        offset += adu_len;
+    }
+    return (int)offset;
+}
+
+// =============================================================================
+// CLIENT
+// =============================================================================
+
+int ocre_modbus_client_init(ocre_modbus_client_t *client, ocre_modbus_transaction_t *transactions,
+                            uint16_t transaction_count, uint32_t timeout_ms, ocre_modbus_send_t send, void *io)
+{
+    if (client == NULL || transactions == NULL || transaction_count == 0 || send == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    memset(transactions, 0, transaction_count * sizeof(ocre_modbus_transaction_t));
+    client->transactions = transactions;
+    client->transaction_count = transaction_count;
+    client->pending = 0;
+    client->next_transaction_id = 1;
+    client->timeout_ms = timeout_ms;
+    client->send = send;
+    client->io = io;
+    return OCRE_SUCCESS;
+}
+
+// Free a slot and report its result; the slot is released first so the callback can reuse it
+static void client_complete(ocre_modbus_client_t *client, ocre_modbus_transaction_t *t,
+                            ocre_modbus_result_t *result)
+{
+    ocre_modbus_client_callback_t callback = t->callback;
+    void *user_data = t->user_data;
+    result->unit_id = t->unit_id;
+    result->function = t->function;
+    result->start = t->start;
+    result->count = t->count;
+    t->in_use = 0;
+    client->pending--;
+    if (callback != NULL)
+    {
+        callback(client, result, user_data);
+    }
+}
+
+static void client_fail(ocre_modbus_client_t *client, ocre_modbus_transaction_t *t, uint8_t status)
+{
+    ocre_modbus_result_t result = {.status = status};
+    client_complete(client, t, &result);
+}
+
+// Send a request whose PDU follows the MBAP header in adu
+static int client_send(ocre_modbus_client_t *client, uint8_t unit_id, uint8_t *adu, uint16_t pdu_len,
+                       uint16_t start, uint16_t count, ocre_modbus_client_callback_t callback, void *user_data)
+{
+    ocre_modbus_transaction_t *t = NULL;
+    for (uint16_t i = 0; i < client->transaction_count; i++)
+    {
+        if (!client->transactions[i].in_use)
+        {
+            t = &client->transactions[i];
+            break;
+        }
+    }
+    if (t == NULL)
+    {
+        return OCRE_ERROR_BUSY;
+    }
+
+    uint16_t transaction_id = client->next_transaction_id++;
+    put_u16(&adu[0], transaction_id);
+    put_u16(&adu[2], 0); // Protocol ID
+    put_u16(&adu[4], 1 + pdu_len);
+    adu[6] = unit_id;
+    int ret = client->send(client->io, adu, OCRE_MODBUS_MBAP_SIZE + pdu_len);
+    if (ret != OCRE_SUCCESS)
+    {
+        return ret < 0 ? ret : OCRE_ERROR_INVALID;
+    }
+
+    t->callback = callback;
+    t->user_data = user_data;
+    t->deadline_us = ocre_time_us() + (uint64_t)client->timeout_ms * 1000;
+    t->transaction_id = transaction_id;
+    t->start = start;
+    t->count = count;
+    t->unit_id = unit_id;
+    t->function = adu[OCRE_MODBUS_MBAP_SIZE];
+    t->in_use = 1;
+    client->pending++;
+    return OCRE_SUCCESS;
+}
+
+int ocre_modbus_client_read(ocre_modbus_client_t *client, uint8_t unit_id, ocre_modbus_table_t table,
+                            uint16_t start, uint16_t count, ocre_modbus_client_callback_t callback, void *user_data)
+{
+    static const uint8_t functions[] = {
+        [OCRE_MODBUS_COILS] = OCRE_MODBUS_FC_READ_COILS,
+        [OCRE_MODBUS_DISCRETE_INPUTS] = OCRE_MODBUS_FC_READ_DISCRETE_INPUTS,
+        [OCRE_MODBUS_HOLDING_REGISTERS] = OCRE_MODBUS_FC_READ_HOLDING_REGISTERS,
+        [OCRE_MODBUS_INPUT_REGISTERS] = OCRE_MODBUS_FC_READ_INPUT_REGISTERS,
+    };
+    if (client == NULL || (unsigned)table > OCRE_MODBUS_INPUT_REGISTERS)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint16_t max = table <= OCRE_MODBUS_DISCRETE_INPUTS ? MAX_READ_BITS : MAX_READ_REGISTERS;
+    if (check_range(start, count, max) != OCRE_MODBUS_EX_NONE)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint8_t adu[OCRE_MODBUS_MBAP_SIZE + 5];
+    uint8_t *pdu = &adu[OCRE_MODBUS_MBAP_SIZE];
+    pdu[0] = functions[table];
+    put_u16(&pdu[1], start);
+    put_u16(&pdu[3], count);
+    return client_send(client, unit_id, adu, 5, start, count, callback, user_data);
+}
+
+int ocre_modbus_client_write_registers(ocre_modbus_client_t *client, uint8_t unit_id, uint16_t start,
+                                       uint16_t count, const uint16_t *values, ocre_modbus_client_callback_t callback,
+                                       void *user_data)
+{
+    if (client == NULL || values == NULL || check_range(start, count, MAX_WRITE_REGISTERS) != OCRE_MODBUS_EX_NONE)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint8_t adu[OCRE_MODBUS_MAX_ADU_SIZE];
+    uint8_t *pdu = &adu[OCRE_MODBUS_MBAP_SIZE];
+    uint16_t pdu_len;
+    put_u16(&pdu[1], start);
+    if (count == 1)
+    {
+        pdu[0] = OCRE_MODBUS_FC_WRITE_SINGLE_REGISTER;
+        put_u16(&pdu[3], values[0]);
+        pdu_len = 5;
+    }
+    else
+    {
+        pdu[0] = OCRE_MODBUS_FC_WRITE_MULTIPLE_REGISTERS;
+        put_u16(&pdu[3], count);
+        pdu[5] = count * 2;
+        for (uint16_t i = 0; i < count; i++)
+        {
+            put_u16(&pdu[6 + 2 * i], values[i]);
+        }
+        pdu_len = 6 + count * 2;
+    }
+    return client_send(client, unit_id, adu, pdu_len, start, count, callback, user_data);
+}
+
+int ocre_modbus_client_write_coils(ocre_modbus_client_t *client, uint8_t unit_id, uint16_t start, uint16_t count,
+                                   const uint8_t *bits, ocre_modbus_client_callback_t callback, void *user_data)
+{
+    if (client == NULL || bits == NULL || check_range(start, count, MAX_WRITE_BITS) != OCRE_MODBUS_EX_NONE)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint8_t adu[OCRE_MODBUS_MAX_ADU_SIZE];
+    uint8_t *pdu = &adu[OCRE_MODBUS_MBAP_SIZE];
+    uint16_t pdu_len;
+    put_u16(&pdu[1], start);
+    if (count == 1)
+    {
+        pdu[0] = OCRE_MODBUS_FC_WRITE_SINGLE_COIL;
+        put_u16(&pdu[3], (bits[0] & 1) ? 0xFF00 : 0x0000);
+        pdu_len = 5;
+    }
+    else
+    {
+        uint8_t byte_count = (count + 7) / 8;
+        pdu[0] = OCRE_MODBUS_FC_WRITE_MULTIPLE_COILS;
+        put_u16(&pdu[3], count);
+        pdu[5] = byte_count;
+        memcpy(&pdu[6], bits, byte_count);
+        if (count % 8)
+        {
+            pdu[5 + byte_count] &= (1 << (count % 8)) - 1; // Unused bits must be zero
+        }
+        pdu_len = 6 + byte_count;
+    }
+    return client_send(client, unit_id, adu, pdu_len, start, count, callback, user_data);
+}
+
+// Check a response PDU against its request and fill in the result data
+static uint8_t client_decode(ocre_modbus_client_t *client, const ocre_modbus_transaction_t *t, const uint8_t *pdu,
+                             uint16_t pdu_len, ocre_modbus_result_t *result)
+{
+    if ((pdu[0] & 0x7F) != t->function)
+    {
+        return OCRE_MODBUS_STATUS_BAD_RESPONSE;
+    }
+    if (pdu[0] & 0x80)
+    {
+        return pdu_len == 2 ? pdu[1] : OCRE_MODBUS_STATUS_BAD_RESPONSE;
+    }
+
+    switch (t->function)
+    {
+    case OCRE_MODBUS_FC_READ_COILS:
+    case OCRE_MODBUS_FC_READ_DISCRETE_INPUTS:
+        if (pdu_len < 2 || pdu[1] != (t->count + 7) / 8 || pdu_len != 2 + pdu[1])
+        {
+            return OCRE_MODBUS_STATUS_BAD_RESPONSE;
+        }
+        result->bits = &pdu[2];
+        return OCRE_MODBUS_EX_NONE;
+    case OCRE_MODBUS_FC_READ_HOLDING_REGISTERS:
+    case OCRE_MODBUS_FC_READ_INPUT_REGISTERS:
+        if (pdu_len < 2 || pdu[1] != t->count * 2 || pdu_len != 2 + pdu[1])
+        {
+            return OCRE_MODBUS_STATUS_BAD_RESPONSE;
+        }
+        for (uint16_t i = 0; i < t->count; i++)
+        {
+            client->values[i] = get_u16(&pdu[2 + 2 * i]);
+        }
+        result->registers = client->values;
+        return OCRE_MODBUS_EX_NONE;
+    case OCRE_MODBUS_FC_WRITE_SINGLE_COIL:
+    case OCRE_MODBUS_FC_WRITE_SINGLE_REGISTER:
+        // Echo of the request, check the address only
+        return pdu_len == 5 && get_u16(&pdu[1]) == t->start ? OCRE_MODBUS_EX_NONE : OCRE_MODBUS_STATUS_BAD_RESPONSE;
+    default:
+        return pdu_len == 5 && get_u16(&pdu[1]) == t->start && get_u16(&pdu[3]) == t->count
+                   ? OCRE_MODBUS_EX_NONE
+                   : OCRE_MODBUS_STATUS_BAD_RESPONSE;
+    }
+}
+
+int ocre_modbus_client_process(ocre_modbus_client_t *client, const uint8_t *in, size_t len)
+{
+    size_t offset = 0;
+    while (len - offset >= OCRE_MODBUS_MBAP_SIZE)
+    {
+        const uint8_t *adu = &in[offset];
+        uint16_t length = get_u16(&adu[4]); // Unit ID and PDU
+        if (get_u16(&adu[2]) != 0 || length < 2 || MBAP_PREFIX + length > OCRE_MODBUS_MAX_ADU_SIZE)
+        {
+            return OCRE_ERROR_INVALID; // Framing is lost, nothing after this can be trusted
+        }
+        size_t adu_len = MBAP_PREFIX + length;
+        if (len - offset < adu_len)
+        {
+            break; // Partial frame, keep it until the rest arrives
+        }
+        offset += adu_len;
+
+        uint16_t transaction_id = get_u16(&adu[0]);
+        for (uint16_t i = 0; i < client->transaction_count; i++)
+        {
+            ocre_modbus_transaction_t *t = &client->transactions[i];
+            if (t->in_use && t->transaction_id == transaction_id)
+            {
+                ocre_modbus_result_t result = {0};
+                result.status = adu[6] == t->unit_id
+                                    ? client_decode(client, t, &adu[OCRE_MODBUS_MBAP_SIZE], length - 1, &result)
+                                    : OCRE_MODBUS_STATUS_BAD_RESPONSE;
+                if (result.status != OCRE_MODBUS_EX_NONE)
+                {
+                    result.registers = NULL;
+                    result.bits = NULL;
+                }
+                client_complete(client, t, &result);
+                break;
+            }
+        }
+    }
+    return (int)offset;
+}
+
+int ocre_modbus_client_poll(ocre_modbus_client_t *client)
+{
+    if (client == NULL || client->pending == 0)
+    {
+        return 0;
+    }
+    uint64_t now = ocre_time_us();
+    int expired = 0;
+    for (uint16_t i = 0; i < client->transaction_count; i++)
+    {
+        ocre_modbus_transaction_t *t = &client->transactions[i];
+        if (t->in_use && now >= t->deadline_us)
+        {
+            client_fail(client, t, OCRE_MODBUS_STATUS_TIMEOUT);
+            expired++;
+        }
+    }
+    return expired;
+}
+
+void ocre_modbus_client_reset(ocre_modbus_client_t *client)
+{
+    if (client == NULL)
+    {
+        return;
+    }
+    for (uint16_t i = 0; i < client->transaction_count; i++)
+    {
+        if (client->transactions[i].in_use)
+        {
+            client_fail(client, &client->transactions[i], OCRE_MODBUS_STATUS_CLOSED);
+        }
+    }
+}
+
+// =============================================================================
+// POLL SCHEDULE
+// =============================================================================
+
+// Extend a request to cover a range if the result stays within one read
+static int block_merge(ocre_modbus_poll_block_t *block, uint8_t unit_id, uint8_t table, uint16_t start,
+                       uint16_t count, uint16_t max_gap)
+{
+    uint32_t end = (uint32_t)start + count;
+    uint32_t block_end = (uint32_t)block->start + block->count;
+    if (block->unit_id != unit_id || block->table != table || start > block_end + max_gap ||
+        block->start > end + max_gap)
+    {
+        return 0;
+    }
+    uint16_t merged_start = start < block->start ? start : block->start;
+    uint32_t merged_end = end > block_end ? end : block_end;
+    if (merged_end - merged_start > MAX_READ_REGISTERS)
+    {
+        return 0;
+    }
+    block->start = merged_start;
+    block->count = merged_end - merged_start;
+    return 1;
+}
+
+int ocre_modbus_schedule_init(ocre_modbus_schedule_t *schedule, ocre_modbus_client_t *client,
+                              ocre_modbus_poll_item_t *items, uint16_t item_count, ocre_modbus_poll_block_t *blocks,
+                              uint16_t max_blocks, uint16_t max_gap, uint32_t interval_ms,
+                              ocre_modbus_schedule_callback_t callback, void *user_data)
+{
+    if (schedule == NULL || client == NULL || items == NULL || item_count == 0 || blocks == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+
+    uint16_t block_count = 0;
+    for (uint16_t i = 0; i < item_count; i++)
+    {
+        ocre_modbus_poll_item_t *item = &items[i];
+        if (item->values == NULL ||
+            (item->table != OCRE_MODBUS_HOLDING_REGISTERS && item->table != OCRE_MODBUS_INPUT_REGISTERS) ||
+            check_range(item->start, item->count, MAX_READ_REGISTERS) != OCRE_MODBUS_EX_NONE)
+        {
+            return OCRE_ERROR_INVALID;
+        }
+        // Join the first request of the same unit and table that stays within one read
+        uint16_t b;
+        for (b = 0; b < block_count; b++)
+        {
+            if (block_merge(&blocks[b], item->unit_id, item->table, item->start, item->count, max_gap))
+            {
+                break;
+            }
+        }
+        if (b == block_count)
+        {
+            if (block_count == max_blocks)
+            {
+                return OCRE_ERROR_NO_MEMORY;
+            }
+            blocks[b].start = item->start;
+            blocks[b].count = item->count;
+            blocks[b].unit_id = item->unit_id;
+            blocks[b].table = item->table;
+            block_count++;
+        }
+        item->block = b;
+        item->status = OCRE_MODBUS_STATUS_TIMEOUT; // Nothing read yet
+    }
+
+    // A request that grew may now reach another one, join those until nothing changes
+    for (uint16_t a = 0; a < block_count; a++)
+    {
+        for (uint16_t b = a + 1; b < block_count; b++)
+        {
+            if (!block_merge(&blocks[a], blocks[b].unit_id, blocks[b].table, blocks[b].start, blocks[b].count,
+                             max_gap))
+            {
+                continue;
+            }
+            // Drop b by moving the last request into its place
+            block_count--;
+            for (uint16_t i = 0; i < item_count; i++)
+            {
+                if (items[i].block == b)
+                {
+                    items[i].block = a;
+                }
+                else if (items[i].block == block_count)
+                {
+                    items[i].block = b;
+                }
+            }
+            blocks[b] = blocks[block_count];
+            a = UINT16_MAX; // Start over, wraps to 0
+            break;
+        }
+    }
+
+    for (uint16_t b = 0; b < block_count; b++)
+    {
+        blocks[b].schedule = schedule;
+        blocks[b].due = 0;
+        blocks[b].in_flight = 0;
+    }
+    schedule->client = client;
+    schedule->items = items;
+    schedule->item_count = item_count;
+    schedule->blocks = blocks;
+    schedule->block_count = block_count;
+    schedule->interval_ms = interval_ms;
+    schedule->next_poll_us = ocre_time_us();
+    schedule->callback = callback;
+    schedule->user_data = user_data;
+    return block_count;
+}
+
+// Scatter a merged read back to the items it covers
+static void schedule_complete(ocre_modbus_client_t *client, const ocre_modbus_result_t *result, void *user_data)
+{
+    ocre_modbus_poll_block_t *block = user_data;
+    ocre_modbus_schedule_t *schedule = block->schedule;
+    uint16_t index = block - schedule->blocks;
+    block->in_flight = 0;
+
+    for (uint16_t i = 0; i < schedule->item_count; i++)
+    {
+        ocre_modbus_poll_item_t *item = &schedule->items[i];
+        if (item->block != index)
+        {
+            continue;
+        }
+        if (result->status == OCRE_MODBUS_EX_NONE)
+        {
+            memcpy(item->values, &result->registers[item->start - block->start], item->count * sizeof(uint16_t));
+        }
+        item->status = result->status;
+        if (schedule->callback != NULL)
+        {
+            schedule->callback(schedule, item, schedule->user_data);
+        }
+    }
+}
+
+int ocre_modbus_schedule_run(ocre_modbus_schedule_t *schedule)
+{
+    if (schedule == NULL)
+    {
+        return 0;
+    }
+    uint64_t now = ocre_time_us();
+    if (now >= schedule->next_poll_us)
+    {
+        for (uint16_t b = 0; b < schedule->block_count; b++)
+        {
+            // A request still outstanding from the last period is not repeated
+            schedule->blocks[b].due = !schedule->blocks[b].in_flight;
+        }
+        schedule->next_poll_us += (uint64_t)schedule->interval_ms * 1000;
+        if (schedule->next_poll_us <= now)
+        {
+            schedule->next_poll_us = now + (uint64_t)schedule->interval_ms * 1000; // Fell behind, skip periods
+        }
+    }
+
+    int sent = 0;
+    for (uint16_t b = 0; b < schedule->block_count; b++)
+    {
+        ocre_modbus_poll_block_t *block = &schedule->blocks[b];
+        if (!block->due || block->in_flight)
+        {
+            continue;
+        }
+        int ret = ocre_modbus_client_read(schedule->client, block->unit_id, block->table, block->start,
+                                          block->count, schedule_complete, block);
+        if (ret == OCRE_ERROR_BUSY)
+        {
+            break; // Retried when a slot frees up
+        }
+        block->due = 0;
+        if (ret == OCRE_SUCCESS)
+        {
+            block->in_flight = 1;
+            sent++;
+        }
+    }
+    return sent;
+}
+
+// =============================================================================
+// REGISTER HELPERS
+// =============================================================================
+
+void ocre_modbus_float_to_registers(float value, uint16_t *regs)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    regs[0] = bits & 0xFFFF; // Low word first
+    regs[1] = bits >> 16;
+}
+
+float ocre_modbus_registers_to_float(const uint16_t *regs)
+{
+    uint32_t bits = ((uint32_t)regs[1] << 16) | regs[0];
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
@@ -0,0 +1,434 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#ifndef OCRE_MODBUS_H
+#define OCRE_MODBUS_H
+
+#include "ocre_api.h"
+#include <stddef.h>
+
+/**
+ * @file ocre_modbus.h
+ * @brief Transport-independent Modbus TCP server and client engines.
+ *
+ * The server frames requests by their MBAP header, decodes the function codes below and
+ * answers them through a register-map callback table. Feed it the bytes received on a
+ * connection and send what it writes back; any TCP stack, such as mongoose, can carry it.
+ *
+ * The client keeps several transactions outstanding on one connection and matches the
+ * responses by transaction ID. A poll schedule on top of it merges register ranges into
+ * as few requests as possible. Use one client per connection to poll many devices.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define OCRE_MODBUS_MBAP_SIZE 7      /**< MBAP header, including the unit ID */
+#define OCRE_MODBUS_MAX_ADU_SIZE 260 /**< Largest Modbus TCP frame */
+
+// Function codes
+#define OCRE_MODBUS_FC_READ_COILS 0x01
+#define OCRE_MODBUS_FC_READ_DISCRETE_INPUTS 0x02
+#define OCRE_MODBUS_FC_READ_HOLDING_REGISTERS 0x03
+#define OCRE_MODBUS_FC_READ_INPUT_REGISTERS 0x04
+#define OCRE_MODBUS_FC_WRITE_SINGLE_COIL 0x05
+#define OCRE_MODBUS_FC_WRITE_SINGLE_REGISTER 0x06
+#define OCRE_MODBUS_FC_WRITE_MULTIPLE_COILS 0x0F
+#define OCRE_MODBUS_FC_WRITE_MULTIPLE_REGISTERS 0x10
+#define OCRE_MODBUS_FC_READ_WRITE_MULTIPLE_REGISTERS 0x17
+
+// Exception codes, returned by the register-map callbacks
+#define OCRE_MODBUS_EX_NONE 0x00                 /**< Request succeeded */
+#define OCRE_MODBUS_EX_ILLEGAL_FUNCTION 0x01     /**< Function not supported */
+#define OCRE_MODBUS_EX_ILLEGAL_DATA_ADDRESS 0x02 /**< Address range outside the map */
+#define OCRE_MODBUS_EX_ILLEGAL_DATA_VALUE 0x03   /**< Bad quantity or value */
+#define OCRE_MODBUS_EX_DEVICE_FAILURE 0x04       /**< The request failed in the device */
+
+    /**
+     * @brief Modbus data tables
+     */
+    typedef enum
+    {
+        OCRE_MODBUS_COILS,             /**< Read/write bits */
+        OCRE_MODBUS_DISCRETE_INPUTS,   /**< Read-only bits */
+        OCRE_MODBUS_HOLDING_REGISTERS, /**< Read/write 16-bit registers */
+        OCRE_MODBUS_INPUT_REGISTERS    /**< Read-only 16-bit registers */
+    } ocre_modbus_table_t;
+
+    /**
+     * @brief Register-map callbacks of a server
+     *
+     * Each callback returns OCRE_MODBUS_EX_NONE or the exception code to answer with.
+     * Leave a callback NULL to reject its function codes with OCRE_MODBUS_EX_ILLEGAL_FUNCTION.
+     */
+    typedef struct
+    {
+        /**
+         * @brief Read holding or input registers
+         * @param user_data Pointer given to ocre_modbus_server_init()
+         * @param table OCRE_MODBUS_HOLDING_REGISTERS or OCRE_MODBUS_INPUT_REGISTERS
+         * @param start First register address
+         * @param count Number of registers, 1 to 125
+         * @param values Receives @p count register values
+         */
+        uint8_t (*read_registers)(void *user_data, ocre_modbus_table_t table, uint16_t start, uint16_t count,
+                                  uint16_t *values);
+
+        /**
+         * @brief Write holding registers; all registers of a request are passed in one call
+         * @param user_data Pointer given to ocre_modbus_server_init()
+         * @param start First register address
+         * @param count Number of registers, 1 to 123
+         * @param values New register values
+         */
+        uint8_t (*write_registers)(void *user_data, uint16_t start, uint16_t count, const uint16_t *values);
+
+        /**
+         * @brief Read coils or discrete inputs
+         * @param user_data Pointer given to ocre_modbus_server_init()
+         * @param table OCRE_MODBUS_COILS or OCRE_MODBUS_DISCRETE_INPUTS
+         * @param start First bit address
+         * @param count Number of bits, 1 to 2000
+         * @param bits Receives the bits packed LSB first, zero-filled on entry
+         */
+        uint8_t (*read_bits)(void *user_data, ocre_modbus_table_t table, uint16_t start, uint16_t count,
+                             uint8_t *bits);
+
+        /**
+         * @brief Write coils
+         * @param user_data Pointer given to ocre_modbus_server_init()
+         * @param start First coil address
+         * @param count Number of coils, 1 to 1968
+         * @param bits New coil states packed LSB first
+         */
+        uint8_t (*write_bits)(void *user_data, uint16_t start, uint16_t count, const uint8_t *bits);
+    } ocre_modbus_map_t;
+
+    /**
+     * @brief Modbus TCP server state
+     */
+    typedef struct
+    {
+        const ocre_modbus_map_t *map; /**< Register-map callbacks */
+        void *user_data;              /**< Passed back to the callbacks */
+    } ocre_modbus_server_t;
+
+    /**
+     * @brief Initialize a server
+     * @param server Server to initialize
+     * @param map Register-map callbacks, kept by reference
+     * @param user_data Pointer passed back to the callbacks
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on bad parameters
+     */
+    int ocre_modbus_server_init(ocre_modbus_server_t *server, const ocre_modbus_map_t *map, void *user_data);
+
+    /**
+     * @brief Answer every complete request at the start of a receive buffer
+     *
+     * Pipelined requests are handled in order and their responses appended to @p out.
+     * A trailing partial frame is left unconsumed. Processing stops early when @p out
+     * has less than OCRE_MODBUS_MAX_ADU_SIZE bytes left, so call again after sending.
+     *
+     * @param server Server state
+     * @param in Received bytes
+     * @param len Number of bytes in @p in
+     * @param out Receives the responses
+     * @param out_size Capacity of @p out, at least OCRE_MODBUS_MAX_ADU_SIZE
+     * @param out_len Receives the number of bytes written to @p out
+     * @return Bytes of @p in consumed, OCRE_ERROR_INVALID if the framing is broken and the
+     *         connection should be closed
+     */
+    int ocre_modbus_server_process(ocre_modbus_server_t *server, const uint8_t *in, size_t len, uint8_t *out,
+                                   size_t out_size, size_t *out_len);
+
+    /**
+     * @brief Answer one complete request ADU
+     * @param server Server state
+     * @param adu Request, MBAP header included
+     * @param len Length of @p adu as given by its MBAP header
+     * @param out Receives the response, room for OCRE_MODBUS_MAX_ADU_SIZE bytes
+     * @return Response length, 0 if the request is too malformed to answer
+     */
+    size_t ocre_modbus_server_handle(ocre_modbus_server_t *server, const uint8_t *adu, size_t len, uint8_t *out);
+
+    // =============================================================================
+    // Client
+    // =============================================================================
+
+#define OCRE_MODBUS_STATUS_TIMEOUT 0xF0      /**< No response within the request timeout */
+#define OCRE_MODBUS_STATUS_BAD_RESPONSE 0xF1 /**< Response does not match its request */
+#define OCRE_MODBUS_STATUS_CLOSED 0xF2       /**< Client reset with the request outstanding */
+
+    typedef struct ocre_modbus_client ocre_modbus_client_t;
+
+    /**
+     * @brief Outcome of a client request
+     */
+    typedef struct
+    {
+        uint8_t status;            /**< OCRE_MODBUS_EX_NONE, an exception code or an OCRE_MODBUS_STATUS_* */
+        uint8_t unit_id;           /**< Unit the request was sent to */
+        uint8_t function;          /**< Function code of the request */
+        uint16_t start;            /**< First address of the request */
+        uint16_t count;            /**< Quantity of the request */
+        const uint16_t *registers; /**< Values of a successful register read, otherwise NULL */
+        const uint8_t *bits;       /**< Packed bits of a successful coil or input read, otherwise NULL */
+    } ocre_modbus_result_t;
+
+    /**
+     * @brief Completion callback of a client request
+     *
+     * Called exactly once per request. The result data is only valid during the call.
+     * New requests may be issued from the callback.
+     */
+    typedef void (*ocre_modbus_client_callback_t)(ocre_modbus_client_t *client, const ocre_modbus_result_t *result,
+                                                  void *user_data);
+
+    /**
+     * @brief Transport send function of a client
+     * @param io Pointer given to ocre_modbus_client_init()
+     * @param data Complete request ADU
+     * @param len Length of @p data
+     * @return OCRE_SUCCESS when the request was queued for sending, negative error code otherwise
+     */
+    typedef int (*ocre_modbus_send_t)(void *io, const uint8_t *data, size_t len);
+
+    /**
+     * @brief Outstanding transaction slot, owned by the caller and managed by the client
+     */
+    typedef struct
+    {
+        ocre_modbus_client_callback_t callback;
+        void *user_data;
+        uint64_t deadline_us;
+        uint16_t transaction_id;
+        uint16_t start;
+        uint16_t count;
+        uint8_t unit_id;
+        uint8_t function;
+        uint8_t in_use;
+    } ocre_modbus_transaction_t;
+
+    /**
+     * @brief Modbus TCP client state, one per connection
+     */
+    struct ocre_modbus_client
+    {
+        ocre_modbus_transaction_t *transactions; /**< Slots, one per outstanding request */
+        uint16_t transaction_count;              /**< Number of slots */
+        uint16_t pending;                        /**< Requests awaiting a response */
+        uint16_t next_transaction_id;            /**< ID of the next request */
+        uint32_t timeout_ms;                     /**< Per-request timeout */
+        ocre_modbus_send_t send;                 /**< Transport send function */
+        void *io;                                /**< Passed to @ref send */
+        uint16_t values[125];                    /**< Registers of the response being delivered */
+    };
+
+    /**
+     * @brief Initialize a client
+     * @param client Client to initialize
+     * @param transactions Caller-owned slots; their number caps the outstanding requests
+     * @param transaction_count Number of slots
+     * @param timeout_ms Time a request may wait for its response
+     * @param send Transport send function
+     * @param io Pointer passed to @p send, such as a connection
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on bad parameters
+     */
+    int ocre_modbus_client_init(ocre_modbus_client_t *client, ocre_modbus_transaction_t *transactions,
+                                uint16_t transaction_count, uint32_t timeout_ms, ocre_modbus_send_t send, void *io);
+
+    /**
+     * @brief Read coils, discrete inputs, holding or input registers
+     * @param client Client state
+     * @param unit_id Unit to address
+     * @param table Table to read
+     * @param start First address
+     * @param count Quantity, up to 2000 bits or 125 registers
+     * @param callback Called with the result
+     * @param user_data Pointer passed to @p callback
+     * @return OCRE_SUCCESS if sent, OCRE_ERROR_BUSY if all slots are in use,
+     *         OCRE_ERROR_INVALID on bad parameters or the send function's error
+     */
+    int ocre_modbus_client_read(ocre_modbus_client_t *client, uint8_t unit_id, ocre_modbus_table_t table,
+                                uint16_t start, uint16_t count, ocre_modbus_client_callback_t callback,
+                                void *user_data);
+
+    /**
+     * @brief Write holding registers, with FC 0x06 for one register and FC 0x10 otherwise
+     * @param client Client state
+     * @param unit_id Unit to address
+     * @param start First register
+     * @param count Number of registers, up to 123
+     * @param values Register values, copied into the request
+     * @param callback Called with the result
+     * @param user_data Pointer passed to @p callback
+     * @return As ocre_modbus_client_read()
+     */
+    int ocre_modbus_client_write_registers(ocre_modbus_client_t *client, uint8_t unit_id, uint16_t start,
+                                           uint16_t count, const uint16_t *values,
+                                           ocre_modbus_client_callback_t callback, void *user_data);
+
+    /**
+     * @brief Write coils, with FC 0x05 for one coil and FC 0x0F otherwise
+     * @param client Client state
+     * @param unit_id Unit to address
+     * @param start First coil
+     * @param count Number of coils, up to 1968
+     * @param bits Coil states packed LSB first, copied into the request
+     * @param callback Called with the result
+     * @param user_data Pointer passed to @p callback
+     * @return As ocre_modbus_client_read()
+     */
+    int ocre_modbus_client_write_coils(ocre_modbus_client_t *client, uint8_t unit_id, uint16_t start,
+                                       uint16_t count, const uint8_t *bits, ocre_modbus_client_callback_t callback,
+                                       void *user_data);
+
+    /**
+     * @brief Deliver every complete response at the start of a receive buffer
+     *
+     * Responses may arrive in any order. Responses to unknown transaction IDs, such as
+     * late answers to timed-out requests, are discarded. A trailing partial frame is left
+     * unconsumed.
+     *
+     * @param client Client state
+     * @param in Received bytes
+     * @param len Number of bytes in @p in
+     * @return Bytes of @p in consumed, OCRE_ERROR_INVALID if the framing is broken and the
+     *         connection should be closed
+     */
+    int ocre_modbus_client_process(ocre_modbus_client_t *client, const uint8_t *in, size_t len);
+
+    /**
+     * @brief Fail requests whose timeout expired with OCRE_MODBUS_STATUS_TIMEOUT
+     * @param client Client state
+     * @return Number of requests that timed out
+     */
+    int ocre_modbus_client_poll(ocre_modbus_client_t *client);
+
+    /**
+     * @brief Fail all outstanding requests with OCRE_MODBUS_STATUS_CLOSED, such as after a disconnect
+     * @param client Client state
+     */
+    void ocre_modbus_client_reset(ocre_modbus_client_t *client);
+
+    // =============================================================================
+    // Poll Schedule
+    // =============================================================================
+
+    /**
+     * @brief Register range polled by a schedule
+     */
+    typedef struct
+    {
+        uint16_t *values; /**< Receives @ref count registers after every successful poll */
+        uint16_t start;   /**< First register */
+        uint16_t count;   /**< Number of registers, 1 to 125 */
+        uint8_t unit_id;  /**< Unit to poll */
+        uint8_t table;    /**< OCRE_MODBUS_HOLDING_REGISTERS or OCRE_MODBUS_INPUT_REGISTERS */
+        uint8_t status;   /**< Status of the last poll, set by the schedule */
+        uint16_t block;   /**< Request the range is read with, set by the schedule */
+    } ocre_modbus_poll_item_t;
+
+    typedef struct ocre_modbus_schedule ocre_modbus_schedule_t;
+
+    /**
+     * @brief Called for every item after each poll, successful or not
+     */
+    typedef void (*ocre_modbus_schedule_callback_t)(ocre_modbus_schedule_t *schedule, ocre_modbus_poll_item_t *item,
+                                                    void *user_data);
+
+    /**
+     * @brief One merged request of a schedule, owned by the caller and managed by the schedule
+     */
+    typedef struct
+    {
+        ocre_modbus_schedule_t *schedule;
+        uint16_t start;
+        uint16_t count;
+        uint8_t unit_id;
+        uint8_t table;
+        uint8_t due;
+        uint8_t in_flight;
+    } ocre_modbus_poll_block_t;
+
+    /**
+     * @brief Periodic poll of a set of register ranges over one client
+     */
+    struct ocre_modbus_schedule
+    {
+        ocre_modbus_client_t *client;             /**< Client the requests go through */
+        ocre_modbus_poll_item_t *items;           /**< Polled ranges */
+        uint16_t item_count;                      /**< Number of items */
+        ocre_modbus_poll_block_t *blocks;         /**< Merged requests */
+        uint16_t block_count;                     /**< Number of merged requests */
+        uint32_t interval_ms;                     /**< Poll period */
+        uint64_t next_poll_us;                    /**< Time of the next poll */
+        ocre_modbus_schedule_callback_t callback; /**< Per-item result callback, may be NULL */
+        void *user_data;                          /**< Passed to @ref callback */
+    };
+
+    /**
+     * @brief Build a schedule, merging ranges of the same unit and table into single requests
+     *
+     * Two ranges are merged when the combined request stays within 125 registers and the
+     * gap between them is at most @p max_gap registers; the gap is read and discarded.
+     *
+     * @param schedule Schedule to initialize
+     * @param client Client the requests go through
+     * @param items Polled ranges, kept by reference
+     * @param item_count Number of items
+     * @param blocks Caller-owned storage for the merged requests
+     * @param max_blocks Capacity of @p blocks
+     * @param max_gap Largest gap bridged when merging ranges, 0 merges adjacent ranges only
+     * @param interval_ms Poll period
+     * @param callback Per-item result callback, may be NULL
+     * @param user_data Pointer passed to @p callback
+     * @return Number of merged requests, OCRE_ERROR_INVALID on bad parameters or items,
+     *         OCRE_ERROR_NO_MEMORY if @p blocks is too small
+     */
+    int ocre_modbus_schedule_init(ocre_modbus_schedule_t *schedule, ocre_modbus_client_t *client,
+                                  ocre_modbus_poll_item_t *items, uint16_t item_count, ocre_modbus_poll_block_t *blocks,
+                                  uint16_t max_blocks, uint16_t max_gap, uint32_t interval_ms,
+                                  ocre_modbus_schedule_callback_t callback, void *user_data);
+
+    /**
+     * @brief Send the requests that are due
+     *
+     * Call regularly, such as after every poll of the network stack. A request still
+     * outstanding from the previous period is not sent again, so a slow device does not
+     * pile up transactions. Requests that find no free slot are sent on a later call.
+     *
+     * @param schedule Schedule state
+     * @return Number of requests sent
+     */
+    int ocre_modbus_schedule_run(ocre_modbus_schedule_t *schedule);
+
+    // =============================================================================
+    // Register Helpers
+    // =============================================================================
+
+    /**
+     * @brief Store a float in two registers, low word first
+     * @param value Value to store
+     * @param regs Receives two registers
+     */
+    void ocre_modbus_float_to_registers(float value, uint16_t *regs);
+
+    /**
+     * @brief Load a float from two registers, low word first
+     * @param regs Two registers
+     * @return Stored value
+     */
+    float ocre_modbus_registers_to_float(const uint16_t *regs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCRE_MODBUS_H */
@@ -0,0 +1,121 @@
+# Packs every file under ASSET_ROOT into OUTPUT, a C file defining the ocre_asset_bundle_t
+# NAME (see ocre_assets.h). All contents go into one array, indexed by sorted path; each
+# entry has its content and, when that saves at least an eighth, a gzipped copy, with
+# ETags derived from the content. GZIP_ONLY drops the plain copy of compressible files.
+#
+# Used through ocre_add_assets() in ocre.cmake:
+#   cmake -DASSET_ROOT=<dir> -DNAME=<symbol> -DOUTPUT=<file.c> [-DGZIP_ONLY=ON] -P ocre_pack_assets.cmake
+
+file(GLOB_RECURSE names RELATIVE ${ASSET_ROOT} ${ASSET_ROOT}/*)
+list(SORT names)
+
+set(work_dir ${OUTPUT}.gz)
+file(MAKE_DIRECTORY ${work_dir})
+
+string(REPEAT "0x..," 16 row)
+
+set(blob "")
+set(table "")
+set(offset 0)
+set(count 0)
+
+# Appends the file at `path` to the blob, sets `<var>_offset` and `<var>_size`
+macro(append_content path var comment)
+    file(READ ${path} hex HEX)
+    string(LENGTH "${hex}" hex_len)
+    math(EXPR ${var}_size "${hex_len} / 2")
+    set(${var}_offset ${offset})
+    if (${var}_size GREATER 0)
+        if (DEFINED clear_mtime)
+            # Clear the gzip header timestamp so the output only changes with the content
+            string(SUBSTRING ${hex} 0 8 header)
+            string(SUBSTRING ${hex} 16 -1 rest)
+            set(hex "${header}00000000${rest}")
+        endif()
+        string(REGEX REPLACE "(..)" "0x\\1," bytes "${hex}")
+        string(REGEX REPLACE "(${row})" "\\1\n    " bytes "${bytes}")
+        string(REGEX REPLACE "\n    $" "" bytes "${bytes}")
+        string(APPEND blob "    // ${comment}\n    ${bytes}\n")
+    endif()
+    math(EXPR offset "${offset} + ${${var}_size}")
+endmacro()
+
+foreach(name ${names})
+    set(path ${ASSET_ROOT}/${name})
+
+    get_filename_component(ext ${name} LAST_EXT)
+    string(TOLOWER "${ext}" ext)
+    if (ext STREQUAL ".html" OR ext STREQUAL ".htm")
+        set(mime "text/html; charset=utf-8")
+    elseif (ext STREQUAL ".css")
+        set(mime "text/css")
+    elseif (ext STREQUAL ".js")
+        set(mime "text/javascript")
+    elseif (ext STREQUAL ".json")
+        set(mime "application/json")
+    elseif (ext STREQUAL ".txt")
+        set(mime "text/plain; charset=utf-8")
+    elseif (ext STREQUAL ".svg")
+        set(mime "image/svg+xml")
+    elseif (ext STREQUAL ".png")
+        set(mime "image/png")
+    elseif (ext STREQUAL ".jpg" OR ext STREQUAL ".jpeg")
+        set(mime "image/jpeg")
+    elseif (ext STREQUAL ".ico")
+        set(mime "image/x-icon")
+    elseif (ext STREQUAL ".wasm")
+        set(mime "application/wasm")
+    else()
+        set(mime "application/octet-stream")
+    endif()
+
+    file(SHA1 ${path} hash)
+    string(SUBSTRING ${hash} 0 16 etag)
+
+    get_filename_component(gz_dir ${work_dir}/${name} DIRECTORY)
+    file(MAKE_DIRECTORY ${gz_dir})
+    file(ARCHIVE_CREATE OUTPUT ${work_dir}/${name}.gz PATHS ${path} FORMAT raw COMPRESSION GZip COMPRESSION_LEVEL 9)
+    file(SIZE ${path} plain_size)
+    file(SIZE ${work_dir}/${name}.gz gz_size)
+    math(EXPR gz_limit "${plain_size} - ${plain_size} / 8")
+
+    set(flags 0)
+    set(plain_offset 0)
+    set(gzip_offset 0)
+    set(gzip_size 0)
+    if (gz_size LESS gz_limit)
+        set(clear_mtime ON)
+        append_content(${work_dir}/${name}.gz gzip "${name}, gzip")
+        unset(clear_mtime)
+        set(flags "OCRE_ASSET_GZIP")
+    endif()
+    if (NOT GZIP_ONLY OR flags STREQUAL "0")
+        append_content(${path} plain "${name}")
+        if (flags STREQUAL "0")
+            set(flags "OCRE_ASSET_PLAIN")
+        else()
+            set(flags "OCRE_ASSET_PLAIN | OCRE_ASSET_GZIP")
+        endif()
+    else()
+        set(plain_size 0)
+    endif()
+
+    string(APPEND table "    { \"/${name}\", \"${mime}\", \"\\\"${etag}\\\"\", \"\\\"${etag}-gz\\\"\", "
+                        "${plain_offset}, ${plain_size}, ${gzip_offset}, ${gzip_size}, ${flags} },\n")
+    math(EXPR count "${count} + 1")
+endforeach()
+
+if (count EQUAL 0)
+    message(FATAL_ERROR "No assets found under ${ASSET_ROOT}")
+endif()
+
+get_filename_component(root_name ${ASSET_ROOT} NAME)
+file(WRITE ${OUTPUT}.tmp
+    "// Generated by ocre_pack_assets.cmake from ${root_name}/, do not edit\n"
+    "#include \"ocre_assets.h\"\n\n"
+    "static const unsigned char ${NAME}_data[${offset} + 1] = {\n${blob}};\n\n"
+    "// Sorted by path for ocre_asset_find()\n"
+    "static const ocre_asset_t ${NAME}_entries[] = {\n${table}};\n\n"
+    "const ocre_asset_bundle_t ${NAME} = { ${NAME}_data, ${NAME}_entries, ${count} };\n")
+# Only touch the output when it changed, so unchanged assets do not rebuild
+configure_file(${OUTPUT}.tmp ${OUTPUT} COPYONLY)
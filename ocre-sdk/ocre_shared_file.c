@@ -0,0 +1,287 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#include "ocre_shared_file.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static uint32_t fnv1a(const void *data, uint32_t len)
+{
+    const uint8_t *p = data;
+    uint32_t hash = 2166136261u;
+    while (len--)
+    {
+        hash = (hash ^ *p++) * 16777619u;
+    }
+    return hash;
+}
+
+static int io_error(int err)
+{
+    return err == ENOSPC ? OCRE_ERROR_NO_SPACE : OCRE_ERROR_IO;
+}
+
+// Write the whole range, returns 0 or the errno of the failed call
+static int write_all(int fd, const void *data, uint32_t len)
+{
+    const char *p = data;
+    while (len > 0)
+    {
+        ssize_t n = write(fd, p, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return errno;
+        }
+        if (n == 0)
+        {
+            return EIO; // No progress, retrying would spin
+        }
+        p += n;
+        len -= (uint32_t)n;
+    }
+    return 0;
+}
+
+// Returns the bytes read, short only at end of file, or -1
+static ssize_t read_full(int fd, void *data, uint32_t len)
+{
+    char *p = data;
+    uint32_t total = 0;
+    while (total < len)
+    {
+        ssize_t n = read(fd, p + total, len - total);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        total += (uint32_t)n;
+    }
+    return total;
+}
+
+static bool copy_path(char *dst, const char *path)
+{
+    size_t len = path ? strlen(path) : 0;
+    // Room for the ".tmp" suffix of the writer's temporary file
+    if (len == 0 || len + sizeof(".tmp") > OCRE_SHARED_FILE_PATH_MAX)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Invalid shared file path\n");
+#endif
+        return false;
+    }
+    memcpy(dst, path, len + 1);
+    return true;
+}
+
+static void shared_file_changed(ocre_file_watch_t *watch, uint32_t changes, void *user_data)
+{
+    ocre_shared_read(user_data);
+}
+
+// =============================================================================
+// WRITER
+// =============================================================================
+
+int ocre_shared_writer_open(ocre_shared_writer_t *writer, const char *path)
+{
+    if (writer == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    memset(writer, 0, sizeof(*writer));
+    if (!copy_path(writer->path, path))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0)
+    {
+        ocre_shared_file_header_t header;
+        if (read_full(fd, &header, sizeof(header)) == sizeof(header) && header.magic == OCRE_SHARED_FILE_MAGIC)
+        {
+            writer->generation = header.generation;
+        }
+        close(fd);
+    }
+    return OCRE_SUCCESS;
+}
+
+int ocre_shared_publish(ocre_shared_writer_t *writer, const void *data, uint32_t len)
+{
+    if (writer == NULL || writer->path[0] == '\0' || (data == NULL && len > 0))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    char tmp[OCRE_SHARED_FILE_PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", writer->path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Failed to create %s (%d)\n", tmp, errno);
+#endif
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    ocre_shared_file_header_t header = {
+        .magic = OCRE_SHARED_FILE_MAGIC,
+        .length = len,
+        .generation = writer->generation + 1,
+        .checksum = fnv1a(data, len),
+    };
+    // The data must be on disk before the rename makes it visible
+    int err = write_all(fd, &header, sizeof(header));
+    if (err == 0)
+    {
+        err = write_all(fd, data, len);
+    }
+    if (err == 0 && fsync(fd) != 0)
+    {
+        err = errno;
+    }
+    if (err)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Failed to write %s (%d)\n", tmp, err);
+#endif
+        close(fd);
+        unlink(tmp);
+        return io_error(err);
+    }
+    close(fd);
+    if (rename(tmp, writer->path) != 0)
+    {
+        // Filesystems that cannot rename over an existing file; readers see the file
+        // missing for a moment, never a partial one
+        if (unlink(writer->path) != 0 || rename(tmp, writer->path) != 0)
+        {
+            err = errno;
+#ifdef OCRE_SDK_LOG
+            printf("Error: Failed to replace %s (%d)\n", writer->path, err);
+#endif
+            unlink(tmp);
+            return io_error(err);
+        }
+    }
+    writer->generation = header.generation;
+    return OCRE_SUCCESS;
+}
+
+uint64_t ocre_shared_writer_generation(const ocre_shared_writer_t *writer)
+{
+    return writer ? writer->generation : 0;
+}
+
+// =============================================================================
+// READER
+// =============================================================================
+
+int ocre_shared_reader_start(ocre_shared_reader_t *reader, const char *path, char *buffer, uint32_t capacity,
+                             ocre_shared_update_callback_t callback, void *user_data)
+{
+    if (reader == NULL || (buffer == NULL && capacity > 0) || callback == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    memset(reader, 0, sizeof(*reader));
+    if (!copy_path(reader->path, path))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    reader->buffer = buffer;
+    reader->capacity = capacity;
+    reader->callback = callback;
+    reader->user_data = user_data;
+    // A published version shows up as the file being replaced; MODIFIED also catches
+    // tools that rewrite it in place, the checksum rejects them while half written
+    int ret = ocre_file_watch_start(&reader->watch, path, OCRE_FILE_CHANGE_CREATED | OCRE_FILE_CHANGE_MODIFIED,
+                                    0, shared_file_changed, reader);
+    if (ret != OCRE_SUCCESS)
+    {
+        return ret;
+    }
+    // Nothing published yet or a partial file: the watch reports the next version
+    ret = ocre_shared_read(reader);
+    if (ret == OCRE_ERROR_NO_MEMORY)
+    {
+        ocre_shared_reader_stop(reader);
+        return ret;
+    }
+    return OCRE_SUCCESS;
+}
+
+int ocre_shared_read(ocre_shared_reader_t *reader)
+{
+    if (reader == NULL || reader->callback == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    // The open file is the version that was there at open() time, whatever gets renamed
+    // over the path while it is read
+    int fd = open(reader->path, O_RDONLY);
+    if (fd < 0)
+    {
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    ocre_shared_file_header_t header;
+    int ret = OCRE_SUCCESS;
+    if (read_full(fd, &header, sizeof(header)) != sizeof(header) || header.magic != OCRE_SHARED_FILE_MAGIC)
+    {
+        ret = OCRE_ERROR_INVALID;
+    }
+    else if (header.generation <= reader->generation)
+    {
+        ret = OCRE_SUCCESS; // Already delivered
+    }
+    else if (header.length > reader->capacity)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Shared file %s version of %u bytes does not fit\n", reader->path, header.length);
+#endif
+        ret = OCRE_ERROR_NO_MEMORY;
+    }
+    else if (read_full(fd, reader->buffer, header.length) != (ssize_t)header.length ||
+             fnv1a(reader->buffer, header.length) != header.checksum)
+    {
+        ret = OCRE_ERROR_INVALID;
+    }
+    else
+    {
+        close(fd);
+        reader->generation = header.generation;
+        reader->callback(reader, reader->buffer, header.length, header.generation, reader->user_data);
+        return OCRE_SUCCESS;
+    }
+    close(fd);
+    return ret;
+}
+
+int ocre_shared_reader_stop(ocre_shared_reader_t *reader)
+{
+    if (reader == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    int ret = ocre_file_watch_stop(&reader->watch);
+    memset(reader, 0, sizeof(*reader));
+    return ret;
+}
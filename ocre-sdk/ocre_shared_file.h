@@ -0,0 +1,159 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#ifndef OCRE_SHARED_FILE_H
+#define OCRE_SHARED_FILE_H
+
+#include "ocre_api.h"
+
+/**
+ * @file ocre_shared_file.h
+ * @brief Versioned files exchanged between containers through a shared mount.
+ *
+ * A writer publishes each version to a temporary file next to the shared one and renames
+ * it over the shared path, so a reader opens either the previous version or the new one,
+ * never a file being written. Every version carries a generation counter and a checksum.
+ * Readers watch the path and read a version once when it lands, instead of polling and
+ * rereading the file.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef OCRE_SHARED_FILE_PATH_MAX
+#define OCRE_SHARED_FILE_PATH_MAX 64    /**< Longest shared file path, including the NUL */
+#endif
+
+#define OCRE_SHARED_FILE_MAGIC 0x4853434f /**< "OCSH" in the first bytes of a shared file */
+
+    /**
+     * @brief Header in front of the data of every version
+     */
+    typedef struct
+    {
+        uint32_t magic;      /**< OCRE_SHARED_FILE_MAGIC */
+        uint32_t length;     /**< Data bytes after the header */
+        uint64_t generation; /**< Increases by one with every published version */
+        uint32_t checksum;   /**< FNV-1a of the data */
+        uint32_t reserved;   /**< Zero */
+    } ocre_shared_file_header_t;
+
+    /**
+     * @brief Writer state
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct
+    {
+        char path[OCRE_SHARED_FILE_PATH_MAX]; /**< Shared file */
+        uint64_t generation;                  /**< Generation of the last published version */
+    } ocre_shared_writer_t;
+
+    struct ocre_shared_reader;
+
+    /**
+     * @brief New version callback function type
+     * @param reader The reader that got the version
+     * @param data Version data, in the reader's buffer until the next version is read
+     * @param len Data length
+     * @param generation Generation of the version
+     * @param user_data Pointer given to ocre_shared_reader_start()
+     */
+    typedef void (*ocre_shared_update_callback_t)(struct ocre_shared_reader *reader, const void *data,
+                                                  uint32_t len, uint64_t generation, void *user_data);
+
+    /**
+     * @brief Reader state
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct ocre_shared_reader
+    {
+        ocre_file_watch_t watch;                /**< Reports versions renamed over the path */
+        char path[OCRE_SHARED_FILE_PATH_MAX];   /**< Shared file */
+        char *buffer;                           /**< Receives the version data */
+        uint32_t capacity;                      /**< Size of buffer */
+        uint64_t generation;                    /**< Generation of the last version delivered */
+        ocre_shared_update_callback_t callback; /**< Called with every new version */
+        void *user_data;                        /**< Passed back to the callback */
+    } ocre_shared_reader_t;
+
+    /**
+     * @brief Prepare to publish versions of a shared file
+     *
+     * Continues from the generation of the version already at @p path, if any.
+     *
+     * @param writer Writer to initialize
+     * @param path Shared file, its directory must exist
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_shared_writer_open(ocre_shared_writer_t *writer, const char *path);
+
+    /**
+     * @brief Publish a new version
+     *
+     * Writes and syncs "<path>.tmp", then renames it over the shared file.
+     *
+     * @param writer Open writer
+     * @param data Version data
+     * @param len Data length
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NO_SPACE if the filesystem is full,
+     *         OCRE_ERROR_IO if writing or replacing the file failed, OCRE_ERROR_INVALID on
+     *         invalid parameters
+     */
+    int ocre_shared_publish(ocre_shared_writer_t *writer, const void *data, uint32_t len);
+
+    /**
+     * @brief Generation of the last version published by a writer
+     * @param writer Open writer
+     * @return Generation, 0 before the first version
+     */
+    uint64_t ocre_shared_writer_generation(const ocre_shared_writer_t *writer);
+
+    /**
+     * @brief Watch a shared file and read each new version once
+     *
+     * The version already there, if any, is delivered before this returns. Later ones are
+     * delivered from ocre_process_events() when the host reports the rename.
+     *
+     * @param reader Reader to initialize
+     * @param path Shared file
+     * @param buffer Receives the version data
+     * @param capacity Size of @p buffer, the largest version that can be read
+     * @param callback Called with every new version
+     * @param user_data Pointer passed back to @p callback
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_shared_reader_start(ocre_shared_reader_t *reader, const char *path, char *buffer, uint32_t capacity,
+                                 ocre_shared_update_callback_t callback, void *user_data);
+
+    /**
+     * @brief Read the shared file now, delivering its version if it is new
+     *
+     * Needed only where the host cannot watch files.
+     *
+     * @param reader Started reader
+     * @return OCRE_SUCCESS if the version was delivered or already seen, OCRE_ERROR_NOT_FOUND
+     *         if nothing was published yet, OCRE_ERROR_NO_MEMORY if the version does not fit
+     *         in the buffer, OCRE_ERROR_INVALID if the file is not a complete shared file
+     */
+    int ocre_shared_read(ocre_shared_reader_t *reader);
+
+    /**
+     * @brief Stop watching a shared file
+     * @param reader Reader to stop
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_shared_reader_stop(ocre_shared_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCRE_SHARED_FILE_H */
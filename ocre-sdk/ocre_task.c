@@ -0,0 +1,223 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#include "ocre_task.h"
+#include <stdio.h>
+#include <string.h>
+
+enum
+{
+    TASK_STOPPED, // Not in the task list
+    TASK_READY,   // Runs on the next pass
+    TASK_WAITING, // Sleeping or waiting for an event
+    TASK_RUNNING  // In its task function
+};
+
+static ocre_task_t *tasks = NULL;
+static uint32_t ready_count = 0;
+static bool running = false;
+static uint32_t pass = 0; // Run pass, so each task runs at most once per pass
+
+static void task_set_state(ocre_task_t *task, uint8_t state)
+{
+    if (task->state == TASK_READY)
+    {
+        ready_count--;
+    }
+    if (state == TASK_READY)
+    {
+        ready_count++;
+    }
+    task->state = state;
+}
+
+static void task_unlink(ocre_task_t *task)
+{
+    for (ocre_task_t **link = &tasks; *link; link = &(*link)->next)
+    {
+        if (*link == task)
+        {
+            *link = task->next;
+            break;
+        }
+    }
+    task->next = NULL;
+    task_set_state(task, TASK_STOPPED);
+}
+
+static void task_timeout(ocre_soft_timer_t *timer, void *user_data)
+{
+    ocre_task_t *task = user_data;
+    if (task->state == TASK_WAITING)
+    {
+        task->timed_out = 1;
+        task->wait_type = OCRE_RESOURCE_TYPE_COUNT;
+        task_set_state(task, TASK_READY);
+    }
+}
+
+int ocre_task_start(ocre_task_t *task, ocre_task_func_t func, void *user_data)
+{
+    if (task == NULL || func == NULL)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    if (ocre_task_is_running(task))
+    {
+        return OCRE_ERROR_BUSY;
+    }
+    memset(task, 0, sizeof(*task));
+    task->func = func;
+    task->user_data = user_data;
+    task->wait_type = OCRE_RESOURCE_TYPE_COUNT;
+    task->pass = pass; // Started from a task, it runs on the next pass
+    ocre_soft_timer_init(&task->timer, task_timeout, task);
+    task->next = tasks;
+    tasks = task;
+    task_set_state(task, TASK_READY);
+    return OCRE_SUCCESS;
+}
+
+int ocre_task_stop(ocre_task_t *task)
+{
+    if (!ocre_task_is_running(task) || task->state == TASK_RUNNING)
+    {
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    ocre_soft_timer_stop(&task->timer);
+    task_unlink(task);
+    return OCRE_SUCCESS;
+}
+
+int ocre_task_wake(ocre_task_t *task)
+{
+    if (task == NULL || task->state != TASK_WAITING)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    ocre_soft_timer_stop(&task->timer);
+    task->timed_out = 0;
+    task->wait_type = OCRE_RESOURCE_TYPE_COUNT;
+    task_set_state(task, TASK_READY);
+    return OCRE_SUCCESS;
+}
+
+bool ocre_task_is_running(const ocre_task_t *task)
+{
+    return task != NULL && task->state != TASK_STOPPED;
+}
+
+bool ocre_task_timed_out(const ocre_task_t *task)
+{
+    return task != NULL && task->timed_out;
+}
+
+int ocre_task_prepare_sleep(ocre_task_t *task, uint32_t ms)
+{
+    task->timed_out = 0;
+    if (ms == 0 || ocre_soft_timer_start(&task->timer, ms, 0) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        if (ms != 0)
+        {
+            printf("Error: Task sleep timer could not be started, yielding instead\n");
+        }
+#endif
+        return OCRE_TASK_YIELD;
+    }
+    return OCRE_TASK_WAIT;
+}
+
+int ocre_task_prepare_wait(ocre_task_t *task, uint32_t type, uint32_t id, int timeout_ms)
+{
+    task->timed_out = 0;
+    task->wait_type = type;
+    task->wait_id = id;
+    if (timeout_ms >= 0)
+    {
+        // A zero timeout ends the wait on the next soft timer tick
+        ocre_soft_timer_start(&task->timer, timeout_ms > 0 ? (uint32_t)timeout_ms : 1, 0);
+    }
+    return OCRE_TASK_WAIT;
+}
+
+bool ocre_task_ready(void)
+{
+    return ready_count > 0;
+}
+
+void ocre_task_event(const event_data_t *event_data)
+{
+    // Ticks of the soft timer wheel are no events of their own
+    if (event_data->type == OCRE_RESOURCE_TYPE_TIMER && event_data->id == OCRE_SOFT_TIMER_HOST_ID)
+    {
+        return;
+    }
+    for (ocre_task_t *task = tasks; task; task = task->next)
+    {
+        if (task->state == TASK_WAITING && task->wait_type == event_data->type &&
+            (task->wait_id == OCRE_TASK_ANY_ID || task->wait_id == event_data->id))
+        {
+            ocre_soft_timer_stop(&task->timer);
+            task->event = *event_data;
+            if (event_data->type == OCRE_RESOURCE_TYPE_MESSAGE)
+            {
+                // The pointers were freed with the message buffers when its callbacks returned
+                task->event.port = 0;
+                task->event.state = 0;
+                task->event.extra = 0;
+            }
+            task->wait_type = OCRE_RESOURCE_TYPE_COUNT;
+            task_set_state(task, TASK_READY);
+        }
+    }
+}
+
+uint32_t ocre_task_run(void)
+{
+    // A task calling ocre_process_events_ex() must not run the tasks again
+    if (running || ready_count == 0)
+    {
+        return 0;
+    }
+    running = true;
+    pass++;
+
+    // Tasks may start, stop or wake others, so look for the next one from the head each
+    // time. Each task runs at most once per pass, so a yielding task lets events through.
+    uint32_t run = 0;
+    ocre_task_t *task = tasks;
+    while (task)
+    {
+        if (task->state != TASK_READY || task->pass == pass)
+        {
+            task = task->next;
+            continue;
+        }
+        task->pass = pass;
+        task_set_state(task, TASK_RUNNING);
+        int result = task->func(task, task->user_data);
+        run++;
+        if (result == OCRE_TASK_YIELD)
+        {
+            task_set_state(task, TASK_READY);
+        }
+        else if (result == OCRE_TASK_WAIT)
+        {
+            task_set_state(task, TASK_WAITING);
+        }
+        else
+        {
+            ocre_soft_timer_stop(&task->timer);
+            task_unlink(task);
+        }
+        task = tasks;
+    }
+
+    running = false;
+    return run;
+}
@@ -0,0 +1,253 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#ifndef OCRE_TASK_H
+#define OCRE_TASK_H
+
+#include "ocre_api.h"
+
+/**
+ * @file ocre_task.h
+ * @brief Stackless cooperative tasks run by the event loop.
+ *
+ * A task is sequential code, such as a sensor loop, that waits with ocre_task_sleep(),
+ * ocre_task_wait_event() or ocre_task_yield() instead of ocre_sleep(). Each wait returns
+ * to ocre_process_events_ex(), which keeps dispatching timer, GPIO and message events
+ * and resumes the task where it left off once its wait is over. All tasks and callbacks
+ * share the one module thread, so no locking is needed.
+ *
+ * Tasks have no stack of their own: a task function is re-entered at its last wait, so
+ * local variables do not keep their values across waits. Keep such state in the
+ * user_data or in statics. The wait macros expand to a return and a case label, so they
+ * can only be used in the task function itself, and not inside a switch statement of its
+ * own. Task storage is owned by the caller.
+ *
+ * @code
+ * static int sample_task(ocre_task_t *task, void *user_data)
+ * {
+ *     OCRE_TASK_BEGIN(task);
+ *     while (1)
+ *     {
+ *         read_sensor();
+ *         ocre_task_sleep(task, 1000);
+ *     }
+ *     OCRE_TASK_END(task);
+ * }
+ * @endcode
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define OCRE_TASK_ANY_ID 0xFFFFFFFFU /**< Wait for an event of the type with any resource ID */
+
+// Task function results, returned by the macros below
+#define OCRE_TASK_YIELD 0 /**< Run again on the next pass of the event loop */
+#define OCRE_TASK_WAIT 1  /**< Blocked until woken, an event arrives or a timeout expires */
+#define OCRE_TASK_DONE 2  /**< Finished, the task is removed */
+
+    struct ocre_task;
+
+    /**
+     * @brief Task function type
+     *
+     * The body is enclosed in OCRE_TASK_BEGIN() and OCRE_TASK_END().
+     *
+     * @param task Task being run
+     * @param user_data Pointer given to ocre_task_start()
+     * @return An OCRE_TASK_* result, produced by the wait macros and OCRE_TASK_END()
+     */
+    typedef int (*ocre_task_func_t)(struct ocre_task *task, void *user_data);
+
+    /**
+     * @brief Cooperative task state
+     *
+     * Fields are private to the SDK, except @ref event after ocre_task_wait_event().
+     */
+    typedef struct ocre_task
+    {
+        struct ocre_task *next;   /**< Next started task */
+        ocre_task_func_t func;    /**< Task function */
+        void *user_data;          /**< Passed to @ref func */
+        ocre_soft_timer_t timer;  /**< Sleep and wait timeout */
+        event_data_t event;       /**< Event that ended the last ocre_task_wait_event() */
+        uint32_t resume;          /**< Line to resume at, 0 to start from the top */
+        uint32_t wait_type;       /**< Resource type waited for, OCRE_RESOURCE_TYPE_COUNT for none */
+        uint32_t wait_id;         /**< Resource ID waited for, or OCRE_TASK_ANY_ID */
+        uint32_t pass;            /**< Last pass of ocre_task_run() the task ran in */
+        uint8_t state;            /**< Scheduling state */
+        uint8_t timed_out;        /**< The last wait ended by its timeout */
+    } ocre_task_t;
+
+    // =============================================================================
+    // Task Body
+    // =============================================================================
+
+/**
+ * @brief Start of a task function body, resumes at the last wait
+ */
+#define OCRE_TASK_BEGIN(task)                                                                                          \
+    switch ((task)->resume)                                                                                            \
+    {                                                                                                                  \
+    case 0:
+
+/**
+ * @brief End of a task function body, finishes the task
+ */
+#define OCRE_TASK_END(task)                                                                                            \
+    }                                                                                                                  \
+    (task)->resume = 0;                                                                                                \
+    return OCRE_TASK_DONE
+
+/**
+ * @brief Finish the task early
+ */
+#define OCRE_TASK_EXIT(task)                                                                                           \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        (task)->resume = 0;                                                                                            \
+        return OCRE_TASK_DONE;                                                                                         \
+    } while (0)
+
+// Save the resume point, return `result` and continue from here when run again
+#define OCRE_TASK_SUSPEND_(task, result)                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        (task)->resume = __LINE__;                                                                                     \
+        return (result);                                                                                               \
+    case __LINE__:;                                                                                                    \
+    } while (0)
+
+/**
+ * @brief Let pending events be dispatched, then continue
+ */
+#define ocre_task_yield(task) OCRE_TASK_SUSPEND_(task, OCRE_TASK_YIELD)
+
+/**
+ * @brief Continue after @p ms milliseconds, dispatching events meanwhile
+ *
+ * Rounded up to OCRE_SOFT_TIMER_TICK_MS.
+ */
+#define ocre_task_sleep(task, ms) OCRE_TASK_SUSPEND_(task, ocre_task_prepare_sleep((task), (ms)))
+
+/**
+ * @brief Continue once an event of a resource has been dispatched, or after a timeout
+ *
+ * The event is dispatched to its callbacks as usual, then copied into task->event.
+ * Afterwards ocre_task_timed_out() tells whether the wait timed out. The buffers of a
+ * message are freed once its callbacks return, so for OCRE_RESOURCE_TYPE_MESSAGE the
+ * task only sees the ID and payload_len, with port, state and extra cleared; read the
+ * payload in a message callback or keep it with ocre_message_retain() there. An ocre_task_wake()
+ * also ends the wait, without an event.
+ *
+ * @param type OCRE_RESOURCE_TYPE_* of the event
+ * @param id Resource ID as in event_data_t, such as the timer ID or GPIO pin, or OCRE_TASK_ANY_ID
+ * @param timeout_ms Longest wait in milliseconds, or OCRE_WAIT_FOREVER
+ */
+#define ocre_task_wait_event(task, type, id, timeout_ms)                                                               \
+    OCRE_TASK_SUSPEND_(task, ocre_task_prepare_wait((task), (type), (id), (timeout_ms)))
+
+/**
+ * @brief Continue once @p condition holds, checking it after each pass of the event loop
+ */
+#define ocre_task_wait_until(task, condition)                                                                          \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        while (!(condition))                                                                                           \
+        {                                                                                                              \
+            ocre_task_yield(task);                                                                                     \
+        }                                                                                                              \
+    } while (0)
+
+    // =============================================================================
+    // Scheduling
+    // =============================================================================
+
+    /**
+     * @brief Start a task
+     *
+     * The task first runs during the next ocre_process_events_ex() call, which does not
+     * block while any task is ready to run.
+     *
+     * @param task Task storage, must stay valid until the task is done or stopped
+     * @param func Task function
+     * @param user_data Pointer passed to @p func
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on invalid parameters,
+     *         OCRE_ERROR_BUSY if the task is already started
+     */
+    int ocre_task_start(ocre_task_t *task, ocre_task_func_t func, void *user_data);
+
+    /**
+     * @brief Stop a task wherever it is waiting
+     * @param task Started task; a task may not stop itself, use OCRE_TASK_EXIT()
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_NOT_FOUND if the task is not started
+     */
+    int ocre_task_stop(ocre_task_t *task);
+
+    /**
+     * @brief End the sleep or event wait of a task, such as from a callback
+     * @param task Started task
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID if the task is not waiting
+     */
+    int ocre_task_wake(ocre_task_t *task);
+
+    /**
+     * @brief Check whether a task is started and not yet done
+     * @param task Task to check
+     * @return true if the task is started
+     */
+    bool ocre_task_is_running(const ocre_task_t *task);
+
+    /**
+     * @brief Check how the last wait of a task ended
+     * @param task Task that finished waiting
+     * @return true if its timeout expired before the event arrived or it was woken
+     */
+    bool ocre_task_timed_out(const ocre_task_t *task);
+
+    /**
+     * @brief Arm the sleep of a task, used by ocre_task_sleep()
+     * @return OCRE_TASK_WAIT, or OCRE_TASK_YIELD when @p ms is 0 or the timer cannot be armed
+     */
+    int ocre_task_prepare_sleep(ocre_task_t *task, uint32_t ms);
+
+    /**
+     * @brief Arm the event wait of a task, used by ocre_task_wait_event()
+     * @return OCRE_TASK_WAIT
+     */
+    int ocre_task_prepare_wait(ocre_task_t *task, uint32_t type, uint32_t id, int timeout_ms);
+
+    /**
+     * @brief Check whether any task is ready to run
+     *
+     * Used by ocre_process_events_ex() to not block while tasks are ready.
+     */
+    bool ocre_task_ready(void);
+
+    /**
+     * @brief Wake the tasks waiting for a dispatched event
+     *
+     * Called by ocre_process_events_ex() after each event.
+     */
+    void ocre_task_event(const event_data_t *event_data);
+
+    /**
+     * @brief Run each ready task once
+     *
+     * Called by ocre_process_events_ex() after dispatching events.
+     *
+     * @return Number of tasks run
+     */
+    uint32_t ocre_task_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCRE_TASK_H */
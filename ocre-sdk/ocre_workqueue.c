@@ -0,0 +1,332 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#include "ocre_workqueue.h"
+#include <stdio.h>
+#include <string.h>
+
+#if (OCRE_WORKQUEUE_DEPTH & (OCRE_WORKQUEUE_DEPTH - 1)) != 0
+#error "OCRE_WORKQUEUE_DEPTH must be a power of two"
+#endif
+
+static ocre_workqueue_t *workqueues[OCRE_MAX_WORKQUEUES] = {0};
+
+// =============================================================================
+// SUBMISSION RING
+// =============================================================================
+
+// Bounded multi-producer, multi-consumer ring: each slot's sequence tells whether it is
+// free for the enqueue position that maps to it, or holds the item for the dequeue one.
+
+static bool ring_push(ocre_workqueue_t *wq, ocre_work_t *work)
+{
+    uint32_t pos = __atomic_load_n(&wq->enqueue_pos, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        ocre_work_slot_t *slot = &wq->slots[pos & (OCRE_WORKQUEUE_DEPTH - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&wq->enqueue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED))
+            {
+                slot->work = work;
+                __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false; // Full
+        }
+        else
+        {
+            pos = __atomic_load_n(&wq->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static ocre_work_t *ring_pop(ocre_workqueue_t *wq)
+{
+    uint32_t pos = __atomic_load_n(&wq->dequeue_pos, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        ocre_work_slot_t *slot = &wq->slots[pos & (OCRE_WORKQUEUE_DEPTH - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - (pos + 1));
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&wq->dequeue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED))
+            {
+                ocre_work_t *work = slot->work;
+                __atomic_store_n(&slot->sequence, pos + OCRE_WORKQUEUE_DEPTH, __ATOMIC_RELEASE);
+                return work;
+            }
+        }
+        else if (diff < 0)
+        {
+            return NULL; // Empty
+        }
+        else
+        {
+            pos = __atomic_load_n(&wq->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// =============================================================================
+// WORKERS AND COMPLETIONS
+// =============================================================================
+
+// Push onto the completed list; only the first item of a batch queues an event
+static void complete(ocre_workqueue_t *wq, ocre_work_t *work)
+{
+    ocre_work_t *head = __atomic_load_n(&wq->completed, __ATOMIC_RELAXED);
+    do
+    {
+        work->next = head;
+    } while (!__atomic_compare_exchange_n(&wq->completed, &head, work, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    // After a refused event every completion tries again, the dispatcher also picks them up on its next pass
+    if (head == NULL || __atomic_load_n(&wq->notify_failed, __ATOMIC_ACQUIRE))
+    {
+        int ret = ocre_workqueue_notify(wq->id);
+        if (ret != OCRE_SUCCESS)
+        {
+            __atomic_add_fetch(&wq->notify_errors, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&wq->notify_failed, 1, __ATOMIC_RELEASE);
+#ifdef OCRE_SDK_LOG
+            printf("Error: Failed to queue completions of work queue %d (%d)\n", wq->id, ret);
+#endif
+        }
+    }
+    sem_post(&wq->finished);
+}
+
+// Run the completion callbacks of everything finished so far, oldest first
+static void run_completions(ocre_workqueue_t *wq)
+{
+    ocre_work_t *list = __atomic_exchange_n(&wq->completed, NULL, __ATOMIC_ACQUIRE);
+    ocre_work_t *oldest = NULL;
+    while (list)
+    {
+        ocre_work_t *next = list->next;
+        list->next = oldest;
+        oldest = list;
+        list = next;
+    }
+    while (oldest)
+    {
+        ocre_work_t *work = oldest;
+        oldest = work->next;
+        work->next = NULL;
+        // Cleared first so the callback may submit the item again
+        __atomic_store_n(&work->queued, 0, __ATOMIC_RELEASE);
+        if (work->done)
+        {
+            work->done(work, work->result);
+        }
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    ocre_workqueue_t *wq = arg;
+    for (;;)
+    {
+        while (sem_wait(&wq->available) != 0)
+        {
+        }
+        ocre_work_t *work = ring_pop(wq);
+        if (work == NULL)
+        {
+            // Only ocre_workqueue_destroy() posts without an item, once the ring is drained
+            if (__atomic_load_n(&wq->stopping, __ATOMIC_ACQUIRE))
+            {
+                return NULL;
+            }
+            continue;
+        }
+        work->result = work->fn(work);
+        complete(wq, work);
+    }
+}
+
+void OCRE_EXPORT("workqueue_callback") workqueue_callback(int id)
+{
+    if (id > 0 && id <= OCRE_MAX_WORKQUEUES && workqueues[id - 1])
+    {
+        run_completions(workqueues[id - 1]);
+        return;
+    }
+#ifdef OCRE_SDK_LOG
+    printf("No work queue registered for id: %d\n", id);
+#endif
+}
+
+bool ocre_workqueue_stalled(void)
+{
+    for (int i = 0; i < OCRE_MAX_WORKQUEUES; i++)
+    {
+        if (workqueues[i] && __atomic_load_n(&workqueues[i]->notify_failed, __ATOMIC_ACQUIRE))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ocre_workqueue_run_stalled(void)
+{
+    for (int i = 0; i < OCRE_MAX_WORKQUEUES; i++)
+    {
+        // Clear before taking the list: a completion pushed after it sets the flag again
+        if (workqueues[i] && __atomic_exchange_n(&workqueues[i]->notify_failed, 0, __ATOMIC_ACQ_REL))
+        {
+            run_completions(workqueues[i]);
+        }
+    }
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+void ocre_work_init(ocre_work_t *work, ocre_work_fn_t fn, ocre_work_done_t done, void *user_data)
+{
+    if (work)
+    {
+        memset(work, 0, sizeof(*work));
+        work->fn = fn;
+        work->done = done;
+        work->user_data = user_data;
+    }
+}
+
+int ocre_workqueue_init(ocre_workqueue_t *wq, uint32_t threads)
+{
+    if (wq == NULL || threads == 0 || threads > OCRE_WORKQUEUE_MAX_THREADS)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    int slot = -1;
+    for (int i = 0; i < OCRE_MAX_WORKQUEUES && slot < 0; i++)
+    {
+        if (workqueues[i] == NULL)
+        {
+            slot = i;
+        }
+    }
+    if (slot < 0)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: No available slots for work queues\n");
+#endif
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    if (ocre_dispatcher_ensure(OCRE_RESOURCE_TYPE_WORKQUEUE) != OCRE_SUCCESS)
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Failed to register work queue dispatcher\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+
+    memset(wq, 0, sizeof(*wq));
+    wq->id = slot + 1;
+    for (uint32_t i = 0; i < OCRE_WORKQUEUE_DEPTH; i++)
+    {
+        wq->slots[i].sequence = i;
+    }
+    if (sem_init(&wq->available, 0, 0) != 0)
+    {
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    if (sem_init(&wq->finished, 0, 0) != 0)
+    {
+        sem_destroy(&wq->available);
+        return OCRE_ERROR_NO_MEMORY;
+    }
+    workqueues[slot] = wq;
+    for (; wq->thread_count < threads; wq->thread_count++)
+    {
+        if (pthread_create(&wq->threads[wq->thread_count], NULL, worker_main, wq) != 0)
+        {
+#ifdef OCRE_SDK_LOG
+            printf("Error: Failed to start worker %u\n", wq->thread_count);
+#endif
+            ocre_workqueue_destroy(wq);
+            return OCRE_ERROR_NO_MEMORY;
+        }
+    }
+    return OCRE_SUCCESS;
+}
+
+int ocre_workqueue_submit(ocre_workqueue_t *wq, ocre_work_t *work)
+{
+    if (wq == NULL || work == NULL || work->fn == NULL || __atomic_load_n(&wq->stopping, __ATOMIC_RELAXED))
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    uint32_t idle = 0;
+    if (!__atomic_compare_exchange_n(&work->queued, &idle, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+#ifdef OCRE_SDK_LOG
+        printf("Error: Work item submitted again before its completion\n");
+#endif
+        return OCRE_ERROR_INVALID;
+    }
+    if (!ring_push(wq, work))
+    {
+        __atomic_store_n(&work->queued, 0, __ATOMIC_RELEASE);
+        return OCRE_ERROR_BUSY;
+    }
+    sem_post(&wq->available);
+    return OCRE_SUCCESS;
+}
+
+int ocre_workqueue_wait(ocre_workqueue_t *wq, ocre_work_t *work)
+{
+    if (wq == NULL || work == NULL || wq->id <= 0 || workqueues[wq->id - 1] != wq)
+    {
+        return OCRE_ERROR_INVALID;
+    }
+    for (;;)
+    {
+        run_completions(wq);
+        if (!__atomic_load_n(&work->queued, __ATOMIC_ACQUIRE))
+        {
+            return OCRE_SUCCESS;
+        }
+        while (sem_wait(&wq->finished) != 0)
+        {
+        }
+    }
+}
+
+int ocre_workqueue_destroy(ocre_workqueue_t *wq)
+{
+    if (wq == NULL || wq->id <= 0 || workqueues[wq->id - 1] != wq)
+    {
+        return OCRE_ERROR_NOT_FOUND;
+    }
+    __atomic_store_n(&wq->stopping, 1, __ATOMIC_RELEASE);
+    // One extra post per worker: after the items, each wakes to an empty ring and exits
+    for (uint32_t i = 0; i < wq->thread_count; i++)
+    {
+        sem_post(&wq->available);
+    }
+    for (uint32_t i = 0; i < wq->thread_count; i++)
+    {
+        pthread_join(wq->threads[i], NULL);
+    }
+    run_completions(wq);
+    sem_destroy(&wq->available);
+    sem_destroy(&wq->finished);
+    workqueues[wq->id - 1] = NULL;
+    memset(wq, 0, sizeof(*wq));
+    return OCRE_SUCCESS;
+}
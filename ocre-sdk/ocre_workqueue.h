@@ -0,0 +1,190 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+#ifndef OCRE_WORKQUEUE_H
+#define OCRE_WORKQUEUE_H
+
+#include "ocre_api.h"
+#include <pthread.h>
+#include <semaphore.h>
+
+/**
+ * @file ocre_workqueue.h
+ * @brief Worker thread pool with completions delivered through ocre_process_events().
+ *
+ * A work item runs its function on one of the pool's threads, then its completion
+ * callback runs on the thread dispatching Ocre events, like any other callback. Blocking
+ * file I/O and heavy processing can so leave the event loop without any locking in the
+ * callbacks.
+ *
+ * Needs a module built for WASI threads: set OCRE_SDK_THREADS before including
+ * ocre.cmake, which also compiles this file into ocre_api.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef OCRE_MAX_WORKQUEUES
+#define OCRE_MAX_WORKQUEUES 2           /**< Work queues open at once */
+#endif
+#ifndef OCRE_WORKQUEUE_MAX_THREADS
+#define OCRE_WORKQUEUE_MAX_THREADS 4    /**< Worker threads per queue */
+#endif
+#ifndef OCRE_WORKQUEUE_DEPTH
+#define OCRE_WORKQUEUE_DEPTH 32         /**< Submitted items waiting for a worker, a power of two */
+#endif
+
+    struct ocre_work;
+
+    /**
+     * @brief Work function, runs on a worker thread
+     * @param work The item being run
+     * @return Result handed to the completion callback
+     */
+    typedef int (*ocre_work_fn_t)(struct ocre_work *work);
+
+    /**
+     * @brief Completion callback, runs from ocre_process_events() on the dispatching thread
+     * @param work The item that finished, free to be submitted again
+     * @param result Value returned by the work function
+     */
+    typedef void (*ocre_work_done_t)(struct ocre_work *work, int result);
+
+    /**
+     * @brief Work item, owned by the caller and untouched by it until completion
+     */
+    typedef struct ocre_work
+    {
+        ocre_work_fn_t fn;      /**< Runs on a worker thread */
+        ocre_work_done_t done;  /**< Runs on the dispatching thread after fn, may be NULL */
+        void *user_data;        /**< Free for the caller */
+        int result;             /**< Return value of fn */
+        struct ocre_work *next; /**< Completion list link, private to the SDK */
+        uint32_t queued;        /**< Set from submission until done is called, private to the SDK */
+    } ocre_work_t;
+
+    /**
+     * @brief Submission slot, private to the SDK
+     */
+    typedef struct
+    {
+        uint32_t sequence;
+        ocre_work_t *work;
+    } ocre_work_slot_t;
+
+    /**
+     * @brief Work queue state
+     *
+     * Fields are private to the SDK.
+     */
+    typedef struct
+    {
+        int id;                                                /**< Event id of the completions */
+        ocre_work_slot_t slots[OCRE_WORKQUEUE_DEPTH];          /**< Bounded lock-free submission ring */
+        uint32_t enqueue_pos;                                  /**< Next slot to fill */
+        uint32_t dequeue_pos;                                  /**< Next slot to run */
+        ocre_work_t *completed;                                /**< Finished items, newest first */
+        sem_t available;                                       /**< Counts submitted items, workers sleep on it */
+        sem_t finished;                                        /**< Counts finished items, ocre_workqueue_wait() sleeps on it */
+        uint32_t stopping;                                     /**< Set by ocre_workqueue_destroy() */
+        uint32_t notify_failed;                                /**< Completions wait without an event queued */
+        uint32_t notify_errors;                                /**< ocre_workqueue_notify() calls that failed */
+        uint32_t thread_count;                                 /**< Workers started */
+        pthread_t threads[OCRE_WORKQUEUE_MAX_THREADS];         /**< Worker threads */
+    } ocre_workqueue_t;
+
+    /**
+     * @brief Queue an OCRE_RESOURCE_TYPE_WORKQUEUE event for this module
+     *
+     * Host import, callable from any thread of the module.
+     *
+     * @param id Event id
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_workqueue_notify(int id);
+
+    /**
+     * @brief Prepare a work item
+     * @param work Item to initialize
+     * @param fn Work function
+     * @param done Completion callback, NULL if none is needed
+     * @param user_data Pointer stored in the item
+     */
+    void ocre_work_init(ocre_work_t *work, ocre_work_fn_t fn, ocre_work_done_t done, void *user_data);
+
+    /**
+     * @brief Start a pool of worker threads
+     * @param wq Queue to initialize
+     * @param threads Number of workers, up to OCRE_WORKQUEUE_MAX_THREADS; each one needs a
+     *                thread slot in the runtime
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_workqueue_init(ocre_workqueue_t *wq, uint32_t threads);
+
+    /**
+     * @brief Hand an item to the pool
+     *
+     * Does not block and takes no lock; callable from any thread, including a work function.
+     *
+     * @param wq Queue to submit to
+     * @param work Item to run, must not already be queued or running
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_BUSY if OCRE_WORKQUEUE_DEPTH items are waiting,
+     *         OCRE_ERROR_INVALID if @p work is still queued, running or awaiting its completion
+     */
+    int ocre_workqueue_submit(ocre_workqueue_t *wq, ocre_work_t *work);
+
+    /**
+     * @brief Wait for an item and run the completions finished meanwhile
+     *
+     * Blocks the dispatching thread until the completion callback of @p work has run,
+     * calling it and the other finished ones in place of their event. Must not be called
+     * from a completion callback of the same queue.
+     *
+     * @param wq Queue @p work was submitted to
+     * @param work Item to wait for, returns at once if it is not queued
+     * @return OCRE_SUCCESS on success, OCRE_ERROR_INVALID on invalid parameters
+     */
+    int ocre_workqueue_wait(ocre_workqueue_t *wq, ocre_work_t *work);
+
+    /**
+     * @brief Stop the pool
+     *
+     * Waits for the submitted items to run, then calls their completion callbacks
+     * from the calling thread.
+     *
+     * @param wq Queue to stop
+     * @return OCRE_SUCCESS on success, negative error code on failure
+     */
+    int ocre_workqueue_destroy(ocre_workqueue_t *wq);
+
+    /**
+     * @brief Dispatcher of OCRE_RESOURCE_TYPE_WORKQUEUE events, runs completion callbacks
+     * @param id Event id of the queue
+     */
+    void workqueue_callback(int id);
+
+    /**
+     * @brief Whether completions wait whose event could not be queued
+     *
+     * Checked by ocre_process_events_ex() and ocre_poll() before blocking in the host.
+     */
+    bool ocre_workqueue_stalled(void);
+
+    /**
+     * @brief Run the completions whose event could not be queued
+     *
+     * Called by ocre_process_events_ex(), in place of the event the host refused.
+     */
+    void ocre_workqueue_run_stalled(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCRE_WORKQUEUE_H */
@@ -1,3 +1,141 @@
-set(CMAKE_TOOLCHAIN_FILE /opt/wasi-sdk/share/cmake/wasi-sdk.cmake)
+# Set OCRE_SDK_THREADS before including this file to build the module for WASI threads,
+# which the ocre_workqueue worker pool needs
+if (OCRE_SDK_THREADS)
+    set(CMAKE_TOOLCHAIN_FILE /opt/wasi-sdk/share/cmake/wasi-sdk-pthread.cmake)
+else()
+    set(CMAKE_TOOLCHAIN_FILE /opt/wasi-sdk/share/cmake/wasi-sdk.cmake)
+endif()
 
 set(CMAKE_EXE_LINKER_FLAGS "-Wl,--import-memory -Wl,--export-memory -Wl,--strip-all -Wl,--allow-undefined -Wl,--max-memory=4194304")
+
+# WASM SIMD128, off by default. With OCRE_SIMD on, the container and the SDK are compiled
+# with -msimd128: clang vectorizes loops where it can, and code may use the wasm_simd128.h
+# intrinsics behind #ifdef __wasm_simd128__. Such modules only load on runtimes built
+# with SIMD support, such as WAMR AOT or JIT.
+option(OCRE_SIMD "Build containers with WASM SIMD128" OFF)
+if (OCRE_SIMD)
+    add_compile_options(-msimd128)
+endif()
+
+set(OCRE_ASSET_PACKER ${CMAKE_CURRENT_LIST_DIR}/ocre-sdk/ocre_pack_assets.cmake)
+
+# ocre_add_assets(<target> <name> <dir> [GZIP_ONLY])
+#
+# Packs every file under <dir> into the const ocre_asset_bundle_t <name>, compiled into
+# <target> (see ocre-sdk/ocre_assets.h). Declare it with
+#   extern const ocre_asset_bundle_t <name>;
+# GZIP_ONLY keeps only the gzipped copy of files that compress, for the smallest image.
+function(ocre_add_assets target name dir)
+    cmake_parse_arguments(ARG "GZIP_ONLY" "" "" ${ARGN})
+    get_filename_component(root ${dir} ABSOLUTE)
+    file(GLOB_RECURSE files CONFIGURE_DEPENDS ${root}/*)
+    set(output ${CMAKE_CURRENT_BINARY_DIR}/${name}.c)
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND ${CMAKE_COMMAND}
+            -DASSET_ROOT=${root}
+            -DNAME=${name}
+            -DOUTPUT=${output}
+            -DGZIP_ONLY=${ARG_GZIP_ONLY}
+            -P ${OCRE_ASSET_PACKER}
+        DEPENDS ${files} ${OCRE_ASSET_PACKER}
+        COMMENT "Packing ${dir} into ${name}"
+    )
+    target_sources(${target} PRIVATE ${output})
+endfunction()
+
+# Ahead-of-time compilation, off by default. With OCRE_AOT on, every .wasm container of the
+# project also gets a <name>.aot next to it: the module goes through wasm-opt, when found,
+# then wamrc for OCRE_AOT_CPU (the build host when empty). Runtimes load the .aot as
+# native code instead of interpreting the .wasm. OCRE_DIST_DIR, set by the top-level
+# build, also receives a copy.
+option(OCRE_AOT "Also compile each container ahead of time with wamrc" OFF)
+set(OCRE_AOT_CPU "" CACHE STRING "wamrc --cpu of the device, such as cortex-m33; empty for the build host")
+set(OCRE_AOT_FLAGS "" CACHE STRING "Extra wamrc flags")
+set(OCRE_WASM_OPT_FLAGS "-O3" CACHE STRING "wasm-opt flags applied before wamrc")
+set(OCRE_ROOT_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+# ocre_add_aot(<target> [CPU <cpu>] [WAMRC_FLAGS <flag>...])
+#
+# Adds the .aot step to one container, for samples that know their device CPU. Does
+# nothing unless OCRE_AOT is on; containers without a call get OCRE_AOT_CPU.
+function(ocre_add_aot target)
+    cmake_parse_arguments(ARG "" "CPU" "WAMRC_FLAGS" ${ARGN})
+    get_target_property(added ${target} OCRE_AOT_ADDED)
+    if (NOT OCRE_AOT OR added)
+        return()
+    endif()
+    set_target_properties(${target} PROPERTIES OCRE_AOT_ADDED ON)
+
+    if (NOT WAMR_ROOT)
+        set(WAMR_ROOT ${OCRE_ROOT_DIR}/wasm-micro-runtime)
+    endif()
+    find_program(OCRE_WAMRC wamrc HINTS ${WAMR_ROOT}/wamr-compiler/build)
+    find_program(OCRE_WASM_OPT wasm-opt HINTS /opt/binaryen/bin)
+    if (NOT OCRE_WAMRC)
+        message(FATAL_ERROR "OCRE_AOT needs wamrc: build ${WAMR_ROOT}/wamr-compiler or set OCRE_WAMRC")
+    endif()
+
+    set(cpu ${OCRE_AOT_CPU})
+    if (ARG_CPU)
+        set(cpu ${ARG_CPU})
+    endif()
+    # wamrc needs the LLVM target and float ABI along with the CPU
+    set(wamrc_flags --opt-level=3)
+    if (cpu STREQUAL "cortex-m33")
+        list(APPEND wamrc_flags --target=thumbv8m.main --target-abi=eabihf --cpu=${cpu})
+    elseif (cpu STREQUAL "cortex-m7" OR cpu STREQUAL "cortex-m4")
+        list(APPEND wamrc_flags --target=thumbv7em --target-abi=eabihf --cpu=${cpu})
+    elseif (cpu STREQUAL "cortex-m0" OR cpu STREQUAL "cortex-m0plus")
+        list(APPEND wamrc_flags --target=thumbv6m --target-abi=eabi --cpu=${cpu})
+    elseif (cpu)
+        list(APPEND wamrc_flags --cpu=${cpu})
+    endif()
+    if (OCRE_SDK_THREADS)
+        list(APPEND wamrc_flags --enable-multi-thread)
+    endif()
+    separate_arguments(extra_flags UNIX_COMMAND "${OCRE_AOT_FLAGS}")
+    list(APPEND wamrc_flags ${extra_flags} ${ARG_WAMRC_FLAGS})
+
+    string(REGEX REPLACE "\\.wasm$" "" base ${target})
+    set(wasm $<TARGET_FILE:${target}>)
+    set(aot $<TARGET_FILE_DIR:${target}>/${base}.aot)
+    set(commands)
+    if (OCRE_WASM_OPT AND OCRE_WASM_OPT_FLAGS)
+        separate_arguments(opt_flags UNIX_COMMAND "${OCRE_WASM_OPT_FLAGS}")
+        set(input $<TARGET_FILE_DIR:${target}>/${base}.opt.wasm)
+        list(APPEND commands COMMAND ${OCRE_WASM_OPT} ${opt_flags}
+            --enable-bulk-memory --enable-sign-ext --enable-mutable-globals
+            --enable-nontrapping-float-to-int --enable-simd --enable-threads
+            ${wasm} -o ${input})
+    else()
+        set(input ${wasm})
+    endif()
+    list(APPEND commands COMMAND ${OCRE_WAMRC} ${wamrc_flags} -o ${aot} ${input})
+    if (OCRE_DIST_DIR)
+        list(APPEND commands COMMAND ${CMAKE_COMMAND} -E copy ${aot} ${OCRE_DIST_DIR})
+    endif()
+    if (NOT cpu)
+        set(cpu "the build host")
+    endif()
+    add_custom_command(TARGET ${target} POST_BUILD
+        ${commands}
+        COMMENT "Compiling ${base}.aot for ${cpu}"
+        VERBATIM
+    )
+endfunction()
+
+# Runs once the including CMakeLists.txt is done, for the containers it did not cover
+function(ocre_add_aot_all)
+    get_property(targets DIRECTORY PROPERTY BUILDSYSTEM_TARGETS)
+    foreach(target ${targets})
+        get_target_property(type ${target} TYPE)
+        if (type STREQUAL "EXECUTABLE" AND target MATCHES "\\.wasm$")
+            ocre_add_aot(${target})
+        endif()
+    endforeach()
+endfunction()
+
+if (OCRE_AOT)
+    cmake_language(DEFER CALL ocre_add_aot_all)
+endif()
@@ -0,0 +1,86 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+
+/*
+ * Result reporting shared by the benchmark containers.
+ *
+ * Every result is one line on stdout, so runs can be collected and compared with grep:
+ *
+ *   BENCH name=<name> samples=<n> min_ns=<v> p50_ns=<v> p99_ns=<v> max_ns=<v>
+ *   BENCH name=<name> ops=<n> elapsed_ns=<v> ns_per_op=<v> ops_per_s=<v>
+ *   BENCH name=<name> skipped=<reason>
+ *
+ * Anything else a benchmark prints goes to stderr.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <ocre_api.h>
+
+#ifndef BENCH_MAX_SAMPLES
+#define BENCH_MAX_SAMPLES 1000
+#endif
+
+typedef struct {
+	uint32_t count;
+	uint64_t ns[BENCH_MAX_SAMPLES];
+} bench_samples_t;
+
+static inline void bench_init(void)
+{
+	setvbuf(stdout, NULL, _IONBF, 0);
+}
+
+static inline void bench_record(bench_samples_t *samples, uint64_t ns)
+{
+	if (samples->count < BENCH_MAX_SAMPLES) {
+		samples->ns[samples->count++] = ns;
+	}
+}
+
+static inline int bench_compare(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+static inline void bench_report_latency(const char *name, bench_samples_t *samples)
+{
+	uint32_t n = samples->count;
+	if (n == 0) {
+		printf("BENCH name=%s skipped=no_samples\n", name);
+		return;
+	}
+	qsort(samples->ns, n, sizeof(samples->ns[0]), bench_compare);
+	printf("BENCH name=%s samples=%u min_ns=%llu p50_ns=%llu p99_ns=%llu max_ns=%llu\n", name, n,
+	       (unsigned long long)samples->ns[0], (unsigned long long)samples->ns[n / 2],
+	       (unsigned long long)samples->ns[(uint64_t)n * 99 / 100], (unsigned long long)samples->ns[n - 1]);
+}
+
+static inline void bench_report_rate(const char *name, uint32_t ops, uint64_t elapsed_ns)
+{
+	if (ops == 0 || elapsed_ns == 0) {
+		printf("BENCH name=%s skipped=no_samples\n", name);
+		return;
+	}
+	printf("BENCH name=%s ops=%u elapsed_ns=%llu ns_per_op=%llu ops_per_s=%llu\n", name, ops,
+	       (unsigned long long)elapsed_ns, (unsigned long long)(elapsed_ns / ops),
+	       (unsigned long long)((uint64_t)ops * 1000000000ULL / elapsed_ns));
+}
+
+static inline void bench_skip(const char *name, const char *reason)
+{
+	printf("BENCH name=%s skipped=%s\n", name, reason);
+}
+
+#endif /* BENCH_H */
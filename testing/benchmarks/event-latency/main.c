@@ -0,0 +1,117 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+
+/*
+ * Time from a host event to its callback in the container.
+ *
+ * timer_latency: a one-shot timer is armed again and again; each sample is the time
+ * between the expiry it was armed for and its callback running.
+ *
+ * gpio_latency: needs an output pin wired to an input pin, given as arguments
+ *   event-latency <out_port> <out_pin> <in_port> <in_pin>
+ * Each sample is the time between toggling the output and the input's edge callback.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ocre_api.h>
+#include "bench.h"
+
+#define TIMER_ID 1
+#define TIMER_INTERVAL_US 1000
+#define EVENT_TIMEOUT_MS 1000
+
+static bench_samples_t samples;
+static volatile uint64_t fired_ns;
+
+static void timer_fired(int timer_id, uint32_t overruns)
+{
+	fired_ns = ocre_time_ns();
+}
+
+static void gpio_fired(int port, int pin, ocre_gpio_pin_state_t state, void *user_data)
+{
+	fired_ns = ocre_time_ns();
+}
+
+// Dispatch events until a callback stored its time, 0 on timeout
+static uint64_t wait_fired(void)
+{
+	uint64_t deadline = ocre_time_ns() + EVENT_TIMEOUT_MS * 1000000ULL;
+	while (fired_ns == 0 && ocre_time_ns() < deadline) {
+		ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, EVENT_TIMEOUT_MS);
+	}
+	uint64_t t = fired_ns;
+	fired_ns = 0;
+	return t;
+}
+
+static void bench_timer(void)
+{
+	if (ocre_timer_create(TIMER_ID) != OCRE_SUCCESS ||
+	    ocre_register_timer_callback_ex(TIMER_ID, timer_fired) != OCRE_SUCCESS) {
+		bench_skip("timer_latency", "no_timer");
+		return;
+	}
+	samples.count = 0;
+	for (int i = 0; i < BENCH_MAX_SAMPLES; i++) {
+		uint64_t due = ocre_time_ns() + TIMER_INTERVAL_US * 1000ULL;
+		if (ocre_timer_start_us(TIMER_ID, TIMER_INTERVAL_US, 0) != OCRE_SUCCESS) {
+			break;
+		}
+		uint64_t t = wait_fired();
+		if (t == 0) {
+			break;
+		}
+		bench_record(&samples, t > due ? t - due : 0);
+	}
+	ocre_unregister_timer_callback(TIMER_ID);
+	ocre_timer_delete(TIMER_ID);
+	bench_report_latency("timer_latency", &samples);
+}
+
+static void bench_gpio(int out_port, int out_pin, int in_port, int in_pin)
+{
+	if (ocre_gpio_init() != OCRE_SUCCESS ||
+	    ocre_gpio_configure(out_port, out_pin, OCRE_GPIO_DIR_OUTPUT) != OCRE_SUCCESS ||
+	    ocre_gpio_configure(in_port, in_pin, OCRE_GPIO_DIR_INPUT) != OCRE_SUCCESS ||
+	    ocre_register_gpio_callback_ex(in_port, in_pin, OCRE_GPIO_EDGE_BOTH, gpio_fired, NULL) != OCRE_SUCCESS) {
+		bench_skip("gpio_latency", "no_gpio");
+		return;
+	}
+	samples.count = 0;
+	for (int i = 0; i < BENCH_MAX_SAMPLES; i++) {
+		uint64_t toggled = ocre_time_ns();
+		ocre_gpio_pin_toggle(out_port, out_pin);
+		uint64_t t = wait_fired();
+		if (t == 0) {
+			break;
+		}
+		bench_record(&samples, t - toggled);
+	}
+	ocre_unregister_gpio_callback(in_pin, in_port);
+	if (samples.count == 0) {
+		bench_skip("gpio_latency", "no_edges");
+		return;
+	}
+	bench_report_latency("gpio_latency", &samples);
+}
+
+int main(int argc, char *argv[])
+{
+	bench_init();
+
+	bench_timer();
+
+	if (argc < 5) {
+		bench_skip("gpio_latency", "no_loopback_pins");
+	} else {
+		bench_gpio(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+	}
+	return 0;
+}
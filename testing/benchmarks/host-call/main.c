@@ -0,0 +1,62 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+
+/*
+ * Cost of crossing from the container into the host.
+ *
+ * guest_call: a call that stays in the module, the baseline.
+ * host_call_time: ocre_time_ns(), the cheapest host import.
+ * host_call_get_events: ocre_get_events() on an empty queue.
+ * process_events_empty: one non-blocking pass of the SDK event loop with nothing queued.
+ */
+
+#include <stdio.h>
+#include <ocre_api.h>
+#include "bench.h"
+
+#define CALLS 100000
+
+static volatile uint64_t sink;
+
+__attribute__((noinline)) static uint64_t guest_call(uint64_t x)
+{
+	return x + 1;
+}
+
+int main(int argc, char *argv[])
+{
+	bench_init();
+	uint64_t start;
+
+	start = ocre_time_ns();
+	for (int i = 0; i < CALLS; i++) {
+		sink = guest_call(sink);
+	}
+	bench_report_rate("guest_call", CALLS, ocre_time_ns() - start);
+
+	start = ocre_time_ns();
+	for (int i = 0; i < CALLS; i++) {
+		sink = ocre_time_ns();
+	}
+	bench_report_rate("host_call_time", CALLS, ocre_time_ns() - start);
+
+	event_data_t event;
+	uint32_t count;
+	start = ocre_time_ns();
+	for (int i = 0; i < CALLS; i++) {
+		ocre_get_events(&event, 1, &count);
+	}
+	bench_report_rate("host_call_get_events", CALLS, ocre_time_ns() - start);
+
+	start = ocre_time_ns();
+	for (int i = 0; i < CALLS; i++) {
+		ocre_process_events_ex(OCRE_EVENT_FLAG_NONE, 0);
+	}
+	bench_report_rate("process_events_empty", CALLS, ocre_time_ns() - start);
+	return 0;
+}
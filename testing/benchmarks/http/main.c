@@ -0,0 +1,110 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+
+/*
+ * HTTP requests per second over loopback, server and client in this container.
+ *
+ * http_keepalive: GET requests one after another on one connection.
+ * http_connection_per_request: a new connection for every GET.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "mongoose.h"
+#include <ocre_api.h>
+#include "bench.h"
+
+#define LISTEN_URL "http://127.0.0.1:18080"
+#define KEEPALIVE_REQUESTS 5000
+#define CONNECTION_REQUESTS 500
+#define TIMEOUT_MS 10000
+
+static const char request[] = "GET /bench HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+
+static uint32_t requests;
+static uint32_t completed;
+static uint32_t failed;
+static bool keepalive;
+static bool connected;
+
+static void server_handler(struct mg_connection *c, int ev, void *ev_data)
+{
+	if (ev == MG_EV_HTTP_MSG) {
+		mg_http_reply(c, 200, "Content-Type: text/plain\r\n", "ok\n");
+	}
+}
+
+static void client_handler(struct mg_connection *c, int ev, void *ev_data)
+{
+	if (ev == MG_EV_CONNECT) {
+		mg_send(c, request, sizeof(request) - 1);
+	} else if (ev == MG_EV_HTTP_MSG) {
+		struct mg_http_message *hm = (struct mg_http_message *)ev_data;
+		if (mg_http_status(hm) != 200) {
+			failed++;
+		}
+		completed++;
+		if (keepalive && completed < requests) {
+			mg_send(c, request, sizeof(request) - 1);
+		} else {
+			c->is_closing = 1;
+		}
+	} else if (ev == MG_EV_ERROR) {
+		failed++;
+		completed++;
+	} else if (ev == MG_EV_CLOSE) {
+		connected = false;
+	}
+}
+
+static void bench_requests(struct mg_mgr *mgr, const char *name, uint32_t count, bool keep)
+{
+	requests = count;
+	completed = 0;
+	failed = 0;
+	keepalive = keep;
+	connected = false;
+	uint64_t start = ocre_time_ns();
+	while (completed < requests && ocre_time_ns() - start < TIMEOUT_MS * 1000000ULL) {
+		if (!connected) {
+			bool ok = mg_http_connect(mgr, LISTEN_URL, client_handler, NULL) != NULL;
+			if (!ok) {
+				break;
+			}
+			connected = true;
+		}
+		mg_mgr_poll(mgr, 0);
+	}
+	uint64_t elapsed = ocre_time_ns() - start;
+	if (failed > 0) {
+		fprintf(stderr, "%s: %u of %u requests failed\n", name, failed, completed);
+	}
+	bench_report_rate(name, completed - failed, elapsed);
+	// Let the last connection close before the next run
+	while (connected && ocre_time_ns() - start < 2 * TIMEOUT_MS * 1000000ULL) {
+		mg_mgr_poll(mgr, 0);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	bench_init();
+
+	struct mg_mgr mgr;
+	mg_mgr_init(&mgr);
+	if (mg_http_listen(&mgr, LISTEN_URL, server_handler, NULL) == NULL) {
+		fprintf(stderr, "Cannot listen on %s\n", LISTEN_URL);
+		return 1;
+	}
+
+	bench_requests(&mgr, "http_keepalive", KEEPALIVE_REQUESTS, true);
+	bench_requests(&mgr, "http_connection_per_request", CONNECTION_REQUESTS, false);
+
+	mg_mgr_free(&mgr);
+	return 0;
+}
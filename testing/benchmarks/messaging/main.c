@@ -0,0 +1,132 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+
+/*
+ * Publish to subscribe through the host broker, with the container subscribed to its
+ * own topic.
+ *
+ * publish_rtt: one message in flight; each sample is the time from the publish call
+ * to the message callback.
+ *
+ * publish_throughput: messages published on a topic handle as fast as the publish
+ * credits allow, timed until the last one was delivered.
+ *
+ * Messages are received into a pool of slots when the host supports it, so the
+ * numbers include no module heap allocation or free call per message.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ocre_api.h>
+#include "bench.h"
+
+#define TOPIC "bench/messaging"
+#define CONTENT_TYPE "application/octet-stream"
+#define PAYLOAD_SIZE 64
+#define THROUGHPUT_MESSAGES 10000
+#define TIMEOUT_MS 5000
+#define POOL_SLOTS 64
+#define MESSAGE_SIZE (sizeof(TOPIC) + sizeof(CONTENT_TYPE) + PAYLOAD_SIZE)
+
+static bench_samples_t samples;
+static uint8_t payload[PAYLOAD_SIZE];
+static volatile uint32_t received;
+static volatile uint64_t received_ns;
+static ocre_msg_pool_t pool;
+static uint64_t pool_buffer[POOL_SLOTS * OCRE_MSG_SLOT_SIZE(MESSAGE_SIZE) / sizeof(uint64_t)];
+
+static void message_received(const char *topic, const char *content_type, const void *data, uint32_t len)
+{
+	received_ns = ocre_time_ns();
+	received++;
+}
+
+static bool timed_out(uint64_t start_ns)
+{
+	return ocre_time_ns() - start_ns > TIMEOUT_MS * 1000000ULL;
+}
+
+static void bench_rtt(void)
+{
+	samples.count = 0;
+	for (int i = 0; i < BENCH_MAX_SAMPLES; i++) {
+		uint32_t expected = received + 1;
+		uint64_t start = ocre_time_ns();
+		if (ocre_publish_message(TOPIC, CONTENT_TYPE, payload, sizeof(payload)) != OCRE_SUCCESS) {
+			break;
+		}
+		while (received != expected && !timed_out(start)) {
+			ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, TIMEOUT_MS);
+		}
+		if (received != expected) {
+			break;
+		}
+		bench_record(&samples, received_ns - start);
+	}
+	bench_report_latency("publish_rtt", &samples);
+}
+
+static void bench_throughput(void)
+{
+	int handle = ocre_topic_open(TOPIC, CONTENT_TYPE);
+	if (handle < 0) {
+		bench_skip("publish_throughput", "no_topic_handle");
+		return;
+	}
+	uint32_t base = received;
+	uint32_t sent = 0;
+	uint64_t start = ocre_time_ns();
+	while (received - base < THROUGHPUT_MESSAGES && !timed_out(start)) {
+		int credits = ocre_publish_credits(handle);
+		if (credits < 0) {
+			credits = 1; // Host without flow control, one message at a time
+		}
+		int published = 0;
+		while (published < credits && sent < THROUGHPUT_MESSAGES &&
+		       ocre_publish_by_handle(handle, payload, sizeof(payload)) == OCRE_SUCCESS) {
+			published++;
+			sent++;
+		}
+		// Drain what is queued, wait only when nothing could be published
+		int flags = published == 0 ? OCRE_EVENT_FLAG_WAIT : OCRE_EVENT_FLAG_NONE;
+		ocre_process_events_ex(flags, TIMEOUT_MS);
+	}
+	uint64_t elapsed = ocre_time_ns() - start;
+	ocre_topic_close(handle);
+	if (received - base < sent) {
+		fprintf(stderr, "publish_throughput: %u of %u messages delivered\n", received - base, sent);
+	}
+	bench_report_rate("publish_throughput", received - base, elapsed);
+}
+
+int main(int argc, char *argv[])
+{
+	bench_init();
+	memset(payload, 0xa5, sizeof(payload));
+
+	ocre_msg_system_init();
+	bool pooled = ocre_subscribe_message_pool(&pool, TOPIC, pool_buffer, sizeof(pool_buffer), MESSAGE_SIZE) ==
+		      OCRE_SUCCESS;
+	if ((!pooled && ocre_subscribe_message(TOPIC) != OCRE_SUCCESS) ||
+	    ocre_register_message_callback(TOPIC, message_received) != OCRE_SUCCESS) {
+		bench_skip("publish_rtt", "no_subscription");
+		bench_skip("publish_throughput", "no_subscription");
+		return 1;
+	}
+	// No message may be lost, a full queue holds the publisher back instead
+	ocre_subscribe_set_overflow_policy(TOPIC, OCRE_OVERFLOW_BLOCK, TIMEOUT_MS);
+
+	bench_rtt();
+	bench_throughput();
+
+	ocre_unregister_message_callback(TOPIC);
+	if (pooled) {
+		ocre_release_message_pool(&pool);
+	}
+	return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+
+/*
+ * Modbus TCP requests per second over loopback, server and client in this container.
+ *
+ * modbus_read_depth1: one read of 10 holding registers outstanding at a time.
+ * modbus_read_depth8: eight reads outstanding, answered in batches by the server.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "mongoose.h"
+#include <ocre_api.h>
+#include <ocre_modbus.h>
+#include "bench.h"
+
+#define LISTEN_URL "tcp://127.0.0.1:15020"
+#define REGISTERS 64
+#define READ_COUNT 10
+#define REQUESTS 5000
+#define MAX_DEPTH 8
+#define TIMEOUT_MS 10000
+
+static uint16_t registers[REGISTERS];
+static ocre_modbus_server_t server;
+
+static ocre_modbus_transaction_t transactions[MAX_DEPTH];
+static ocre_modbus_client_t client;
+static uint32_t issued;
+static uint32_t completed;
+static uint32_t failed;
+
+static uint8_t read_registers(void *user_data, ocre_modbus_table_t table, uint16_t start, uint16_t count,
+			      uint16_t *values)
+{
+	if (start + count > REGISTERS) {
+		return OCRE_MODBUS_EX_ILLEGAL_DATA_ADDRESS;
+	}
+	memcpy(values, &registers[start], count * sizeof(uint16_t));
+	return OCRE_MODBUS_EX_NONE;
+}
+
+static const ocre_modbus_map_t map = {
+	.read_registers = read_registers,
+};
+
+static void server_handler(struct mg_connection *c, int ev, void *ev_data)
+{
+	if (ev == MG_EV_READ) {
+		static uint8_t responses[MAX_DEPTH * OCRE_MODBUS_MAX_ADU_SIZE];
+		size_t offset = 0;
+		int used;
+		do {
+			size_t len = 0;
+			used = ocre_modbus_server_process(&server, (const uint8_t *)c->recv.buf + offset,
+							  c->recv.len - offset, responses, sizeof(responses), &len);
+			if (len > 0) {
+				mg_send(c, responses, len);
+			}
+			if (used < 0) {
+				c->is_closing = 1;
+				offset = c->recv.len;
+				break;
+			}
+			offset += used;
+		} while (used > 0);
+		mg_iobuf_del(&c->recv, 0, offset);
+	}
+}
+
+static int client_send(void *io, const uint8_t *data, size_t len)
+{
+	return mg_send((struct mg_connection *)io, data, len) ? OCRE_SUCCESS : OCRE_ERROR_NO_MEMORY;
+}
+
+static void read_done(ocre_modbus_client_t *c, const ocre_modbus_result_t *result, void *user_data);
+
+static void issue_read(void)
+{
+	if (issued < REQUESTS &&
+	    ocre_modbus_client_read(&client, 1, OCRE_MODBUS_HOLDING_REGISTERS, 0, READ_COUNT, read_done, NULL) ==
+		    OCRE_SUCCESS) {
+		issued++;
+	}
+}
+
+static void read_done(ocre_modbus_client_t *c, const ocre_modbus_result_t *result, void *user_data)
+{
+	if (result->status != OCRE_MODBUS_EX_NONE) {
+		failed++;
+	}
+	completed++;
+	issue_read();
+}
+
+static void client_handler(struct mg_connection *c, int ev, void *ev_data)
+{
+	uint32_t depth = (uint32_t)(uintptr_t)c->fn_data;
+	if (ev == MG_EV_CONNECT) {
+		ocre_modbus_client_init(&client, transactions, depth, TIMEOUT_MS, client_send, c);
+		for (uint32_t i = 0; i < depth; i++) {
+			issue_read();
+		}
+	} else if (ev == MG_EV_READ) {
+		int used = ocre_modbus_client_process(&client, (const uint8_t *)c->recv.buf, c->recv.len);
+		if (used < 0) {
+			c->is_closing = 1;
+			return;
+		}
+		mg_iobuf_del(&c->recv, 0, (size_t)used);
+	} else if (ev == MG_EV_ERROR || ev == MG_EV_CLOSE) {
+		ocre_modbus_client_reset(&client);
+	}
+}
+
+static void bench_depth(struct mg_mgr *mgr, const char *name, uint32_t depth)
+{
+	issued = 0;
+	completed = 0;
+	failed = 0;
+	struct mg_connection *c = mg_connect(mgr, LISTEN_URL, client_handler, (void *)(uintptr_t)depth);
+	if (c == NULL) {
+		bench_skip(name, "no_connection");
+		return;
+	}
+	uint64_t start = ocre_time_ns();
+	while (completed < REQUESTS && ocre_time_ns() - start < TIMEOUT_MS * 1000000ULL) {
+		mg_mgr_poll(mgr, 0);
+	}
+	uint64_t elapsed = ocre_time_ns() - start;
+	if (failed > 0) {
+		fprintf(stderr, "%s: %u of %u requests failed\n", name, failed, completed);
+	}
+	bench_report_rate(name, completed - failed, elapsed);
+	issued = REQUESTS; // Nothing more to send while closing
+	c->is_closing = 1;
+	mg_mgr_poll(mgr, 0);
+}
+
+int main(int argc, char *argv[])
+{
+	bench_init();
+	for (int i = 0; i < REGISTERS; i++) {
+		registers[i] = (uint16_t)i;
+	}
+
+	struct mg_mgr mgr;
+	mg_mgr_init(&mgr);
+	ocre_modbus_server_init(&server, &map, NULL);
+	if (mg_listen(&mgr, LISTEN_URL, server_handler, NULL) == NULL) {
+		fprintf(stderr, "Cannot listen on %s\n", LISTEN_URL);
+		return 1;
+	}
+
+	bench_depth(&mgr, "modbus_read_depth1", 1);
+	bench_depth(&mgr, "modbus_read_depth8", MAX_DEPTH);
+
+	mg_mgr_free(&mgr);
+	return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+
+/*
+ * Sensor read rate of the first channel of a sensor.
+ *
+ *   sensors [sensor_name]
+ *
+ * sensor_read_by_id reads sensor 0, or the named sensor once resolved.
+ * sensor_read_by_name passes the name on every read, so each read looks it up again.
+ * sensor_read_samples reads the channel as a fixed-point sample.
+ */
+
+#include <stdio.h>
+#include <ocre_api.h>
+#include "bench.h"
+
+#define READS 10000
+
+static volatile double sink;
+
+static void bench_by_id(int sensor_id, int channel)
+{
+	uint64_t start = ocre_time_ns();
+	for (int i = 0; i < READS; i++) {
+		sink = ocre_sensors_read(sensor_id, channel);
+	}
+	bench_report_rate("sensor_read_by_id", READS, ocre_time_ns() - start);
+}
+
+static void bench_by_name(const char *name, int channel)
+{
+	uint64_t start = ocre_time_ns();
+	for (int i = 0; i < READS; i++) {
+		sink = ocre_sensors_read_by_name(name, channel);
+	}
+	bench_report_rate("sensor_read_by_name", READS, ocre_time_ns() - start);
+}
+
+static void bench_samples(int sensor_id, int channel)
+{
+	ocre_sensor_sample_t sample;
+	uint64_t start = ocre_time_ns();
+	for (int i = 0; i < READS; i++) {
+		if (ocre_sensors_read_sample(sensor_id, channel, &sample) != OCRE_SUCCESS) {
+			bench_skip("sensor_read_samples", "read_failed");
+			return;
+		}
+	}
+	bench_report_rate("sensor_read_samples", READS, ocre_time_ns() - start);
+}
+
+int main(int argc, char *argv[])
+{
+	bench_init();
+	const char *name = argc > 1 ? argv[1] : NULL;
+
+	if (ocre_sensors_init() != OCRE_SUCCESS || ocre_sensors_discover() <= 0) {
+		bench_skip("sensor_read_by_id", "no_sensors");
+		bench_skip("sensor_read_by_name", "no_sensors");
+		bench_skip("sensor_read_samples", "no_sensors");
+		return 0;
+	}
+
+	int sensor_id = name ? ocre_sensors_resolve(name) : 0;
+	if (sensor_id < 0) {
+		fprintf(stderr, "Sensor %s not found\n", name);
+		return 1;
+	}
+	int rc = name ? ocre_sensors_open_by_name(name) : ocre_sensors_open(ocre_sensors_get_handle(sensor_id));
+	if (rc != OCRE_SUCCESS) {
+		fprintf(stderr, "Cannot open sensor %d\n", sensor_id);
+		return 1;
+	}
+	int channel = ocre_sensors_get_channel_type(sensor_id, 0);
+	if (channel < 0) {
+		fprintf(stderr, "Sensor %d has no channels\n", sensor_id);
+		return 1;
+	}
+
+	bench_by_id(sensor_id, channel);
+	if (name) {
+		bench_by_name(name, channel);
+	} else {
+		bench_skip("sensor_read_by_name", "no_sensor_name");
+	}
+	bench_samples(sensor_id, channel);
+	return 0;
+}
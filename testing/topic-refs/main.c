@@ -0,0 +1,65 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+
+/*
+ * Interned topic level strings are reference counted in one byte. Register more
+ * filters sharing the level "leaf" than a signed or unsigned byte can count, release
+ * some, intern new strings and check every remaining filter is still found.
+ */
+
+#include <stdio.h>
+#include <ocre_api.h>
+
+#define FILTERS 300
+#define RELEASED 150
+
+static void message_received(const char *topic, const char *content_type, const void *data, uint32_t len)
+{
+}
+
+static void filter_name(char *buf, size_t size, int i)
+{
+	snprintf(buf, size, "t%d/leaf", i);
+}
+
+int main(int argc, char *argv[])
+{
+	char topic[32];
+	int failures = 0;
+
+	for (int i = 0; i < FILTERS; i++) {
+		filter_name(topic, sizeof(topic), i);
+		if (ocre_register_message_callback(topic, message_received) != OCRE_SUCCESS) {
+			fprintf(stderr, "register %s failed\n", topic);
+			return 1;
+		}
+	}
+	for (int i = 0; i < RELEASED; i++) {
+		filter_name(topic, sizeof(topic), i);
+		if (ocre_unregister_message_callback(topic) != OCRE_SUCCESS) {
+			fprintf(stderr, "unregister %s failed\n", topic);
+			failures++;
+		}
+	}
+	// New strings reuse pool space only if "leaf" was wrongly dropped
+	if (ocre_register_message_callback("other/level", message_received) != OCRE_SUCCESS) {
+		fprintf(stderr, "register other/level failed\n");
+		failures++;
+	}
+	for (int i = RELEASED; i < FILTERS; i++) {
+		filter_name(topic, sizeof(topic), i);
+		if (ocre_unregister_message_callback(topic) != OCRE_SUCCESS) {
+			fprintf(stderr, "%s lost after releasing other references\n", topic);
+			failures++;
+		}
+	}
+	ocre_unregister_message_callback("other/level");
+
+	fprintf(stderr, "topic-refs: %s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * @copyright Copyright © contributors to Project Ocre,
+ * which has been established as Project Ocre a Series of LF Projects, LLC
+
+ * SPDX-License-Identifier: Apache-2.0
+
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include <ocre_api.h>
+#include <ocre_workqueue.h>
+
+#define THREAD_COUNT 2
+#define ITEM_COUNT 16
+#define ITERATIONS 100000
+
+static ocre_workqueue_t wq;
+static ocre_work_t items[ITEM_COUNT];
+static pthread_t main_thread;
+static int completed;
+static int failures;
+
+static uint32_t checksum(uint32_t seed)
+{
+	uint32_t x = seed;
+	for (int i = 0; i < ITERATIONS; i++) {
+		x = x * 1664525u + 1013904223u;
+	}
+	return x;
+}
+
+static int work_fn(ocre_work_t *work)
+{
+	// Runs on the workers, unlike the completions
+	if (pthread_equal(pthread_self(), main_thread)) {
+		__atomic_fetch_add(&failures, 1, __ATOMIC_RELAXED);
+	}
+	return (int)checksum((uint32_t)(uintptr_t)work->user_data);
+}
+
+static void work_done(ocre_work_t *work, int result)
+{
+	if (!pthread_equal(pthread_self(), main_thread) ||
+	    result != (int)checksum((uint32_t)(uintptr_t)work->user_data)) {
+		__atomic_fetch_add(&failures, 1, __ATOMIC_RELAXED);
+	}
+	completed++;
+}
+
+int main(int argc, char *argv[])
+{
+	main_thread = pthread_self();
+	fprintf(stderr, "Starting workqueue test\n");
+
+	int rc = ocre_workqueue_init(&wq, THREAD_COUNT);
+	if (rc != OCRE_SUCCESS) {
+		fprintf(stderr, "ocre_workqueue_init: %d\n", rc);
+		return 1;
+	}
+
+	for (int i = 0; i < ITEM_COUNT; i++) {
+		ocre_work_init(&items[i], work_fn, work_done, (void *)(uintptr_t)(i + 1));
+		while ((rc = ocre_workqueue_submit(&wq, &items[i])) == OCRE_ERROR_BUSY) {
+			ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, 100);
+		}
+		if (rc != OCRE_SUCCESS) {
+			fprintf(stderr, "ocre_workqueue_submit: %d\n", rc);
+			return 1;
+		}
+	}
+
+	// Completions arrive as events on this thread
+	while (completed < ITEM_COUNT) {
+		if (ocre_process_events_ex(OCRE_EVENT_FLAG_WAIT, 5000) <= 0) {
+			break;
+		}
+	}
+
+	ocre_workqueue_destroy(&wq);
+	int failed = __atomic_load_n(&failures, __ATOMIC_RELAXED);
+	fprintf(stderr, "Finished workqueue test: %d completed, %d failures\n", completed, failed);
+
+	return completed == ITEM_COUNT && failed == 0 ? 0 : 1;
+}